@@ -48,6 +48,13 @@ int32_t db_store_i64(account_name scope, table_name table, account_name payer, u
 void db_update_i64(int32_t iterator, account_name payer, const void* data, uint32_t len);
 void db_remove_i64(int32_t iterator);
 int32_t db_get_i64(int32_t iterator, const void* data, uint32_t len);
+/**
+ *  Reads the row at iterator and the rows that follow it in the table, up to max_rows rows and as many as fit in len
+ *  bytes. Each row is written as its iterator (int32_t), the size of its data (uint32_t) and its primary key
+ *  (uint64_t), followed by its data.
+ *  @return the number of rows read, 0 when the first row does not fit
+ */
+int32_t db_get_range_i64(int32_t iterator, void* data, uint32_t len, uint32_t max_rows);
 int32_t db_next_i64(int32_t iterator, uint64_t* primary);
 int32_t db_previous_i64(int32_t iterator, uint64_t* primary);
 int32_t db_find_i64(account_name code, account_name scope, table_name table, uint64_t id);
@@ -116,6 +116,92 @@ namespace _multi_index_detail {
       static constexpr key256 lowest() { return key256(); }
    };
 
+   /**
+    *  Open addressing hash map from a 64 bit key to a position in the item cache of a multi_index. Collisions
+    *  are resolved by linear probing, and erasing shifts the entries that follow back into the freed slot, so
+    *  lookups never have to step over deleted entries.
+    */
+   class item_position_map {
+      public:
+         static constexpr uint32_t npos = static_cast<uint32_t>(-1);
+
+         uint32_t find( uint64_t key )const {
+            if( _slots.empty() )
+               return npos;
+            for( size_t i = home_slot( key ); ; i = (i + 1) & mask() ) {
+               if( _slots[i].position == npos || _slots[i].key == key )
+                  return _slots[i].position;
+            }
+         }
+
+         /// inserts the key or replaces its position
+         void set( uint64_t key, uint32_t position ) {
+            if( (_size + 1) * 4 > _slots.size() * 3 )
+               grow();
+            size_t i = home_slot( key );
+            while( _slots[i].position != npos && _slots[i].key != key )
+               i = (i + 1) & mask();
+            if( _slots[i].position == npos )
+               ++_size;
+            _slots[i].key = key;
+            _slots[i].position = position;
+         }
+
+         void erase( uint64_t key ) {
+            if( _slots.empty() )
+               return;
+            size_t hole = home_slot( key );
+            for( ; _slots[hole].key != key || _slots[hole].position == npos; hole = (hole + 1) & mask() ) {
+               if( _slots[hole].position == npos )
+                  return;
+            }
+            for( size_t i = (hole + 1) & mask(); _slots[i].position != npos; i = (i + 1) & mask() ) {
+               // an entry may only move back into the hole if the hole is not before its home slot
+               if( ((i - home_slot( _slots[i].key )) & mask()) >= ((i - hole) & mask()) ) {
+                  _slots[hole] = _slots[i];
+                  hole = i;
+               }
+            }
+            _slots[hole].position = npos;
+            --_size;
+         }
+
+      private:
+         struct slot {
+            uint64_t key      = 0;
+            uint32_t position = npos;
+         };
+
+         size_t mask()const { return _slots.size() - 1; }
+
+         size_t home_slot( uint64_t key )const {
+            return (key * 0x9E3779B97F4A7C15ULL) >> (64 - _bits); // fibonacci hashing, primary keys are often sequential
+         }
+
+         void grow() {
+            std::vector<slot> old( _slots.empty() ? 16 : _slots.size() * 2 );
+            old.swap( _slots );
+            _bits = 0;
+            while( (size_t(1) << _bits) < _slots.size() )
+               ++_bits;
+            _size = 0;
+            for( const auto& s : old ) {
+               if( s.position != npos )
+                  set( s.key, s.position );
+            }
+         }
+
+         std::vector<slot> _slots;
+         uint32_t          _size = 0;
+         uint32_t          _bits = 0;
+   };
+
+   /// counts the rows written through any multi_index of the contract, so read ahead rows can tell they may be stale
+   inline uint64_t& table_writes() {
+      static uint64_t writes = 0;
+      return writes;
+   }
+
 }
 
 template<uint64_t IndexName, typename Extractor>
@@ -173,7 +259,47 @@ class multi_index
          int32_t               _primary_itr;
       };
 
-      mutable std::vector<item_ptr> _items_vector;
+      /// the loaded rows, with hash indices from their primary key and from their primary iterator into the vector
+      mutable std::vector<item_ptr>                         _items_vector;
+      mutable _multi_index_detail::item_position_map        _items_by_primary_key;
+      mutable _multi_index_detail::item_position_map        _items_by_primary_itr;
+
+      const item* find_cached_by_primary_key( uint64_t pk )const {
+         auto pos = _items_by_primary_key.find( pk );
+         return pos == _multi_index_detail::item_position_map::npos ? nullptr : _items_vector[pos]._item.get();
+      }
+
+      const item* find_cached_by_primary_itr( int32_t itr )const {
+         auto pos = _items_by_primary_itr.find( static_cast<uint32_t>(itr) );
+         return pos == _multi_index_detail::item_position_map::npos ? nullptr : _items_vector[pos]._item.get();
+      }
+
+      const item* cache_item( std::unique_ptr<item>&& itm )const {
+         const item* ptr = itm.get();
+         auto pk   = itm->primary_key();
+         auto pitr = itm->__primary_itr;
+         auto pos  = static_cast<uint32_t>(_items_vector.size());
+
+         _items_vector.emplace_back( std::move(itm), pk, pitr );
+         _items_by_primary_key.set( pk, pos );
+         _items_by_primary_itr.set( static_cast<uint32_t>(pitr), pos );
+         return ptr;
+      }
+
+      /// destroys the cached row, moving the last one into its place
+      void uncache_item( uint64_t pk ) {
+         auto pos = _items_by_primary_key.find( pk );
+         eosio_assert( pos != _multi_index_detail::item_position_map::npos, "attempt to remove object that was not in multi_index" );
+
+         _items_by_primary_key.erase( pk );
+         _items_by_primary_itr.erase( static_cast<uint32_t>(_items_vector[pos]._primary_itr) );
+         if( pos + 1 != _items_vector.size() ) {
+            _items_vector[pos] = std::move( _items_vector.back() );
+            _items_by_primary_key.set( _items_vector[pos]._primary_key, pos );
+            _items_by_primary_itr.set( static_cast<uint32_t>(_items_vector[pos]._primary_itr), pos );
+         }
+         _items_vector.pop_back();
+      }
 
       template<uint64_t IndexName, typename Extractor, uint64_t Number, bool IsConst>
       struct index {
@@ -439,28 +565,35 @@ class multi_index
 
       indices_type _indices;
 
-      const item& load_object_by_primary_iterator( int32_t itr )const {
-         using namespace _multi_index_detail;
-
-         auto itr2 = std::find_if(_items_vector.rbegin(), _items_vector.rend(), [&](const item_ptr& ptr) {
-            return ptr._primary_itr == itr;
-         });
-         if( itr2 != _items_vector.rend() )
-            return *itr2->_item;
+      /// iterating forward by primary key reads ahead once it has taken this many steps, see load_object_by_primary_iterator
+      static constexpr uint32_t prefetch_min_steps   = 2;
+      static constexpr uint32_t prefetch_rows        = 16;
+      static constexpr uint32_t prefetch_buffer_size = 4096;
 
-         auto size = db_get_i64( itr, nullptr, 0 );
-         eosio_assert( size >= 0, "error reading iterator" );
-
-         //using malloc/free here potentially is not exception-safe, although WASM doesn't support exceptions
-         void* buffer = max_stack_buffer_size < size_t(size) ? malloc(size_t(size)) : alloca(size_t(size));
+      struct prefetched_row {
+         int32_t  itr;
+         uint32_t offset; ///< of the row's data in _prefetch_buffer
+         uint32_t size;
+      };
 
-         db_get_i64( itr, buffer, uint32_t(size) );
+      /// rows read ahead are kept as the bytes db_get_range_i64 wrote, and only deserialized once iteration reaches them
+      mutable std::vector<char>           _prefetch_buffer;
+      mutable std::vector<prefetched_row> _prefetched_rows;
+      mutable uint64_t                    _prefetch_writes = 0; ///< table_writes() as of the read, less this instance's writes
+      mutable uint32_t                    _forward_steps   = 0;
+
+      /// counts a write through this instance, which leaves the rows it read ahead valid
+      void note_write()const {
+         auto& writes = _multi_index_detail::table_writes();
+         if( _prefetch_writes == writes )
+            ++_prefetch_writes;
+         ++writes;
+      }
 
-         datastream<const char*> ds( (char*)buffer, uint32_t(size) );
+      const item& load_row( int32_t itr, const char* data, size_t size )const {
+         using namespace _multi_index_detail;
 
-         if ( max_stack_buffer_size < size_t(size) ) {
-            free(buffer);
-         }
+         datastream<const char*> ds( data, size );
 
          auto itm = std::make_unique<item>( this, [&]( auto& i ) {
             T& val = static_cast<T&>(i);
@@ -474,13 +607,78 @@ class multi_index
             });
          });
 
-         const item* ptr = itm.get();
-         auto pk   = itm->primary_key();
-         auto pitr = itm->__primary_itr;
+         return *cache_item( std::move(itm) );
+      }
 
-         _items_vector.emplace_back( std::move(itm), pk, pitr );
+      /// the row at itr if it was read ahead and no other multi_index has written since
+      const item* load_prefetched_row( int32_t itr )const {
+         if( _prefetch_writes != _multi_index_detail::table_writes() ) {
+            _prefetched_rows.clear();
+            return nullptr;
+         }
+         for( const auto& row : _prefetched_rows ) {
+            if( row.itr == itr )
+               return &load_row( itr, _prefetch_buffer.data() + row.offset, row.size );
+         }
+         return nullptr;
+      }
+
+      /// reads the row at itr and up to max_rows - 1 rows after it, returns nullptr when the first row does not fit
+      const item* prefetch_rows_from( int32_t itr, uint32_t max_rows )const {
+         if( _prefetch_buffer.empty() )
+            _prefetch_buffer.resize( prefetch_buffer_size );
+         auto rows = db_get_range_i64( itr, _prefetch_buffer.data(), uint32_t(_prefetch_buffer.size()), max_rows );
+
+         _prefetched_rows.clear();
+         _prefetch_writes = _multi_index_detail::table_writes();
+         uint32_t offset = 0;
+         for( int32_t r = 0; r < rows; ++r ) {
+            prefetched_row row;
+            memcpy( &row.itr, _prefetch_buffer.data() + offset, sizeof(row.itr) );
+            memcpy( &row.size, _prefetch_buffer.data() + offset + sizeof(row.itr), sizeof(row.size) );
+            row.offset = offset + sizeof(row.itr) + sizeof(row.size) + sizeof(uint64_t);
+            offset = row.offset + row.size;
+            _prefetched_rows.push_back( row );
+         }
+         return load_prefetched_row( itr );
+      }
+
+      /**
+       *  @param forward  the row is the next one by primary key of a forward iteration. Once an iteration has taken
+       *                  prefetch_min_steps steps, rows are read ahead with the same call, as many as it has taken
+       *                  steps so far and at most prefetch_rows, so short scans read little or nothing ahead.
+       */
+      const item& load_object_by_primary_iterator( int32_t itr, bool forward = false )const {
+         _forward_steps = forward ? _forward_steps + 1 : 0;
+
+         if( auto cached = find_cached_by_primary_itr( itr ) )
+            return *cached;
+
+         if( forward ) {
+            if( auto row = load_prefetched_row( itr ) )
+               return *row;
+            if( _forward_steps >= prefetch_min_steps ) {
+               if( auto row = prefetch_rows_from( itr, std::min( _forward_steps, prefetch_rows ) ) )
+                  return *row;
+            }
+            // a row that does not fit in the buffer is read on its own
+         }
+
+         auto size = db_get_i64( itr, nullptr, 0 );
+         eosio_assert( size >= 0, "error reading iterator" );
+
+         //using malloc/free here potentially is not exception-safe, although WASM doesn't support exceptions
+         void* buffer = max_stack_buffer_size < size_t(size) ? malloc(size_t(size)) : alloca(size_t(size));
+
+         db_get_i64( itr, buffer, uint32_t(size) );
+
+         const item& row = load_row( itr, (const char*)buffer, size_t(size) );
+
+         if ( max_stack_buffer_size < size_t(size) ) {
+            free(buffer);
+         }
 
-         return *ptr;
+         return row;
       } /// load_object_by_primary_iterator
 
    public:
@@ -518,7 +716,7 @@ class multi_index
             if( next_itr < 0 )
                _item = nullptr;
             else
-               _item = &_multidx->load_object_by_primary_iterator( next_itr );
+               _item = &_multidx->load_object_by_primary_iterator( next_itr, true );
             return *this;
          }
          const_iterator& operator--() {
@@ -655,6 +853,7 @@ class multi_index
             auto pk = obj.primary_key();
 
             i.__primary_itr = db_store_i64( _scope, TableName, payer, pk, buffer, size );
+            note_write();
 
             if ( max_stack_buffer_size < size ) {
                free(buffer);
@@ -670,13 +869,7 @@ class multi_index
             });
          });
 
-         const item* ptr = itm.get();
-         auto pk   = itm->primary_key();
-         auto pitr = itm->__primary_itr;
-
-         _items_vector.emplace_back( std::move(itm), pk, pitr );
-
-         return {this, ptr};
+         return {this, cache_item( std::move(itm) )};
       }
 
       template<typename Lambda>
@@ -716,6 +909,7 @@ class multi_index
          ds << obj;
 
          db_update_i64( objitem.__primary_itr, payer, buffer, size );
+         note_write();
 
          if ( max_stack_buffer_size < size ) {
             free( buffer );
@@ -749,11 +943,8 @@ class multi_index
       }
 
       const_iterator find( uint64_t primary )const {
-         auto itr2 = std::find_if(_items_vector.rbegin(), _items_vector.rend(), [&](const item_ptr& ptr) {
-            return ptr._item->primary_key() == primary;
-         });
-         if( itr2 != _items_vector.rend() )
-            return iterator_to(*(itr2->_item));
+         if( auto cached = find_cached_by_primary_key( primary ) )
+            return iterator_to(*cached);
 
          auto itr = db_find_i64( _code, _scope, TableName, primary );
          if( itr < 0 ) return end();
@@ -781,15 +972,10 @@ class multi_index
          eosio_assert( _code == current_receiver(), "cannot erase objects in table of another contract" ); // Quick fix for mutating db using multi_index that shouldn't allow mutation. Real fix can come in RC2.
 
          auto pk = objitem.primary_key();
-         auto itr2 = std::find_if(_items_vector.rbegin(), _items_vector.rend(), [&](const item_ptr& ptr) {
-            return ptr._item->primary_key() == pk;
-         });
-
-         eosio_assert( itr2 != _items_vector.rend(), "attempt to remove object that was not in multi_index" );
-
-         _items_vector.erase(--(itr2.base()));
+         eosio_assert( find_cached_by_primary_key( pk ) == &objitem, "attempt to remove object that was not in multi_index" );
 
          db_remove_i64( objitem.__primary_itr );
+         note_write();
 
          hana::for_each( _indices, [&]( auto& idx ) {
             typedef typename decltype(+hana::at_c<0>(idx))::type index_type;
@@ -802,6 +988,9 @@ class multi_index
             if( i >= 0 )
                secondary_index_db_functions<typename index_type::secondary_key_type>::db_idx_remove( i );
          });
+
+         // last, as it destroys the object
+         uncache_item( pk );
       }
 
 };
@@ -156,6 +156,126 @@ struct limit_order {
 
                }
                break;
+               case 2: // Touch many rows in one action
+               {
+                  print("Testing many rows in one action.\n");
+                  const uint64_t num_rows = 300;
+                  eosio::multi_index<N(manyorders), limit_order,
+                     indexed_by< N(byexp), const_mem_fun<limit_order, uint64_t, &limit_order::get_expiration> >
+                  > orders( N(multitest), N(multitest) );
+
+                  for( uint64_t id = 1; id <= num_rows; ++id ) {
+                     orders.emplace( payer, [&]( auto& o ) {
+                        o.id = id;
+                        o.expiration = 1000 + id;
+                        o.owner = N(dan);
+                     });
+                  }
+
+                  // every row is found in the cache, newest first and oldest first
+                  for( uint64_t id = num_rows; id > 0; --id ) {
+                     eosio_assert( orders.get(id).expiration == 1000 + id, "wrong row found" );
+                  }
+                  for( uint64_t id = 1; id <= num_rows; ++id ) {
+                     orders.modify( orders.get(id), payer, [&]( auto& o ) {
+                        o.expiration = 2000 - id;
+                     });
+                  }
+
+                  uint64_t count = 0;
+                  uint64_t last_expiration = 0;
+                  for( const auto& item : orders.get_index<N(byexp)>() ) {
+                     eosio_assert( item.expiration > last_expiration, "rows out of order" );
+                     last_expiration = item.expiration;
+                     ++count;
+                  }
+                  eosio_assert( count == num_rows, "wrong number of rows" );
+
+                  for( uint64_t id = 1; id <= num_rows; id += 2 ) {
+                     orders.erase( orders.find(id) );
+                  }
+                  for( uint64_t id = 1; id <= num_rows; ++id ) {
+                     eosio_assert( (orders.find(id) == orders.end()) == (id % 2 == 1), "erased rows remain or others are gone" );
+                  }
+
+                  count = 0;
+                  for( auto itr = orders.begin(); itr != orders.end(); ) {
+                     itr = orders.erase( itr );
+                     ++count;
+                  }
+                  eosio_assert( count == num_rows / 2, "wrong number of rows left" );
+                  print("Touched ", num_rows, " rows.\n");
+               }
+               break;
+               case 3: // Rows read ahead by one multi_index see what another one writes
+               {
+                  print("Testing rows read ahead while iterating.\n");
+                  const uint64_t num_rows = 40;
+                  typedef eosio::multi_index<N(aheadorders), limit_order> orders_type;
+                  {
+                     orders_type orders( N(multitest), N(multitest) );
+                     for( uint64_t id = 1; id <= num_rows; ++id ) {
+                        orders.emplace( payer, [&]( auto& o ) {
+                           o.id = id;
+                           o.expiration = 1000 + id;
+                           o.owner = N(dan);
+                        });
+                     }
+                  }
+
+                  orders_type reader( N(multitest), N(multitest) );
+                  orders_type writer( N(multitest), N(multitest) );
+                  uint64_t count = 0;
+                  for( const auto& item : reader ) {
+                     ++count;
+                     eosio_assert( item.id == count, "rows out of order" );
+                     eosio_assert( item.expiration == (item.id % 3 == 0 ? 3000 + item.id : 1000 + item.id), "stale row read ahead" );
+                     // change a row the reader has likely read ahead but not reached yet
+                     if( count + 2 <= num_rows && (count + 2) % 3 == 0 ) {
+                        writer.modify( writer.get(count + 2), payer, [&]( auto& o ) {
+                           o.expiration = 3000 + o.id;
+                        });
+                     }
+                  }
+                  eosio_assert( count == num_rows, "wrong number of rows" );
+               }
+               break;
+               case 4: // Find many rows through the row cache
+               case 5: // Find the same rows by scanning them, the way the row cache used to
+               {
+                  const uint64_t num_rows = 300;
+                  eosio::multi_index<N(lookups), limit_order> orders( N(multitest), N(multitest) );
+
+                  std::vector<const limit_order*> rows;
+                  for( uint64_t id = 1; id <= num_rows; ++id ) {
+                     rows.push_back( &*orders.emplace( payer, [&]( auto& o ) {
+                        o.id = id;
+                        o.expiration = 1000 + id;
+                        o.owner = N(dan);
+                     }) );
+                  }
+
+                  for( uint32_t round = 0; round < 2; ++round ) {
+                     for( uint64_t id = num_rows; id > 0; --id ) {
+                        const limit_order* row = nullptr;
+                        if( act.what == 4 ) {
+                           row = &orders.get( id );
+                        } else {
+                           for( auto r : rows ) {
+                              if( r->id == id ) {
+                                 row = r;
+                                 break;
+                              }
+                           }
+                        }
+                        eosio_assert( row != nullptr && row->id == id && row->expiration == 1000 + id, "wrong row found" );
+                     }
+                  }
+
+                  for( auto itr = orders.begin(); itr != orders.end(); )
+                     itr = orders.erase( itr );
+               }
+               break;
                default:
                   eosio_assert(0, "Given what code is not supported.");
                break;
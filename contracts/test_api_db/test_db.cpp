@@ -241,6 +241,52 @@ void test_db::primary_i64_upperbound(uint64_t receiver, uint64_t code, uint64_t
    }
 }
 
+void test_db::primary_i64_range(uint64_t receiver, uint64_t code, uint64_t action)
+{
+   (void)code;(void)action;
+   auto table = N(mytable);
+   const std::string err = "primary_i64_range";
+   const uint32_t header_size = sizeof(int32_t) + sizeof(uint32_t) + sizeof(uint64_t);
+   char buffer[256];
+
+   // rows of mytable from bob on: bob, charlie, emily and joe
+   int bob_itr = db_find_i64(receiver, receiver, table, N(bob));
+   {
+      int rows = db_get_range_i64(bob_itr, buffer, sizeof(buffer), 10);
+      eosio_assert(rows == 4, err.c_str());
+
+      int32_t itr;
+      uint32_t size;
+      uint64_t prim;
+      memcpy(&itr, buffer, sizeof(itr));
+      memcpy(&size, buffer + sizeof(itr), sizeof(size));
+      memcpy(&prim, buffer + sizeof(itr) + sizeof(size), sizeof(prim));
+      eosio_assert(itr == bob_itr && prim == N(bob), err.c_str());
+      eosio_assert(size == strlen("bob's info") && std::string(buffer + header_size, size) == "bob's info", err.c_str());
+
+      const char* second = buffer + header_size + size;
+      memcpy(&itr, second, sizeof(itr));
+      memcpy(&prim, second + sizeof(itr) + sizeof(size), sizeof(prim));
+      eosio_assert(itr == db_find_i64(receiver, receiver, table, N(charlie)) && prim == N(charlie), err.c_str());
+   }
+   {
+      int rows = db_get_range_i64(bob_itr, buffer, sizeof(buffer), 2);
+      eosio_assert(rows == 2, err.c_str());
+   }
+   {
+      // only as many rows as fit
+      int rows = db_get_range_i64(bob_itr, buffer, header_size + strlen("bob's info"), 10);
+      eosio_assert(rows == 1, err.c_str());
+      rows = db_get_range_i64(bob_itr, buffer, header_size + strlen("bob's info") - 1, 10);
+      eosio_assert(rows == 0, err.c_str());
+   }
+   {
+      int joe_itr = db_find_i64(receiver, receiver, table, N(joe));
+      int rows = db_get_range_i64(joe_itr, buffer, sizeof(buffer), 10);
+      eosio_assert(rows == 1, err.c_str());
+   }
+}
+
 void test_db::idx64_general(uint64_t receiver, uint64_t code, uint64_t action)
 {
    (void)code;(void)action;
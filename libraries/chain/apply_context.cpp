@@ -360,7 +360,7 @@ void apply_context::reset_console() {
 }
 
 void apply_context::checktime(uint32_t instruction_count) {
-   if (trx_meta.processing_deadline && fc::time_point::now() > (*trx_meta.processing_deadline)) {
+   if (trx_meta.processing_deadline && _checktime_timer.expired()) {
       throw checktime_exceeded();
    }
    _cpu_usage += instruction_count;
@@ -542,6 +542,28 @@ int apply_context::db_get_i64( int iterator, char* buffer, size_t buffer_size )
    return copy_size;
 }
 
+int apply_context::db_get_range_i64( int iterator, char* buffer, size_t buffer_size, uint32_t max_rows ) {
+   const key_value_object& first = keyval_cache.get( iterator );
+   const auto& idx = db.get_index<contracts::key_value_index, contracts::by_scope_primary>();
+
+   const size_t header_size = sizeof(int32_t) + sizeof(uint32_t) + sizeof(uint64_t);
+   size_t pos = 0;
+   uint32_t rows = 0;
+   for( auto itr = idx.iterator_to( first ); rows < max_rows && itr != idx.end() && itr->t_id == first.t_id; ++itr, ++rows ) {
+      const uint32_t size = itr->value.size();
+      if( buffer_size - pos < header_size + size ) break;
+
+      const int32_t row_iterator = keyval_cache.add( *itr );
+      memcpy( buffer + pos, &row_iterator, sizeof(row_iterator) );
+      memcpy( buffer + pos + sizeof(row_iterator), &size, sizeof(size) );
+      memcpy( buffer + pos + sizeof(row_iterator) + sizeof(size), &itr->primary_key, sizeof(uint64_t) );
+      memcpy( buffer + pos + header_size, itr->value.data(), size );
+      pos += header_size + size;
+   }
+
+   return rows;
+}
+
 int apply_context::db_next_i64( int iterator, uint64_t& primary ) {
    if( iterator < -1 ) return -1; // cannot increment past end iterator of table
 
@@ -3,15 +3,73 @@
  *  @copyright defined in eos/LICENSE.txt
  */
 #include <eosio/chain/block_log.hpp>
+#include <eosio/chain/config.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <fstream>
+#include <mutex>
+#include <thread>
 #include <fc/io/raw.hpp>
 
-#define LOG_READ  (std::ios::in | std::ios::binary)
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
 #define LOG_WRITE (std::ios::out | std::ios::binary | std::ios::app)
 
 namespace eosio { namespace chain {
 
    namespace detail {
+      namespace bip = boost::interprocess;
+
+      /**
+       * A read only mapping of a log file that reserves address space past the end of the file, so the
+       * bytes appended later are read through the same mapping until the file outgrows the reservation.
+       * Files are only truncated while the log is opened, so the mapped bytes stay valid as the file grows.
+       */
+      struct log_file_mapping {
+         log_file_mapping(const fc::path& file, uint64_t reserved)
+         :reserved(reserved) {
+            mapping = bip::file_mapping(file.generic_string().c_str(), bip::read_only);
+            region = bip::mapped_region(mapping, bip::read_only, 0, reserved);
+            // blocks are read by number, scattered across the log
+            region.advise(bip::mapped_region::advice_random);
+         }
+
+         uint64_t           reserved;
+         bip::file_mapping  mapping;
+         bip::mapped_region region;
+      };
+
+      /**
+       * The first size bytes of a log file, as they were when they were mapped.
+       */
+      struct mapped_log_file {
+         mapped_log_file(std::shared_ptr<const log_file_mapping> mapping, uint64_t size)
+         :size(size), mapping(std::move(mapping)) {}
+
+         const char* data()const { return mapping ? static_cast<const char*>(mapping->region.get_address()) : nullptr; }
+
+         uint64_t read_pos(uint64_t offset)const {
+            FC_ASSERT(offset + sizeof(uint64_t) <= size, "Read past the end of the log file.",
+                      ("offset", offset)("size", size));
+            uint64_t pos;
+            memcpy(&pos, data() + offset, sizeof(pos));
+            return pos;
+         }
+
+         uint64_t                                size;
+         std::shared_ptr<const log_file_mapping> mapping;
+      };
+
+      /// maps the first size bytes of file through current's mapping if they fit in its reservation
+      std::shared_ptr<const mapped_log_file> map_log_file(const fc::path& file, uint64_t size, const std::shared_ptr<const mapped_log_file>& current) {
+         if (!size)
+            return std::make_shared<const mapped_log_file>(nullptr, 0);
+         if (current && current->mapping && current->mapping->reserved >= size)
+            return std::make_shared<const mapped_log_file>(current->mapping, size);
+         auto reserved = size + std::max<uint64_t>(size / 4, config::block_log_map_reserve);
+         return std::make_shared<const mapped_log_file>(std::make_shared<const log_file_mapping>(file, reserved), size);
+      }
+
       class block_log_impl {
          public:
             optional<signed_block>   head;
@@ -20,44 +78,106 @@ namespace eosio { namespace chain {
             std::fstream             index_stream;
             fc::path                 block_file;
             fc::path                 index_file;
-            bool                     block_write;
-            bool                     index_write;
-
-            inline void check_block_read() {
-               if (block_write) {
-                  block_stream.close();
-                  block_stream.open(block_file.generic_string().c_str(), LOG_READ);
-                  block_write = false;
+            uint64_t                 block_file_size = 0;
+            uint64_t                 index_file_size = 0;
+
+            std::mutex                               mutex; ///< guards the streams, the sizes and the mappings
+            std::shared_ptr<const mapped_log_file>   block_map;
+            std::shared_ptr<const mapped_log_file>   index_map;
+
+            /**
+             * Mappings of both files that cover the first index_bytes of the index and the blocks it points to,
+             * or everything appended so far. The files are only flushed and mapped again when the current
+             * mappings fall short, which leaves reads of older blocks alone while blocks are appended.
+             */
+            std::pair<std::shared_ptr<const mapped_log_file>, std::shared_ptr<const mapped_log_file>> map_files(uint64_t index_bytes = std::numeric_limits<uint64_t>::max()) {
+               std::lock_guard<std::mutex> lock(mutex);
+               const bool everything = index_bytes >= index_file_size;
+               if (!block_map || !index_map || index_map->size < std::min(index_bytes, index_file_size) ||
+                   (everything && (block_map->size < block_file_size || index_map->size < index_file_size))) {
+                  block_stream.flush();
+                  index_stream.flush();
+                  block_map = map_log_file(block_file, block_file_size, block_map);
+                  index_map = map_log_file(index_file, index_file_size, index_map);
                }
+               return {block_map, index_map};
             }
 
-            inline void check_block_write() {
-               if (!block_write) {
-                  block_stream.close();
-                  block_stream.open(block_file.generic_string().c_str(), LOG_WRITE);
-                  block_write = true;
-               }
+            void truncate_index(uint64_t size) {
+               std::lock_guard<std::mutex> lock(mutex);
+               index_stream.close();
+               if (size)
+                  fc::resize_file(index_file, size);
+               else
+                  fc::remove_all(index_file);
+               index_stream.open(index_file.generic_string().c_str(), LOG_WRITE);
+               index_file_size = size;
+               index_map.reset();
             }
+      };
 
-            inline void check_index_read() {
-               try {
-                  if (index_write) {
-                     index_stream.close();
-                     index_stream.open(index_file.generic_string().c_str(), LOG_READ);
-                     index_write = false;
-                  }
-               }
-               FC_LOG_AND_RETHROW()
-            }
+      /**
+       * Number of leading entries of the index that agree with the log. Entry i holds the position of block
+       * i + 1, it agrees with the log when the position word trailing the block before it points back at
+       * entry i - 1. Each entry only depends on its predecessor, so segments of the index are checked in
+       * parallel.
+       */
+      uint32_t valid_index_prefix(const mapped_log_file& blocks, const mapped_log_file& index, uint64_t head_pos, uint32_t count) {
+         auto entry_valid = [&](uint32_t i) {
+            uint64_t pos = index.read_pos(sizeof(uint64_t) * i);
+            if (pos > head_pos)
+               return false;
+            if (i == 0)
+               return pos == 0;
+            uint64_t prev = index.read_pos(sizeof(uint64_t) * (i - 1));
+            return pos >= prev + sizeof(uint64_t) && blocks.read_pos(pos - sizeof(uint64_t)) == prev;
+         };
+         auto first_invalid = [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i)
+               if (!entry_valid(i))
+                  return i;
+            return end;
+         };
+
+         const uint32_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+         if (threads == 1 || count < config::block_log_index_segment_size)
+            return first_invalid(0, count);
+
+         boost::asio::thread_pool pool(threads);
+         vector<std::future<uint32_t>> segments;
+         for (uint32_t begin = 0; begin < count; begin += config::block_log_index_segment_size) {
+            uint32_t end = std::min<uint64_t>(uint64_t(begin) + config::block_log_index_segment_size, count);
+            segments.emplace_back(async_thread_pool(pool, [&first_invalid, begin, end]() { return first_invalid(begin, end); }));
+         }
+         uint32_t valid = count;
+         for (auto& segment : segments)
+            valid = std::min(valid, segment.get());
+         return valid;
+      }
+   }
 
-            inline void check_index_write() {
-               if (!index_write) {
-                  index_stream.close();
-                  index_stream.open(index_file.generic_string().c_str(), LOG_WRITE);
-                  index_write = true;
-               }
-            }
-      };
+   signed_block packed_block_view::unpack()const {
+      fc::datastream<const char*> ds(_data, _size);
+      signed_block b;
+      fc::raw::unpack(ds, b);
+      return b;
+   }
+
+   packed_block_view block_range::view(uint32_t block_num)const {
+      FC_ASSERT(block_num >= _first && block_num <= _last, "Block is not in the range.",
+                ("block_num", block_num)("first", _first)("last", _last));
+      packed_block_view v;
+      v._file = _blocks;
+      v._block_num = block_num;
+      v._pos = _index->read_pos(sizeof(uint64_t) * (block_num - 1));
+      // every block is followed by its position, so a block ends 8 bytes before the next one starts
+      uint64_t end = (uint64_t(block_num) * sizeof(uint64_t) < _index->size) ? _index->read_pos(sizeof(uint64_t) * block_num)
+                                                                                : _blocks->size;
+      FC_ASSERT(v._pos + sizeof(uint64_t) <= end && end <= _blocks->size, "Block log index is inconsistent with the log.",
+                ("block_num", block_num)("pos", v._pos)("end", end));
+      v._data = _blocks->data() + v._pos;
+      v._size = end - sizeof(uint64_t) - v._pos;
+      return v;
    }
 
    block_log::block_log(const fc::path& data_dir)
@@ -83,6 +203,8 @@ namespace eosio { namespace chain {
          my->block_stream.close();
       if (my->index_stream.is_open())
          my->index_stream.close();
+      my->block_map.reset();
+      my->index_map.reset();
 
       if (!fc::is_directory(data_dir))
          fc::create_directories(data_dir);
@@ -92,8 +214,6 @@ namespace eosio { namespace chain {
       //ilog("Opening block log at ${path}", ("path", my->block_file.generic_string()));
       my->block_stream.open(my->block_file.generic_string().c_str(), LOG_WRITE);
       my->index_stream.open(my->index_file.generic_string().c_str(), LOG_WRITE);
-      my->block_write = true;
-      my->index_write = true;
 
       /* On startup of the block log, there are several states the log file and the index file can be
        * in relation to each other.
@@ -115,6 +235,8 @@ namespace eosio { namespace chain {
        */
       auto log_size = fc::file_size(my->block_file);
       auto index_size = fc::file_size(my->index_file);
+      my->block_file_size = log_size;
+      my->index_file_size = index_size;
 
       if (log_size) {
          ilog("Log is nonempty");
@@ -122,17 +244,10 @@ namespace eosio { namespace chain {
          my->head_id = my->head->id();
 
          if (index_size) {
-            my->check_block_read();
-            my->check_index_read();
-
             ilog("Index is nonempty");
-            uint64_t block_pos;
-            my->block_stream.seekg(-sizeof(uint64_t), std::ios::end);
-            my->block_stream.read((char*)&block_pos, sizeof(block_pos));
-
-            uint64_t index_pos;
-            my->index_stream.seekg(-sizeof(uint64_t), std::ios::end);
-            my->index_stream.read((char*)&index_pos, sizeof(index_pos));
+            auto maps = my->map_files();
+            uint64_t block_pos = maps.first->read_pos(maps.first->size - sizeof(uint64_t));
+            uint64_t index_pos = maps.second->read_pos(maps.second->size - sizeof(uint64_t));
 
             if (block_pos < index_pos) {
                ilog("block_pos < index_pos, close and reopen index_stream");
@@ -147,27 +262,25 @@ namespace eosio { namespace chain {
          }
       } else if (index_size) {
          ilog("Index is nonempty, remove and recreate it");
-         my->index_stream.close();
-         fc::remove_all(my->index_file);
-         my->index_stream.open(my->index_file.generic_string().c_str(), LOG_WRITE);
-         my->index_write = true;
+         my->truncate_index(0);
       }
    }
 
    uint64_t block_log::append(const signed_block& b) {
       try {
-         my->check_block_write();
-         my->check_index_write();
+         std::lock_guard<std::mutex> lock(my->mutex);
 
-         uint64_t pos = my->block_stream.tellp();
-         FC_ASSERT(my->index_stream.tellp() == sizeof(uint64_t) * (b.block_num() - 1),
+         uint64_t pos = my->block_file_size;
+         FC_ASSERT(my->index_file_size == sizeof(uint64_t) * (b.block_num() - 1),
                    "Append to index file occuring at wrong position.",
-                   ("position", (uint64_t) my->index_stream.tellp())
+                   ("position", my->index_file_size)
                    ("expected", (b.block_num() - 1) * sizeof(uint64_t)));
          auto data = fc::raw::pack(b);
          my->block_stream.write(data.data(), data.size());
          my->block_stream.write((char*)&pos, sizeof(pos));
          my->index_stream.write((char*)&pos, sizeof(pos));
+         my->block_file_size += data.size() + sizeof(pos);
+         my->index_file_size += sizeof(pos);
          my->head = b;
          my->head_id = b.id();
 
@@ -177,26 +290,28 @@ namespace eosio { namespace chain {
    }
 
    void block_log::flush() {
+      std::lock_guard<std::mutex> lock(my->mutex);
       my->block_stream.flush();
       my->index_stream.flush();
    }
 
    std::pair<signed_block, uint64_t> block_log::read_block(uint64_t pos)const {
-      my->check_block_read();
+      auto block_map = my->map_files().first;
+      FC_ASSERT(pos < block_map->size, "Read past the end of the block log.", ("pos", pos)("size", block_map->size));
 
-      my->block_stream.seekg(pos);
+      fc::datastream<const char*> ds(block_map->data() + pos, block_map->size - pos);
       std::pair<signed_block,uint64_t> result;
-      fc::raw::unpack(my->block_stream, result.first);
-      result.second = uint64_t(my->block_stream.tellg()) + 8;
+      fc::raw::unpack(ds, result.first);
+      result.second = pos + ds.tellp() + 8;
       return result;
    }
 
    optional<signed_block> block_log::read_block_by_num(uint32_t block_num)const {
       try {
          optional<signed_block> b;
-         uint64_t pos = get_block_pos(block_num);
-         if (pos != npos) {
-            b = read_block(pos).first;
+         auto packed = read_packed_block_by_num(block_num);
+         if (packed) {
+            b = packed->unpack();
             FC_ASSERT(b->block_num() == block_num,
                       "Wrong block was read from block log.", ("returned", b->block_num())("expected", block_num));
          }
@@ -204,57 +319,92 @@ namespace eosio { namespace chain {
       } FC_LOG_AND_RETHROW()
    }
 
-   uint64_t block_log::get_block_pos(uint32_t block_num) const {
-      my->check_index_read();
+   optional<packed_block_view> block_log::read_packed_block_by_num(uint32_t block_num)const {
+      auto range = read_block_range(block_num, block_num);
+      if (range.empty())
+         return optional<packed_block_view>();
+      return range.view(block_num);
+   }
 
-      if (!(my->head.valid() && block_num <= block_header::num_from_id(my->head_id) && block_num > 0))
-         return npos;
-      my->index_stream.seekg(sizeof(uint64_t) * (block_num - 1));
-      uint64_t pos;
-      my->index_stream.read((char*)&pos, sizeof(pos));
-      return pos;
+   block_range block_log::read_block_range(uint32_t first, uint32_t last)const {
+      block_range range;
+      auto maps = my->map_files(uint64_t(last) * sizeof(uint64_t));
+      range._blocks = maps.first;
+      range._index = maps.second;
+      range._first = std::max<uint32_t>(first, 1);
+      range._last = std::min<uint64_t>(last, maps.second->size / sizeof(uint64_t));
+      return range;
    }
 
-   optional<signed_block> block_log::read_head()const {
-      my->check_block_read();
+   uint64_t block_log::get_block_pos(uint32_t block_num) const {
+      {
+         std::lock_guard<std::mutex> lock(my->mutex);
+         if (!(my->head.valid() && block_num <= block_header::num_from_id(my->head_id) && block_num > 0))
+            return npos;
+      }
+      return my->map_files(sizeof(uint64_t) * block_num).second->read_pos(sizeof(uint64_t) * (block_num - 1));
+   }
 
+   optional<signed_block> block_log::read_head()const {
       uint64_t pos;
 
       // Check that the file is not empty
-      my->block_stream.seekg(0, std::ios::end);
-      if (my->block_stream.tellg() <= sizeof(pos))
+      auto block_map = my->map_files().first;
+      if (block_map->size <= sizeof(pos))
          return {};
 
-      my->block_stream.seekg(-sizeof(pos), std::ios::end);
-      my->block_stream.read((char*)&pos, sizeof(pos));
+      pos = block_map->read_pos(block_map->size - sizeof(pos));
       return read_block(pos).first;
    }
 
-   const optional<signed_block>& block_log::head()const {
+   optional<signed_block> block_log::head()const {
+      std::lock_guard<std::mutex> lock(my->mutex);
       return my->head;
    }
 
    void block_log::construct_index() {
       ilog("Reconstructing Block Log Index...");
-      my->index_stream.close();
-      fc::remove_all(my->index_file);
-      my->index_stream.open(my->index_file.generic_string().c_str(), LOG_WRITE);
-      my->index_write = true;
-
-      uint64_t pos = 0;
-      uint64_t end_pos;
-      my->check_block_read();
-
-      my->block_stream.seekg(-sizeof( uint64_t), std::ios::end);
-      my->block_stream.read((char*)&end_pos, sizeof(end_pos));
-      signed_block tmp;
+      auto maps = my->map_files();
+      const auto& blocks = *maps.first;
+      const auto& index = *maps.second;
+
+      const uint64_t head_pos = blocks.read_pos(blocks.size - sizeof(uint64_t));
+      const uint32_t head_num = my->head->block_num();
+
+      // the part of the index that still agrees with the log is kept, so an interrupted rebuild resumes where it stopped
+      const uint32_t valid = detail::valid_index_prefix(blocks, index, head_pos, std::min<uint64_t>(index.size / sizeof(uint64_t), head_num));
+      ilog("Keeping ${valid} of ${count} entries of the existing index", ("valid", valid)("count", index.size / sizeof(uint64_t)));
+
+      // walk back from the head block to the first missing one by following the trailing position words,
+      // which finds every position without unpacking a single block
+      vector<uint64_t> positions(head_num - valid);
+      uint64_t pos = head_pos;
+      for (uint32_t num = head_num; num > valid; --num) {
+         positions[num - valid - 1] = pos;
+         if (num > 1) {
+            FC_ASSERT(pos >= sizeof(uint64_t), "Block log is corrupt, block ${num} has no predecessor.", ("num", num));
+            pos = blocks.read_pos(pos - sizeof(uint64_t));
+         }
+      }
+      if (valid > 0) {
+         FC_ASSERT(pos == index.read_pos(sizeof(uint64_t) * (valid - 1)),
+                   "Block log does not link back to block ${num} of the index.", ("num", valid));
+      } else if (!positions.empty()) {
+         FC_ASSERT(positions.front() == 0, "Block log does not link back to its first block.");
+      }
 
-      my->block_stream.seekg(pos);
+      my->truncate_index(sizeof(uint64_t) * valid);
 
-      while (pos < end_pos) {
-         fc::raw::unpack(my->block_stream, tmp);
-         my->block_stream.read((char*)&pos, sizeof(pos));
-         my->index_stream.write((char*)&pos, sizeof(pos));
+      std::lock_guard<std::mutex> lock(my->mutex);
+      for (size_t i = 0; i < positions.size(); ++i) {
+         my->index_stream.write((char*)&positions[i], sizeof(uint64_t));
+         my->index_file_size += sizeof(uint64_t);
+         if ((i + 1) % config::block_log_index_checkpoint_interval == 0) {
+            // everything flushed so far is a valid prefix to resume from
+            my->index_stream.flush();
+            ilog("Reconstructed index up to block ${num} of ${head}", ("num", valid + i + 1)("head", head_num));
+         }
       }
+      my->index_stream.flush();
    }
 } }
@@ -40,6 +40,7 @@
 #include <fstream>
 #include <functional>
 #include <chrono>
+#include <atomic>
 
 namespace eosio { namespace chain {
 
@@ -56,10 +57,15 @@ chain_controller::chain_controller( const chain_controller::controller_config& c
       (cfg.read_only ? database::read_only : database::read_write),
       cfg.shared_memory_size),
  _block_log(cfg.block_log_dir),
- _wasm_interface(cfg.wasm_runtime),
+ _max_pending_shards(std::max<uint16_t>(cfg.max_pending_shards, 1)),
+ _wasm_interface(cfg.wasm_runtime, cfg.wasm_module_cache_size, cfg.wasm_jit_cache_dir, cfg.wasm_jit_cache_size, cfg.wasm_native_float),
+ _abi_serializer_cache(cfg.abi_serializer_cache_size),
  _limits(cfg.limits),
  _resource_limits(_db)
 {
+   if( cfg.thread_pool_size > 0 )
+      _thread_pool.emplace( cfg.thread_pool_size );
+
    _initialize_indexes();
    _resource_limits.initialize_database();
 
@@ -139,6 +145,16 @@ optional<signed_block> chain_controller::fetch_block_by_number(uint32_t num)cons
    return optional<signed_block>();
 }
 
+optional<packed_block_view> chain_controller::fetch_packed_block_by_number(uint32_t num)const
+{
+   return _block_log.read_packed_block_by_num(num);
+}
+
+block_range chain_controller::fetch_block_range(uint32_t first, uint32_t last)const
+{
+   return _block_log.read_block_range(first, last);
+}
+
 std::vector<block_id_type> chain_controller::get_block_ids_on_fork(block_id_type head_of_fork) const
 {
   pair<fork_database::branch_type, fork_database::branch_type> branches = _fork_db.fetch_branch_from(head_block_id(), head_of_fork);
@@ -167,10 +183,10 @@ std::vector<block_id_type> chain_controller::get_block_ids_on_fork(block_id_type
 void chain_controller::push_block(const signed_block& new_block, uint32_t skip)
 { try {
    with_skip_flags( skip, [&](){
-      return without_pending_transactions( [&]() {
-         return _db.with_write_lock( [&]() {
+      return _db.with_write_lock( [&]() {
+         return without_pending_transactions( [&]() {
             return _push_block(new_block);
-         } );
+         });
       });
    });
    ilog( "push block #${n} from ${pro} ${time}  ${id} lib: ${l} success", ("n",new_block.block_num())("pro",name(new_block.producer))("time",new_block.timestamp)("id",new_block.id())("l",last_irreversible_block_num()));
@@ -200,7 +216,7 @@ bool chain_controller::_push_block(const signed_block& new_block)
 
             // pop blocks until we hit the forked block
             while (head_block_id() != branches.second.back()->data.previous)
-               pop_block();
+               _pop_block();
 
             // push all blocks on the new fork
             for (auto ritr = branches.first.rbegin(); ritr != branches.first.rend(); ++ritr) {
@@ -235,7 +251,7 @@ bool chain_controller::_push_block(const signed_block& new_block)
 
                    // pop all blocks from the bad fork
                    while (head_block_id() != branches.second.back()->data.previous)
-                      pop_block();
+                      _pop_block();
 
                    // restore all blocks from the good fork
                    for (auto ritr = branches.second.rbegin(); ritr != branches.second.rend(); ++ritr) {
@@ -277,25 +293,94 @@ bool chain_controller::_push_block(const signed_block& new_block)
  */
 transaction_trace chain_controller::push_transaction(const packed_transaction& trx, uint32_t skip)
 { try {
-   // If this is the first transaction pushed after applying a block, start a new undo session.
-   // This allows us to quickly rewind to the clean state of the head block, in case a new block arrives.
-   if( !_pending_block ) {
-      _start_pending_block();
-   }
-
    return with_skip_flags(skip, [&]() {
       return _db.with_write_lock([&]() {
+         // If this is the first transaction pushed after applying a block, start a new undo session.
+         // This allows us to quickly rewind to the clean state of the head block, in case a new block arrives.
+         if( !_pending_block ) {
+            _start_pending_block();
+         }
+
          return _push_transaction(trx);
       });
    });
 } EOS_CAPTURE_AND_RETHROW( transaction_exception ) }
 
+void chain_controller::recover_signing_keys( const packed_transaction& trx ) {
+   if( !_thread_pool || trx.signatures.empty() )
+      return;
+
+   // keyed by the digest of everything that was signed and every signature, so that keys are only ever reused for
+   // the exact same bytes
+   auto digest = trx.packed_digest();
+   if( _pending_recoveries.count( digest ) )
+      return;
+
+   // the worker owns a copy of the transaction, the message it came from may be gone by the time it runs
+   _pending_recoveries.emplace( digest, async_thread_pool( *_thread_pool, [trx]() {
+      const transaction t = trx.get_transaction();
+      return recovered_signing_keys{ t.expiration, t.get_signature_keys( trx.signatures, chain_id_type(), trx.get_context_free_data(), false ) };
+   }).share());
+   _pending_recovery_order.push_back( digest );
+
+   // dropping the future does not wait for the task, which still owns its shared state and simply finishes unseen
+   while( _pending_recovery_order.size() > config::max_pending_signature_recoveries ) {
+      _pending_recoveries.erase( _pending_recovery_order.front() );
+      _pending_recovery_order.pop_front();
+   }
+}
+
+void chain_controller::recover_signing_keys( const signed_block& b ) {
+   for( const auto& trx : b.input_transactions )
+      recover_signing_keys( trx );
+}
+
+optional<flat_set<public_key_type>> chain_controller::_take_recovered_signing_keys( const digest_type& packed_digest ) {
+   auto itr = _pending_recoveries.find( packed_digest );
+   if( itr == _pending_recoveries.end() )
+      return optional<flat_set<public_key_type>>();
+
+   auto recovery = std::move( itr->second );
+   _pending_recoveries.erase( itr );
+
+   // a failed recovery is repeated inline so that its error is reported the usual way
+   try {
+      return recovery.get().keys;
+   } catch( ... ) {}
+   return optional<flat_set<public_key_type>>();
+}
+
+void chain_controller::_clear_expired_recoveries() {
+   const auto now = head_block_time();
+   for( auto itr = _pending_recoveries.begin(); itr != _pending_recoveries.end(); ) {
+      // recoveries still running are looked at again after a later block
+      bool expired = false;
+      if( itr->second.wait_for( std::chrono::seconds(0) ) == std::future_status::ready ) {
+         try {
+            expired = itr->second.get().expiration <= now;
+         } catch( ... ) {
+            expired = true;
+         }
+      }
+      itr = expired ? _pending_recoveries.erase( itr ) : std::next( itr );
+   }
+}
+
 transaction_trace chain_controller::_push_transaction(const packed_transaction& packed_trx)
 { try {
    //edump((transaction_header(packed_trx.get_transaction())));
    auto start = fc::time_point::now();
+   // the recovery started for the transaction is taken out whether or not the transaction is accepted
+   optional<flat_set<public_key_type>> recovered_keys;
+   if( !_pending_recoveries.empty() ) {
+      if( should_check_signatures() )
+         recovered_keys = _take_recovered_signing_keys( packed_trx.packed_digest() );
+      else
+         _pending_recoveries.erase( packed_trx.packed_digest() );
+   }
    transaction_metadata   mtrx( packed_trx, get_chain_id(), head_block_time());
    //idump((transaction_header(mtrx.trx())));
+   mtrx.signing_keys = std::move( recovered_keys );
 
    const transaction& trx = mtrx.trx();
    mtrx.delay =  fc::seconds(trx.delay_sec);
@@ -305,7 +390,8 @@ transaction_trace chain_controller::_push_transaction(const packed_transaction&
    validate_referenced_accounts(trx);
    validate_uniqueness(trx);
    if( should_check_authorization() ) {
-      auto enforced_delay = check_transaction_authorization(trx, packed_trx.signatures, mtrx.context_free_data);
+      auto enforced_delay = mtrx.signing_keys ? check_authorization( trx.actions, *mtrx.signing_keys )
+                                              : check_transaction_authorization( trx, packed_trx.signatures, mtrx.context_free_data );
       auto max_delay = fc::seconds( get_global_properties().configuration.max_transaction_delay );
       if ( max_delay < enforced_delay ) {
          enforced_delay = max_delay;
@@ -353,7 +439,7 @@ transaction_trace chain_controller::_push_transaction( transaction_metadata&& da
       /// TODO: move _pending_cycle into db so that it can be undone if transation fails, for now we will apply
       /// the transaction first so that there is nothing to undo... this only works because things are currently
       /// single threaded
-      // set cycle, shard, region etc
+      // set cycle, region etc, the shard is chosen from the locks the transaction used once it has been applied
       meta.region_id = 0;
       meta.cycle_index = cyclenum;
       meta.shard_index = 0;
@@ -517,6 +603,9 @@ void chain_controller::_start_pending_cycle() {
    _pending_cycle_trace = cycle_trace();
 
    _pending_cycle_trace->shard_traces.resize(_pending_cycle_trace->shard_traces.size() + 1 );
+   _pending_shard_schedule.clear();
+   _pending_shard_schedule.resize(_pending_cycle_trace->shard_traces.size());
+   _pending_cycle_sequence = 0;
 
    auto& bcycle = _pending_block->regions.back().cycles_summary.back();
    if(bcycle.empty() || !bcycle.back().empty())
@@ -555,6 +644,191 @@ void chain_controller::_finalize_pending_cycle()
    _apply_cycle_trace(*_pending_cycle_trace);
    _pending_block_trace->region_traces.back().cycle_traces.emplace_back(std::move(*_pending_cycle_trace));
    _pending_cycle_trace.reset();
+   _pending_shard_schedule.clear();
+}
+
+static bool locks_intersect( const flat_set<shard_lock>& a, const flat_set<shard_lock>& b ) {
+   auto ai = a.begin();
+   auto bi = b.begin();
+   while( ai != a.end() && bi != b.end() ) {
+      if( *ai < *bi )      ++ai;
+      else if( *bi < *ai ) ++bi;
+      else                 return true;
+   }
+   return false;
+}
+
+/**
+ *  Chooses the shard of the pending cycle for a transaction that has just been applied.
+ *
+ *  Transactions are applied one at a time, so a transaction may only be placed in a shard other than
+ *  the one holding the transactions it conflicts with if a validator can run the shards of the cycle
+ *  in any order and reach the same state. A transaction that conflicts with no shard starts a new
+ *  one, a transaction that conflicts with exactly one shard joins it, and a transaction that links
+ *  several shards together merges them in the order their transactions were applied.
+ */
+uint32_t chain_controller::_schedule_pending_transaction( transaction_trace& trace, const transaction_metadata& meta )
+{
+   {
+      // only fills in the trace's own locks, the shard's locks are updated once the shard is known
+      flat_set<shard_lock> read_locks, write_locks;
+      record_locks_for_data_access(trace, read_locks, write_locks);
+   }
+
+   pending_shard_schedule locks;
+   locks.write_locks = trace.write_locks;
+   locks.read_locks  = trace.read_locks;
+
+   // deferred and delayed transactions, and actions that send or cancel deferred transactions, create and destroy
+   // generated transactions
+   if( meta.sender || meta.delay.count() > 0 || !trace.deferred_transaction_requests.empty() ) {
+      locks.write_locks.emplace(shard_lock{config::system_account_name, N(eosio.gentrx)});
+   }
+
+   // cpu, net and ram usage are added to each account and checked against its limits as every transaction is applied,
+   // so transactions that bill the same account must stay in the order they were applied in. Billed are the
+   // authorizers, the payers of generated transactions and the payers of rows, whose scopes are always write locked
+   flat_set<account_name> billed_accounts;
+   for( const auto& act : meta.trx().actions )
+      for( const auto& auth : act.authorization )
+         billed_accounts.insert( auth.actor );
+   for( const auto& l : trace.write_locks )
+      billed_accounts.insert( l.scope );
+   if( meta.sender )
+      billed_accounts.insert( meta.payer );
+   for( const auto& req : trace.deferred_transaction_requests ) {
+      if( req.contains<deferred_transaction>() )
+         billed_accounts.insert( req.get<deferred_transaction>().payer );
+   }
+   for( const auto& a : billed_accounts ) {
+      locks.write_locks.emplace(shard_lock{a, config::eosio_resource_scope});
+   }
+   // every transaction has its authorization checked against the permissions, which are written under this lock
+   const shard_lock auth_lock{config::system_account_name, config::eosio_auth_scope};
+   if( locks.write_locks.find(auth_lock) == locks.write_locks.end() ) {
+      locks.read_locks.emplace(auth_lock);
+   }
+
+   vector<uint32_t> conflicts;
+   for( uint32_t idx = 0; idx < _pending_shard_schedule.size(); ++idx ) {
+      const auto& shard = _pending_shard_schedule[idx];
+      if( locks_intersect(locks.write_locks, shard.write_locks) ||
+          locks_intersect(locks.write_locks, shard.read_locks)  ||
+          locks_intersect(locks.read_locks,  shard.write_locks) ) {
+         conflicts.push_back(idx);
+      }
+   }
+
+   uint32_t shard_index = 0;
+   if( conflicts.empty() ) {
+      auto least_loaded = _pending_shard_schedule.begin();
+      for( auto itr = _pending_shard_schedule.begin(); itr != _pending_shard_schedule.end(); ++itr ) {
+         if( itr->sequence.size() < least_loaded->sequence.size() )
+            least_loaded = itr;
+      }
+
+      if( least_loaded->sequence.empty() || _pending_shard_schedule.size() >= _max_pending_shards ) {
+         shard_index = least_loaded - _pending_shard_schedule.begin();
+      } else {
+         shard_index = _pending_shard_schedule.size();
+         _pending_shard_schedule.resize(shard_index + 1);
+         _pending_cycle_trace->shard_traces.resize(shard_index + 1);
+         _pending_block->regions.back().cycles_summary.back().resize(shard_index + 1);
+      }
+   } else {
+      shard_index = conflicts.front();
+      // merge from the back so the indices of the remaining shards to merge stay valid
+      for( auto itr = conflicts.rbegin(); *itr != shard_index; ++itr ) {
+         _merge_pending_shards(shard_index, *itr);
+      }
+   }
+
+   auto& shard = _pending_shard_schedule[shard_index];
+   for( const auto& l : locks.write_locks ) {
+      shard.read_locks.erase(l);
+   }
+   for( const auto& l : locks.read_locks ) {
+      if( shard.write_locks.find(l) == shard.write_locks.end() )
+         shard.read_locks.insert(l);
+   }
+   shard.write_locks.insert(locks.write_locks.begin(), locks.write_locks.end());
+   shard.sequence.push_back(_pending_cycle_sequence++);
+
+   return shard_index;
+}
+
+/**
+ *  Moves the transactions of shard `from` into shard `into`, interleaving them in the order they were
+ *  applied, and removes shard `from` from the pending cycle.
+ */
+void chain_controller::_merge_pending_shards( uint32_t into, uint32_t from )
+{
+   FC_ASSERT( into < from && from < _pending_shard_schedule.size(), "invalid shards to merge" );
+
+   auto& bcycle = _pending_block->regions.back().cycles_summary.back();
+   auto& traces = _pending_cycle_trace->shard_traces;
+
+   auto& dst_schedule = _pending_shard_schedule[into];
+   auto& src_schedule = _pending_shard_schedule[from];
+   auto& dst_trace    = traces[into];
+   auto& src_trace    = traces[from];
+   auto& dst_summary  = bcycle[into];
+   auto& src_summary  = bcycle[from];
+
+   vector<uint32_t>            sequence;
+   vector<transaction_trace>   transaction_traces;
+   vector<transaction_receipt> receipts;
+   const auto total = dst_schedule.sequence.size() + src_schedule.sequence.size();
+   sequence.reserve(total);
+   transaction_traces.reserve(total);
+   receipts.reserve(total);
+
+   size_t d = 0, s = 0;
+   while( d < dst_schedule.sequence.size() || s < src_schedule.sequence.size() ) {
+      bool take_dst = s == src_schedule.sequence.size() ||
+                      (d < dst_schedule.sequence.size() && dst_schedule.sequence[d] < src_schedule.sequence[s]);
+      if( take_dst ) {
+         sequence.push_back(dst_schedule.sequence[d]);
+         transaction_traces.emplace_back(move(dst_trace.transaction_traces[d]));
+         receipts.emplace_back(move(dst_summary.transactions[d]));
+         ++d;
+      } else {
+         sequence.push_back(src_schedule.sequence[s]);
+         transaction_traces.emplace_back(move(src_trace.transaction_traces[s]));
+         receipts.emplace_back(move(src_summary.transactions[s]));
+         ++s;
+      }
+      transaction_traces.back().shard_index = into;
+   }
+
+   dst_schedule.sequence = move(sequence);
+   dst_trace.transaction_traces = move(transaction_traces);
+   dst_summary.transactions = move(receipts);
+
+   // shards that are merged do not conflict, so their locks stay disjoint
+   dst_schedule.read_locks.insert(src_schedule.read_locks.begin(), src_schedule.read_locks.end());
+   dst_schedule.write_locks.insert(src_schedule.write_locks.begin(), src_schedule.write_locks.end());
+   dst_trace.read_locks.insert(src_trace.read_locks.begin(), src_trace.read_locks.end());
+   dst_trace.write_locks.insert(src_trace.write_locks.begin(), src_trace.write_locks.end());
+
+   _pending_shard_schedule.erase(_pending_shard_schedule.begin() + from);
+   traces.erase(traces.begin() + from);
+   bcycle.erase(bcycle.begin() + from);
+
+   for( uint32_t idx = from; idx < traces.size(); ++idx ) {
+      for( auto& t : traces[idx].transaction_traces ) {
+         t.shard_index = idx;
+      }
+   }
+
+   // so do the metadata of the pending cycle's transactions, which are the last ones pushed
+   const uint32_t cycle_index = _pending_block->regions.back().cycles_summary.size() - 1;
+   for( auto itr = _pending_transaction_metas.rbegin(); itr != _pending_transaction_metas.rend() && itr->cycle_index == cycle_index; ++itr ) {
+      if( itr->shard_index == from )
+         itr->shard_index = into;
+      else if( itr->shard_index > from )
+         --itr->shard_index;
+   }
 }
 
 void chain_controller::_apply_cycle_trace( const cycle_trace& res )
@@ -615,6 +889,7 @@ void chain_controller::_finalize_block( const block_trace& trace, const producer
 
    create_block_summary(b);
    clear_expired_transactions();
+   _clear_expired_recoveries();
 
    update_last_irreversible_block();
    _resource_limits.process_account_limit_updates();
@@ -697,14 +972,14 @@ signed_block chain_controller::_generate_block( block_timestamp_type when,
 
       auto result = move( *_pending_block );
 
-      clear_pending();
+      _clear_pending();
 
       if (!(skip&skip_fork_db)) {
          _fork_db.push_block(result);
       }
       return result;
    } catch ( ... ) {
-      clear_pending();
+      _clear_pending();
 
       elog( "error while producing block" );
       _start_pending_block();
@@ -718,7 +993,14 @@ signed_block chain_controller::_generate_block( block_timestamp_type when,
  */
 void chain_controller::pop_block()
 { try {
-   clear_pending();
+   _db.with_write_lock( [&]() {
+      _pop_block();
+   });
+} FC_CAPTURE_AND_RETHROW() }
+
+void chain_controller::_pop_block()
+{ try {
+   _clear_pending();
    auto head_id = head_block_id();
    optional<signed_block> head_block = fetch_block_by_id( head_id );
 
@@ -730,16 +1012,24 @@ void chain_controller::pop_block()
 } FC_CAPTURE_AND_RETHROW() }
 
 void chain_controller::clear_pending()
+{ try {
+   _db.with_write_lock( [&]() {
+      _clear_pending();
+   });
+} FC_CAPTURE_AND_RETHROW() }
+
+void chain_controller::_clear_pending()
 { try {
    _pending_block_trace.reset();
    _pending_block.reset();
    _pending_block_session.reset();
    _pending_transaction_metas.clear();
+   _pending_shard_schedule.clear();
 } FC_CAPTURE_AND_RETHROW() }
 
 //////////////////// private methods ////////////////////
 
-void chain_controller::_apply_block(const signed_block& next_block, uint32_t skip)
+void chain_controller::_apply_block(const signed_block& next_block, uint32_t skip, vector<transaction_metadata>* prepared_input_metas)
 {
    auto block_num = next_block.block_num();
    if (_checkpoints.size() && _checkpoints.rbegin()->second != block_id_type()) {
@@ -754,7 +1044,7 @@ void chain_controller::_apply_block(const signed_block& next_block, uint32_t ski
 
    with_applying_block([&] {
       with_skip_flags(skip, [&] {
-         __apply_block(next_block);
+         __apply_block(next_block, prepared_input_metas);
       });
    });
 }
@@ -771,7 +1061,7 @@ static void validate_shard_locks(const vector<shard_lock>& locks, const string&
    }
 }
 
-void chain_controller::__apply_block(const signed_block& next_block)
+void chain_controller::__apply_block(const signed_block& next_block, vector<transaction_metadata>* prepared_input_metas)
 { try {
    optional<fc::time_point> processing_deadline;
    if (!_currently_replaying_blocks && _limits.max_push_block_us.count() > 0) {
@@ -802,14 +1092,55 @@ void chain_controller::__apply_block(const signed_block& next_block)
       input_metas.emplace_back(packed_transaction(t), get_chain_id(), head_block_time(), processing_deadline, true /*implicit*/);
    }
 
+   /// unpacking, hashing and signature recovery of the input transactions does not touch the database, so it is
+   /// spread across the thread pool; the results are consumed in block order so the traces are unaffected
+   const bool check_signatures = should_check_signatures();
+   const bool inputs_prepared = prepared_input_metas && prepared_input_metas->size() == next_block.input_transactions.size();
+   auto prepare_input = [&next_block, &processing_deadline]( const packed_transaction& t, bool recover_keys ) {
+      transaction_metadata mtrx( t, chain_id_type(), next_block.timestamp, processing_deadline );
+      if( recover_keys ) {
+         mtrx.signing_keys = mtrx.trx().get_signature_keys( t.signatures, chain_id_type(), mtrx.context_free_data, false );
+      }
+      return mtrx;
+   };
+
+   // transactions whose keys are already being recovered (see recover_signing_keys) pick them up in block order below
+   vector<optional<digest_type>> recovery_started( next_block.input_transactions.size() );
+   for( size_t i = 0; check_signatures && !_pending_recoveries.empty() && i < next_block.input_transactions.size(); ++i ) {
+      auto digest = next_block.input_transactions[i].packed_digest();
+      if( _pending_recoveries.count( digest ) )
+         recovery_started[i] = digest;
+   }
+
+   vector<std::future<transaction_metadata>> prepared_inputs;
+   auto wait_for_prepared_inputs = fc::make_scoped_exit( [&prepared_inputs]() {
+      // outstanding tasks reference this frame, make sure they are finished before it unwinds
+      for( auto& f : prepared_inputs )
+         if( f.valid() ) f.wait();
+   });
+   if( _thread_pool && !inputs_prepared && next_block.input_transactions.size() > 1 ) {
+      prepared_inputs.reserve( next_block.input_transactions.size() );
+      for( const auto& t : next_block.input_transactions ) {
+         const bool recover_keys = check_signatures && !recovery_started[prepared_inputs.size()];
+         prepared_inputs.emplace_back( async_thread_pool( *_thread_pool, [&prepare_input, &t, recover_keys]() { return prepare_input( t, recover_keys ); } ) );
+      }
+   }
+
    map<transaction_id_type,size_t> trx_index;
-   for( const auto& t : next_block.input_transactions ) {
-      input_metas.emplace_back(t, chain_id_type(), next_block.timestamp, processing_deadline);
-      validate_transaction_with_minimal_state( input_metas.back().trx(), input_metas.back().billable_packed_size );
-      if( should_check_signatures() ) {
-         input_metas.back().signing_keys = input_metas.back().trx().get_signature_keys( t.signatures, chain_id_type(),
-                                                                                        input_metas.back().context_free_data, false );
+   for( size_t i = 0; i < next_block.input_transactions.size(); ++i ) {
+      if( inputs_prepared ) {
+         input_metas.emplace_back( std::move( (*prepared_input_metas)[i] ) );
+      } else if( prepared_inputs.size() ) {
+         input_metas.emplace_back( prepared_inputs[i].get() );
+      } else {
+         input_metas.emplace_back( prepare_input( next_block.input_transactions[i], check_signatures && !recovery_started[i] ) );
       }
+      auto& mtrx = input_metas.back();
+      if( recovery_started[i] )
+         mtrx.signing_keys = _take_recovered_signing_keys( *recovery_started[i] );
+      if( check_signatures && !mtrx.signing_keys )
+         mtrx.signing_keys = mtrx.trx().get_signature_keys( next_block.input_transactions[i].signatures, chain_id_type(), mtrx.context_free_data, false );
+      validate_transaction_with_minimal_state( input_metas.back().trx(), input_metas.back().billable_packed_size );
       trx_index[input_metas.back().id] =  input_metas.size() - 1;
    }
 
@@ -896,6 +1227,7 @@ void chain_controller::__apply_block(const signed_block& next_block)
                         validate_not_expired( trx );
                         validate_uniqueness( trx );
                         _temp.emplace(trx, gtrx->published, trx.sender, trx.sender_id, gtrx->packed_trx.data(), gtrx->packed_trx.size(), processing_deadline );
+                        _temp->payer = trx.payer;
                         _destroy_generated_transaction(*gtrx);
                         return &*_temp;
                      } else {
@@ -1782,21 +2114,81 @@ void chain_controller::replay() {
 
    const auto last_block_num = last_block->block_num();
 
+   /// a block read from the log together with its unpacked input transactions
+   struct replay_block {
+      signed_block                  block;
+      vector<transaction_metadata>  input_metas;
+   };
+
+   // reading, unpacking and hashing the blocks and their transactions is done by the thread pool ahead of
+   // the block being applied, up to config::replay_pipeline_depth blocks ahead
+   std::atomic<int64_t> prepare_us(0);
+   auto prepare = [&prepare_us]( const packed_block_view& view ) {
+      auto prepare_start = fc::time_point::now();
+      replay_block r;
+      r.block = view.unpack();
+      r.input_metas.reserve( r.block.input_transactions.size() );
+      for( const auto& t : r.block.input_transactions )
+         r.input_metas.emplace_back( t, chain_id_type(), r.block.timestamp );
+      prepare_us += (fc::time_point::now() - prepare_start).count();
+      return r;
+   };
+
+   auto blocks = _block_log.read_block_range(1, last_block_num);
+   auto next = blocks.begin();
+   std::deque<std::future<replay_block>> pipeline;
+   auto wait_for_pipeline = fc::make_scoped_exit( [&pipeline]() {
+      // outstanding tasks reference this frame, make sure they are finished before it unwinds
+      for( auto& f : pipeline )
+         if( f.valid() ) f.wait();
+   });
+
+   int64_t wait_us = 0;
+   int64_t apply_us = 0;
+   auto report = [&]( uint32_t block_num ) {
+      auto elapsed = fc::time_point::now() - start;
+      ilog("Replayed ${n} of ${last} blocks (${p}%), ${bps} blocks/s, prepare ${prepare} ms, wait ${wait} ms, apply ${apply} ms",
+           ("n", block_num)("last", last_block_num)("p", block_num * 100 / last_block_num)
+           ("bps", elapsed.count() > 0 ? uint64_t(block_num) * 1000000 / elapsed.count() : 0)
+           ("prepare", prepare_us.load() / 1000)("wait", wait_us / 1000)("apply", apply_us / 1000));
+   };
+
    ilog("Replaying ${n} blocks...", ("n", last_block_num) );
    for (uint32_t i = 1; i <= last_block_num; ++i) {
-      if (i % 5000 == 0)
-         std::cerr << "   " << double(i*100)/last_block_num << "%   "<<i << " of " <<last_block_num<<"   \n";
-      fc::optional<signed_block> block = _block_log.read_block_by_num(i);
-      FC_ASSERT(block, "Could not find block #${n} in block_log!", ("n", i));
-      _apply_block(*block, skip_producer_signature |
-                          skip_transaction_signatures |
-                          skip_transaction_dupe_check |
-                          skip_tapos_check |
-                          skip_producer_schedule_check |
-                          skip_authority_check |
-                          received_block);
+      replay_block r;
+      if (_thread_pool) {
+         while (pipeline.size() < config::replay_pipeline_depth && next != blocks.end()) {
+            auto view = *next;
+            pipeline.emplace_back( async_thread_pool( *_thread_pool, [&prepare, view]() { return prepare( view ); } ) );
+            ++next;
+         }
+         FC_ASSERT(!pipeline.empty(), "Could not find block #${n} in block_log!", ("n", i));
+         auto wait_start = fc::time_point::now();
+         r = pipeline.front().get();
+         pipeline.pop_front();
+         wait_us += (fc::time_point::now() - wait_start).count();
+      } else {
+         FC_ASSERT(i <= blocks.size(), "Could not find block #${n} in block_log!", ("n", i));
+         r = prepare( blocks.view(i) );
+      }
+      FC_ASSERT(r.block.block_num() == i, "Wrong block was read from block log.", ("returned", r.block.block_num())("expected", i));
+
+      auto apply_start = fc::time_point::now();
+      _apply_block(r.block, skip_producer_signature |
+                            skip_transaction_signatures |
+                            skip_transaction_dupe_check |
+                            skip_tapos_check |
+                            skip_producer_schedule_check |
+                            skip_authority_check |
+                            received_block,
+                   &r.input_metas);
+      apply_us += (fc::time_point::now() - apply_start).count();
+
+      if (i % config::replay_report_interval == 0)
+         report(i);
    }
    auto end = fc::time_point::now();
+   report(last_block_num);
    ilog("Done replaying ${n} blocks, elapsed time: ${t} sec",
         ("n", head_block_num())("t",double((end-start).count())/1000000.0));
 
@@ -2229,12 +2621,12 @@ void chain_controller::_create_generated_transaction( const deferred_transaction
 
 vector<transaction_trace> chain_controller::push_deferred_transactions( bool flush, uint32_t skip )
 { try {
-   if( !_pending_block ) {
-      _start_pending_block( true );
-   }
-
    return with_skip_flags(skip, [&]() {
       return _db.with_write_lock([&]() {
+         if( !_pending_block ) {
+            _start_pending_block( true );
+         }
+
          return _push_deferred_transactions( flush );
       });
    });
@@ -2288,6 +2680,7 @@ vector<transaction_trace> chain_controller::_push_deferred_transactions( bool fl
          try {
             auto trx = fc::raw::unpack<deferred_transaction>(trx_p->packed_trx.data(), trx_p->packed_trx.size());
             transaction_metadata mtrx (trx, trx_p->published, trx.sender, trx.sender_id, trx_p->packed_trx.data(), trx_p->packed_trx.size(), processing_deadline);
+            mtrx.payer = trx.payer;
             res.push_back( _push_transaction(std::move(mtrx)) );
          } FC_CAPTURE_AND_LOG((trx_p->trx_id)(trx_p->sender));
       }
@@ -2337,9 +2730,10 @@ transaction_trace chain_controller::wrap_transaction_processing( transaction_met
    auto result = trx_processing(data);
    _resource_limits.synchronize_account_ram_usage();
 
+   const auto shard_index = _schedule_pending_transaction(result, data);
    auto& bcycle = _pending_block->regions.back().cycles_summary.back();
-   auto& bshard = bcycle.front();
-   auto& bshard_trace = _pending_cycle_trace->shard_traces.at(0);
+   auto& bshard = bcycle.at(shard_index);
+   auto& bshard_trace = _pending_cycle_trace->shard_traces.at(shard_index);
 
    record_locks_for_data_access(result, bshard_trace.read_locks, bshard_trace.write_locks);
 
@@ -2351,7 +2745,8 @@ transaction_trace chain_controller::wrap_transaction_processing( transaction_met
 
    result.region_id   = 0; // Currently we only support region 0.
    result.cycle_index = _pending_block->regions.back().cycles_summary.size() - 1;
-   result.shard_index = 0; // Currently we only have one shard per cycle.
+   result.shard_index = shard_index;
+   data.shard_index   = shard_index;
 
    bshard_trace.append(result);
 
@@ -0,0 +1,135 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+#include <eosio/chain/checktime_timer.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace eosio { namespace chain {
+
+   namespace {
+      const int64_t no_deadline = std::numeric_limits<int64_t>::max();
+
+      uint64_t encode_deadline(int64_t deadline_us, bool expired) {
+         return (uint64_t(std::max<int64_t>(deadline_us, 0)) << 1) | (expired ? 1 : 0);
+      }
+   }
+
+   /**
+    *  The one thread that expires the timers of all threads. It sleeps until the earliest deadline of the
+    *  timers that have not expired yet. Arming a timer only takes its mutex when the new deadline is earlier
+    *  than the one the thread sleeps until, or while the thread is looking at the timers.
+    *
+    *  Every timer keeps the watchdog alive, so the thread is joined only once the last timer is gone, whichever
+    *  thread destroys it.
+    */
+   class checktime_watchdog {
+      public:
+         static std::shared_ptr<checktime_watchdog> instance() {
+            static std::shared_ptr<checktime_watchdog> watchdog(new checktime_watchdog());
+            return watchdog;
+         }
+
+         ~checktime_watchdog() {
+            {
+               std::lock_guard<std::mutex> lock(_mutex);
+               _done = true;
+            }
+            _wakeup.notify_one();
+            _thread.join();
+         }
+
+         void add(checktime_timer* timer) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _timers.insert(timer);
+         }
+
+         void remove(checktime_timer* timer) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _timers.erase(timer);
+         }
+
+         /// called once a timer holds its new deadline
+         void armed(int64_t deadline_us) {
+            if (deadline_us < _next_wakeup.load()) {
+               std::lock_guard<std::mutex> lock(_mutex);
+               _wakeup.notify_one();
+            }
+         }
+
+      private:
+         checktime_watchdog()
+         :_thread([this]() { run(); })
+         {}
+
+         void run() {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (!_done) {
+               // a timer armed while the timers are looked at waits for the mutex and wakes the thread up again
+               _next_wakeup.store(no_deadline);
+
+               auto now = fc::time_point::now().time_since_epoch().count();
+               int64_t next = no_deadline;
+               for (auto* timer : _timers) {
+                  uint64_t state = timer->_state.load();
+                  if (state & 1)
+                     continue;
+                  int64_t deadline = int64_t(state >> 1);
+                  // only expires the deadline that was seen, a timer armed again meanwhile keeps its new one
+                  if (now > deadline)
+                     timer->_state.compare_exchange_strong(state, state | 1);
+                  else if (deadline < next)
+                     next = deadline;
+               }
+               _next_wakeup.store(next);
+
+               if (next == no_deadline) {
+                  _wakeup.wait(lock);
+               } else {
+                  // one microsecond past the deadline, as a timer only expires once the clock is beyond it
+                  std::chrono::system_clock::time_point wake_time(std::chrono::microseconds(next + 1));
+                  _wakeup.wait_until(lock, wake_time);
+               }
+            }
+         }
+
+         std::mutex                  _mutex;
+         std::condition_variable     _wakeup;
+         std::set<checktime_timer*>  _timers;
+         std::atomic<int64_t>        _next_wakeup{no_deadline}; ///< when the thread wakes up, in microseconds
+         bool                        _done = false;
+         std::thread                 _thread;
+   };
+
+   checktime_timer::checktime_timer()
+   :_state(encode_deadline(no_deadline, false)),
+    _watchdog(checktime_watchdog::instance())
+   {
+      _watchdog->add(this);
+   }
+
+   checktime_timer::~checktime_timer() {
+      _watchdog->remove(this);
+   }
+
+   checktime_timer& checktime_timer::for_this_thread() {
+      static thread_local checktime_timer timer;
+      return timer;
+   }
+
+   void checktime_timer::arm(const fc::time_point& deadline) {
+      auto deadline_us = deadline.time_since_epoch().count();
+      bool expired = fc::time_point::now() > deadline;
+      _state.store(encode_deadline(deadline_us, expired));
+      if (!expired)
+         _watchdog->armed(deadline_us);
+   }
+
+} } // eosio::chain
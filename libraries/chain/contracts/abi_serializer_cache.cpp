@@ -0,0 +1,97 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+#include <eosio/chain/contracts/abi_serializer_cache.hpp>
+
+namespace eosio { namespace chain { namespace contracts {
+
+   abi_serializer_cache::abi_serializer_cache( uint32_t capacity )
+   :_capacity(capacity) {}
+
+   abi_serializer_cache::cached_abi_ptr abi_serializer_cache::get_abi( const account_object& account ) {
+      if( abi_serializer::is_empty_abi(account.abi) )
+         return cached_abi_ptr();
+
+      return get_abi( account.name, account.abi_version, [&]() {
+         optional<abi_def> abi = abi_def();
+         abi_serializer::to_abi( account.abi, *abi );
+         return abi;
+      });
+   }
+
+   abi_serializer_cache::cached_abi_ptr abi_serializer_cache::get_abi( const account_name& account, const digest_type& abi_version,
+                                                                       const abi_loader& loader ) {
+      if( auto abi = find(account, abi_version) )
+         return abi;
+
+      // parsed without holding the lock, two threads missing on the same ABI both parse it
+      auto abi = loader();
+      if( !abi )
+         return cached_abi_ptr();
+
+      auto result = std::make_shared<const cached_abi>( std::move(*abi) );
+      insert( account, abi_version, result );
+      return result;
+   }
+
+   abi_serializer_cache::abi_serializer_ptr abi_serializer_cache::get_serializer( const account_object& account ) {
+      auto abi = get_abi( account );
+      if( !abi )
+         return abi_serializer_ptr();
+      return abi_serializer_ptr( abi, &abi->serializer );
+   }
+
+   void abi_serializer_cache::erase( const account_name& account ) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto itr = _entries.find(account);
+      if( itr != _entries.end() ) {
+         _lru.erase( itr->second.lru_position );
+         _entries.erase( itr );
+      }
+   }
+
+   abi_serializer_cache_stats abi_serializer_cache::get_stats()const {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto result = _stats;
+      result.size = _entries.size();
+      result.capacity = _capacity;
+      return result;
+   }
+
+   abi_serializer_cache::cached_abi_ptr abi_serializer_cache::find( const account_name& account, const digest_type& abi_version ) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto itr = _entries.find(account);
+      if( itr == _entries.end() || itr->second.abi_version != abi_version ) {
+         ++_stats.misses;
+         return cached_abi_ptr();
+      }
+      ++_stats.hits;
+      _lru.splice( _lru.begin(), _lru, itr->second.lru_position );
+      return itr->second.abi;
+   }
+
+   void abi_serializer_cache::insert( const account_name& account, const digest_type& abi_version, const cached_abi_ptr& abi ) {
+      if( _capacity == 0 )
+         return;
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto itr = _entries.find(account);
+      if( itr != _entries.end() ) {
+         // replaces the serializer of the previous version of the ABI
+         itr->second.abi_version = abi_version;
+         itr->second.abi = abi;
+         _lru.splice( _lru.begin(), _lru, itr->second.lru_position );
+         return;
+      }
+
+      _lru.push_front(account);
+      _entries.emplace( account, cache_entry{abi_version, abi, _lru.begin()} );
+      while( _entries.size() > _capacity ) {
+         _entries.erase( _lru.back() );
+         _lru.pop_back();
+         ++_stats.evictions;
+      }
+   }
+
+} } } // eosio::chain::contracts
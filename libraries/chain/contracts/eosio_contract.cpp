@@ -138,6 +138,9 @@ void apply_eosio_setcode(apply_context& context) {
 
    });
 
+   // instantiate the new code in the background so that its first action does not pay for it
+   context.mutable_controller.get_wasm_interface().warmup( code_id, act.code.data(), act.code.size() );
+
    if (new_size != old_size) {
       resources.add_pending_account_ram_usage(
          act.account,
@@ -23,6 +23,7 @@ namespace eosio { namespace chain {
 
       time_point_sec       last_code_update;
       digest_type          code_version;
+      digest_type          abi_version; ///< hash of abi, keys the cached serializers of API nodes
       block_timestamp_type creation_date;
 
       shared_vector<char>  code;
@@ -34,6 +35,7 @@ namespace eosio { namespace chain {
          abi.resize( fc::raw::pack_size( a ) );
          fc::datastream<char*> ds( abi.data(), abi.size() );
          fc::raw::pack( ds, a );
+         abi_version = digest_type::hash( abi.data(), abi.size() );
       }
 
       eosio::chain::contracts::abi_def get_abi()const {
@@ -59,4 +61,4 @@ namespace eosio { namespace chain {
 CHAINBASE_SET_INDEX_TYPE(eosio::chain::account_object, eosio::chain::account_index)
 
 
-FC_REFLECT(eosio::chain::account_object, (name)(vm_type)(vm_version)(code_version)(code)(creation_date))
+FC_REFLECT(eosio::chain::account_object, (name)(vm_type)(vm_version)(code_version)(abi_version)(code)(creation_date))
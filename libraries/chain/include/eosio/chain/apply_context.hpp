@@ -6,6 +6,7 @@
 #include <eosio/chain/block_trace.hpp>
 #include <eosio/chain/transaction.hpp>
 #include <eosio/chain/transaction_metadata.hpp>
+#include <eosio/chain/checktime_timer.hpp>
 #include <eosio/chain/contracts/contract_table_objects.hpp>
 #include <fc/utility.hpp>
 #include <sstream>
@@ -469,9 +470,12 @@ class apply_context {
        idx256(*this),
        idx_double(*this),
        idx_long_double(*this),
-       recurse_depth(depth)
+       recurse_depth(depth),
+       _checktime_timer(checktime_timer::for_this_thread())
       {
          reset_console();
+         if (trx_meta.processing_deadline && _checktime_timer.deadline() != *trx_meta.processing_deadline)
+            _checktime_timer.arm(*trx_meta.processing_deadline);
       }
 
       void exec();
@@ -573,6 +577,13 @@ class apply_context {
       void db_update_i64( int iterator, account_name payer, const char* buffer, size_t buffer_size );
       void db_remove_i64( int iterator );
       int db_get_i64( int iterator, char* buffer, size_t buffer_size );
+      /**
+       * Copies the row at iterator and the rows that follow it in the table into buffer, up to max_rows rows and as
+       * many as fit. Each row is written as its iterator (int32), the size of its data (uint32) and its primary key
+       * (uint64), followed by its data.
+       * @return the number of rows written
+       */
+      int db_get_range_i64( int iterator, char* buffer, size_t buffer_size, uint32_t max_rows );
       int db_next_i64( int iterator, uint64_t& primary );
       int db_previous_i64( int iterator, uint64_t& primary );
       int db_find_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id );
@@ -619,6 +630,7 @@ class apply_context {
       vector<scope_name>                  _write_scopes;
       bytes                               _cached_trx;
       uint64_t                            _cpu_usage;
+      checktime_timer&                    _checktime_timer; ///< expires at trx_meta.processing_deadline
 };
 
 using apply_handler = std::function<void(apply_context&)>;
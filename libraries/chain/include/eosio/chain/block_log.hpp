@@ -8,7 +8,68 @@
 
 namespace eosio { namespace chain {
 
-   namespace detail { class block_log_impl; }
+   namespace detail { class block_log_impl; struct mapped_log_file; }
+
+   /**
+    * A block as it is stored in the block log. The bytes point into the memory mapped log file,
+    * which stays mapped for as long as the view exists, so the view remains valid after the log
+    * has grown and can be handed to other threads.
+    */
+   class packed_block_view {
+      public:
+         uint32_t     block_num()const { return _block_num; }
+         uint64_t     position()const  { return _pos; }
+         const char*  data()const      { return _data; }
+         size_t       size()const      { return _size; }
+
+         signed_block unpack()const;
+
+      private:
+         friend class block_log;
+
+         std::shared_ptr<const detail::mapped_log_file> _file;
+         uint32_t                                       _block_num = 0;
+         uint64_t                                       _pos = 0;
+         const char*                                    _data = nullptr;
+         size_t                                         _size = 0;
+   };
+
+   /**
+    * The blocks [first, last] of the block log, read straight from the memory mapped files without
+    * copying or unpacking them.
+    */
+   class block_range {
+      public:
+         class iterator {
+            public:
+               packed_block_view operator*()const { return _range->view(_block_num); }
+               iterator& operator++() { ++_block_num; return *this; }
+               bool operator==(const iterator& other)const { return _block_num == other._block_num; }
+               bool operator!=(const iterator& other)const { return _block_num != other._block_num; }
+
+            private:
+               friend class block_range;
+               iterator(const block_range* range, uint32_t block_num) :_range(range), _block_num(block_num) {}
+
+               const block_range* _range;
+               uint32_t           _block_num;
+         };
+
+         iterator begin()const { return iterator(this, _first); }
+         iterator end()const   { return iterator(this, _last + 1); }
+         bool     empty()const { return _first > _last; }
+         uint32_t size()const  { return empty() ? 0 : _last - _first + 1; }
+
+         packed_block_view view(uint32_t block_num)const;
+
+      private:
+         friend class block_log;
+
+         std::shared_ptr<const detail::mapped_log_file> _blocks;
+         std::shared_ptr<const detail::mapped_log_file> _index;
+         uint32_t                                       _first = 1;
+         uint32_t                                       _last = 0;
+   };
 
    /* The block log is an external append only log of the blocks. Blocks should only be written
     * to the log after they irreverisble as the log is append only. The log is a doubly linked
@@ -33,6 +94,9 @@ namespace eosio { namespace chain {
     *
     * The main file is the only file that needs to persist. The index file can be reconstructed during a
     * linear scan of the main file.
+    *
+    * Both files are only ever appended to through streams and read through memory maps of them, which
+    * are extended when a read reaches past what they cover. Reading is safe from any number of threads at once.
     */
 
    class block_log {
@@ -54,7 +118,17 @@ namespace eosio { namespace chain {
           */
          uint64_t get_block_pos(uint32_t block_num) const;
          optional<signed_block> read_head()const;
-         const optional<signed_block>& head()const;
+         optional<signed_block> head()const;
+
+         /**
+          * Return the packed block, or an empty optional if it is not in the log.
+          */
+         optional<packed_block_view> read_packed_block_by_num(uint32_t block_num)const;
+
+         /**
+          * Return the blocks [first, last] that are in the log, last is clamped to the head of the log.
+          */
+         block_range read_block_range(uint32_t first, uint32_t last = std::numeric_limits<uint32_t>::max())const;
 
          static const uint64_t npos = std::numeric_limits<uint64_t>::max();
 
@@ -19,9 +19,11 @@
 #include <eosio/chain/apply_context.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/contracts/genesis_state.hpp>
+#include <eosio/chain/contracts/abi_serializer_cache.hpp>
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/wasm_interface.hpp>
 #include <eosio/chain/webassembly/runtime_interface.hpp>
+#include <eosio/chain/thread_utils.hpp>
 
 #include <fc/log/logger.hpp>
 
@@ -83,6 +85,13 @@ namespace eosio { namespace chain {
             contracts::genesis_state_type  genesis;
             runtime_limits                 limits;
             wasm_interface::vm_type        wasm_runtime        =  config::default_wasm_runtime;
+            uint32_t                       wasm_module_cache_size = config::default_wasm_module_cache_size;
+            uint32_t                       abi_serializer_cache_size = config::default_abi_serializer_cache_size;
+            path                           wasm_jit_cache_dir; ///< empty disables the persistent wavm code cache
+            uint64_t                       wasm_jit_cache_size =  config::default_wasm_jit_cache_size; ///< bytes of the wavm code cache, the oldest code is removed beyond it
+            bool                           wasm_native_float   =  false; ///< false computes every float operation with softfloat
+            uint16_t                       thread_pool_size    =  config::default_controller_thread_pool_size; ///< 0 prepares block inputs on the calling thread
+            uint16_t                       max_pending_shards  =  config::default_max_pending_shards; ///< 1 places every pending transaction in a single shard
          };
 
          explicit chain_controller( const controller_config& cfg );
@@ -93,6 +102,17 @@ namespace eosio { namespace chain {
          transaction_trace push_transaction( const packed_transaction& trx, uint32_t skip = skip_nothing );
          vector<transaction_trace> push_deferred_transactions( bool flush = false, uint32_t skip = skip_nothing );
 
+         /**
+          *  Starts recovering the keys that signed a transaction, or the input transactions of a block, on
+          *  the thread pool so that push_transaction and push_block only have to check the authority. Keys
+          *  that are never picked up are dropped once their transaction expires, or once
+          *  config::max_pending_signature_recoveries newer transactions have been started. Does nothing when
+          *  the controller has no thread pool.
+          */
+         void recover_signing_keys( const packed_transaction& trx );
+         void recover_signing_keys( const signed_block& b );
+         size_t pending_signature_recoveries()const { return _pending_recoveries.size(); }
+
          uint128_t transaction_id_to_sender_id( const transaction_id_type& tid )const;
 
       /**
@@ -138,6 +158,10 @@ namespace eosio { namespace chain {
          block_id_type                  get_block_id_for_num( uint32_t block_num )const;
          optional<signed_block>         fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>         fetch_block_by_number( uint32_t num )const;
+         /// packed irreversible block straight from the block log, without copying or unpacking it
+         optional<packed_block_view>    fetch_packed_block_by_number( uint32_t num )const;
+         /// packed irreversible blocks [first, last] straight from the block log
+         block_range                    fetch_block_range( uint32_t first, uint32_t last )const;
          std::vector<block_id_type>     get_block_ids_on_fork(block_id_type head_of_fork)const;
 
          /**
@@ -197,7 +221,7 @@ namespace eosio { namespace chain {
          /**
           *  This method will backup all tranasctions in the current pending block,
           *  undo the pending block, call f(), and then push the pending transactions
-          *  on top of the new state.
+          *  on top of the new state. The caller must hold the database write lock.
           */
          template<typename Function>
          auto without_pending_transactions( Function&& f )
@@ -207,7 +231,7 @@ namespace eosio { namespace chain {
             if( _pending_block )
                old_input = move(_pending_transaction_metas);
 
-            clear_pending();
+            _clear_pending();
 
             /** after applying f() push previously input transactions on top */
             auto on_exit = fc::make_scoped_exit( [&](){
@@ -285,6 +309,14 @@ namespace eosio { namespace chain {
          wasm_interface& get_wasm_interface() {
             return _wasm_interface;
          }
+         const wasm_interface& get_wasm_interface()const {
+            return _wasm_interface;
+         }
+
+         /// shared by the readers of the chain, the cache is thread safe
+         contracts::abi_serializer_cache& get_abi_serializer_cache()const {
+            return _abi_serializer_cache;
+         }
 
          /**
           * @param actions - the actions to check authorization across
@@ -336,6 +368,11 @@ namespace eosio { namespace chain {
 
          transaction_trace _push_transaction( const packed_transaction& trx );
          transaction_trace _push_transaction( transaction_metadata&& data );
+
+         /// signing keys recovered by recover_signing_keys for trx, if its recovery was started and succeeded
+         optional<flat_set<public_key_type>> _take_recovered_signing_keys( const digest_type& packed_digest );
+         /// drops the recoveries of transactions that expired before being pushed, and those that failed
+         void _clear_expired_recoveries();
          transaction_trace _apply_transaction( transaction_metadata& data );
          transaction_trace __apply_transaction( transaction_metadata& data );
          transaction_trace _apply_error( transaction_metadata& data );
@@ -360,8 +397,9 @@ namespace eosio { namespace chain {
 
          void replay();
 
-         void _apply_block(const signed_block& next_block, uint32_t skip = skip_nothing);
-         void __apply_block(const signed_block& next_block);
+         /// prepared_input_metas, when given, are the unpacked input transactions of next_block and are consumed
+         void _apply_block(const signed_block& next_block, uint32_t skip = skip_nothing, vector<transaction_metadata>* prepared_input_metas = nullptr);
+         void __apply_block(const signed_block& next_block, vector<transaction_metadata>* prepared_input_metas = nullptr);
 
          template<typename Function>
          auto with_applying_block(Function&& f) -> decltype((*((Function*)nullptr))()) {
@@ -440,9 +478,15 @@ namespace eosio { namespace chain {
          void _spinup_db();
          void _spinup_fork_db();
 
+         /// pop_block and clear_pending without taking the database write lock, for callers that already hold it
+         void _pop_block();
+         void _clear_pending();
+
          void _start_pending_block( bool skip_deferred = false );
          void _start_pending_cycle();
          void _finalize_pending_cycle();
+         uint32_t _schedule_pending_transaction( transaction_trace& trace, const transaction_metadata& meta );
+         void _merge_pending_shards( uint32_t into, uint32_t from );
          void _apply_cycle_trace( const cycle_trace& trace );
          void _finalize_block( const block_trace& b, const producer_object& signing_producer );
 
@@ -461,6 +505,20 @@ namespace eosio { namespace chain {
          vector<transaction_metadata>     _pending_transaction_metas;
          optional<cycle_trace>            _pending_cycle_trace;
 
+         /**
+          *  Scheduling state of a shard of the pending cycle. The locks include the state a transaction
+          *  depends on without recording a lock for it (permissions, generated transactions) so that
+          *  transactions depending on each other through that state are never placed in different shards.
+          */
+         struct pending_shard_schedule {
+            flat_set<shard_lock>          read_locks;
+            flat_set<shard_lock>          write_locks;
+            vector<uint32_t>              sequence; ///< order in which each transaction of the shard was applied
+         };
+         vector<pending_shard_schedule>   _pending_shard_schedule;
+         uint32_t                         _pending_cycle_sequence = 0;
+         uint16_t                         _max_pending_shards = config::default_max_pending_shards;
+
          bool                             _currently_applying_block = false;
          bool                             _currently_replaying_blocks = false;
          uint64_t                         _skip_flags = 0;
@@ -471,9 +529,21 @@ namespace eosio { namespace chain {
          map< account_name, map<handler_key, apply_handler> >   _apply_handlers;
 
          wasm_interface                   _wasm_interface;
+         mutable contracts::abi_serializer_cache _abi_serializer_cache;
 
          runtime_limits                   _limits;
          resource_limits_manager          _resource_limits;
+
+         optional<boost::asio::thread_pool> _thread_pool;
+
+         struct recovered_signing_keys {
+            time_point_sec            expiration;
+            flat_set<public_key_type> keys;
+         };
+
+         /// recoveries started by recover_signing_keys, indexed by the packed_digest of the transaction
+         map<digest_type, std::shared_future<recovered_signing_keys>> _pending_recoveries;
+         deque<digest_type>               _pending_recovery_order;
    };
 
 } }
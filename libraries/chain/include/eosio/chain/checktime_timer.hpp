@@ -0,0 +1,54 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+#pragma once
+#include <fc/time.hpp>
+
+#include <atomic>
+#include <memory>
+
+namespace eosio { namespace chain {
+
+   class checktime_watchdog;
+
+   /**
+    *  A deadline that is watched by a background thread instead of being compared against the clock by the
+    *  thread it applies to. Once the deadline passes the watchdog thread sets the expired flag, so checking
+    *  for it is a single load.
+    *
+    *  Each thread that executes contracts owns one timer, see for_this_thread(), and re-arms it whenever the
+    *  deadline it checks against changes.
+    */
+   class checktime_timer {
+      public:
+         checktime_timer();
+         ~checktime_timer();
+
+         checktime_timer(const checktime_timer&) = delete;
+         checktime_timer& operator=(const checktime_timer&) = delete;
+
+         /**
+          *  @return the timer of the calling thread
+          */
+         static checktime_timer& for_this_thread();
+
+         /**
+          *  Watch for the given deadline instead of the previous one. A deadline that has already passed
+          *  expires the timer right away.
+          */
+         void arm(const fc::time_point& deadline);
+
+         fc::time_point deadline()const { return fc::time_point(fc::microseconds(int64_t(_state.load(std::memory_order_relaxed) >> 1))); }
+         bool expired()const { return _state.load(std::memory_order_relaxed) & 1; }
+
+      private:
+         friend class checktime_watchdog;
+
+         /// the deadline in microseconds shifted left by one, with whether it expired in the lowest bit, so that arming
+         /// is a single store and the watchdog only ever expires the deadline it saw
+         std::atomic<uint64_t>                _state;
+         std::shared_ptr<checktime_watchdog>  _watchdog; ///< outlives the timer, whichever thread exits last
+   };
+
+} } // eosio::chain
@@ -23,6 +23,7 @@ const static uint64_t anybody_account_name   = N(anybody);
 const static uint64_t producers_account_name = N(producers);
 const static uint64_t eosio_auth_scope       = N(eosio.auth);
 const static uint64_t eosio_all_scope        = N(eosio.all);
+const static uint64_t eosio_resource_scope   = N(eosio.rsrc); ///< implicit lock on the resource usage an account is billed
 
 const static uint64_t active_name = N(active);
 const static uint64_t owner_name  = N(owner);
@@ -82,6 +83,18 @@ const static uint32_t   setcode_ram_bytes_multiplier       = 10;     ///< multip
 
 const static eosio::chain::wasm_interface::vm_type default_wasm_runtime = eosio::chain::wasm_interface::vm_type::binaryen;
 
+const static uint32_t   default_wasm_module_cache_size      = 1024; ///< instantiated contracts kept by wasm_interface
+const static uint64_t   default_wasm_jit_cache_size         = 1024*1024*1024ll; ///< bytes of compiled contracts the wavm runtime keeps on disk
+const static uint32_t   default_abi_serializer_cache_size   = 1024; ///< parsed account ABIs kept for the API plugins
+const static uint16_t   default_controller_thread_pool_size = 2; ///< worker threads used to prepare the input transactions of a block
+const static uint16_t   default_max_pending_shards          = 16; ///< upper bound on the independent shards a producer packs into one cycle
+const static uint32_t   block_log_index_segment_size        = 1024*1024; ///< index entries checked by one thread when validating blocks.index
+const static uint32_t   block_log_index_checkpoint_interval = 1024*1024; ///< index entries written between flushes while rebuilding blocks.index
+const static uint64_t   block_log_map_reserve               = 256*1024*1024; ///< bytes of address space mapped past the end of a block log file for it to grow into
+const static uint32_t   replay_pipeline_depth               = 256; ///< blocks read and unpacked ahead of the one being applied during a replay
+const static uint32_t   replay_report_interval              = 5000; ///< blocks between progress reports during a replay
+const static uint32_t   max_pending_signature_recoveries    = 10000; ///< transactions whose keys may be recovered ahead of being pushed
+
 /**
  *  The number of sequential blocks produced by a single producer
  */
@@ -197,7 +197,7 @@ namespace impl {
          mvo("authorization", act.authorization);
 
          auto abi = resolver(act.account);
-         if (abi.valid()) {
+         if (abi) {
             auto type = abi->get_action_type(act.name);
             mvo("data", abi->binary_to_variant(type, act.data));
             mvo("hex_data", act.data);
@@ -323,7 +323,7 @@ namespace impl {
                from_variant(data, act.data);
             } else if ( data.is_object() ) {
                auto abi = resolver(act.account);
-               if (abi.valid()) {
+               if (abi) {
                   auto type = abi->get_action_type(act.name);
                   act.data = std::move(abi->variant_to_binary(type, data));
                }
@@ -0,0 +1,86 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+#pragma once
+#include <eosio/chain/contracts/abi_serializer.hpp>
+#include <eosio/chain/account_object.hpp>
+
+#include <list>
+#include <memory>
+#include <mutex>
+
+namespace eosio { namespace chain { namespace contracts {
+
+   struct abi_serializer_cache_stats {
+      uint64_t hits      = 0;
+      uint64_t misses    = 0;
+      uint64_t evictions = 0;
+      uint32_t size      = 0;
+      uint32_t capacity  = 0;
+   };
+
+   /**
+    *  An ABI together with the serializer built from it
+    */
+   struct cached_abi {
+      explicit cached_abi( abi_def a )
+      :abi(std::move(a)),serializer(abi){}
+
+      const abi_def        abi;
+      const abi_serializer serializer;
+   };
+
+   /**
+    *  @brief Thread safe LRU cache of the ABIs of accounts and their serializers
+    *
+    *  Entries are keyed by account and by the version of the account's ABI, so an ABI
+    *  replaced by setabi is parsed again the next time it is used, on any fork. Callers
+    *  keep the entries they were handed alive after they are evicted.
+    */
+   class abi_serializer_cache {
+      public:
+         using cached_abi_ptr     = std::shared_ptr<const cached_abi>;
+         using abi_serializer_ptr = std::shared_ptr<const abi_serializer>;
+         using abi_loader         = std::function<optional<abi_def>()>;
+
+         /// a capacity of 0 disables the cache, every call parses the ABI
+         explicit abi_serializer_cache( uint32_t capacity );
+
+         /// ABI of the account, null if it has none
+         cached_abi_ptr get_abi( const account_object& account );
+
+         /**
+          * ABI with the given version of an account which is not read from the chain database,
+          * the loader is only called on a miss and returns an empty optional if there is no ABI
+          */
+         cached_abi_ptr get_abi( const account_name& account, const digest_type& abi_version, const abi_loader& loader );
+
+         /// serializer of the account's ABI, null if it has none; suitable as an abi_serializer resolver result
+         abi_serializer_ptr get_serializer( const account_object& account );
+
+         /// drops the entry of account, for ABIs whose version is not tracked
+         void erase( const account_name& account );
+
+         abi_serializer_cache_stats get_stats()const;
+
+      private:
+         struct cache_entry {
+            digest_type                       abi_version;
+            cached_abi_ptr                    abi;
+            std::list<account_name>::iterator lru_position;
+         };
+
+         cached_abi_ptr find( const account_name& account, const digest_type& abi_version );
+         void           insert( const account_name& account, const digest_type& abi_version, const cached_abi_ptr& abi );
+
+         const uint32_t                  _capacity;
+         mutable std::mutex              _mutex; ///< guards the entries, the LRU order and the stats
+         map<account_name, cache_entry>  _entries;
+         std::list<account_name>         _lru;
+         abi_serializer_cache_stats      _stats;
+   };
+
+} } } // eosio::chain::contracts
+
+FC_REFLECT( eosio::chain::contracts::abi_serializer_cache_stats, (hits)(misses)(evictions)(size)(capacity) )
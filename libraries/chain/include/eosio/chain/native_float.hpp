@@ -0,0 +1,86 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+#pragma once
+#include <cfenv>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+/**
+ * Native float math only reproduces softfloat when every operation is done in the precision of its type, as with
+ * SSE2, and the compiler is not allowed to reorder or fuse it
+ */
+#if (defined(__SSE2_MATH__) || defined(_M_X64)) && FLT_EVAL_METHOD == 0 && !defined(__FAST_MATH__)
+#define EOSIO_NATIVE_FLOAT 1
+#endif
+
+namespace eosio { namespace chain { namespace native_float {
+
+   namespace detail {
+      template<typename T>
+      bool validate_type() {
+         volatile T one = 1;
+         volatile T half_ulp = std::numeric_limits<T>::epsilon() / 2;
+         volatile T denorm = std::numeric_limits<T>::denorm_min();
+         volatile T normal = std::numeric_limits<T>::min();
+         volatile T half = T(0.5);
+         return denorm * one == std::numeric_limits<T>::denorm_min() &&              // denormals are not read as zero
+                normal * half != T(0) &&                                              // nor are results flushed to zero
+                one + half_ulp == T(1) &&                                             // ties round to even
+                (one + std::numeric_limits<T>::epsilon()) + half_ulp == T(1) + 2 * std::numeric_limits<T>::epsilon();
+      }
+
+      inline bool validate() {
+#ifdef EOSIO_NATIVE_FLOAT
+         return std::fegetround() == FE_TONEAREST && validate_type<float>() && validate_type<double>();
+#else
+         return false;
+#endif
+      }
+   }
+
+   /**
+    * @return whether the native operations of the calling thread give the results of softfloat, this is checked
+    * once for each thread
+    */
+   inline bool enabled() {
+      static thread_local const bool valid = detail::validate();
+      return valid;
+   }
+
+   namespace detail {
+      template<typename T>
+      inline bool result(T value, T& out) {
+         if (!enabled() || std::isnan(value))
+            return false;
+         out = value;
+         return true;
+      }
+   }
+
+   /**
+    * IEEE 754 add, sub, mul, div and sqrt are correctly rounded, so with round to nearest and denormals kept as
+    * they are the native results are bit for bit those of softfloat. The exception is a NaN result, whose sign and
+    * payload are up to the hardware, so those are left to softfloat.
+    *
+    * Each operation stores the native result in out and returns true, or returns false when softfloat has to
+    * compute it. softfloat_api only asks them when the node opted in, see controller_config::wasm_native_float.
+    */
+   template<typename T>
+   inline bool add(T a, T b, T& out) { return detail::result<T>(a + b, out); }
+
+   template<typename T>
+   inline bool sub(T a, T b, T& out) { return detail::result<T>(a - b, out); }
+
+   template<typename T>
+   inline bool mul(T a, T b, T& out) { return detail::result<T>(a * b, out); }
+
+   template<typename T>
+   inline bool div(T a, T b, T& out) { return detail::result<T>(a / b, out); }
+
+   template<typename T>
+   inline bool sqrt(T a, T& out) { return detail::result<T>(std::sqrt(a), out); }
+
+} } } // eosio::chain::native_float
@@ -0,0 +1,26 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+#pragma once
+
+#include <boost/asio/thread_pool.hpp>
+#include <boost/asio/post.hpp>
+
+#include <future>
+#include <memory>
+
+namespace eosio { namespace chain {
+
+   /**
+    *  Posts f() to the thread_pool and returns a future for its result. Any exception
+    *  thrown by f() is rethrown from future::get() on the waiting thread.
+    */
+   template<typename F>
+   auto async_thread_pool( boost::asio::thread_pool& thread_pool, F&& f ) {
+      auto task = std::make_shared<std::packaged_task<decltype( f() )()>>( std::forward<F>( f ) );
+      boost::asio::post( thread_pool, [task]() { (*task)(); } );
+      return task->get_future();
+   }
+
+} } // eosio::chain
@@ -45,6 +45,7 @@ class transaction_metadata {
       // things for processing deferred transactions
       optional<account_name>                sender;
       uint128_t                             sender_id = 0;
+      account_name                          payer;
 
       // packed form to pass to contracts if needed
       const char*                           raw_data = nullptr;
@@ -76,4 +77,4 @@ class transaction_metadata {
 
 } } // eosio::chain
 
-FC_REFLECT( eosio::chain::transaction_metadata, (raw_trx)(signing_keys)(id)(region_id)(cycle_index)(shard_index)(billable_packed_size)(published)(sender)(sender_id)(is_implicit))
+FC_REFLECT( eosio::chain::transaction_metadata, (raw_trx)(signing_keys)(id)(region_id)(cycle_index)(shard_index)(billable_packed_size)(published)(sender)(sender_id)(payer)(is_implicit))
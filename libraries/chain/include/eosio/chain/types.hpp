@@ -133,10 +133,10 @@ namespace eosio { namespace chain {
       generated_transaction_object_type,
       producer_object_type,
       chain_property_object_type,
-      account_control_history_object_type, ///< Defined by account_history_plugin
-      account_transaction_history_object_type, ///< Defined by account_history_plugin
-      transaction_history_object_type, ///< Defined by account_history_plugin
-      public_key_history_object_type, ///< Defined by account_history_plugin
+      account_control_history_object_type, ///< No longer used, account_history_plugin keeps its history outside of the database
+      account_transaction_history_object_type, ///< No longer used, account_history_plugin keeps its history outside of the database
+      transaction_history_object_type, ///< No longer used, account_history_plugin keeps its history outside of the database
+      public_key_history_object_type, ///< No longer used, account_history_plugin keeps its history outside of the database
       balance_object_type, ///< Defined by native_contract library
       staked_balance_object_type, ///< Defined by native_contract library
       producer_votes_object_type, ///< Defined by native_contract library
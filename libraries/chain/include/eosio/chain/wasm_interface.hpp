@@ -43,6 +43,20 @@ namespace eosio { namespace chain {
       };
    } }
 
+   /**
+    *  Counters of the cache of instantiated modules kept by wasm_interface
+    */
+   struct wasm_cache_stats {
+      uint64_t hits            = 0;
+      uint64_t misses          = 0;
+      uint64_t evictions       = 0;
+      uint64_t compilations    = 0; ///< modules instantiated, on a miss or by a warmup
+      uint64_t warmups         = 0; ///< warmups requested for modules that were not cached
+      uint64_t compile_time_us = 0; ///< total time spent instantiating modules
+      uint32_t size            = 0;
+      uint32_t capacity        = 0;
+   };
+
    /**
     * @class wasm_interface
     *
@@ -54,22 +68,39 @@ namespace eosio { namespace chain {
             binaryen,
          };
 
-         wasm_interface(vm_type vm);
+         /// module_cache_size is the number of instantiated modules kept, least recently used ones are evicted;
+         /// wavm keeps the machine code it compiles in jit_cache_dir across restarts, unless it is empty, up to
+         /// jit_cache_size bytes of it;
+         /// enable_native_float opts in to native float operations where they are validated to match softfloat
+         wasm_interface(vm_type vm, uint32_t module_cache_size, const fc::path& jit_cache_dir, uint64_t jit_cache_size, bool enable_native_float = false);
          ~wasm_interface();
 
          //validates code -- does a WASM validation pass and checks the wasm against EOSIO specific constraints
          static void validate(const bytes& code);
 
          //Calls apply or error on a given code
+         //Several threads may call apply at once, each with its own apply_context; each thread executes
+         //its own instance of the module in its own memory
          void apply(const digest_type& code_id, const shared_vector<char>& code, apply_context& context);
 
+         //Instantiates code on a background thread so that the first apply does not have to, e.g. after setcode
+         void warmup(const digest_type& code_id, const char* code, size_t code_size);
+
+         wasm_cache_stats get_cache_stats()const;
+
+         //Whether add, sub, mul, div and sqrt may be computed natively, opted in and validated on this host
+         bool native_float_enabled()const { return use_native_float; }
+
       private:
          unique_ptr<struct wasm_interface_impl> my;
+         const bool use_native_float;
          friend class eosio::chain::webassembly::common::intrinsics_accessor;
    };
 
 } } // eosio::chain
 
+FC_REFLECT( eosio::chain::wasm_cache_stats, (hits)(misses)(evictions)(compilations)(warmups)(compile_time_us)(size)(capacity) )
+
 namespace eosio{ namespace chain {
    std::istream& operator>>(std::istream& in, wasm_interface::vm_type& runtime);
 }}
@@ -6,6 +6,12 @@
 #include <eosio/chain/webassembly/runtime_interface.hpp>
 #include <eosio/chain/wasm_eosio_injection.hpp>
 
+#include <boost/asio/thread_pool.hpp>
+#include <boost/asio/post.hpp>
+
+#include <list>
+#include <mutex>
+
 #include "IR/Module.h"
 #include "Runtime/Intrinsics.h"
 #include "Platform/Platform.h"
@@ -20,14 +26,21 @@ using namespace Runtime;
 namespace eosio { namespace chain {
 
    struct wasm_interface_impl {
-      wasm_interface_impl(wasm_interface::vm_type vm) {
+      wasm_interface_impl(wasm_interface::vm_type vm, uint32_t module_cache_size, const fc::path& jit_cache_dir, uint64_t jit_cache_size)
+      :module_cache_size(std::max<uint32_t>(module_cache_size, 1)) {
          if(vm == wasm_interface::vm_type::wavm)
-            runtime_interface = std::make_unique<webassembly::wavm::wavm_runtime>();
+            runtime_interface = std::make_unique<webassembly::wavm::wavm_runtime>(jit_cache_dir, jit_cache_size);
          else if(vm == wasm_interface::vm_type::binaryen)
             runtime_interface = std::make_unique<webassembly::binaryen::binaryen_runtime>();
          else
             FC_THROW("wasm_interface_impl fall through");
       }
+
+      ~wasm_interface_impl() {
+         // abandon warmups that have not started yet and wait for the one in progress
+         warmup_thread.stop();
+         warmup_thread.join();
+      }
       
       std::vector<uint8_t> parse_initial_memory(const Module& module) {
          std::vector<uint8_t> mem_image;
@@ -47,35 +60,126 @@ namespace eosio { namespace chain {
          return mem_image;
       }
 
-      std::unique_ptr<wasm_instantiated_module_interface>& get_instantiated_module(const digest_type& code_id, const shared_vector<char>& code) {
+      std::shared_ptr<wasm_instantiated_module_interface> instantiate_module(const char* code, size_t code_size) {
+         IR::Module module;
+         try {
+            Serialization::MemoryInputStream stream((const U8*)code, code_size);
+            WASM::serialize(stream, module);
+         } catch(Serialization::FatalSerializationException& e) {
+            EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
+         }
+         wasm_injections::wasm_binary_injection injector(module);
+         injector.inject();
+
+         std::vector<U8> bytes;
+         try {
+            Serialization::ArrayOutputStream outstream;
+            WASM::serialize(outstream, module);
+            bytes = outstream.getBytes();
+         } catch(Serialization::FatalSerializationException& e) {
+            EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
+         }
+
+         return runtime_interface->instantiate_module((const char*)bytes.data(), bytes.size(), parse_initial_memory(module));
+      }
+
+      /// the cached module, most recently used first
+      std::shared_ptr<wasm_instantiated_module_interface> find_cached_module(const digest_type& code_id) {
+         std::lock_guard<std::mutex> lock(cache_mutex);
          auto it = instantiation_cache.find(code_id);
-         if(it == instantiation_cache.end()) {
-            IR::Module module;
-            try {
-               Serialization::MemoryInputStream stream((const U8*)code.data(), code.size());
-               WASM::serialize(stream, module);
-            } catch(Serialization::FatalSerializationException& e) {
-               EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
-            }
-            wasm_injections::wasm_binary_injection injector(module);
-            injector.inject();
+         if(it == instantiation_cache.end())
+            return nullptr;
+         lru.splice(lru.begin(), lru, it->second.lru_position);
+         return it->second.module;
+      }
+
+      void cache_module(const digest_type& code_id, std::shared_ptr<wasm_instantiated_module_interface> module) {
+         // evicted modules are destroyed after the lock is released, modules being executed are kept alive by
+         // their callers until they return
+         std::vector<std::shared_ptr<wasm_instantiated_module_interface>> evicted;
+         std::lock_guard<std::mutex> lock(cache_mutex);
+         if(instantiation_cache.count(code_id))
+            return;
+         lru.push_front(code_id);
+         instantiation_cache.emplace(code_id, cached_module{std::move(module), lru.begin()});
+         while(instantiation_cache.size() > module_cache_size) {
+            auto it = instantiation_cache.find(lru.back());
+            evicted.emplace_back(std::move(it->second.module));
+            instantiation_cache.erase(it);
+            lru.pop_back();
+            ++stats.evictions;
+         }
+         stats.size = instantiation_cache.size();
+      }
 
-            std::vector<U8> bytes;
+      /// compiles code unless it has been cached meanwhile, only one module is compiled at a time
+      std::shared_ptr<wasm_instantiated_module_interface> compile_module(const digest_type& code_id, const char* code, size_t code_size) {
+         std::lock_guard<std::mutex> compile_lock(compile_mutex);
+         if(auto module = find_cached_module(code_id))
+            return module;
+
+         auto start = fc::time_point::now();
+         auto module = instantiate_module(code, code_size);
+         auto compile_time = fc::time_point::now() - start;
+         {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            ++stats.compilations;
+            stats.compile_time_us += compile_time.count();
+         }
+         cache_module(code_id, module);
+         return module;
+      }
+
+      std::shared_ptr<wasm_instantiated_module_interface> get_instantiated_module(const digest_type& code_id, const char* code, size_t code_size) {
+         if(auto module = find_cached_module(code_id)) {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            ++stats.hits;
+            return module;
+         }
+         {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            ++stats.misses;
+         }
+         return compile_module(code_id, code, code_size);
+      }
+
+      void warmup(const digest_type& code_id, const char* code, size_t code_size) {
+         {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            if(instantiation_cache.count(code_id))
+               return;
+            ++stats.warmups;
+         }
+         boost::asio::post(warmup_thread, [this, code_id, code = std::vector<char>(code, code + code_size)]() {
             try {
-               Serialization::ArrayOutputStream outstream;
-               WASM::serialize(outstream, module);
-               bytes = outstream.getBytes();
-            } catch(Serialization::FatalSerializationException& e) {
-               EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
+               compile_module(code_id, code.data(), code.size());
+            } catch(const fc::exception& e) {
+               wlog("failed to warm up wasm module ${id}: ${e}", ("id", code_id)("e", e.to_detail_string()));
             }
+         });
+      }
 
-            it = instantiation_cache.emplace(code_id, runtime_interface->instantiate_module((const char*)bytes.data(), bytes.size(), parse_initial_memory(module))).first;
-         }
-         return it->second;
+      wasm_cache_stats get_cache_stats() {
+         std::lock_guard<std::mutex> lock(cache_mutex);
+         auto result = stats;
+         result.size = instantiation_cache.size();
+         result.capacity = module_cache_size;
+         return result;
       }
 
+      struct cached_module {
+         std::shared_ptr<wasm_instantiated_module_interface> module;
+         std::list<digest_type>::iterator                    lru_position;
+      };
+
       std::unique_ptr<wasm_runtime_interface> runtime_interface;
-      map<digest_type, std::unique_ptr<wasm_instantiated_module_interface>> instantiation_cache;
+      const uint32_t                          module_cache_size;
+      std::mutex                              cache_mutex;   ///< guards the cache, the LRU order and the stats
+      std::mutex                              compile_mutex; ///< runtimes compile one module at a time
+      map<digest_type, cached_module>         instantiation_cache;
+      std::list<digest_type>                  lru;
+      wasm_cache_stats                        stats;
+      boost::asio::thread_pool                warmup_thread{1};
    };
 
 #define _REGISTER_INTRINSIC_EXPLICIT(CLS, MOD, METHOD, WASM_SIG, NAME, SIG)\
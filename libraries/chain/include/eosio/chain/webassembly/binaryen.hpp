@@ -7,6 +7,10 @@
 #include <wasm-interpreter.h>
 #include <softfloat_types.h>
 
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
 
 namespace eosio { namespace chain { namespace webassembly { namespace binaryen {
 
@@ -34,14 +38,65 @@ struct intrinsic_registrator {
    }
 };
 
-using import_lut_type = unordered_map<uintptr_t, intrinsic_registrator::intrinsic_fn>;
+/**
+ * The intrinsics of a module's imports, resolved once when the module is instantiated. The interpreter hands
+ * callImport the Import itself rather than its number, and binaryen's Import has no room for one, so the
+ * intrinsics are kept in an open addressed table keyed by the address of the Import. The table is at most half
+ * full, so a host call usually costs one multiply and one probe, where an unordered_map or a search over the
+ * sorted addresses cost several times that
+ */
+struct import_table_type {
+   using intrinsic_fn = intrinsic_registrator::intrinsic_fn;
+
+   explicit import_table_type(size_t num_imports) {
+      size_t size = 2;
+      while (size < 2 * num_imports)
+         size *= 2;
+      slots.resize(size, {nullptr, nullptr});
+      for (shift = 64; size > 1; size /= 2)
+         --shift;
+   }
+
+   void add(const Import* import, intrinsic_fn fn) {
+      auto& slot = slots[probe(import)];
+      FC_ASSERT(slot.first == nullptr, "import resolved twice");
+      slot = {import, fn};
+   }
+
+   intrinsic_fn find(const Import* import) const {
+      const auto& slot = slots[probe(import)];
+      EOS_ASSERT(slot.first == import, wasm_execution_error, "unknown import ${m}:${n}", ("m", import->module.c_str())("n", import->base.c_str()));
+      return slot.second;
+   }
+
+   private:
+      vector<pair<const Import*, intrinsic_fn>>  slots;      ///< a power of two in size, empty slots have no Import
+      uint32_t                                   shift = 63; ///< keeps the top log2(slots.size()) bits of the hash
+
+      /// the slot holding the import, or the empty slot where it belongs
+      size_t probe(const Import* import) const {
+         const size_t mask = slots.size() - 1;
+         size_t index = size_t(((uint64_t)(uintptr_t)import * 11400714819323198485ull) >> shift);
+         while (slots[index].first != nullptr && slots[index].first != import)
+            index = (index + 1) & mask;
+         return index;
+      }
+};
 
 
 struct interpreter_interface : ModuleInstance::ExternalInterface {
-   interpreter_interface(linear_memory_type& memory, call_indirect_table_type& table, import_lut_type& import_lut, const unsigned& initial_memory_size, apply_context& context)
-   :memory(memory),table(table),import_lut(import_lut), current_memory_size(initial_memory_size), context(context)
+   interpreter_interface(linear_memory_type& memory, const call_indirect_table_type& table, const import_table_type& imports)
+   :memory(memory),table(table),imports(imports)
    {}
 
+   /**
+    * Point the interface at the action about to execute, with the memory back at its initial size
+    */
+   void bind(apply_context& action_context, unsigned initial_memory_size) {
+      context = &action_context;
+      current_memory_size = initial_memory_size;
+   }
+
    void importGlobals(std::map<Name, Literal>& globals, Module& wasm) override
    {
 
@@ -53,9 +108,7 @@ struct interpreter_interface : ModuleInstance::ExternalInterface {
 
    Literal callImport(Import *import, LiteralList &args) override
    {
-      auto fn_iter = import_lut.find((uintptr_t)import);
-      EOS_ASSERT(fn_iter != import_lut.end(), wasm_execution_error, "unknown import ${m}:${n}", ("m", import->module.c_str())("n", import->module.c_str()));
-      return fn_iter->second(this, args);
+      return imports.find(import)(this, args);
    }
 
    Literal callTable(Index index, LiteralList& arguments, WasmType result, ModuleInstance& instance) override
@@ -131,11 +184,49 @@ struct interpreter_interface : ModuleInstance::ExternalInterface {
    void store32(Address addr, int32_t value) override { store_memory(addr, value); }
    void store64(Address addr, int64_t value) override { store_memory(addr, value); }
 
-   linear_memory_type&          memory;
-   call_indirect_table_type&    table;
-   import_lut_type&             import_lut;
-   unsigned                     current_memory_size;
-   apply_context&               context;
+   linear_memory_type&              memory;
+   const call_indirect_table_type&  table;
+   const import_table_type&         imports;
+   unsigned                         current_memory_size = 0;
+   apply_context*                   context = nullptr;
+};
+
+/**
+ * An instance of a module that is reused from one action to the next. Constructing a ModuleInstance evaluates
+ * the globals and runs the start function, reset() puts an existing instance back into that state instead
+ */
+class resettable_instance : public ModuleInstance {
+   public:
+      resettable_instance(Module& wasm, ExternalInterface* external_interface)
+      :ModuleInstance(wasm, external_interface), initial_globals(evaluate_globals(wasm))
+      {}
+
+      /**
+       * Restore the globals and memory size the instance was constructed with, and run the start function again.
+       * The linear memory itself is restored by the caller
+       */
+      void reset() {
+         // the set of globals never changes after construction, so both maps hold the same names in the same order
+         auto initial = initial_globals.begin();
+         for (auto& global : globals)
+            global.second = (initial++)->second;
+         memorySize = wasm.memory.initial;
+         if (wasm.start.is()) {
+            LiteralList arguments;
+            callFunction(wasm.start, arguments);
+         }
+      }
+
+   private:
+      /// the globals as they are before the start function runs
+      static TrivialGlobalManager evaluate_globals(Module& wasm) {
+         TrivialGlobalManager result;
+         for (auto& global : wasm.globals)
+            result[global->name] = ConstantExpressionRunner<TrivialGlobalManager>(result).visit(global->init).value;
+         return result;
+      }
+
+      const TrivialGlobalManager initial_globals;
 };
 
 class binaryen_runtime : public eosio::chain::wasm_runtime_interface {
@@ -143,8 +234,15 @@ class binaryen_runtime : public eosio::chain::wasm_runtime_interface {
       binaryen_runtime();
       std::unique_ptr<wasm_instantiated_module_interface> instantiate_module(const char* code_bytes, size_t code_size, std::vector<uint8_t> initial_memory) override;
 
+      /**
+       * The linear memory that the modules executed on the calling thread share. Each thread gets its own
+       * memory, so modules may execute on several threads at once
+       */
+      linear_memory_type& get_thread_memory();
+
    private:
-      linear_memory_type                  _memory __attribute__ ((aligned (4096)));
+      std::mutex                                                        _thread_memories_mutex;
+      std::unordered_map<std::thread::id, std::unique_ptr<linear_memory_type>> _thread_memories;
 };
 
 /**
@@ -602,7 +700,7 @@ struct intrinsic_function_invoker {
 
    template<MethodSig Method>
    static Ret wrapper(interpreter_interface* interface, Params... params, LiteralList&, int) {
-      return (class_from_wasm<Cls>::value(interface->context).*Method)(params...);
+      return (class_from_wasm<Cls>::value(*interface->context).*Method)(params...);
    }
 
    template<MethodSig Method>
@@ -617,7 +715,7 @@ struct intrinsic_function_invoker<void, MethodSig, Cls, Params...> {
 
    template<MethodSig Method>
    static void_type wrapper(interpreter_interface* interface, Params... params, LiteralList& args, int offset) {
-      (class_from_wasm<Cls>::value(interface->context).*Method)(params...);
+      (class_from_wasm<Cls>::value(*interface->context).*Method)(params...);
       return void_type();
    }
 
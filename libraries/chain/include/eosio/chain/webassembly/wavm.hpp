@@ -6,6 +6,10 @@
 #include "Runtime/Runtime.h"
 #include "IR/Types.h"
 
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
 
 namespace eosio { namespace chain { namespace webassembly { namespace wavm {
 
@@ -16,25 +20,39 @@ using namespace eosio::chain::webassembly::common;
 
 class wavm_runtime : public eosio::chain::wasm_runtime_interface {
    public:
-      wavm_runtime();
+      /// machine code of instantiated modules is cached in jit_cache_dir across restarts, unless it is empty, the
+      /// oldest entries are removed beyond jit_cache_size bytes
+      wavm_runtime(const fc::path& jit_cache_dir, uint64_t jit_cache_size);
       ~wavm_runtime();
       std::unique_ptr<wasm_instantiated_module_interface> instantiate_module(const char* code_bytes, size_t code_size, std::vector<uint8_t> initial_memory) override;
 
+      /**
+       * The memory that the modules executed on the calling thread share. Each thread gets its own memory,
+       * so modules may execute on several threads at once
+       */
+      MemoryInstance* get_thread_memory();
+
       struct runtime_guard {
          runtime_guard();
          ~runtime_guard();
       };
 
    private:
-      std::shared_ptr<runtime_guard> _runtime_guard;
+      std::shared_ptr<runtime_guard>                    _runtime_guard;
+      bool                                              _jit_cache_enabled = false;
+      std::mutex                                        _thread_memories_mutex;
+      std::unordered_map<std::thread::id, MemoryInstance*> _thread_memories;
 };
 
-//This is a temporary hack for the single threaded implementation
+/**
+ * The action being executed on the calling thread, for the intrinsics it calls. A thread executes
+ * one action at a time
+ */
 struct running_instance_context {
    MemoryInstance* memory;
    apply_context*  apply_ctx;
 };
-extern running_instance_context the_running_instance_context;
+extern thread_local running_instance_context the_running_instance_context;
 
 /**
  * class to represent an in-wasm-memory array
@@ -7,6 +7,7 @@
 #include <fc/bitutil.hpp>
 #include <fc/smart_ref_impl.hpp>
 #include <algorithm>
+#include <mutex>
 
 #include <boost/range/adaptor/transformed.hpp>
 #include <boost/multi_index_container.hpp>
@@ -77,18 +78,26 @@ flat_set<public_key_type> transaction::get_signature_keys( const vector<signatur
 
    constexpr size_t recovery_cache_size = 100000;
    static recovery_cache_type recovery_cache;
+   static std::mutex recovery_cache_mutex; // keys may be recovered from several threads at once
    const digest_type digest = sig_digest(chain_id, cfd);
+   const transaction_id_type trx_id = id();
 
    flat_set<public_key_type> recovered_pub_keys;
    for(const signature_type& sig : signatures) {
-      recovery_cache_type::index<by_sig>::type::iterator it = recovery_cache.get<by_sig>().find(sig);
-
       public_key_type recov;
-      if(it == recovery_cache.get<by_sig>().end() || it->trx_id != id()) {
+      bool cached = false;
+      {
+         std::lock_guard<std::mutex> lock(recovery_cache_mutex);
+         auto it = recovery_cache.get<by_sig>().find(sig);
+         if(it != recovery_cache.get<by_sig>().end() && it->trx_id == trx_id) {
+            recov = it->pub_key;
+            cached = true;
+         }
+      }
+      if(!cached) {
          recov = public_key_type(sig, digest);
-         recovery_cache.emplace_back( cached_pub_key{id(), recov, sig} ); //could fail on dup signatures; not a problem
-      } else {
-         recov = it->pub_key;
+         std::lock_guard<std::mutex> lock(recovery_cache_mutex);
+         recovery_cache.emplace_back( cached_pub_key{trx_id, recov, sig} ); //could fail on dup signatures; not a problem
       }
       bool successful_insertion = false;
       std::tie(std::ignore, successful_insertion) = recovered_pub_keys.insert(recov);
@@ -98,8 +107,11 @@ flat_set<public_key_type> transaction::get_signature_keys( const vector<signatur
                );
    }
 
-   while(recovery_cache.size() > recovery_cache_size)
-      recovery_cache.erase(recovery_cache.begin());
+   {
+      std::lock_guard<std::mutex> lock(recovery_cache_mutex);
+      while(recovery_cache.size() > recovery_cache_size)
+         recovery_cache.erase(recovery_cache.begin());
+   }
 
    return recovered_pub_keys;
 } FC_CAPTURE_AND_RETHROW() }
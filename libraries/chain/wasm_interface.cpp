@@ -10,6 +10,7 @@
 #include <eosio/chain/wasm_interface_private.hpp>
 #include <eosio/chain/wasm_eosio_validation.hpp>
 #include <eosio/chain/wasm_eosio_injection.hpp>
+#include <eosio/chain/native_float.hpp>
 #include <fc/exception/exception.hpp>
 #include <fc/crypto/sha256.hpp>
 #include <fc/crypto/sha1.hpp>
@@ -26,7 +27,8 @@ namespace eosio { namespace chain {
    using namespace webassembly;
    using namespace webassembly::common;
 
-   wasm_interface::wasm_interface(vm_type vm) : my( new wasm_interface_impl(vm) ) {}
+   wasm_interface::wasm_interface(vm_type vm, uint32_t module_cache_size, const fc::path& jit_cache_dir, uint64_t jit_cache_size, bool enable_native_float)
+   : my( new wasm_interface_impl(vm, module_cache_size, jit_cache_dir, jit_cache_size) ), use_native_float(enable_native_float && native_float::enabled()) {}
 
    wasm_interface::~wasm_interface() {}
 
@@ -51,7 +53,16 @@ namespace eosio { namespace chain {
    }
 
    void wasm_interface::apply( const digest_type& code_id, const shared_vector<char>& code, apply_context& context ) {
-      my->get_instantiated_module(code_id, code)->apply(context);
+      auto module = my->get_instantiated_module(code_id, code.data(), code.size());
+      module->apply(context);
+   }
+
+   void wasm_interface::warmup( const digest_type& code_id, const char* code, size_t code_size ) {
+      my->warmup(code_id, code, code_size);
+   }
+
+   wasm_cache_stats wasm_interface::get_cache_stats()const {
+      return my->get_cache_stats();
    }
 
    wasm_instantiated_module_interface::~wasm_instantiated_module_interface() {}
@@ -206,21 +217,38 @@ public:
 class softfloat_api : public context_aware_api {
    public:
       // TODO add traps on truncations for special cases (NaN or outside the range which rounds to an integer)
-      using context_aware_api::context_aware_api;
+      // add, sub, mul, div and sqrt take the native result when the node opted in and it is known to be that of
+      // softfloat, see native_float
+      softfloat_api( apply_context& ctx, bool context_free = false )
+      :context_aware_api(ctx, context_free)
+      ,native_enabled(ctx.mutable_controller.get_wasm_interface().native_float_enabled())
+      {}
       // float binops
       float _eosio_f32_add( float a, float b ) {
+         float result;
+         if (native_enabled && native_float::add(a, b, result))
+            return result;
          float32_t ret = f32_add( to_softfloat32(a), to_softfloat32(b) );
          return *reinterpret_cast<float*>(&ret);
       }
       float _eosio_f32_sub( float a, float b ) {
+         float result;
+         if (native_enabled && native_float::sub(a, b, result))
+            return result;
          float32_t ret = f32_sub( to_softfloat32(a), to_softfloat32(b) );
          return *reinterpret_cast<float*>(&ret);
       }
       float _eosio_f32_div( float a, float b ) {
+         float result;
+         if (native_enabled && native_float::div(a, b, result))
+            return result;
          float32_t ret = f32_div( to_softfloat32(a), to_softfloat32(b) );
          return *reinterpret_cast<float*>(&ret);
       }
       float _eosio_f32_mul( float a, float b ) {
+         float result;
+         if (native_enabled && native_float::mul(a, b, result))
+            return result;
          float32_t ret = f32_mul( to_softfloat32(a), to_softfloat32(b) );
          return *reinterpret_cast<float*>(&ret);
       }
@@ -275,6 +303,9 @@ class softfloat_api : public context_aware_api {
          return from_softfloat32(a);
       }
       float _eosio_f32_sqrt( float a ) {
+         float result;
+         if (native_enabled && native_float::sqrt(a, result))
+            return result;
          float32_t ret = f32_sqrt( to_softfloat32(a) );
          return from_softfloat32(ret);
       }
@@ -378,18 +409,30 @@ class softfloat_api : public context_aware_api {
 
       // double binops
       double _eosio_f64_add( double a, double b ) {
+         double result;
+         if (native_enabled && native_float::add(a, b, result))
+            return result;
          float64_t ret = f64_add( to_softfloat64(a), to_softfloat64(b) );
          return from_softfloat64(ret);
       }
       double _eosio_f64_sub( double a, double b ) {
+         double result;
+         if (native_enabled && native_float::sub(a, b, result))
+            return result;
          float64_t ret = f64_sub( to_softfloat64(a), to_softfloat64(b) );
          return from_softfloat64(ret);
       }
       double _eosio_f64_div( double a, double b ) {
+         double result;
+         if (native_enabled && native_float::div(a, b, result))
+            return result;
          float64_t ret = f64_div( to_softfloat64(a), to_softfloat64(b) );
          return from_softfloat64(ret);
       }
       double _eosio_f64_mul( double a, double b ) {
+         double result;
+         if (native_enabled && native_float::mul(a, b, result))
+            return result;
          float64_t ret = f64_mul( to_softfloat64(a), to_softfloat64(b) );
          return from_softfloat64(ret);
       }
@@ -439,6 +482,9 @@ class softfloat_api : public context_aware_api {
          return from_softfloat64(a);
       }
       double _eosio_f64_sqrt( double a ) {
+         double result;
+         if (native_enabled && native_float::sqrt(a, result))
+            return result;
          float64_t ret = f64_sqrt( to_softfloat64(a) );
          return from_softfloat64(ret);
       }
@@ -672,6 +718,9 @@ class softfloat_api : public context_aware_api {
       static bool sign_bit( float32_t f ) { return f.v >> 31; }
       static bool sign_bit( float64_t f ) { return f.v >> 63; }
 
+   private:
+      const bool native_enabled;
+
 };
 class producer_api : public context_aware_api {
    public:
@@ -1094,6 +1143,9 @@ class database_api : public context_aware_api {
       int db_get_i64( int itr, array_ptr<char> buffer, size_t buffer_size ) {
          return context.db_get_i64( itr, buffer, buffer_size );
       }
+      int db_get_range_i64( int itr, array_ptr<char> buffer, size_t buffer_size, uint32_t max_rows ) {
+         return context.db_get_range_i64( itr, buffer, buffer_size, max_rows );
+      }
       int db_next_i64( int itr, uint64_t& primary ) {
          return context.db_next_i64(itr, primary);
       }
@@ -1634,6 +1686,7 @@ REGISTER_INTRINSICS( database_api,
    (db_update_i64,       void(int,int64_t,int,int))
    (db_remove_i64,       void(int))
    (db_get_i64,          int(int, int, int))
+   (db_get_range_i64,    int(int, int, int, int))
    (db_next_i64,         int(int, int))
    (db_previous_i64,     int(int, int))
    (db_find_i64,         int(int64_t,int64_t,int64_t,int64_t))
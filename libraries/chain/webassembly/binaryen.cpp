@@ -8,15 +8,15 @@ namespace eosio { namespace chain { namespace webassembly { namespace binaryen {
 
 class binaryen_instantiated_module : public wasm_instantiated_module_interface {
    public:
-      binaryen_instantiated_module(linear_memory_type& shared_linear_memory,
+      binaryen_instantiated_module(binaryen_runtime& runtime,
                                    std::vector<uint8_t> initial_memory,
                                    call_indirect_table_type table,
-                                   import_lut_type import_lut,
+                                   import_table_type imports,
                                    unique_ptr<Module>&& module) :
-         _shared_linear_memory(shared_linear_memory),
+         _runtime(runtime),
          _initial_memory(initial_memory),
          _table(forward<decltype(table)>(table)),
-         _import_lut(forward<decltype(import_lut)>(import_lut)),
+         _imports(forward<decltype(imports)>(imports)),
          _module(forward<decltype(module)>(module)) {
 
       }
@@ -29,24 +29,51 @@ class binaryen_instantiated_module : public wasm_instantiated_module_interface {
       }
 
    private:
-      linear_memory_type&        _shared_linear_memory;      
+      /// what one thread keeps of the module from one action to the next
+      struct thread_instance {
+         thread_instance(linear_memory_type& memory, const call_indirect_table_type& table, const import_table_type& imports)
+         :interface(memory, table, imports)
+         {}
+
+         interpreter_interface            interface;
+         unique_ptr<resettable_instance>  instance;
+      };
+
+      binaryen_runtime&          _runtime;
       std::vector<uint8_t>       _initial_memory;
       call_indirect_table_type   _table;
-      import_lut_type            _import_lut;
+      import_table_type          _imports;
       unique_ptr<Module>          _module;
 
+      std::mutex                                                     _thread_instances_mutex;
+      std::unordered_map<std::thread::id, unique_ptr<thread_instance>> _thread_instances;
+
+      thread_instance& get_thread_instance() {
+         linear_memory_type& thread_memory = _runtime.get_thread_memory();
+         std::lock_guard<std::mutex> lock(_thread_instances_mutex);
+         auto& entry = _thread_instances[std::this_thread::get_id()];
+         if (!entry)
+            entry = std::make_unique<thread_instance>(thread_memory, _table, _imports);
+         return *entry;
+      }
+
       void call(const string& entry_point, LiteralList& args, apply_context& context){
          const unsigned initial_memory_size = _module->memory.initial*Memory::kPageSize;
-         interpreter_interface local_interface(_shared_linear_memory, _table, _import_lut, initial_memory_size, context);
+         //the module, table and import table are only read, each thread has its own memory and instance
+         thread_instance& local = get_thread_instance();
+         local.interface.bind(context, initial_memory_size);
 
          //zero out the initial pages
-         memset(_shared_linear_memory.data, 0, initial_memory_size);
+         memset(local.interface.memory.data, 0, initial_memory_size);
          //copy back in the initial data
-         memcpy(_shared_linear_memory.data, _initial_memory.data(), _initial_memory.size());
-         
-         //be aware that construction of the ModuleInstance implictly fires the start function
-         ModuleInstance instance(*_module.get(), &local_interface);
-         instance.callExport(Name(entry_point), args);
+         memcpy(local.interface.memory.data, _initial_memory.data(), _initial_memory.size());
+
+         //be aware that construction of the instance, and resetting it, implictly fires the start function
+         if (!local.instance)
+            local.instance = std::make_unique<resettable_instance>(*_module.get(), &local.interface);
+         else
+            local.instance->reset();
+         local.instance->callExport(Name(entry_point), args);
       }
 };
 
@@ -54,6 +81,14 @@ binaryen_runtime::binaryen_runtime() {
 
 }
 
+linear_memory_type& binaryen_runtime::get_thread_memory() {
+   std::lock_guard<std::mutex> lock(_thread_memories_mutex);
+   auto& memory = _thread_memories[std::this_thread::get_id()];
+   if (!memory)
+      memory = std::make_unique<linear_memory_type>();
+   return *memory;
+}
+
 std::unique_ptr<wasm_instantiated_module_interface> binaryen_runtime::instantiate_module(const char* code_bytes, size_t code_size, std::vector<uint8_t> initial_memory) {
    try {
       vector<char> code(code_bytes, code_bytes + code_size);
@@ -79,16 +114,15 @@ std::unique_ptr<wasm_instantiated_module_interface> binaryen_runtime::instantiat
          }
       }
 
-      // initialize the import lut
-      import_lut_type import_lut;
-      import_lut.reserve(module->imports.size());
+      // resolve the imports to their intrinsics
+      import_table_type imports(module->imports.size());
       for (auto& import : module->imports) {
          std::string full_name = string(import->module.c_str()) + "." + string(import->base.c_str());
          if (import->kind == ExternalKind::Function) {
             auto& intrinsic_map = intrinsic_registrator::get_map();
             auto intrinsic_itr = intrinsic_map.find(full_name);
             if (intrinsic_itr != intrinsic_map.end()) {
-               import_lut.emplace(make_pair((uintptr_t)import.get(), intrinsic_itr->second));
+               imports.add(import.get(), intrinsic_itr->second);
                continue;
             }
          }
@@ -96,7 +130,7 @@ std::unique_ptr<wasm_instantiated_module_interface> binaryen_runtime::instantiat
          FC_ASSERT( !"unresolvable", "${module}.${export}", ("module",import->module.c_str())("export",import->base.c_str()) );
       }
 
-      return std::make_unique<binaryen_instantiated_module>(_memory, initial_memory, move(table), move(import_lut), move(module));
+      return std::make_unique<binaryen_instantiated_module>(*this, initial_memory, move(table), move(imports), move(module));
    } catch (const ParseException &e) {
       FC_THROW_EXCEPTION(wasm_execution_error, "Error building interpreter: ${s}", ("s", e.text));
    }
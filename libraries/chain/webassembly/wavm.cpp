@@ -12,22 +12,89 @@
 #include "Runtime/Linker.h"
 #include "Runtime/Intrinsics.h"
 
+#include <algorithm>
 #include <mutex>
+#include <unordered_set>
 
 using namespace IR;
 using namespace Runtime;
 
 namespace eosio { namespace chain { namespace webassembly { namespace wavm {
 
-running_instance_context the_running_instance_context;
+thread_local running_instance_context the_running_instance_context;
+
+/**
+ * WAVM frees module instances, their machine code and memories by garbage collection, which must not run while
+ * another thread creates objects or runs code. The instances and memories that the runtimes still use are the roots
+ * of every collection. Objects are released when their module is evicted or their runtime destroyed, and once
+ * enough of them are released a collection runs as soon as no thread is creating objects or executing, by
+ * whichever thread is the last to leave. Creating and executing only hold the lock to count themselves, so a
+ * compilation on one thread never holds up execution on another
+ */
+struct gc_roots {
+   static gc_roots& get() {
+      static gc_roots roots;
+      return roots;
+   }
+
+   /// a collection walks every object, so it waits for this many releases
+   static constexpr uint32_t collection_batch = 16;
+
+   /// counts the calling thread as creating objects or executing code until it is destroyed
+   struct activity {
+      activity() {
+         gc_roots& roots = get();
+         std::lock_guard<std::mutex> lock(roots.mutex);
+         ++roots.active;
+      }
+
+      ~activity() {
+         gc_roots& roots = get();
+         std::lock_guard<std::mutex> lock(roots.mutex);
+         if(root)
+            roots.objects.insert(root);
+         --roots.active;
+         roots.collect_if_due();
+      }
+
+      /// the object created, made a root as the activity ends
+      ObjectInstance* root = nullptr;
+   };
+
+   /// the objects are no longer used, a later collection frees them and whatever only they reference
+   void release(const std::vector<ObjectInstance*>& released, bool collect_soon = false) {
+      std::lock_guard<std::mutex> lock(mutex);
+      for(auto* object : released)
+         objects.erase(object);
+      releases = collect_soon ? std::max(releases, collection_batch) : releases + released.size();
+      collect_if_due();
+   }
+
+   private:
+      /// must hold mutex
+      void collect_if_due() {
+         if(active || releases < collection_batch)
+            return;
+         freeUnreferencedObjects(std::vector<ObjectInstance*>(objects.begin(), objects.end()));
+         releases = 0;
+      }
+
+      std::mutex                          mutex;
+      std::unordered_set<ObjectInstance*> objects;
+      uint32_t                            active = 0;   ///< threads creating objects or executing code
+      uint32_t                            releases = 0; ///< objects released since the last collection
+};
 
 class wavm_instantiated_module : public wasm_instantiated_module_interface {
    public:
-      wavm_instantiated_module(ModuleInstance* instance, Module* module, std::vector<uint8_t> initial_mem) :
-         _initial_memory(initial_mem),
+      wavm_instantiated_module(wavm_runtime& runtime, ModuleInstance* instance, Module* module, const std::vector<uint8_t>& initial_mem) :
+         _runtime(runtime),
+         _initial_memory(createMemorySnapshot(initial_mem.data(), initial_mem.size())),
          _instance(instance),
          _module(module)
-      {}
+      {
+         _thread_instances.emplace(runtime.get_thread_memory(), instance);
+      }
 
       void apply(apply_context& context) override {
          vector<Value> args = {Value(uint64_t(context.receiver)),
@@ -38,36 +105,64 @@ class wavm_instantiated_module : public wasm_instantiated_module_interface {
       }
 
       ~wavm_instantiated_module() {
+         std::vector<ObjectInstance*> instances;
+         for(const auto& thread_instance : _thread_instances)
+            instances.push_back(asObject(thread_instance.second));
+         gc_roots::get().release(instances);
+         deleteMemorySnapshot(_initial_memory);
          delete _module;
-         //_instance is deleted via WAVM's object garbage collection when wavm_rutime is deleted
       }
 
    private:
+      /**
+       * The instance bound to the calling thread's memory, which only that thread executes. The first call on
+       * each other thread links another instance against the machine code of the one created at instantiation
+       */
+      ModuleInstance* get_thread_instance() {
+         MemoryInstance* thread_memory = _runtime.get_thread_memory();
+         {
+            std::lock_guard<std::mutex> lock(_thread_instances_mutex);
+            auto it = _thread_instances.find(thread_memory);
+            if(it != _thread_instances.end())
+               return it->second;
+         }
+         ModuleInstance* instance;
+         {
+            gc_roots::activity cloning;
+            instance = cloneModuleInstance(*_module, _instance, thread_memory);
+            FC_ASSERT(instance != nullptr);
+            cloning.root = asObject(instance);
+         }
+         std::lock_guard<std::mutex> lock(_thread_instances_mutex);
+         _thread_instances.emplace(thread_memory, instance);
+         return instance;
+      }
+
       void call(const string &entry_point, const vector <Value> &args, apply_context &context) {
          try {
-            FunctionInstance* call = asFunctionNullable(getInstanceExport(_instance,entry_point));
+            ModuleInstance* instance = get_thread_instance();
+            gc_roots::activity executing;
+            FunctionInstance* call = asFunctionNullable(getInstanceExport(instance,entry_point));
             if( !call )
                return;
 
             FC_ASSERT( getFunctionType(call)->parameters.size() == args.size() );
 
-            //The memory instance is reused across all wavm_instantiated_modules, but for wasm instances
+            //The thread's memory instance is reused across all wavm_instantiated_modules, but for wasm instances
             // that didn't declare "memory", getDefaultMemory() won't see it
-            MemoryInstance* default_mem = getDefaultMemory(_instance);
+            MemoryInstance* default_mem = getDefaultMemory(instance);
             if(default_mem) {
-               //reset memory resizes the sandbox'ed memory to the module's init memory size and then
-               // (effectively) memzeros it all
-               resetMemory(default_mem, _module->memories.defs[0].type);
-
-               char* memstart = &memoryRef<char>(getDefaultMemory(_instance), 0);
-               memcpy(memstart, _initial_memory.data(), _initial_memory.size());
+               //reset memory resizes the sandbox'ed memory to the module's init memory size and restores its
+               // initial image. The image is mapped copy-on-write, so only the pages the previous action wrote
+               // cost anything to reset
+               resetMemory(default_mem, _module->memories.defs[0].type, _initial_memory);
             }
 
             the_running_instance_context.memory = default_mem;
             the_running_instance_context.apply_ctx = &context;
 
-            resetGlobalInstances(_instance);
-            runInstanceStartFunc(_instance);
+            resetGlobalInstances(instance);
+            runInstanceStartFunc(instance);
             Runtime::invokeFunction(call,args);
          } catch( const wasm_exit& e ) {
          } catch( const Runtime::Exception& e ) {
@@ -79,10 +174,14 @@ class wavm_instantiated_module : public wasm_instantiated_module_interface {
       }
 
 
-      std::vector<uint8_t> _initial_memory;
+      wavm_runtime&        _runtime;
+      MemorySnapshot*      _initial_memory;
       //naked pointers because ModuleInstance is opaque
       ModuleInstance*      _instance;
       Module*              _module;
+
+      std::mutex                                          _thread_instances_mutex;
+      std::unordered_map<MemoryInstance*, ModuleInstance*> _thread_instances;
 };
 
 
@@ -99,7 +198,7 @@ wavm_runtime::runtime_guard::~runtime_guard() {
 static weak_ptr<wavm_runtime::runtime_guard> __runtime_guard_ptr;
 static std::mutex __runtime_guard_lock;
 
-wavm_runtime::wavm_runtime() {
+wavm_runtime::wavm_runtime(const fc::path& jit_cache_dir, uint64_t jit_cache_size) {
    std::lock_guard<std::mutex> l(__runtime_guard_lock);
    if (__runtime_guard_ptr.use_count() == 0) {
       _runtime_guard = std::make_shared<runtime_guard>();
@@ -107,9 +206,33 @@ wavm_runtime::wavm_runtime() {
    } else {
       _runtime_guard = __runtime_guard_ptr.lock();
    }
+
+   if (!jit_cache_dir.empty()) {
+      if (!fc::exists(jit_cache_dir))
+         fc::create_directories(jit_cache_dir);
+      Runtime::setObjectCacheDirectory(jit_cache_dir.generic_string(), jit_cache_size);
+      _jit_cache_enabled = true;
+   }
 }
 
 wavm_runtime::~wavm_runtime() {
+   std::vector<ObjectInstance*> memories;
+   for(const auto& thread_memory : _thread_memories)
+      memories.push_back(asObject(thread_memory.second));
+   gc_roots::get().release(memories, true);
+}
+
+MemoryInstance* wavm_runtime::get_thread_memory() {
+   std::lock_guard<std::mutex> lock(_thread_memories_mutex);
+   MemoryInstance*& memory = _thread_memories[std::this_thread::get_id()];
+   if (!memory) {
+      gc_roots::activity creating;
+      //resized to each module's initial memory size before it executes
+      memory = createMemory(MemoryType());
+      FC_ASSERT(memory != nullptr, "failed to reserve wasm memory");
+      creating.root = asObject(memory);
+   }
+   return memory;
 }
 
 std::unique_ptr<wasm_instantiated_module_interface> wavm_runtime::instantiate_module(const char* code_bytes, size_t code_size, std::vector<uint8_t> initial_memory) {
@@ -123,10 +246,21 @@ std::unique_ptr<wasm_instantiated_module_interface> wavm_runtime::instantiate_mo
 
    eosio::chain::webassembly::common::root_resolver resolver;
    LinkResult link_result = linkModule(*module, resolver);
-   ModuleInstance *instance = instantiateModule(*module, std::move(link_result.resolvedImports));
-   FC_ASSERT(instance != nullptr);
 
-   return std::make_unique<wavm_instantiated_module>(instance, module, initial_memory);
+   //the cache is keyed by the injected code, so a change to the injection doesn't load code compiled before it
+   string object_cache_key;
+   if (_jit_cache_enabled)
+      object_cache_key = fc::sha256::hash(code_bytes, code_size).str();
+   MemoryInstance* thread_memory = get_thread_memory();
+   ModuleInstance* instance;
+   {
+      gc_roots::activity compiling;
+      instance = instantiateModule(*module, std::move(link_result.resolvedImports), object_cache_key, thread_memory);
+      FC_ASSERT(instance != nullptr);
+      compiling.root = asObject(instance);
+   }
+
+   return std::make_unique<wavm_instantiated_module>(*this, instance, module, initial_memory);
 }
 
 }}}}
@@ -94,6 +94,28 @@ namespace Platform
 	// baseVirtualAddress must be a multiple of the preferred page size.
 	PLATFORM_API void freeVirtualPages(U8* baseVirtualAddress,Uptr numPages);
 
+	// Discards the contents of the specified committed virtual pages: anonymous pages read as zeros again, and the pages of
+	// a mapped image read as the image again. Only the pages that were written since they were committed or mapped cost time.
+	// baseVirtualAddress must be a multiple of the preferred page size.
+	PLATFORM_API void resetVirtualPages(U8* baseVirtualAddress,Uptr numPages);
+
+	// An immutable image of some bytes, that can be mapped copy-on-write into virtual pages.
+	struct VirtualImage;
+
+	// Creates an image of the given bytes, padded with zeros to a whole number of pages.
+	// Returns nullptr if the platform can't map images.
+	PLATFORM_API VirtualImage* createVirtualImage(const U8* bytes,Uptr numBytes);
+	PLATFORM_API void destroyVirtualImage(VirtualImage* image);
+	PLATFORM_API Uptr getVirtualImageNumPages(VirtualImage* image);
+
+	// Maps an image over virtual pages allocated by allocateVirtualPages, with read/write access. Writes to the pages are
+	// private to them, and are discarded by resetVirtualPages. Returns true if successful.
+	// baseVirtualAddress must be a multiple of the preferred page size.
+	PLATFORM_API bool mapVirtualImage(VirtualImage* image,U8* baseVirtualAddress);
+
+	// Replaces an image mapped at baseVirtualAddress by uncommitted virtual pages.
+	PLATFORM_API void unmapVirtualImage(VirtualImage* image,U8* baseVirtualAddress);
+
 	//
 	// Call stack and exceptions
 	//
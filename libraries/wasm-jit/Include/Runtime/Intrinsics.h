@@ -93,6 +93,11 @@ namespace Intrinsics
 	// Finds an intrinsic object by name and type.
 	RUNTIME_API Runtime::ObjectInstance* find(const std::string& name,const IR::ObjectType& type);
 
+	// Gets the name an intrinsic object is registered under, its name decorated with its type, and finds an intrinsic
+	// function by that name.
+	RUNTIME_API std::string getDecoratedName(const std::string& name,const IR::ObjectType& type);
+	RUNTIME_API Runtime::FunctionInstance* findFunction(const std::string& decoratedName);
+
 	// Returns an array of all intrinsic runtime Objects; used as roots for garbage collection.
 	RUNTIME_API std::vector<Runtime::ObjectInstance*> getAllIntrinsicObjects();
 }
@@ -114,6 +114,7 @@ namespace Runtime
 	inline ModuleInstance* asModuleNullable(ObjectInstance* object)	{ return object && object->kind == IR::ObjectKind::module ? (ModuleInstance*)object : nullptr; }
 	
 	// Frees unreferenced Objects, using the provided array of Objects as the root set.
+	// Must not be called while other threads are creating objects or running code.
 	RUNTIME_API void freeUnreferencedObjects(std::vector<ObjectInstance*>&& rootObjectReferences);
 
 	//
@@ -168,6 +169,13 @@ namespace Runtime
 
 	// Validates that an offset range is wholly inside a Memory's virtual address range.
 	RUNTIME_API U8* getValidatedMemoryOffsetRange(MemoryInstance* memory,Uptr offset,Uptr numBytes);
+
+	// An immutable copy of the initial contents of a memory, that resetMemory restores.
+	// Where the platform supports it, the snapshot is mapped copy-on-write into the memory, so restoring it only costs
+	// time for the pages that were written since the last reset.
+	struct MemorySnapshot;
+	RUNTIME_API MemorySnapshot* createMemorySnapshot(const U8* bytes,Uptr numBytes);
+	RUNTIME_API void deleteMemorySnapshot(MemorySnapshot* snapshot);
 	
 	// Validates an access to a single element of memory at the given offset, and returns a reference to it.
 	template<typename Value> Value& memoryRef(MemoryInstance* memory,U32 offset)
@@ -203,7 +211,21 @@ namespace Runtime
 	};
 
 	// Instantiates a module, bindings its imports to the specified objects. May throw InstantiationException.
-	RUNTIME_API ModuleInstance* instantiateModule(const IR::Module& module,ImportBindings&& imports);
+	// If objectCacheKey isn't empty and an object cache directory is set, the module's machine code is loaded from
+	// the object cache entry with that key, or compiled and saved there if the entry is missing or invalid.
+	// The key must identify the module's code, and be usable as a file name.
+	// If memory isn't null, the module's memory definition is bound to it instead of a new memory, so modules that never
+	// run at the same time may share the address space reserved for one memory.
+	RUNTIME_API ModuleInstance* instantiateModule(const IR::Module& module,ImportBindings&& imports,const std::string& objectCacheKey = std::string(),MemoryInstance* memory = nullptr);
+
+	// Creates another instance of the module an instance was instantiated from, with the same imports, and its memory
+	// definition bound to memory like instantiateModule. The new instance reuses the machine code of the existing one
+	// instead of compiling the module again, so it's cheap to create an instance for each thread that runs a module.
+	RUNTIME_API ModuleInstance* cloneModuleInstance(const IR::Module& module,ModuleInstance* moduleInstance,MemoryInstance* memory = nullptr);
+
+	// Sets the directory of the object cache, which keeps the machine code of modules across processes. Empty disables it.
+	// Once its entries exceed maxBytes, those written longest ago are removed.
+	RUNTIME_API void setObjectCacheDirectory(const std::string& directory,U64 maxBytes);
 
 	// Gets the default table/memory for a ModuleInstance.
 	RUNTIME_API MemoryInstance* getDefaultMemory(ModuleInstance* moduleInstance);
@@ -212,7 +234,9 @@ namespace Runtime
 
 	RUNTIME_API void runInstanceStartFunc(ModuleInstance* moduleInstance);
 	RUNTIME_API void resetGlobalInstances(ModuleInstance* moduleInstance);
-	RUNTIME_API void resetMemory(MemoryInstance* memory, IR::MemoryType& newMemoryType);
+	// Resizes a memory to the minimum size of newMemoryType, and resets its contents to the snapshot followed by zeros,
+	// or to all zeros if snapshot is null. The snapshot must fit in the minimum size.
+	RUNTIME_API void resetMemory(MemoryInstance* memory, IR::MemoryType& newMemoryType, const MemorySnapshot* snapshot = nullptr);
 
 	// Gets an object exported by a ModuleInstance by name.
 	RUNTIME_API ObjectInstance* getInstanceExport(ModuleInstance* moduleInstance,const std::string& name);
@@ -28,6 +28,10 @@
 #ifdef __linux__
 	#include <execinfo.h>
 	#include <dlfcn.h>
+	#include <sys/syscall.h>
+	#ifndef MFD_CLOEXEC
+		#define MFD_CLOEXEC 0x0001U
+	#endif
 #endif
 #ifdef __FreeBSD__
 	#include <execinfo.h>
@@ -107,6 +111,71 @@ namespace Platform
 		if(munmap(baseVirtualAddress,numPages << getPageSizeLog2())) { Errors::fatal("munmap failed"); }
 	}
 
+	void resetVirtualPages(U8* baseVirtualAddress,Uptr numPages)
+	{
+		errorUnless(isPageAligned(baseVirtualAddress));
+		auto numBytes = numPages << getPageSizeLog2();
+		#ifdef __linux__
+			// Linux frees the private copies of the pages, so they're read from the mapped file or zero-filled again on the next access.
+			if(madvise(baseVirtualAddress,numBytes,MADV_DONTNEED)) { Errors::fatal("madvise failed"); }
+		#else
+			// MADV_DONTNEED doesn't necessarily discard the contents of the pages elsewhere, so replace them with new anonymous pages.
+			if(mmap(baseVirtualAddress,numBytes,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED,-1,0) == MAP_FAILED) { Errors::fatal("mmap failed"); }
+		#endif
+	}
+
+	struct VirtualImage
+	{
+		int fd;
+		Uptr numPages;
+	};
+
+	VirtualImage* createVirtualImage(const U8* bytes,Uptr numBytes)
+	{
+		#if defined(__linux__) && defined(SYS_memfd_create)
+			// Keep the image in an anonymous in-memory file, which private mappings of share until they're written.
+			const int fd = (int)syscall(SYS_memfd_create,"wavm-image",MFD_CLOEXEC);
+			if(fd < 0) { return nullptr; }
+
+			const Uptr numPages = (numBytes + (Uptr(1) << getPageSizeLog2()) - 1) >> getPageSizeLog2();
+			bool succeeded = ftruncate(fd,off_t(numPages << getPageSizeLog2())) == 0;
+			for(Uptr offset = 0;succeeded && offset < numBytes;)
+			{
+				const ssize_t numWrittenBytes = pwrite(fd,bytes + offset,numBytes - offset,off_t(offset));
+				if(numWrittenBytes > 0) { offset += Uptr(numWrittenBytes); }
+				else { succeeded = numWrittenBytes < 0 && errno == EINTR; }
+			}
+			if(!succeeded) { close(fd); return nullptr; }
+
+			return new VirtualImage {fd,numPages};
+		#else
+			return nullptr;
+		#endif
+	}
+
+	void destroyVirtualImage(VirtualImage* image)
+	{
+		// Mappings of the image keep the file alive until they're replaced.
+		close(image->fd);
+		delete image;
+	}
+
+	Uptr getVirtualImageNumPages(VirtualImage* image) { return image->numPages; }
+
+	bool mapVirtualImage(VirtualImage* image,U8* baseVirtualAddress)
+	{
+		errorUnless(isPageAligned(baseVirtualAddress));
+		if(!image->numPages) { return true; }
+		return mmap(baseVirtualAddress,image->numPages << getPageSizeLog2(),PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_FIXED,image->fd,0) != MAP_FAILED;
+	}
+
+	void unmapVirtualImage(VirtualImage* image,U8* baseVirtualAddress)
+	{
+		errorUnless(isPageAligned(baseVirtualAddress));
+		if(!image->numPages) { return; }
+		if(mmap(baseVirtualAddress,image->numPages << getPageSizeLog2(),PROT_NONE,MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED,-1,0) == MAP_FAILED) { Errors::fatal("mmap failed"); }
+	}
+
 	bool describeInstructionPointer(Uptr ip,std::string& outDescription)
 	{
 		#if defined __linux__ || defined __FreeBSD__
@@ -85,6 +85,22 @@ namespace Platform
 		if(baseVirtualAddress && !result) { Errors::fatal("VirtualFree(MEM_RELEASE) failed"); }
 	}
 
+	void resetVirtualPages(U8* baseVirtualAddress,Uptr numPages)
+	{
+		// Recommitting decommitted pages zero-fills them when they're next accessed.
+		decommitVirtualPages(baseVirtualAddress,numPages);
+		if(!commitVirtualPages(baseVirtualAddress,numPages,MemoryAccess::ReadWrite)) { Errors::fatal("VirtualAlloc(MEM_COMMIT) failed"); }
+	}
+
+	// Copy-on-write images aren't supported on Windows: the virtual pages of a memory are reserved by a single VirtualAlloc,
+	// which a file mapping can't be placed in.
+	struct VirtualImage {};
+	VirtualImage* createVirtualImage(const U8* bytes,Uptr numBytes) { return nullptr; }
+	void destroyVirtualImage(VirtualImage* image) { Errors::unreachable(); }
+	Uptr getVirtualImageNumPages(VirtualImage* image) { Errors::unreachable(); }
+	bool mapVirtualImage(VirtualImage* image,U8* baseVirtualAddress) { Errors::unreachable(); }
+	void unmapVirtualImage(VirtualImage* image,U8* baseVirtualAddress) { Errors::unreachable(); }
+
 	// The interface to the DbgHelp DLL
 	struct DbgHelp
 	{
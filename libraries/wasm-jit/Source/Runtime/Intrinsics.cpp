@@ -153,6 +153,13 @@ namespace Intrinsics
 		return result;
 	}
 	
+	Runtime::FunctionInstance* findFunction(const std::string& decoratedName)
+	{
+		Platform::Lock Lock(Singleton::get().mutex);
+		auto keyValue = Singleton::get().functionMap.find(decoratedName);
+		return keyValue == Singleton::get().functionMap.end() ? nullptr : keyValue->second->function;
+	}
+	
 	std::vector<Runtime::ObjectInstance*> getAllIntrinsicObjects()
 	{
 		Platform::Lock lock(Singleton::get().mutex);
@@ -27,6 +27,8 @@ namespace LLVMJIT
 		llvm::Constant* defaultTableMaxElementIndex;
 		llvm::Constant* defaultMemoryBase;
 		llvm::Constant* defaultMemoryEndOffset;
+		llvm::Constant* defaultMemoryObjectAsI64;
+		llvm::Constant* defaultTableObjectAsI64;
 		
 		llvm::DIBuilder diBuilder;
 		llvm::DICompileUnit* diCompileUnit;
@@ -62,6 +64,22 @@ namespace LLVMJIT
 
 		}
 		llvm::Module* emit();
+
+		// Emits a pointer to an object the module instance refers to. Instead of embedding the object's address, the code
+		// refers to a symbol that is bound to the object when the code is loaded, so it may be loaded for another instance.
+		llvm::Constant* emitInstancePointer(const std::string& symbolName,llvm::Type* pointeeType)
+		{
+			if(pointeeType->isFunctionTy())
+			{ return llvmModule->getOrInsertFunction(symbolName,llvm::cast<llvm::FunctionType>(pointeeType)); }
+
+			// Declare the symbol as an array of unknown size, so LLVM doesn't assume anything about the size of the object.
+			auto symbol = llvmModule->getOrInsertGlobal(symbolName,llvm::ArrayType::get(llvmI8Type,0));
+			return llvm::ConstantExpr::getPointerCast(symbol,pointeeType->getPointerTo());
+		}
+		llvm::Constant* emitInstancePointerAsI64(const std::string& symbolName)
+		{
+			return llvm::ConstantExpr::getPtrToInt(emitInstancePointer(symbolName,llvmI8Type),llvmI64Type);
+		}
 	};
 
 	// The context used by functions involved in JITing a single AST function.
@@ -306,7 +324,7 @@ namespace LLVMJIT
 			assert(intrinsicObject);
 			FunctionInstance* intrinsicFunction = asFunction(intrinsicObject);
 			assert(intrinsicFunction->type == intrinsicType);
-			auto intrinsicFunctionPointer = emitLiteralPointer(intrinsicFunction->nativeFunction,asLLVMType(intrinsicType)->getPointerTo());
+			auto intrinsicFunctionPointer = moduleContext.emitInstancePointer(getIntrinsicSymbolName(intrinsicName,intrinsicType),asLLVMType(intrinsicType));
 			return irBuilder.CreateCall(intrinsicFunctionPointer,llvm::ArrayRef<llvm::Value*>(args.begin(),args.end()));
 		}
 
@@ -687,7 +705,7 @@ namespace LLVMJIT
 			// Load the type for this table entry.
 			auto functionTypePointerPointer = irBuilder.CreateInBoundsGEP(moduleContext.defaultTablePointer,{functionIndexZExt,emitLiteral((U32)0)});
 			auto functionTypePointer = irBuilder.CreateLoad(functionTypePointerPointer);
-			auto llvmCalleeType = emitLiteralPointer(calleeType,llvmI8PtrType);
+			auto llvmCalleeType = moduleContext.emitInstancePointer(getInstanceSymbolName("type",imm.type.index),llvmI8Type);
 			
 			// If the function type doesn't match, trap.
 			emitConditionalTrapIntrinsic(
@@ -696,7 +714,7 @@ namespace LLVMJIT
 				FunctionType::get(ResultType::none,{ValueType::i32,ValueType::i64,ValueType::i64}),
 				{	tableElementIndex,
 					irBuilder.CreatePtrToInt(llvmCalleeType,llvmI64Type),
-					emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultTable))	}
+					moduleContext.defaultTableObjectAsI64	}
 				);
 
 			// Call the function loaded from the table.
@@ -750,7 +768,7 @@ namespace LLVMJIT
 		void grow_memory(MemoryImm)
 		{
 			auto deltaNumPages = pop();
-			auto defaultMemoryObjectAsI64 = emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultMemory));
+			auto defaultMemoryObjectAsI64 = moduleContext.defaultMemoryObjectAsI64;
 			auto previousNumPages = emitRuntimeIntrinsic(
 				"wavmIntrinsics.growMemory",
 				FunctionType::get(ResultType::i32,{ValueType::i32,ValueType::i64}),
@@ -759,7 +777,7 @@ namespace LLVMJIT
 		}
 		void current_memory(MemoryImm)
 		{
-			auto defaultMemoryObjectAsI64 = emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultMemory));
+			auto defaultMemoryObjectAsI64 = moduleContext.defaultMemoryObjectAsI64;
 			auto currentNumPages = emitRuntimeIntrinsic(
 				"wavmIntrinsics.currentMemory",
 				FunctionType::get(ResultType::i32,{ValueType::i64}),
@@ -1234,7 +1252,7 @@ namespace LLVMJIT
 		{
 			auto numWaiters = pop();
 			auto address = pop();
-			auto defaultMemoryObjectAsI64 = emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultMemory));
+			auto defaultMemoryObjectAsI64 = moduleContext.defaultMemoryObjectAsI64;
 			push(emitRuntimeIntrinsic(
 				"wavmIntrinsics.wake",
 				FunctionType::get(ResultType::i32,{ValueType::i32,ValueType::i32,ValueType::i64}),
@@ -1245,7 +1263,7 @@ namespace LLVMJIT
 			auto timeout = pop();
 			auto expectedValue = pop();
 			auto address = pop();
-			auto defaultMemoryObjectAsI64 = emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultMemory));
+			auto defaultMemoryObjectAsI64 = moduleContext.defaultMemoryObjectAsI64;
 			push(emitRuntimeIntrinsic(
 				"wavmIntrinsics.wait",
 				FunctionType::get(ResultType::i32,{ValueType::i32,ValueType::i32,ValueType::f64,ValueType::i64}),
@@ -1256,7 +1274,7 @@ namespace LLVMJIT
 			auto timeout = pop();
 			auto expectedValue = pop();
 			auto address = pop();
-			auto defaultMemoryObjectAsI64 = emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultMemory));
+			auto defaultMemoryObjectAsI64 = moduleContext.defaultMemoryObjectAsI64;
 			push(emitRuntimeIntrinsic(
 				"wavmIntrinsics.wait",
 				FunctionType::get(ResultType::i32,{ValueType::i32,ValueType::i64,ValueType::f64,ValueType::i64}),
@@ -1269,7 +1287,7 @@ namespace LLVMJIT
 			auto errorFunctionIndex = pop();
 			auto argument = pop();
 			auto functionIndex = pop();
-			auto defaultTableAsI64 = emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultTable));
+			auto defaultTableAsI64 = moduleContext.defaultTableObjectAsI64;
 			emitRuntimeIntrinsic(
 				"wavmIntrinsics.launchThread",
 				FunctionType::get(ResultType::none,{ValueType::i32,ValueType::i32,ValueType::i32,ValueType::i64}),
@@ -1513,7 +1531,7 @@ namespace LLVMJIT
 			emitRuntimeIntrinsic(
 				"wavmIntrinsics.debugEnterFunction",
 				FunctionType::get(ResultType::none,{ValueType::i64}),
-				{emitLiteral(reinterpret_cast<U64>(functionInstance))}
+				{moduleContext.emitInstancePointerAsI64(getInstanceSymbolName("function",Uptr(&functionDef - module.functions.defs.data())))}
 				);
 		}
 
@@ -1564,7 +1582,7 @@ namespace LLVMJIT
 			emitRuntimeIntrinsic(
 				"wavmIntrinsics.debugExitFunction",
 				FunctionType::get(ResultType::none,{ValueType::i64}),
-				{emitLiteral(reinterpret_cast<U64>(functionInstance))}
+				{moduleContext.emitInstancePointerAsI64(getInstanceSymbolName("function",Uptr(&functionDef - module.functions.defs.data())))}
 				);
 		}
 
@@ -1577,14 +1595,20 @@ namespace LLVMJIT
 	{
 		Timing::Timer emitTimer;
 
-		// Create literals for the default memory base and mask.
+		// Create constants for the default memory base and mask.
+		// The end offset is the same for every memory, so it's emitted as a literal.
 		if(moduleInstance->defaultMemory)
 		{
-			defaultMemoryBase = emitLiteralPointer(moduleInstance->defaultMemory->baseAddress,llvmI8PtrType);
+			defaultMemoryBase = emitInstancePointer(getInstanceSymbolName("memoryBase"),llvmI8Type);
+			defaultMemoryObjectAsI64 = emitInstancePointerAsI64(getInstanceSymbolName("memory"));
 			const Uptr defaultMemoryEndOffsetValue = Uptr(moduleInstance->defaultMemory->endOffset);
 			defaultMemoryEndOffset = emitLiteral(defaultMemoryEndOffsetValue);
 		}
-		else { defaultMemoryBase = defaultMemoryEndOffset = nullptr; }
+		else
+		{
+			defaultMemoryBase = defaultMemoryEndOffset = nullptr;
+			defaultMemoryObjectAsI64 = emitLiteral((U64)0);
+		}
 
 		// Set up the LLVM values used to access the global table.
 		if(moduleInstance->defaultTable)
@@ -1593,24 +1617,29 @@ namespace LLVMJIT
 				llvmI8PtrType,
 				llvmI8PtrType
 				});
-			defaultTablePointer = emitLiteralPointer(moduleInstance->defaultTable->baseAddress,tableElementType->getPointerTo());
+			defaultTablePointer = emitInstancePointer(getInstanceSymbolName("tableBase"),tableElementType);
+			defaultTableObjectAsI64 = emitInstancePointerAsI64(getInstanceSymbolName("table"));
 			defaultTableMaxElementIndex = emitLiteral(((Uptr)moduleInstance->defaultTable->endOffset)/sizeof(TableInstance::FunctionElement));
 		}
 		else
 		{
 			defaultTablePointer = defaultTableMaxElementIndex = nullptr;
+			defaultTableObjectAsI64 = emitLiteral((U64)0);
 		}
 
 		// Create LLVM pointer constants for the module's imported functions.
 		for(Uptr functionIndex = 0;functionIndex < module.functions.imports.size();++functionIndex)
 		{
 			const FunctionInstance* functionInstance = moduleInstance->functions[functionIndex];
-			importedFunctionPointers.push_back(emitLiteralPointer(functionInstance->nativeFunction,asLLVMType(functionInstance->type)->getPointerTo()));
+			importedFunctionPointers.push_back(emitInstancePointer(getInstanceSymbolName("import",functionIndex),asLLVMType(functionInstance->type)));
 		}
 
 		// Create LLVM pointer constants for the module's globals.
-		for(auto global : moduleInstance->globals)
-		{ globalPointers.push_back(emitLiteralPointer(&global->value,asLLVMType(global->type.valueType)->getPointerTo())); }
+		for(Uptr globalIndex = 0;globalIndex < moduleInstance->globals.size();++globalIndex)
+		{
+			const GlobalInstance* global = moduleInstance->globals[globalIndex];
+			globalPointers.push_back(emitInstancePointer(getInstanceSymbolName("global",globalIndex),asLLVMType(global->type.valueType)));
+		}
 		
 		// Create the LLVM functions.
 		functionDefs.resize(module.functions.defs.size());
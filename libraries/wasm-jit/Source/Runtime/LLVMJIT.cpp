@@ -58,6 +58,19 @@ namespace LLVMJIT
 	// A map from function types to function indices in the invoke thunk unit.
 	std::map<const FunctionType*,struct JITSymbol*> invokeThunkTypeToSymbolMap;
 
+	// Serializes the uses of the global LLVM context and target machine, which aren't thread-safe: emitting and compiling
+	// modules and invoke thunks. Loading compiled objects doesn't need it, so modules may be instantiated concurrently
+	// from compiled objects. Also guards invokeThunkTypeToSymbolMap.
+	Platform::Mutex* llvmContextMutex = Platform::createMutex();
+
+	// The directory that compiled module object code is cached in, or empty if the object cache is disabled, and the
+	// number of bytes of entries it may hold.
+	Platform::Mutex* objectCacheDirectoryMutex = Platform::createMutex();
+	std::string objectCacheDirectory;
+	U64 objectCacheMaxBytes = 0;
+
+	typedef llvm::object::OwningBinary<llvm::object::ObjectFile> ObjectBinary;
+
 	// Information about a JIT symbol, used to map instruction pointers to descriptive names.
 	struct JITSymbol
 	{
@@ -224,16 +237,21 @@ namespace LLVMJIT
 		{
 			objectLayer = llvm::make_unique<ObjectLayer>(NotifyLoadedFunctor(this),NotifyFinalizedFunctor(this));
 			objectLayer->setProcessAllSections(true);
-			compileLayer = llvm::make_unique<CompileLayer>(*objectLayer,llvm::orc::SimpleCompiler(*targetMachine));
 		}
 		~JITUnit()
 		{
-			compileLayer->removeModuleSet(handle);
+			objectLayer->removeObjectSet(handle);
 			#ifdef _WIN64
 				if(pdataCopy) { Platform::deregisterSEHUnwindInfo(reinterpret_cast<Uptr>(pdataCopy)); }
 			#endif
 		}
 
+		// Optimizes a LLVM module and generates an object file for it. Deletes the LLVM module.
+		std::unique_ptr<ObjectBinary> compileObject(llvm::Module* llvmModule);
+
+		// Links an object file into memory, resolving its external symbols with the given resolver, and finalizes it.
+		void load(std::unique_ptr<ObjectBinary> object,llvm::JITSymbolResolver* resolver);
+
 		void compile(llvm::Module* llvmModule);
 
 		virtual void notifySymbolLoaded(const char* name,Uptr baseAddress,Uptr numBytes,std::map<U32,U32>&& offsetToOpIndexMap) = 0;
@@ -260,12 +278,10 @@ namespace LLVMJIT
 			void operator()(const llvm::orc::ObjectLinkingLayerBase::ObjSetHandleT& objectSetHandle);
 		};
 		typedef llvm::orc::ObjectLinkingLayer<NotifyLoadedFunctor> ObjectLayer;
-		typedef llvm::orc::IRCompileLayer<ObjectLayer> CompileLayer;
 
 		UnitMemoryManager memoryManager;
 		std::unique_ptr<ObjectLayer> objectLayer;
-		std::unique_ptr<CompileLayer> compileLayer;
-		CompileLayer::ModuleSetHandleT handle;
+		ObjectLayer::ObjSetHandleT handle;
 		bool shouldLogMetrics;
 
 		struct LoadedObject
@@ -281,10 +297,23 @@ namespace LLVMJIT
 		#endif
 	};
 
+	// Resolves the symbols that a module's code uses to refer to the objects of its instance and to intrinsic functions.
+	struct InstanceResolver : llvm::JITSymbolResolver
+	{
+		std::map<std::string,Uptr> instanceSymbolMap;
+
+		virtual llvm::JITSymbol findSymbol(const std::string& name) override;
+		virtual llvm::JITSymbol findSymbolInLogicalDylib(const std::string& name) override;
+	};
+
 	// The JIT compilation unit for a WebAssembly module instance.
 	struct JITModule : JITUnit, JITModuleBase
 	{
 		ModuleInstance* moduleInstance;
+		InstanceResolver resolver;
+
+		// The module's object file, which other instances of the module may load instead of compiling it again.
+		std::shared_ptr<llvm::MemoryBuffer> objectBytes;
 
 		std::vector<JITSymbol*> functionDefSymbols;
 
@@ -389,6 +418,33 @@ namespace LLVMJIT
 	}
 	llvm::JITSymbol NullResolver::findSymbolInLogicalDylib(const std::string& name) { return llvm::JITSymbol(nullptr); }
 
+	llvm::JITSymbol InstanceResolver::findSymbol(const std::string& name)
+	{
+		#if defined(_WIN32) && !defined(_WIN64)
+			const std::string undecoratedName = name.size() && name[0] == '_' ? name.substr(1) : name;
+		#else
+			const std::string& undecoratedName = name;
+		#endif
+
+		auto instanceSymbolIt = instanceSymbolMap.find(undecoratedName);
+		if(instanceSymbolIt != instanceSymbolMap.end())
+		{
+			return llvm::JITSymbol(instanceSymbolIt->second,llvm::JITSymbolFlags::None);
+		}
+
+		const char intrinsicPrefix[] = "wavmIntrinsic.";
+		const Uptr numPrefixChars = sizeof(intrinsicPrefix) - 1;
+		if(!undecoratedName.compare(0,numPrefixChars,intrinsicPrefix))
+		{
+			FunctionInstance* intrinsicFunction = Intrinsics::findFunction(undecoratedName.substr(numPrefixChars));
+			if(!intrinsicFunction) { Errors::fatalf("LLVM generated code references undefined intrinsic: %s\n",name.c_str()); }
+			return llvm::JITSymbol(reinterpret_cast<Uptr>(intrinsicFunction->nativeFunction),llvm::JITSymbolFlags::None);
+		}
+
+		return NullResolver::singleton.findSymbol(name);
+	}
+	llvm::JITSymbol InstanceResolver::findSymbolInLogicalDylib(const std::string& name) { return llvm::JITSymbol(nullptr); }
+
 	void JITUnit::NotifyLoadedFunctor::operator()(
 		const llvm::orc::ObjectLinkingLayerBase::ObjSetHandleT& objectSetHandle,
 		const std::vector<std::unique_ptr<llvm::object::OwningBinary<llvm::object::ObjectFile>>>& objectSet,
@@ -550,7 +606,7 @@ namespace LLVMJIT
 		Log::printf(Log::Category::debug,"Dumped LLVM module to: %s\n",augmentedFilename.c_str());
 	}
 
-	void JITUnit::compile(llvm::Module* llvmModule)
+	std::unique_ptr<ObjectBinary> JITUnit::compileObject(llvm::Module* llvmModule)
 	{
 		// Get a target machine object for this host, and set the module to use its data layout.
 		llvmModule->setDataLayout(targetMachine->createDataLayout());
@@ -587,13 +643,9 @@ namespace LLVMJIT
 
 		if(DUMP_OPTIMIZED_MODULE) { printModule(llvmModule,"llvmOptimizedDump"); }
 
-		// Pass the module to the JIT compiler.
+		// Generate machine code for the module.
 		Timing::Timer machineCodeTimer;
-		handle = compileLayer->addModuleSet(
-			std::vector<llvm::Module*>{llvmModule},
-			&memoryManager,
-			&NullResolver::singleton);
-		compileLayer->emitAndFinalize(handle);
+		auto object = llvm::make_unique<ObjectBinary>(llvm::orc::SimpleCompiler(*targetMachine)(*llvmModule));
 
 		if(shouldLogMetrics)
 		{
@@ -601,19 +653,268 @@ namespace LLVMJIT
 		}
 
 		delete llvmModule;
+		return object;
 	}
 
-	void instantiateModule(const IR::Module& module,ModuleInstance* moduleInstance)
+	void JITUnit::load(std::unique_ptr<ObjectBinary> object,llvm::JITSymbolResolver* resolver)
 	{
-		// Emit LLVM IR for the module.
-		auto llvmModule = emitModule(module,moduleInstance);
+		std::vector<std::unique_ptr<ObjectBinary>> objectSet;
+		objectSet.push_back(std::move(object));
+		handle = objectLayer->addObjectSet(std::move(objectSet),&memoryManager,resolver);
+		objectLayer->emitAndFinalize(handle);
+	}
 
+	void JITUnit::compile(llvm::Module* llvmModule)
+	{
+		load(compileObject(llvmModule),&NullResolver::singleton);
+	}
+
+	// Identifies the code generator that produced an object cache entry. Entries written by another version of LLVM, for
+	// another target, or by a version of LLVMEmitIR that refers to instance objects differently are recompiled.
+	// Increment objectCacheFormatVersion when changing the code emitted for a module.
+	static const U32 objectCacheFormatVersion = 1;
+	static std::string getObjectCacheVersion()
+	{
+		return "WAVM object cache " + std::to_string(objectCacheFormatVersion)
+			+ ";LLVM " + LLVM_VERSION_STRING
+			+ ";" + targetMachine->getTargetTriple().str()
+			+ ";" + targetMachine->getTargetCPU().str()
+			+ ";" + targetMachine->getTargetFeatureString().str();
+	}
+
+	// An object cache entry is a header, followed by the cache version string, the entry's key, and the object file.
+	struct ObjectCacheHeader
+	{
+		U8 magic[8];
+		U64 numVersionBytes;
+		U64 numKeyBytes;
+		U64 numObjectBytes;
+		U64 objectChecksum;
+	};
+	static const U8 objectCacheMagic[8] = {'W','A','V','M','O','B','J',0};
+
+	// FNV-1a; only meant to detect truncated or corrupted entries.
+	static U64 getObjectChecksum(const char* bytes,Uptr numBytes)
+	{
+		U64 checksum = 0xcbf29ce484222325ull;
+		for(Uptr byteIndex = 0;byteIndex < numBytes;++byteIndex)
+		{
+			checksum ^= U8(bytes[byteIndex]);
+			checksum *= 0x100000001b3ull;
+		}
+		return checksum;
+	}
+
+	static std::string getObjectCachePath(const std::string& objectCacheKey)
+	{
+		Platform::Lock objectCacheDirectoryLock(objectCacheDirectoryMutex);
+		if(!objectCacheKey.size() || !objectCacheDirectory.size()) { return std::string(); }
+		return objectCacheDirectory + "/" + objectCacheKey + ".wavmobj";
+	}
+
+	// Parses an object file. Returns null if it's invalid.
+	static std::unique_ptr<ObjectBinary> createObjectBinary(std::unique_ptr<llvm::MemoryBuffer> objectBuffer)
+	{
+		auto object = llvm::object::ObjectFile::createObjectFile(objectBuffer->getMemBufferRef());
+		if(!object)
+		{
+			llvm::consumeError(object.takeError());
+			return nullptr;
+		}
+		return llvm::make_unique<ObjectBinary>(std::move(*object),std::move(objectBuffer));
+	}
+
+	// Reads an object file from the object cache. Returns null if there's no valid entry with the given key.
+	static std::unique_ptr<ObjectBinary> loadCachedObject(const std::string& path,const std::string& objectCacheKey)
+	{
+		auto fileBuffer = llvm::MemoryBuffer::getFile(path);
+		if(!fileBuffer) { return nullptr; }
+		const char* bytes = (*fileBuffer)->getBufferStart();
+		const Uptr numBytes = (*fileBuffer)->getBufferSize();
+
+		// Validate the header, the version of the code generator, and the key.
+		ObjectCacheHeader header;
+		if(numBytes < sizeof(header)) { return nullptr; }
+		memcpy(&header,bytes,sizeof(header));
+		const std::string version = getObjectCacheVersion();
+		if(memcmp(header.magic,objectCacheMagic,sizeof(objectCacheMagic))
+		|| header.numVersionBytes != version.size()
+		|| header.numKeyBytes != objectCacheKey.size()
+		|| header.numObjectBytes != numBytes - sizeof(header) - version.size() - objectCacheKey.size()) { return nullptr; }
+		const char* versionBytes = bytes + sizeof(header);
+		const char* keyBytes = versionBytes + version.size();
+		const char* objectBytes = keyBytes + objectCacheKey.size();
+		if(memcmp(versionBytes,version.data(),version.size())
+		|| memcmp(keyBytes,objectCacheKey.data(),objectCacheKey.size())
+		|| getObjectChecksum(objectBytes,Uptr(header.numObjectBytes)) != header.objectChecksum) { return nullptr; }
+
+		// Copy the object file into its own buffer, which is suitably aligned for the object file parser.
+		return createObjectBinary(llvm::MemoryBuffer::getMemBufferCopy(llvm::StringRef(objectBytes,Uptr(header.numObjectBytes)),path));
+	}
+
+	// Removes the entries that were written longest ago until the object cache fits in objectCacheMaxBytes, except for
+	// the entry at keptPath.
+	static void pruneObjectCache(const std::string& keptPath)
+	{
+		std::string directory;
+		U64 maxBytes;
+		{
+			Platform::Lock objectCacheDirectoryLock(objectCacheDirectoryMutex);
+			directory = objectCacheDirectory;
+			maxBytes = objectCacheMaxBytes;
+		}
+
+		typedef decltype(llvm::sys::fs::file_status().getLastModificationTime()) ModificationTime;
+		struct Entry
+		{
+			ModificationTime modificationTime;
+			U64 numBytes;
+			std::string path;
+		};
+		std::vector<Entry> entries;
+		U64 totalBytes = 0;
+		std::error_code errorCode;
+		for(llvm::sys::fs::directory_iterator entryIt(directory,errorCode), endIt;!errorCode && entryIt != endIt;entryIt.increment(errorCode))
+		{
+			llvm::sys::fs::file_status status;
+			if(llvm::sys::path::extension(entryIt->path()) != ".wavmobj" || entryIt->status(status)) { continue; }
+			entries.push_back({status.getLastModificationTime(),status.getSize(),entryIt->path()});
+			totalBytes += status.getSize();
+		}
+		if(totalBytes <= maxBytes) { return; }
+
+		std::sort(entries.begin(),entries.end(),[](const Entry& a,const Entry& b) { return a.modificationTime < b.modificationTime; });
+		for(auto entryIt = entries.begin();entryIt != entries.end() && totalBytes > maxBytes;++entryIt)
+		{
+			if(entryIt->path != keptPath && !llvm::sys::fs::remove(entryIt->path)) { totalBytes -= entryIt->numBytes; }
+		}
+	}
+
+	// Writes an object file to the object cache. The entry is written to a temporary file of its own that is renamed
+	// over the old entry, so concurrent or interrupted writers never leave a partial entry behind.
+	static void saveCachedObject(const std::string& path,const std::string& objectCacheKey,const ObjectBinary& object)
+	{
+		const llvm::StringRef objectBytes = object.getBinary()->getData();
+		const std::string version = getObjectCacheVersion();
+
+		ObjectCacheHeader header;
+		memcpy(header.magic,objectCacheMagic,sizeof(objectCacheMagic));
+		header.numVersionBytes = version.size();
+		header.numKeyBytes = objectCacheKey.size();
+		header.numObjectBytes = objectBytes.size();
+		header.objectChecksum = getObjectChecksum(objectBytes.data(),objectBytes.size());
+
+		llvm::SmallString<256> temporaryPathChars;
+		int temporaryFile;
+		if(std::error_code errorCode = llvm::sys::fs::createUniqueFile(path + "-%%%%%%%%.tmp",temporaryFile,temporaryPathChars))
+		{
+			Log::printf(Log::Category::error,"Couldn't write object cache entry %s: %s\n",path.c_str(),errorCode.message().c_str());
+			return;
+		}
+		const std::string temporaryPath = temporaryPathChars.str();
+		{
+			llvm::raw_fd_ostream stream(temporaryFile,true);
+			stream.write(reinterpret_cast<const char*>(&header),sizeof(header));
+			stream << version << objectCacheKey << objectBytes;
+			stream.close();
+			if(stream.has_error())
+			{
+				stream.clear_error();
+				Log::printf(Log::Category::error,"Couldn't write object cache entry %s\n",temporaryPath.c_str());
+				llvm::sys::fs::remove(temporaryPath);
+				return;
+			}
+		}
+		if(llvm::sys::fs::rename(temporaryPath,path)) { llvm::sys::fs::remove(temporaryPath); return; }
+		pruneObjectCache(path);
+	}
+
+	// Maps the names of the symbols the module's code refers to its instance's objects by to the objects' addresses.
+	static std::map<std::string,Uptr> getInstanceSymbolMap(const IR::Module& module,ModuleInstance* moduleInstance)
+	{
+		std::map<std::string,Uptr> instanceSymbolMap;
+		if(moduleInstance->defaultMemory)
+		{
+			instanceSymbolMap[getInstanceSymbolName("memory")] = reinterpret_cast<Uptr>(moduleInstance->defaultMemory);
+			instanceSymbolMap[getInstanceSymbolName("memoryBase")] = reinterpret_cast<Uptr>(moduleInstance->defaultMemory->baseAddress);
+		}
+		if(moduleInstance->defaultTable)
+		{
+			instanceSymbolMap[getInstanceSymbolName("table")] = reinterpret_cast<Uptr>(moduleInstance->defaultTable);
+			instanceSymbolMap[getInstanceSymbolName("tableBase")] = reinterpret_cast<Uptr>(moduleInstance->defaultTable->baseAddress);
+		}
+		for(Uptr functionIndex = 0;functionIndex < module.functions.imports.size();++functionIndex)
+		{
+			instanceSymbolMap[getInstanceSymbolName("import",functionIndex)] = reinterpret_cast<Uptr>(moduleInstance->functions[functionIndex]->nativeFunction);
+		}
+		for(Uptr globalIndex = 0;globalIndex < moduleInstance->globals.size();++globalIndex)
+		{
+			instanceSymbolMap[getInstanceSymbolName("global",globalIndex)] = reinterpret_cast<Uptr>(&moduleInstance->globals[globalIndex]->value);
+		}
+		for(Uptr typeIndex = 0;typeIndex < module.types.size();++typeIndex)
+		{
+			instanceSymbolMap[getInstanceSymbolName("type",typeIndex)] = reinterpret_cast<Uptr>(module.types[typeIndex]);
+		}
+		for(Uptr functionDefIndex = 0;functionDefIndex < moduleInstance->functionDefs.size();++functionDefIndex)
+		{
+			instanceSymbolMap[getInstanceSymbolName("function",functionDefIndex)] = reinterpret_cast<Uptr>(moduleInstance->functionDefs[functionDefIndex]);
+		}
+		return instanceSymbolMap;
+	}
+
+	void instantiateModule(const IR::Module& module,ModuleInstance* moduleInstance,const std::string& objectCacheKey)
+	{
 		// Construct the JIT compilation pipeline for this module.
 		auto jitModule = new JITModule(moduleInstance);
 		moduleInstance->jitModule = jitModule;
+		jitModule->resolver.instanceSymbolMap = getInstanceSymbolMap(module,moduleInstance);
 
-		// Compile the module.
-		jitModule->compile(llvmModule);
+		// Load the module's code from the object cache if it has already been compiled.
+		const std::string objectCachePath = getObjectCachePath(objectCacheKey);
+		if(objectCachePath.size())
+		{
+			Timing::Timer loadTimer;
+			auto object = loadCachedObject(objectCachePath,objectCacheKey);
+			if(object)
+			{
+				jitModule->objectBytes = llvm::MemoryBuffer::getMemBufferCopy(object->getBinary()->getData());
+				jitModule->load(std::move(object),&jitModule->resolver);
+				Timing::logTimer("Loaded cached machine code",loadTimer);
+				return;
+			}
+		}
+
+		// Emit LLVM IR for the module, and compile it.
+		std::unique_ptr<ObjectBinary> object;
+		{
+			Platform::Lock llvmContextLock(llvmContextMutex);
+			object = jitModule->compileObject(emitModule(module,moduleInstance));
+		}
+		if(objectCachePath.size()) { saveCachedObject(objectCachePath,objectCacheKey,*object); }
+		jitModule->objectBytes = llvm::MemoryBuffer::getMemBufferCopy(object->getBinary()->getData());
+		jitModule->load(std::move(object),&jitModule->resolver);
+	}
+
+	void instantiateModule(const IR::Module& module,ModuleInstance* moduleInstance,const ModuleInstance* compiledInstance)
+	{
+		auto jitModule = new JITModule(moduleInstance);
+		moduleInstance->jitModule = jitModule;
+		jitModule->resolver.instanceSymbolMap = getInstanceSymbolMap(module,moduleInstance);
+
+		// Link the object file of the compiled instance against this instance's objects. The instances share the object
+		// file's bytes, which the linker only reads.
+		auto compiledJITModule = static_cast<const JITModule*>(compiledInstance->jitModule);
+		jitModule->objectBytes = compiledJITModule->objectBytes;
+		auto object = createObjectBinary(llvm::MemoryBuffer::getMemBuffer(jitModule->objectBytes->getMemBufferRef(),false));
+		errorUnless(object != nullptr);
+		jitModule->load(std::move(object),&jitModule->resolver);
+	}
+
+	void setObjectCacheDirectory(const std::string& directory,U64 maxBytes)
+	{
+		Platform::Lock objectCacheDirectoryLock(objectCacheDirectoryMutex);
+		objectCacheDirectory = directory;
+		objectCacheMaxBytes = maxBytes;
 	}
 
 	std::string getExternalFunctionName(ModuleInstance* moduleInstance,Uptr functionDefIndex)
@@ -623,6 +924,21 @@ namespace LLVMJIT
 			+ "_" + moduleInstance->functionDefs[functionDefIndex]->debugName;
 	}
 
+	std::string getInstanceSymbolName(const char* objectName)
+	{
+		return std::string("wavmInstance.") + objectName;
+	}
+
+	std::string getInstanceSymbolName(const char* objectName,Uptr index)
+	{
+		return getInstanceSymbolName(objectName) + std::to_string(index);
+	}
+
+	std::string getIntrinsicSymbolName(const char* intrinsicName,const FunctionType* intrinsicType)
+	{
+		return "wavmIntrinsic." + Intrinsics::getDecoratedName(intrinsicName,intrinsicType);
+	}
+
 	bool getFunctionIndexFromExternalName(const char* externalName,Uptr& outFunctionDefIndex)
 	{
 		#if defined(_WIN32) && !defined(_WIN64)
@@ -679,6 +995,8 @@ namespace LLVMJIT
 
 	InvokeFunctionPointer getInvokeThunk(const FunctionType* functionType)
 	{
+		Platform::Lock llvmContextLock(llvmContextMutex);
+
 		// Reuse cached invoke thunks for the same function type.
 		auto mapIt = invokeThunkTypeToSymbolMap.find(functionType);
 		if(mapIt != invokeThunkTypeToSymbolMap.end()) { return reinterpret_cast<InvokeFunctionPointer>(mapIt->second->baseAddress); }
@@ -24,6 +24,7 @@
 #endif
 
 #include "llvm/Analysis/Passes.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/RTDyldMemoryManager.h"
 #include "llvm/ExecutionEngine/Orc/CompileUtils.h"
@@ -44,6 +45,10 @@
 #include "llvm/Object/SymbolSize.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/DataTypes.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/DynamicLibrary.h"
@@ -51,6 +56,7 @@
 #include "llvm/IR/DIBuilder.h"
 #include "llvm/DebugInfo/DIContext.h"
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#include <algorithm>
 #include <cctype>
 #include <string>
 #include <vector>
@@ -125,6 +131,13 @@ namespace LLVMJIT
 	std::string getExternalFunctionName(ModuleInstance* moduleInstance,Uptr functionDefIndex);
 	bool getFunctionIndexFromExternalName(const char* externalName,Uptr& outFunctionDefIndex);
 
+	// Functions that name the symbols the emitted code uses to refer to the objects of a module instance and to intrinsic
+	// functions. They are bound to the objects' addresses when the code is loaded, so the code doesn't depend on the
+	// instance it was compiled for, and may be saved in the object cache.
+	std::string getInstanceSymbolName(const char* objectName);
+	std::string getInstanceSymbolName(const char* objectName,Uptr index);
+	std::string getIntrinsicSymbolName(const char* intrinsicName,const FunctionType* intrinsicType);
+
 	// Emits LLVM IR for a module.
 	llvm::Module* emitModule(const IR::Module& module,ModuleInstance* moduleInstance);
 }
@@ -3,9 +3,12 @@
 #include "Platform/Platform.h"
 #include "RuntimePrivate.h"
 
+#include <algorithm>
+
 namespace Runtime
 {
 	// Global lists of memories; used to query whether an address is reserved by one of them.
+	static Platform::Mutex* memoriesMutex = Platform::createMutex();
 	std::vector<MemoryInstance*> memories;
 
 	static Uptr getPlatformPagesPerWebAssemblyPageLog2()
@@ -46,7 +49,10 @@ namespace Runtime
 		if(growMemory(memory,Uptr(type.size.min)) == -1) { delete memory; return nullptr; }
 
 		// Add the memory to the global array.
-		memories.push_back(memory);
+		{
+			Platform::Lock memoriesLock(memoriesMutex);
+			memories.push_back(memory);
+		}
 		return memory;
 	}
 
@@ -61,17 +67,21 @@ namespace Runtime
 		reservedNumPlatformPages = 0;
 
 		// Remove the memory from the global array.
-		for(Uptr memoryIndex = 0;memoryIndex < memories.size();++memoryIndex)
 		{
-			if(memories[memoryIndex] == this) { memories.erase(memories.begin() + memoryIndex); break; }
+			Platform::Lock memoriesLock(memoriesMutex);
+			for(Uptr memoryIndex = 0;memoryIndex < memories.size();++memoryIndex)
+			{
+				if(memories[memoryIndex] == this) { memories.erase(memories.begin() + memoryIndex); break; }
+			}
 		}
 
-		theMemoryInstance = nullptr;
+		Platform::destroyMutex(snapshotMutex);
 	}
 	
 	bool isAddressOwnedByMemory(U8* address)
 	{
 		// Iterate over all memories and check if the address is within the reserved address space for each.
+		Platform::Lock memoriesLock(memoriesMutex);
 		for(auto memory : memories)
 		{
 			U8* startAddress = memory->reservedBaseAddress;
@@ -88,15 +98,84 @@ namespace Runtime
 		return Uptr(memory->type.size.max);
 	}
 
-	void resetMemory(MemoryInstance* memory, MemoryType& newMemoryType) {
-		memory->type.size.min = 1;
-		if(shrinkMemory(memory, memory->numPages - 1) == -1)
+	MemorySnapshot* createMemorySnapshot(const U8* bytes,Uptr numBytes)
+	{
+		MemorySnapshot* snapshot = new MemorySnapshot();
+		snapshot->numBytes = numBytes;
+		snapshot->image = Platform::createVirtualImage(bytes,numBytes);
+		if(!snapshot->image) { snapshot->bytes.assign(bytes,bytes + numBytes); }
+		return snapshot;
+	}
+
+	// Replaces the snapshot mapped at the start of a memory by zeroed pages.
+	static void unmapSnapshot(MemoryInstance* memory)
+	{
+		Platform::VirtualImage* image = memory->mappedSnapshot->image;
+		Platform::unmapVirtualImage(image,memory->baseAddress);
+		memory->mappedSnapshot = nullptr;
+
+		// Recommit the unmapped pages that are within the memory's current size.
+		const Uptr numCommittedPlatformPages = memory->numPages << getPlatformPagesPerWebAssemblyPageLog2();
+		const Uptr numRecommittedPlatformPages = std::min(Platform::getVirtualImageNumPages(image),numCommittedPlatformPages);
+		if(numRecommittedPlatformPages && !Platform::commitVirtualPages(memory->baseAddress,numRecommittedPlatformPages))
+		{
 			causeException(Exception::Cause::outOfMemory);
-		memset(memory->baseAddress, 0, 1<<IR::numBytesPerPageLog2);
+		}
+	}
+
+	void deleteMemorySnapshot(MemorySnapshot* snapshot)
+	{
+		{
+			// A memory must not keep reading the snapshot's image after it's deleted, or be taken to already hold a new
+			// snapshot that is allocated at the same address.
+			Platform::Lock memoriesLock(memoriesMutex);
+			for(auto memory : memories)
+			{
+				Platform::Lock snapshotLock(memory->snapshotMutex);
+				if(memory->mappedSnapshot == snapshot) { unmapSnapshot(memory); }
+			}
+		}
+		if(snapshot->image) { Platform::destroyVirtualImage(snapshot->image); }
+		delete snapshot;
+	}
+
+	void resetMemory(MemoryInstance* memory,MemoryType& newMemoryType,const MemorySnapshot* snapshot)
+	{
+		Platform::Lock snapshotLock(memory->snapshotMutex);
+
+		// Discard everything written since the last reset. The pages that weren't written don't cost anything: they still
+		// read as zeros, or as the snapshot mapped by the last reset.
+		if(memory->numPages > 0)
+		{
+			Platform::resetVirtualPages(memory->baseAddress,memory->numPages << getPlatformPagesPerWebAssemblyPageLog2());
+		}
+
+		// Resize the memory to the new type's minimum size.
 		memory->type = newMemoryType;
-		if(growMemory(memory, memory->type.size.min - 1) == -1)
-			causeException(Exception::Cause::outOfMemory);
-   }
+		assert(memory->type.size.min <= UINTPTR_MAX);
+		const Uptr newNumPages = Uptr(memory->type.size.min);
+		if(memory->numPages > newNumPages)
+		{
+			if(shrinkMemory(memory,memory->numPages - newNumPages) == -1) { causeException(Exception::Cause::outOfMemory); }
+		}
+		else if(memory->numPages < newNumPages)
+		{
+			if(growMemory(memory,newNumPages - memory->numPages) == -1) { causeException(Exception::Cause::outOfMemory); }
+		}
+
+		// Restore the snapshot: map its image unless it's already mapped, or copy its bytes.
+		if(memory->mappedSnapshot && memory->mappedSnapshot != snapshot) { unmapSnapshot(memory); }
+		if(snapshot)
+		{
+			if(snapshot->numBytes > (newNumPages << IR::numBytesPerPageLog2)) { causeException(Exception::Cause::invalidSegmentOffset); }
+			if(!snapshot->image) { memcpy(memory->baseAddress,snapshot->bytes.data(),snapshot->bytes.size()); }
+			else if(memory->mappedSnapshot != snapshot)
+			{
+				if(!Platform::mapVirtualImage(snapshot->image,memory->baseAddress)) { causeException(Exception::Cause::outOfMemory); }
+				memory->mappedSnapshot = snapshot;
+			}
+		}
+	}
 
 	Iptr growMemory(MemoryInstance* memory,Uptr numNewPages)
 	{
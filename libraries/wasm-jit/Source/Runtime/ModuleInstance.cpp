@@ -28,9 +28,11 @@ namespace Runtime
 		};
 	}
 
-	MemoryInstance* MemoryInstance::theMemoryInstance = nullptr;
+	// Serializes updates of the global list of module instances, which may be instantiated on any thread.
+	static Platform::Mutex* moduleInstancesMutex = Platform::createMutex();
 
-	ModuleInstance* instantiateModule(const IR::Module& module,ImportBindings&& imports)
+	// Creates a ModuleInstance bound to the given imports, and the objects it defines, but doesn't load its machine code.
+	static ModuleInstance* createModuleInstance(const IR::Module& module,ImportBindings&& imports,MemoryInstance* memory)
 	{
 		ModuleInstance* moduleInstance = new ModuleInstance(
 			std::move(imports.functions),
@@ -74,11 +76,13 @@ namespace Runtime
 		}
 		for(const MemoryDef& memoryDef : module.memories.defs)
 		{
-			if(!MemoryInstance::theMemoryInstance) {
-				MemoryInstance::theMemoryInstance = createMemory(memoryDef.type);
-				if(!MemoryInstance::theMemoryInstance) { causeException(Exception::Cause::outOfMemory); }
+			MemoryInstance* memoryInstance = memory;
+			if(!memoryInstance)
+			{
+				memoryInstance = createMemory(memoryDef.type);
+				if(!memoryInstance) { causeException(Exception::Cause::outOfMemory); }
 			}
-			moduleInstance->memories.push_back(MemoryInstance::theMemoryInstance);
+			moduleInstance->memories.push_back(memoryInstance);
 		}
 
 		// Find the default memory and table for the module.
@@ -106,7 +110,7 @@ namespace Runtime
 		}
 
 		//Previously, the module instantiation would write in to the memoryInstance here. Don't do that
-      //since the memoryInstance is shared across all moduleInstances and we could be compiling
+      //since the memoryInstance may be shared with other moduleInstances and we could be compiling
       //a new instance while another instance is running
 		
 		// Instantiate the module's global definitions.
@@ -129,9 +133,12 @@ namespace Runtime
 			moduleInstance->functions.push_back(functionInstance);
 		}
 
-		// Generate machine code for the module.
-		LLVMJIT::instantiateModule(module,moduleInstance);
+		return moduleInstance;
+	}
 
+	// Sets up the exports, table segments and start function of a ModuleInstance whose machine code has been loaded.
+	static ModuleInstance* finishModuleInstance(const IR::Module& module,ModuleInstance* moduleInstance)
+	{
 		// Set up the instance's exports.
 		for(const Export& exportIt : module.exports)
 		{
@@ -172,10 +179,39 @@ namespace Runtime
 			moduleInstance->startFunctionIndex = module.startFunctionIndex;
 		}
 
-		moduleInstances.push_back(moduleInstance);
+		{
+			Platform::Lock moduleInstancesLock(moduleInstancesMutex);
+			moduleInstances.push_back(moduleInstance);
+		}
 		return moduleInstance;
 	}
 
+	ModuleInstance* instantiateModule(const IR::Module& module,ImportBindings&& imports,const std::string& objectCacheKey,MemoryInstance* memory)
+	{
+		ModuleInstance* moduleInstance = createModuleInstance(module,std::move(imports),memory);
+
+		// Generate machine code for the module.
+		LLVMJIT::instantiateModule(module,moduleInstance,objectCacheKey);
+
+		return finishModuleInstance(module,moduleInstance);
+	}
+
+	ModuleInstance* cloneModuleInstance(const IR::Module& module,ModuleInstance* compiledInstance,MemoryInstance* memory)
+	{
+		// Bind the new instance to the same imports as the existing instance.
+		ImportBindings imports;
+		imports.functions.assign(compiledInstance->functions.begin(),compiledInstance->functions.begin() + module.functions.imports.size());
+		imports.tables.assign(compiledInstance->tables.begin(),compiledInstance->tables.begin() + module.tables.imports.size());
+		imports.memories.assign(compiledInstance->memories.begin(),compiledInstance->memories.begin() + module.memories.imports.size());
+		imports.globals.assign(compiledInstance->globals.begin(),compiledInstance->globals.begin() + module.globals.imports.size());
+		ModuleInstance* moduleInstance = createModuleInstance(module,std::move(imports),memory);
+
+		// Load the machine code that was generated for the existing instance.
+		LLVMJIT::instantiateModule(module,moduleInstance,compiledInstance);
+
+		return finishModuleInstance(module,moduleInstance);
+	}
+
 	ModuleInstance::~ModuleInstance()
 	{
 		delete jitModule;
@@ -8,9 +8,10 @@
 
 namespace Runtime
 {
-	// Keep a global list of all objects.
+	// Keep a global list of all objects. Objects may be created and deleted on any thread.
 	struct GCGlobals
 	{
+		Platform::Mutex* mutex;
 		std::set<GCObject*> allObjects;
 
 		static GCGlobals& get()
@@ -20,19 +21,23 @@ namespace Runtime
 		}
 		
 	private:
-		GCGlobals() {}
+		GCGlobals(): mutex(Platform::createMutex()) {}
 	};
 
 	GCObject::GCObject(ObjectKind inKind): ObjectInstance(inKind)
 	{
 		// Add the object to the global array.
-		GCGlobals::get().allObjects.insert(this);
+		GCGlobals& gcGlobals = GCGlobals::get();
+		Platform::Lock gcGlobalsLock(gcGlobals.mutex);
+		gcGlobals.allObjects.insert(this);
 	}
 
 	GCObject::~GCObject()
 	{
 		// Remove the object from the global array.
-		GCGlobals::get().allObjects.erase(this);
+		GCGlobals& gcGlobals = GCGlobals::get();
+		Platform::Lock gcGlobalsLock(gcGlobals.mutex);
+		gcGlobals.allObjects.erase(this);
 	}
 
 	void freeUnreferencedObjects(std::vector<ObjectInstance*>&& rootObjectReferences)
@@ -114,17 +119,16 @@ namespace Runtime
 		};
 
 		// Iterate over all objects, and delete objects that weren't referenced directly or indirectly by the root set.
-		GCGlobals& gcGlobals = GCGlobals::get();
-		auto objectIt = gcGlobals.allObjects.begin();
-		while(objectIt != gcGlobals.allObjects.end())
+		// The objects remove themselves from the global array when they're deleted, so delete them without holding its lock.
+		std::vector<GCObject*> unreferencedObjects;
 		{
-			if(referencedObjects.count(*objectIt)) { ++objectIt; }
-			else
+			GCGlobals& gcGlobals = GCGlobals::get();
+			Platform::Lock gcGlobalsLock(gcGlobals.mutex);
+			for(auto object : gcGlobals.allObjects)
 			{
-				ObjectInstance* object = *objectIt;
-				objectIt = gcGlobals.allObjects.erase(objectIt);
-				delete object;
+				if(!referencedObjects.count(object)) { unreferencedObjects.push_back(object); }
 			}
 		}
+		for(auto object : unreferencedObjects) { delete object; }
 	}
 }
\ No newline at end of file
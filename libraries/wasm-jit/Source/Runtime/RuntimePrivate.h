@@ -20,7 +20,9 @@ namespace LLVMJIT
 	};
 
 	void init();
-	void instantiateModule(const IR::Module& module,Runtime::ModuleInstance* moduleInstance);
+	void instantiateModule(const IR::Module& module,Runtime::ModuleInstance* moduleInstance,const std::string& objectCacheKey);
+	void instantiateModule(const IR::Module& module,Runtime::ModuleInstance* moduleInstance,const Runtime::ModuleInstance* compiledInstance);
+	void setObjectCacheDirectory(const std::string& directory,U64 maxBytes);
 	bool describeInstructionPointer(Uptr ip,std::string& outDescription);
 	
 	typedef void (*InvokeFunctionPointer)(void*,U64*);
@@ -88,10 +90,21 @@ namespace Runtime
 		U8* reservedBaseAddress;
 		Uptr reservedNumPlatformPages;
 
-		MemoryInstance(const MemoryType& inType): GCObject(ObjectKind::memory), type(inType), baseAddress(nullptr), numPages(0), endOffset(0), reservedBaseAddress(nullptr), reservedNumPlatformPages(0) {}
+		// The snapshot whose image is mapped at the start of the memory by resetMemory, if any. The mutex serializes
+		// resetting the memory with deleting the snapshot, which may happen on another thread.
+		const MemorySnapshot* mappedSnapshot;
+		Platform::Mutex* snapshotMutex;
+
+		MemoryInstance(const MemoryType& inType): GCObject(ObjectKind::memory), type(inType), baseAddress(nullptr), numPages(0), endOffset(0), reservedBaseAddress(nullptr), reservedNumPlatformPages(0), mappedSnapshot(nullptr), snapshotMutex(Platform::createMutex()) {}
 		~MemoryInstance() override;
+	};
 
-      static MemoryInstance* theMemoryInstance;
+	// The initial contents of a memory. If the platform can't map an image of them, resetMemory copies the bytes instead.
+	struct MemorySnapshot
+	{
+		Uptr numBytes;
+		Platform::VirtualImage* image;
+		std::vector<U8> bytes;
 	};
 
 	// An instance of a WebAssembly global.
@@ -1,12 +1,5 @@
-/**
- *  @file
- *  @copyright defined in eos/LICENSE.txt
- */
 #include <eosio/account_history_plugin/account_history_plugin.hpp>
-#include <eosio/account_history_plugin/account_control_history_object.hpp>
-#include <eosio/account_history_plugin/account_transaction_history_object.hpp>
-#include <eosio/account_history_plugin/public_key_history_object.hpp>
-#include <eosio/account_history_plugin/transaction_history_object.hpp>
+#include <eosio/account_history_plugin/history_store.hpp>
 #include <eosio/chain/account_object.hpp>
 #include <eosio/chain/chain_controller.hpp>
 #include <eosio/chain/config.hpp>
@@ -16,11 +9,9 @@
 
 #include <fc/crypto/sha256.hpp>
 #include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
 #include <fc/variant.hpp>
 
-#include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/mem_fun.hpp>
-#include <eosio/chain/multi_index_includes.hpp>
 #include <boost/range/adaptors.hpp>
 #include <boost/range/algorithm.hpp>
 #include <boost/range/algorithm_ext.hpp>
@@ -36,9 +27,7 @@ using chain::permission_level_weight;
 using chain::permission_name;
 using chain::packed_transaction;
 using chain::signed_block;
-using boost::multi_index_container;
 using chain::transaction_id_type;
-using namespace boost::multi_index;
 using ordered_transaction_results = account_history_apis::read_only::ordered_transaction_results;
 using get_transactions_results = account_history_apis::read_only::get_transactions_results;
 
@@ -49,61 +38,31 @@ public:
    vector<account_name> get_key_accounts(const public_key_type& public_key) const;
    vector<account_name> get_controlled_accounts(const account_name& controlling_account) const;
    void applied_block(const chain::block_trace&);
+   void applied_irreversible_block(const signed_block&);
    fc::variant transaction_to_variant(const packed_transaction& pretty_input) const;
 
    chain_plugin* chain_plug;
    static const int64_t DEFAULT_TRANSACTION_TIME_LIMIT;
    int64_t transactions_time_limit = DEFAULT_TRANSACTION_TIME_LIMIT;
    std::set<account_name> filter_on;
+   std::unique_ptr<history_store> store;
 
-   bool init_db = false;
-   void check_init_db() {
-      if( !init_db ) {
-         init_db = true;
-         auto& db = chain_plug->chain().get_mutable_database();
-         db.add_index<account_control_history_multi_index>();
-         db.add_index<account_transaction_history_multi_index>();
-         db.add_index<public_key_history_multi_index>();
-         db.add_index<transaction_history_multi_index>();
-      }
-   }
 private:
-   struct block_comp
-   {
-      bool operator()(const block_id_type& a, const block_id_type& b) const
-      {
-         return chain::block_header::num_from_id(a) > chain::block_header::num_from_id(b);
-      }
+   /// history of the reversible blocks of the current chain, by block number, waiting for their block to become
+   /// irreversible. Reads are served from them as well as from the store.
+   std::map<uint32_t, std::pair<block_id_type, history_block>> pending_blocks;
+
+   struct pending_transaction {
+      block_id_type       block_id;
+      transaction_id_type id;
    };
-   typedef std::multimap<block_id_type, transaction_id_type, block_comp> block_transaction_id_map;
 
-   optional<block_id_type> find_block_id(const chainbase::database& db, const transaction_id_type& transaction_id) const;
-   packed_transaction find_transaction(const chain::transaction_id_type&  transaction_id, const signed_block& block) const;
+   packed_transaction read_transaction(const transaction_location& location) const;
+   packed_transaction read_pending_transaction(const pending_transaction& pending) const;
+   vector<pending_transaction> pending_account_transactions(const account_name& account) const;
+   vector<authority_change> pending_authority_changes() const;
    bool is_scope_relevant(const vector<account_name>& scope);
-   get_transactions_results ordered_transactions(const block_transaction_id_map& block_transaction_ids, const fc::time_point& start_time, const uint32_t begin, const uint32_t end) const;
-   static void add(chainbase::database& db, const vector<key_weight>& keys, const account_name& account_name, const permission_name& permission);
-   template<typename MultiIndex, typename LookupType>
-   static void remove(chainbase::database& db, const account_name& account_name, const permission_name& permission)
-   {
-      const auto& idx = db.get_index<MultiIndex, LookupType>();
-      auto& mutable_idx = db.get_mutable_index<MultiIndex>();
-      while(!idx.empty()) {
-         auto key = boost::make_tuple(account_name, permission);
-         const auto& itr = idx.lower_bound(key);
-         if (itr == idx.end()) {
-            break;
-         }
-
-         const auto& range_end = idx.upper_bound(key);
-         if (itr == range_end) {
-            break;
-         }
-
-         mutable_idx.remove(*itr);
-      }
-   }
-
-   static void add(chainbase::database& db, const vector<permission_level_weight>& controlling_accounts, const account_name& account_name, const permission_name& permission);
+   static void add(history_block& block, const chain::authority& auth, const account_name& account_name, const permission_name& permission);
    bool time_exceeded(const fc::time_point& start_time) const;
 
    static const account_name NEW_ACCOUNT;
@@ -121,41 +80,75 @@ const permission_name account_history_plugin_impl::OWNER = "owner";
 const permission_name account_history_plugin_impl::ACTIVE = "active";
 const permission_name account_history_plugin_impl::RECOVERY = "recovery";
 
-optional<block_id_type> account_history_plugin_impl::find_block_id(const chainbase::database& db, const transaction_id_type& transaction_id) const
+packed_transaction account_history_plugin_impl::read_transaction(const transaction_location& location) const
 {
-   optional<block_id_type> block_id;
-   const auto& trx_idx = db.get_index<transaction_history_multi_index, by_trx_id>();
-   auto transaction_history = trx_idx.find( transaction_id );
-   if (transaction_history != trx_idx.end())
-      block_id = transaction_history->block_id;
-
-   return block_id;
+   auto block = chain_plug->chain().fetch_packed_block_by_number(location.block_num);
+   FC_ASSERT(block, "Transaction was indexed as being in block ${b}, but no such block is in the block log", ("b", location.block_num));
+   FC_ASSERT(location.trx_offset < block->size(), "Transaction was indexed at offset ${o} of block ${b}, which is only ${s} bytes",
+             ("o", location.trx_offset)("b", location.block_num)("s", block->size()));
+
+   fc::datastream<const char*> ds(block->data() + location.trx_offset, block->size() - location.trx_offset);
+   packed_transaction trx;
+   fc::raw::unpack(ds, trx);
+   return trx;
 }
 
-packed_transaction account_history_plugin_impl::find_transaction(const chain::transaction_id_type&  transaction_id, const chain::signed_block& block) const
+packed_transaction account_history_plugin_impl::read_pending_transaction(const pending_transaction& pending) const
 {
-   for (const packed_transaction& trx : block.input_transactions)
-      if (trx.get_transaction().id() == transaction_id)
+   auto block = chain_plug->chain().fetch_block_by_id(pending.block_id);
+   FC_ASSERT(block, "Transaction was indexed as being in block ${b}, but no such block is known", ("b", pending.block_id));
+   for (const auto& trx : block->input_transactions)
+      if (trx.get_transaction().id() == pending.id)
          return trx;
 
-   // ERROR in indexing logic
-   FC_THROW("Transaction with ID ${tid} was indexed as being in block ID ${bid}, but was not found in that block", ("tid", transaction_id)("bid", block.id()));
+   FC_THROW("Transaction with ID ${tid} was indexed as being in block ${b}, but was not found in that block",
+            ("tid", pending.id)("b", pending.block_id));
+}
+
+/// the account's transactions in reversible blocks, newest first like those of the store
+vector<account_history_plugin_impl::pending_transaction> account_history_plugin_impl::pending_account_transactions(const account_name& account) const
+{
+   vector<pending_transaction> result;
+   for (auto block = pending_blocks.rbegin(); block != pending_blocks.rend(); ++block)
+   {
+      vector<const history_block::transaction*> ordered;
+      for (const auto& trx : block->second.second.transactions)
+         if (std::find(trx.accounts.begin(), trx.accounts.end(), account) != trx.accounts.end())
+            ordered.push_back(&trx);
+      std::sort(ordered.begin(), ordered.end(), [](const history_block::transaction* a, const history_block::transaction* b) {
+         return a->location.trx_offset > b->location.trx_offset;
+      });
+      for (const auto* trx : ordered)
+         result.push_back(pending_transaction{block->second.first, trx->id});
+   }
+   return result;
+}
+
+vector<authority_change> account_history_plugin_impl::pending_authority_changes() const
+{
+   vector<authority_change> changes;
+   for (const auto& block : pending_blocks)
+      changes.insert(changes.end(), block.second.second.authorities.begin(), block.second.second.authorities.end());
+   return changes;
 }
 
 packed_transaction account_history_plugin_impl::get_transaction(const chain::transaction_id_type&  transaction_id) const
 {
-   const auto& db = chain_plug->chain().get_database();
-   optional<block_id_type> block_id;
-   db.with_read_lock( [&]() {
-      block_id = find_block_id(db, transaction_id);
-   } );
-   if( block_id.valid() )
+   auto location = store->find_transaction(transaction_id);
+   if( location.valid() )
    {
-      auto block = chain_plug->chain().fetch_block_by_id(*block_id);
-      FC_ASSERT(block, "Transaction with ID ${tid} was indexed as being in block ID ${bid}, but no such block was found", ("tid", transaction_id)("bid", block_id));
-      return find_transaction(transaction_id, *block);
+      auto trx = read_transaction(*location);
+      // ERROR in indexing logic
+      FC_ASSERT(trx.get_transaction().id() == transaction_id, "Transaction with ID ${tid} was indexed as being in block ${b}, but was not found in that block",
+                ("tid", transaction_id)("b", location->block_num));
+      return trx;
    }
 
+   for (const auto& block : pending_blocks)
+      for (const auto& trx : block.second.second.transactions)
+         if (trx.id == transaction_id)
+            return read_pending_transaction(pending_transaction{block.second.first, transaction_id});
+
    FC_THROW_EXCEPTION(chain::unknown_transaction_exception,
                       "Could not find transaction for: ${id}", ("id", transaction_id.str()));
 }
@@ -163,22 +156,11 @@ packed_transaction account_history_plugin_impl::get_transaction(const chain::tra
 get_transactions_results account_history_plugin_impl::get_transactions(const account_name&  account_name, const optional<uint32_t>& skip_seq, const optional<uint32_t>& num_seq) const
 {
    fc::time_point start_time = fc::time_point::now();
-   const auto& db = chain_plug->chain().get_database();
-
-   block_transaction_id_map block_transaction_ids;
-   db.with_read_lock( [&]() {
-      const auto& account_idx = db.get_index<account_transaction_history_multi_index, by_account_name>();
-      auto range = account_idx.equal_range( account_name );
-      for (auto obj = range.first; obj != range.second; ++obj)
-      {
-         optional<block_id_type> block_id = find_block_id(db, obj->transaction_id);
-         FC_ASSERT(block_id, "Transaction with ID ${tid} was tracked for ${account}, but no corresponding block id was found", ("tid", obj->transaction_id)("account", account_name));
-         block_transaction_ids.emplace(std::make_pair(*block_id,  obj->transaction_id));
-      }
-   } );
 
+   // the transactions of reversible blocks are the newest, they come before those of the store
+   const auto pending = pending_account_transactions(account_name);
    uint32_t begin, end;
-   const auto size = block_transaction_ids.size();
+   const auto size = pending.size() + store->count_account_transactions(account_name);
    if (!skip_seq)
    {
       begin = 0;
@@ -193,72 +175,28 @@ get_transactions_results account_history_plugin_impl::get_transactions(const acc
       else
       {
          end = begin + *num_seq;
-         if (end > size)
+         if (end > size || end < begin)
             end = size;
       }
-
-      if (begin > size - 1 || begin >= end)
-         return get_transactions_results();
    }
 
-   return ordered_transactions(block_transaction_ids, start_time, begin, end);
-}
-
-get_transactions_results account_history_plugin_impl::ordered_transactions(const block_transaction_id_map& block_transaction_ids, const fc::time_point& start_time, const uint32_t begin, const uint32_t end) const
-{
    get_transactions_results results;
-   results.transactions.reserve(end - begin);
+   if (begin >= end)
+      return results;
 
-   auto block_transaction = block_transaction_ids.cbegin();
-
-   uint32_t current = 0;
-   // keep iterating through each equal range
-   while (block_transaction != block_transaction_ids.cend() && !time_exceeded(start_time))
+   // newest first, the same order as the sequence numbers
+   const uint32_t stored_begin = std::max<uint32_t>(begin, pending.size()) - pending.size();
+   const auto locations = store->get_account_transactions(account_name, stored_begin, end > pending.size() ? end - pending.size() - stored_begin : 0);
+   results.transactions.reserve(end - begin);
+   uint32_t current = begin;
+   while (current < end)
    {
-      optional<signed_block> block = chain_plug->chain().fetch_block_by_id(block_transaction->first);
-      FC_ASSERT(block, "Transaction with ID ${tid} was indexed as being in block ID ${bid}, but no such block was found", ("tid", block_transaction->second)("bid", block_transaction->first));
-
-      auto range = block_transaction_ids.equal_range(block_transaction->first);
+      const auto trx = current < pending.size() ? read_pending_transaction(pending[current])
+                                                : read_transaction(locations[current - pending.size() - stored_begin]);
+      results.transactions.emplace_back(ordered_transaction_results{current++, trx.get_transaction().id(), transaction_to_variant(trx)});
 
-      std::set<transaction_id_type> trans_ids_for_block;
-      for (block_transaction = range.first; block_transaction != range.second; ++block_transaction)
-      {
-         trans_ids_for_block.insert(block_transaction->second);
-      }
-
-      const uint32_t trx_after_block = current + trans_ids_for_block.size();
-      if (trx_after_block <= begin)
-      {
-         current = trx_after_block;
-         continue;
-      }
-      for (auto trx = block->input_transactions.crbegin(); trx != block->input_transactions.crend() && current < trx_after_block; ++trx)
-      {
-         transaction_id_type trx_id = trx->get_transaction().id();
-         if(trans_ids_for_block.count(trx_id))
-         {
-            if(++current > begin)
-            {
-               const auto pretty_trx = transaction_to_variant(*trx);
-               results.transactions.emplace_back(ordered_transaction_results{(current - 1), trx_id, pretty_trx});
-
-               if(current >= end)
-               {
-                  return results;
-               }
-            }
-
-            // just check after finding transaction or transitioning to next block to avoid spending all our time checking
-            if (time_exceeded(start_time))
-            {
-               results.time_limit_exceeded_error = true;
-               return results;
-            }
-         }
-      }
-
-      // just check after finding transaction or transitioning to next block to avoid spending all our time checking
-      if (time_exceeded(start_time))
+      // just check after finding transaction to avoid spending all our time checking
+      if (current < end && time_exceeded(start_time))
       {
          results.time_limit_exceeded_error = true;
          return results;
@@ -275,32 +213,12 @@ bool account_history_plugin_impl::time_exceeded(const fc::time_point& start_time
 
 vector<account_name> account_history_plugin_impl::get_key_accounts(const public_key_type& public_key) const
 {
-   std::set<account_name> accounts;
-   const auto& db = chain_plug->chain().get_database();
-   db.with_read_lock( [&]() {
-      const auto& pub_key_idx = db.get_index<public_key_history_multi_index, by_pub_key>();
-      auto range = pub_key_idx.equal_range( public_key );
-      for (auto obj = range.first; obj != range.second; ++obj)
-      {
-         accounts.insert(obj->name);
-      }
-   } );
-   return vector<account_name>(accounts.begin(), accounts.end());
+   return store->get_key_accounts(public_key, pending_authority_changes());
 }
 
 vector<account_name> account_history_plugin_impl::get_controlled_accounts(const account_name& controlling_account) const
 {
-   std::set<account_name> accounts;
-   const auto& db = chain_plug->chain().get_database();
-   db.with_read_lock( [&]() {
-      const auto& account_control_idx = db.get_index<account_control_history_multi_index, by_controlling>();
-      auto range = account_control_idx.equal_range( controlling_account );
-      for (auto obj = range.first; obj != range.second; ++obj)
-      {
-         accounts.insert(obj->controlled_account);
-      }
-   } );
-   return vector<account_name>(accounts.begin(), accounts.end());
+   return store->get_controlled_accounts(controlling_account, pending_authority_changes());
 }
 
 static vector<account_name> generated_affected_accounts(const chain::transaction_trace& trx_trace) {
@@ -317,11 +235,35 @@ static vector<account_name> generated_affected_accounts(const chain::transaction
    return result;
 }
 
+/**
+ * The offsets of the input transactions inside the block as it is packed into the block log, a packed block is
+ * its summary followed by the input transactions.
+ */
+static std::map<transaction_id_type, uint32_t> input_transaction_offsets(const signed_block& block) {
+   std::map<transaction_id_type, uint32_t> offsets;
+   uint64_t offset = fc::raw::pack_size(static_cast<const chain::signed_block_summary&>(block)) +
+                     fc::raw::pack_size(fc::unsigned_int((uint32_t)block.input_transactions.size()));
+   for (const auto& trx : block.input_transactions) {
+      offsets.emplace(trx.get_transaction().id(), offset);
+      offset += fc::raw::pack_size(trx);
+   }
+   return offsets;
+}
+
 void account_history_plugin_impl::applied_block(const chain::block_trace& trace)
 {
    const auto& block = trace.block;
-   const auto block_id = block.id();
-   auto& db = chain_plug->chain().get_mutable_database();
+   const auto block_num = block.block_num();
+   if (block_num <= store->head_block_num())
+      return; // on restart or replay may already have block
+
+   // blocks are applied in order along the current chain, so the blocks pending from this number on belong to a
+   // fork that was switched away from. Should that fork be switched back to, its blocks are applied again.
+   pending_blocks.erase(pending_blocks.lower_bound(block_num), pending_blocks.end());
+
+   history_block history;
+   history.block_num = block_num;
+   optional<std::map<transaction_id_type, uint32_t>> trx_offsets;
    const bool check_relevance = filter_on.size();
    auto process_one = [&](const chain::transaction_trace& trx_trace )
    {
@@ -329,25 +271,13 @@ void account_history_plugin_impl::applied_block(const chain::block_trace& trace)
       if (check_relevance && !is_scope_relevant(affected_accounts))
          return;
 
-      auto trx_obj_ptr = db.find<transaction_history_object, by_trx_id>(trx_trace.id);
-      if (trx_obj_ptr != nullptr)
-         return; // on restart may already have block
-
-      db.create<transaction_history_object>([&block_id,&trx_trace](transaction_history_object& transaction_history) {
-         transaction_history.block_id = block_id;
-         transaction_history.transaction_id = trx_trace.id;
-         transaction_history.transaction_status = trx_trace.status;
-      });
-
-      auto create_ath_object = [&trx_trace,&db](const account_name& name) {
-         db.create<account_transaction_history_object>([&trx_trace,&name](account_transaction_history_object& account_transaction_history) {
-            account_transaction_history.name = name;
-            account_transaction_history.transaction_id = trx_trace.id;
-         });
-      };
-
-      for (const auto& account_name : affected_accounts)
-         create_ath_object(account_name);
+      if (!trx_offsets)
+         trx_offsets = input_transaction_offsets(block);
+      // deferred and generated transactions are not stored in the block, so they have no location to record, but
+      // the authorities they change are indexed like those of any other transaction
+      auto offset = trx_offsets->find(trx_trace.id);
+      if (offset != trx_offsets->end())
+         history.transactions.emplace_back(history_block::transaction{trx_trace.id, transaction_location{block_num, offset->second}, std::move(affected_accounts)});
 
       for (const auto& act_trace : trx_trace.action_traces)
       {
@@ -356,29 +286,19 @@ void account_history_plugin_impl::applied_block(const chain::block_trace& trace)
             if (act_trace.act.name == NEW_ACCOUNT)
             {
                const auto create = act_trace.act.data_as<chain::contracts::newaccount>();
-               add(db, create.owner.keys, create.name, OWNER);
-               add(db, create.active.keys, create.name, ACTIVE);
-               add(db, create.recovery.keys, create.name, RECOVERY);
-
-               add(db, create.owner.accounts, create.name, OWNER);
-               add(db, create.active.accounts, create.name, ACTIVE);
-               add(db, create.recovery.accounts, create.name, RECOVERY);
+               add(history, create.owner, create.name, OWNER);
+               add(history, create.active, create.name, ACTIVE);
+               add(history, create.recovery, create.name, RECOVERY);
             }
             else if (act_trace.act.name == UPDATE_AUTH)
             {
                const auto update = act_trace.act.data_as<chain::contracts::updateauth>();
-               remove<public_key_history_multi_index, by_account_permission>(db, update.account, update.permission);
-               add(db, update.data.keys, update.account, update.permission);
-
-               remove<account_control_history_multi_index, by_controlled_authority>(db, update.account, update.permission);
-               add(db, update.data.accounts, update.account, update.permission);
+               add(history, update.data, update.account, update.permission);
             }
             else if (act_trace.act.name == DELETE_AUTH)
             {
                const auto del = act_trace.act.data_as<chain::contracts::deleteauth>();
-               remove<public_key_history_multi_index, by_account_permission>(db, del.account, del.permission);
-
-               remove<account_control_history_multi_index, by_controlled_authority>(db, del.account, del.permission);
+               history.authorities.emplace_back(authority_change{del.account, del.permission});
             }
          }
       }
@@ -390,30 +310,39 @@ void account_history_plugin_impl::applied_block(const chain::block_trace& trace)
          for(const auto& st: ct.shard_traces)
             for(const auto& trx_trace: st.transaction_traces)
                process_one(trx_trace);
+
+   if (history.transactions.empty() && history.authorities.empty())
+      return;
+
+   // blocks replayed from the block log are already irreversible
+   if (chain_plug->chain().fetch_packed_block_by_number(block_num))
+      store->append(history);
+   else
+      pending_blocks.emplace(block_num, std::make_pair(block.id(), std::move(history)));
 }
 
-void account_history_plugin_impl::add(chainbase::database& db, const vector<key_weight>& keys, const account_name& name, const permission_name& permission)
+void account_history_plugin_impl::applied_irreversible_block(const signed_block& block)
 {
-   for (auto pub_key_weight : keys )
+   const auto block_num = block.block_num();
+   const auto block_id = block.id();
+   auto range_end = pending_blocks.upper_bound(block_num);
+   for (auto itr = pending_blocks.begin(); itr != range_end; ++itr)
    {
-      db.create<public_key_history_object>([&](public_key_history_object& obj) {
-         obj.public_key = pub_key_weight.key;
-         obj.name = name;
-         obj.permission = permission;
-      });
+      // blocks of forks that were abandoned are dropped along with it
+      if (itr->first == block_num && itr->second.first == block_id && block_num > store->head_block_num())
+         store->append(itr->second.second);
    }
+   pending_blocks.erase(pending_blocks.begin(), range_end);
 }
 
-void account_history_plugin_impl::add(chainbase::database& db, const vector<permission_level_weight>& controlling_accounts, const account_name& account_name, const permission_name& permission)
+void account_history_plugin_impl::add(history_block& block, const chain::authority& auth, const account_name& name, const permission_name& permission)
 {
-   for (auto controlling_account : controlling_accounts )
-   {
-      db.create<account_control_history_object>([&](account_control_history_object& obj) {
-         obj.controlled_account = account_name;
-         obj.controlled_permission = permission;
-         obj.controlling_account = controlling_account.permission.actor;
-      });
-   }
+   authority_change change{name, permission};
+   for (const auto& pub_key_weight : auth.keys)
+      change.keys.emplace_back(pub_key_weight.key);
+   for (const auto& controlling_account : auth.accounts)
+      change.controlling_accounts.emplace_back(controlling_account.permission.actor);
+   block.authorities.emplace_back(std::move(change));
 }
 
 bool account_history_plugin_impl::is_scope_relevant(const vector<account_name>& scope)
@@ -427,17 +356,14 @@ bool account_history_plugin_impl::is_scope_relevant(const vector<account_name>&
 
 fc::variant account_history_plugin_impl::transaction_to_variant(const packed_transaction& ptrx) const
 {
-   const chainbase::database& database = chain_plug->chain().get_database();
-   auto resolver = [&database]( const account_name& name ) -> optional<abi_serializer> {
-      const auto* accnt = database.find<chain::account_object,chain::by_name>( name );
+   const chain::chain_controller& controller = chain_plug->chain();
+   auto resolver = [&controller]( const account_name& name ) -> chain::contracts::abi_serializer_cache::abi_serializer_ptr {
+      const auto* accnt = controller.get_database().find<chain::account_object,chain::by_name>( name );
       if (accnt != nullptr) {
-         abi_def abi;
-         if (abi_serializer::to_abi(accnt->abi, abi)) {
-            return abi_serializer(abi);
-         }
+         return controller.get_abi_serializer_cache().get_serializer(*accnt);
       }
 
-      return optional<abi_serializer>();
+      return chain::contracts::abi_serializer_cache::abi_serializer_ptr();
    };
 
    fc::variant pretty_output;
@@ -462,6 +388,8 @@ void account_history_plugin::set_program_options(options_description& cli, optio
           "Track only transactions whose scopes involve the listed accounts. Default is to track all transactions.")
          ("get-transactions-time-limit", bpo::value<int>()->default_value(account_history_plugin_impl::DEFAULT_TRANSACTION_TIME_LIMIT),
           "Limits the maximum time (in milliseconds) processing a single get_transactions call.")
+         ("account-history-dir", bpo::value<bfs::path>()->default_value("account_history"),
+          "the location of the account history store (absolute path or relative to application data dir)")
          ;
 }
 
@@ -476,28 +404,36 @@ void account_history_plugin::plugin_initialize(const variables_map& options)
          my->filter_on.emplace(filter_account);
    }
 
+   auto history_dir = options.at("account-history-dir").as<bfs::path>();
+   if(history_dir.is_relative())
+      history_dir = app().data_dir() / history_dir;
+   my->store.reset(new history_store(history_dir));
+
    my->chain_plug = app().find_plugin<chain_plugin>();
-   my->chain_plug->chain_config().applied_block_callbacks.emplace_back( 
+   my->chain_plug->chain_config().applied_block_callbacks.emplace_back(
             [&impl = my](const chain::block_trace& trace) {
-                  impl->check_init_db();
+               try {
                   impl->applied_block(trace);
+               } FC_LOG_AND_DROP()
+            });
+   my->chain_plug->chain_config().applied_irreversible_block_callbacks.emplace_back(
+            [&impl = my](const signed_block& block) {
+               try {
+                  impl->applied_irreversible_block(block);
+               } FC_LOG_AND_DROP()
             });
 }
 
 
 void account_history_plugin::plugin_startup()
 {
-   /*
-   auto& db = my->chain_plug->chain().get_mutable_database();
-   db.add_index<account_control_history_multi_index>();
-   db.add_index<account_transaction_history_multi_index>();
-   db.add_index<public_key_history_multi_index>();
-   db.add_index<transaction_history_multi_index>();
-
-   my->chain_plug->chain().applied_block.connect ([&impl = my](const chain::block_trace& trace) {
-      impl->applied_block(trace);
-   });
-   */
+   // the history points into the block log, it is of no use once the blocks it was built from are gone
+   const auto head = my->store->head_block_num();
+   if (head && !my->chain_plug->chain().fetch_packed_block_by_number(head))
+   {
+      wlog("Block ${b} of the account history is not in the block log, wiping the account history", ("b", head));
+      my->store->wipe();
+   }
 }
 
 void account_history_plugin::plugin_shutdown()
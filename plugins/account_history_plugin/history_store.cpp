@@ -0,0 +1,339 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+#include <eosio/account_history_plugin/history_store.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <set>
+
+#define HISTORY_LOG_MODE (std::ios::in | std::ios::out | std::ios::binary | std::ios::app)
+
+namespace eosio {
+
+namespace {
+   const uint64_t npos = std::numeric_limits<uint64_t>::max();
+
+   struct transaction_record {
+      char     id[sizeof(transaction_id_type)];
+      uint32_t block_num;
+      uint32_t trx_offset;
+   };
+
+   struct posting_record {
+      uint64_t account;
+      uint32_t block_num;
+      uint32_t trx_offset;
+      uint64_t prev; ///< record number of the account's previous posting, or npos
+   };
+
+   struct head_record {
+      uint32_t block_num;
+      uint32_t reserved;
+      uint64_t transaction_count;
+      uint64_t posting_count;
+      uint64_t authorities_size;
+   };
+
+   uint64_t id_prefix(const transaction_id_type& id) {
+      return id._hash[0];
+   }
+
+   template<typename Record>
+   Record read_record(std::fstream& stream, uint64_t record_num) {
+      Record r;
+      stream.seekg(record_num * sizeof(Record));
+      stream.read((char*)&r, sizeof(r));
+      return r;
+   }
+
+   /// truncate what an interrupted write left beyond the committed size
+   void truncate_file(const fc::path& file, uint64_t size) {
+      if (fc::exists(file) && fc::file_size(file) > size) {
+         wlog("Truncating ${f} from ${old} to ${new} bytes", ("f", file.generic_string())("old", fc::file_size(file))("new", size));
+         fc::resize_file(file, size);
+      }
+   }
+}
+
+history_store::history_store(const fc::path& data_dir)
+{
+   if (!fc::is_directory(data_dir))
+      fc::create_directories(data_dir);
+   _transactions_file = data_dir / "transactions.log";
+   _postings_file = data_dir / "postings.log";
+   _authorities_file = data_dir / "authorities.log";
+   _head_file = data_dir / "history.head";
+
+   _transactions.exceptions(std::fstream::failbit | std::fstream::badbit);
+   _postings.exceptions(std::fstream::failbit | std::fstream::badbit);
+   _authorities.exceptions(std::fstream::failbit | std::fstream::badbit);
+
+   open();
+}
+
+void history_store::open()
+{
+   head_record head{};
+   if (fc::exists(_head_file)) {
+      std::ifstream head_stream(_head_file.generic_string().c_str(), std::ios::binary);
+      head_stream.read((char*)&head, sizeof(head));
+      FC_ASSERT(head_stream.gcount() == sizeof(head), "Account history head file ${f} is corrupt", ("f", _head_file.generic_string()));
+   }
+   _head_block_num = head.block_num;
+   _transaction_count = head.transaction_count;
+   _posting_count = head.posting_count;
+   _authorities_size = head.authorities_size;
+
+   truncate_file(_transactions_file, _transaction_count * sizeof(transaction_record));
+   truncate_file(_postings_file, _posting_count * sizeof(posting_record));
+   truncate_file(_authorities_file, _authorities_size);
+
+   _transactions.open(_transactions_file.generic_string().c_str(), HISTORY_LOG_MODE);
+   _postings.open(_postings_file.generic_string().c_str(), HISTORY_LOG_MODE);
+   _authorities.open(_authorities_file.generic_string().c_str(), HISTORY_LOG_MODE);
+
+   FC_ASSERT(fc::file_size(_transactions_file) == _transaction_count * sizeof(transaction_record) &&
+             fc::file_size(_postings_file) == _posting_count * sizeof(posting_record) &&
+             fc::file_size(_authorities_file) == _authorities_size,
+             "Account history logs are shorter than recorded in ${f}", ("f", _head_file.generic_string()));
+
+   _transaction_records.clear();
+   _posting_heads.clear();
+   _public_keys.clear();
+   _account_controls.clear();
+
+   _transactions.seekg(0);
+   for (uint64_t i = 0; i < _transaction_count; ++i) {
+      transaction_record r;
+      _transactions.read((char*)&r, sizeof(r));
+      transaction_id_type id;
+      memcpy(id.data(), r.id, sizeof(r.id));
+      _transaction_records.emplace(id_prefix(id), i);
+   }
+
+   _postings.seekg(0);
+   for (uint64_t i = 0; i < _posting_count; ++i) {
+      posting_record r;
+      _postings.read((char*)&r, sizeof(r));
+      auto& head = _posting_heads[r.account];
+      head.last = i;
+      ++head.count;
+   }
+
+   _authorities.seekg(0);
+   for (uint64_t pos = 0; pos < _authorities_size;) {
+      uint32_t size;
+      _authorities.read((char*)&size, sizeof(size));
+      vector<char> data(size);
+      _authorities.read(data.data(), size);
+      apply(fc::raw::unpack<authority_change>(data));
+      pos += sizeof(size) + size;
+   }
+
+   ilog("Opened account history at block ${b} with ${t} transactions",
+        ("b", _head_block_num)("t", _transaction_count));
+}
+
+void history_store::wipe()
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+   _transactions.close();
+   _postings.close();
+   _authorities.close();
+   fc::remove_all(_head_file);
+   fc::remove_all(_transactions_file);
+   fc::remove_all(_postings_file);
+   fc::remove_all(_authorities_file);
+   open();
+}
+
+void history_store::append(const history_block& block)
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+   FC_ASSERT(block.block_num > _head_block_num, "Account history is already at block ${h}, cannot append block ${b}",
+             ("h", _head_block_num)("b", block.block_num));
+
+   // postings in the order the transactions are stored in the block, so that walking back from the newest posting
+   // returns a block's transactions last to first
+   vector<const history_block::transaction*> ordered;
+   ordered.reserve(block.transactions.size());
+   for (const auto& trx : block.transactions)
+      ordered.push_back(&trx);
+   std::sort(ordered.begin(), ordered.end(), [](const history_block::transaction* a, const history_block::transaction* b) {
+      return a->location.trx_offset < b->location.trx_offset;
+   });
+
+   std::unordered_map<uint64_t, posting_head> posting_heads;
+   uint64_t posting_count = _posting_count;
+   for (const auto* trx : ordered) {
+      for (const auto& account : trx->accounts) {
+         auto itr = posting_heads.find(account.value);
+         if (itr == posting_heads.end()) {
+            auto existing = _posting_heads.find(account.value);
+            itr = posting_heads.emplace(account.value, existing == _posting_heads.end() ? posting_head() : existing->second).first;
+         }
+         auto& head = itr->second;
+         posting_record r{account.value, block.block_num, trx->location.trx_offset, head.count ? head.last : npos};
+         _postings.write((const char*)&r, sizeof(r));
+         head.last = posting_count++;
+         ++head.count;
+      }
+   }
+
+   uint64_t authorities_size = _authorities_size;
+   for (const auto& change : block.authorities) {
+      auto data = fc::raw::pack(change);
+      uint32_t size = data.size();
+      _authorities.write((const char*)&size, sizeof(size));
+      _authorities.write(data.data(), data.size());
+      authorities_size += sizeof(size) + size;
+   }
+
+   for (const auto& trx : block.transactions) {
+      transaction_record r;
+      memcpy(r.id, trx.id.data(), sizeof(r.id));
+      r.block_num = block.block_num;
+      r.trx_offset = trx.location.trx_offset;
+      _transactions.write((const char*)&r, sizeof(r));
+   }
+
+   _postings.flush();
+   _authorities.flush();
+   _transactions.flush();
+
+   for (const auto& head : posting_heads)
+      _posting_heads[head.first] = head.second;
+   for (const auto& trx : block.transactions)
+      _transaction_records.emplace(id_prefix(trx.id), _transaction_count++);
+   _posting_count = posting_count;
+   _authorities_size = authorities_size;
+   _head_block_num = block.block_num;
+   for (const auto& change : block.authorities)
+      apply(change);
+
+   write_head();
+}
+
+void history_store::write_head()
+{
+   head_record head{_head_block_num, 0, _transaction_count, _posting_count, _authorities_size};
+   auto tmp_file = _head_file.generic_string() + ".tmp";
+   {
+      std::ofstream head_stream(tmp_file.c_str(), std::ios::binary | std::ios::trunc);
+      head_stream.write((const char*)&head, sizeof(head));
+      head_stream.flush();
+      FC_ASSERT(head_stream.good(), "Unable to write ${f}", ("f", tmp_file));
+   }
+   fc::rename(tmp_file, _head_file);
+}
+
+void history_store::apply(const authority_change& change)
+{
+   auto& key_idx = _public_keys.get<by_account_permission>();
+   key_idx.erase(key_idx.lower_bound(boost::make_tuple(change.account, change.permission)),
+                 key_idx.upper_bound(boost::make_tuple(change.account, change.permission)));
+   for (const auto& key : change.keys)
+      _public_keys.insert(public_key_entry{key, change.account, change.permission});
+
+   auto& control_idx = _account_controls.get<by_account_permission>();
+   control_idx.erase(control_idx.lower_bound(boost::make_tuple(change.account, change.permission)),
+                     control_idx.upper_bound(boost::make_tuple(change.account, change.permission)));
+   for (const auto& controlling : change.controlling_accounts)
+      _account_controls.insert(account_control_entry{change.account, change.permission, controlling});
+}
+
+uint32_t history_store::head_block_num()const
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+   return _head_block_num;
+}
+
+optional<transaction_location> history_store::find_transaction(const transaction_id_type& id)const
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+   auto range = _transaction_records.equal_range(id_prefix(id));
+   for (auto itr = range.first; itr != range.second; ++itr) {
+      auto r = read_record<transaction_record>(_transactions, itr->second);
+      if (memcmp(r.id, id.data(), sizeof(r.id)) == 0)
+         return transaction_location{r.block_num, r.trx_offset};
+   }
+   return optional<transaction_location>();
+}
+
+uint32_t history_store::count_account_transactions(const account_name& account)const
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+   auto itr = _posting_heads.find(account.value);
+   return itr == _posting_heads.end() ? 0 : itr->second.count;
+}
+
+vector<transaction_location> history_store::get_account_transactions(const account_name& account, uint32_t skip, uint32_t num)const
+{
+   vector<transaction_location> result;
+   std::lock_guard<std::mutex> lock(_mutex);
+   auto itr = _posting_heads.find(account.value);
+   if (itr == _posting_heads.end() || skip >= itr->second.count)
+      return result;
+
+   result.reserve(std::min(num, itr->second.count - skip));
+   uint64_t record = itr->second.last;
+   for (uint32_t seq = 0; record != npos && result.size() < num; ++seq) {
+      auto r = read_record<posting_record>(_postings, record);
+      if (seq >= skip)
+         result.push_back(transaction_location{r.block_num, r.trx_offset});
+      record = r.prev;
+   }
+   return result;
+}
+
+/// the last of the changes to each permission
+static std::map<std::pair<account_name, permission_name>, const authority_change*> latest_changes(const vector<authority_change>& changes)
+{
+   std::map<std::pair<account_name, permission_name>, const authority_change*> latest;
+   for (const auto& change : changes)
+      latest[std::make_pair(change.account, change.permission)] = &change;
+   return latest;
+}
+
+vector<account_name> history_store::get_key_accounts(const public_key_type& key, const vector<authority_change>& newer)const
+{
+   const auto replaced = latest_changes(newer);
+   std::set<account_name> accounts;
+   for (const auto& change : replaced)
+      if (std::find(change.second->keys.begin(), change.second->keys.end(), key) != change.second->keys.end())
+         accounts.insert(change.second->account);
+
+   std::lock_guard<std::mutex> lock(_mutex);
+   auto range = _public_keys.get<by_pub_key>().equal_range(key);
+   for (auto itr = range.first; itr != range.second; ++itr)
+      if (!replaced.count(std::make_pair(itr->name, itr->permission)))
+         accounts.insert(itr->name);
+   return vector<account_name>(accounts.begin(), accounts.end());
+}
+
+vector<account_name> history_store::get_controlled_accounts(const account_name& controlling_account, const vector<authority_change>& newer)const
+{
+   const auto replaced = latest_changes(newer);
+   std::set<account_name> accounts;
+   for (const auto& change : replaced) {
+      const auto& controlling = change.second->controlling_accounts;
+      if (std::find(controlling.begin(), controlling.end(), controlling_account) != controlling.end())
+         accounts.insert(change.second->account);
+   }
+
+   std::lock_guard<std::mutex> lock(_mutex);
+   auto range = _account_controls.get<by_controlling>().equal_range(controlling_account);
+   for (auto itr = range.first; itr != range.second; ++itr)
+      if (!replaced.count(std::make_pair(itr->controlled_account, itr->controlled_permission)))
+         accounts.insert(itr->controlled_account);
+   return vector<account_name>(accounts.begin(), accounts.end());
+}
+
+} /// namespace eosio
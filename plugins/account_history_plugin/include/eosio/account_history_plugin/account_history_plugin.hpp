@@ -23,6 +23,10 @@ namespace eosio {
 namespace account_history_apis {
 struct empty{};
 
+/**
+ * The history is served for reversible blocks as well as irreversible ones, so what a read returns about the
+ * newest blocks is undone when the chain switches to another fork.
+ */
 class read_only {
    account_history_const_ptr account_history;
 
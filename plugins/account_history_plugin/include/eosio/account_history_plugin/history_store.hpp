@@ -0,0 +1,197 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+#pragma once
+#include <eosio/chain/types.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+namespace eosio {
+using chain::account_name;
+using chain::permission_name;
+using chain::public_key_type;
+using chain::transaction_id_type;
+using fc::optional;
+using std::vector;
+
+/**
+ * Where a transaction is stored in the block log: the number of the irreversible block that holds it
+ * and the byte offset of its packed_transaction inside that block's entry of the log.
+ */
+struct transaction_location {
+   uint32_t block_num  = 0;
+   uint32_t trx_offset = 0;
+};
+
+/**
+ * The keys and controlling accounts that an authority was set to. An authority that was deleted is
+ * set to neither keys nor accounts.
+ */
+struct authority_change {
+   account_name            account;
+   permission_name         permission;
+   vector<public_key_type> keys;
+   vector<account_name>    controlling_accounts;
+};
+
+/**
+ * Everything the history records for one irreversible block, it is written to the store at once.
+ */
+struct history_block {
+   struct transaction {
+      transaction_id_type  id;
+      transaction_location location;
+      vector<account_name> accounts;
+   };
+
+   uint32_t                 block_num = 0;
+   vector<transaction>      transactions;
+   vector<authority_change> authorities;
+};
+
+/**
+ * An append only store of account history, kept outside of the chain database. It only ever holds
+ * irreversible blocks, so it needs no undo state and does not grow the shared memory file.
+ *
+ *   transactions.log  fixed size records of transaction id -> transaction_location
+ *   postings.log      fixed size records of account -> transaction_location, each one pointing back at
+ *                     the previous posting of the same account so an account's history is walked from
+ *                     its newest transaction without any index on disk
+ *   authorities.log   the authority_change records, replayed on open to rebuild the key and controlling
+ *                     account lookups
+ *   history.head      the last block written and the size of each log after it, replaced once a block is
+ *                     completely written. Anything beyond those sizes is left from an interrupted write and
+ *                     is truncated on open.
+ *
+ * The lookups by transaction id and the heads of the posting lists are kept in memory and rebuilt from
+ * the logs on open. Access is safe from any number of threads at once.
+ */
+class history_store {
+   public:
+      explicit history_store(const fc::path& data_dir);
+
+      /**
+       * Append a block, its number must be above head_block_num()
+       */
+      void append(const history_block& block);
+
+      /**
+       * Remove everything from the store
+       */
+      void wipe();
+
+      /**
+       * @return the number of the last block appended or 0 for an empty store
+       */
+      uint32_t head_block_num()const;
+
+      optional<transaction_location> find_transaction(const transaction_id_type& id)const;
+
+      /**
+       * @return the number of transactions recorded for the account
+       */
+      uint32_t count_account_transactions(const account_name& account)const;
+
+      /**
+       * @return up to num transactions of the account, newest first, after skipping the skip newest ones
+       */
+      vector<transaction_location> get_account_transactions(const account_name& account, uint32_t skip, uint32_t num)const;
+
+      /**
+       * @param newer authority changes of blocks not appended yet, in the order they were made, each one replaces
+       *              what the store holds for its permission
+       */
+      vector<account_name> get_key_accounts(const public_key_type& key, const vector<authority_change>& newer = vector<authority_change>())const;
+      vector<account_name> get_controlled_accounts(const account_name& controlling_account, const vector<authority_change>& newer = vector<authority_change>())const;
+
+   private:
+      struct public_key_entry {
+         public_key_type public_key;
+         account_name    name;
+         permission_name permission;
+      };
+
+      struct account_control_entry {
+         account_name    controlled_account;
+         permission_name controlled_permission;
+         account_name    controlling_account;
+      };
+
+      struct by_pub_key;
+      struct by_controlling;
+      struct by_account_permission;
+      typedef boost::multi_index_container<
+         public_key_entry,
+         boost::multi_index::indexed_by<
+            boost::multi_index::ordered_non_unique<boost::multi_index::tag<by_pub_key>,
+               boost::multi_index::member<public_key_entry, public_key_type, &public_key_entry::public_key>
+            >,
+            boost::multi_index::ordered_non_unique<boost::multi_index::tag<by_account_permission>,
+               boost::multi_index::composite_key< public_key_entry,
+                  boost::multi_index::member<public_key_entry, account_name,    &public_key_entry::name>,
+                  boost::multi_index::member<public_key_entry, permission_name, &public_key_entry::permission>
+               >
+            >
+         >
+      > public_key_index;
+      typedef boost::multi_index_container<
+         account_control_entry,
+         boost::multi_index::indexed_by<
+            boost::multi_index::ordered_non_unique<boost::multi_index::tag<by_controlling>,
+               boost::multi_index::member<account_control_entry, account_name, &account_control_entry::controlling_account>
+            >,
+            boost::multi_index::ordered_non_unique<boost::multi_index::tag<by_account_permission>,
+               boost::multi_index::composite_key< account_control_entry,
+                  boost::multi_index::member<account_control_entry, account_name,    &account_control_entry::controlled_account>,
+                  boost::multi_index::member<account_control_entry, permission_name, &account_control_entry::controlled_permission>
+               >
+            >
+         >
+      > account_control_index;
+
+      /// head of an account's posting list
+      struct posting_head {
+         uint64_t last  = 0; ///< record number of the newest posting
+         uint32_t count = 0;
+      };
+
+      void open();
+      void apply(const authority_change& change);
+      void write_head();
+
+      fc::path                                      _transactions_file;
+      fc::path                                      _postings_file;
+      fc::path                                      _authorities_file;
+      fc::path                                      _head_file;
+
+      mutable std::mutex                            _mutex;
+      mutable std::fstream                          _transactions;
+      mutable std::fstream                          _postings;
+      std::fstream                                  _authorities;
+      uint32_t                                      _head_block_num = 0;
+      uint64_t                                      _transaction_count = 0;
+      uint64_t                                      _posting_count = 0;
+      uint64_t                                      _authorities_size = 0;
+
+      /// record numbers in transactions.log by the leading 64 bits of the transaction id
+      std::unordered_multimap<uint64_t, uint64_t>   _transaction_records;
+      std::unordered_map<uint64_t, posting_head>    _posting_heads;
+      public_key_index                              _public_keys;
+      account_control_index                         _account_controls;
+};
+
+} /// namespace eosio
+
+FC_REFLECT( eosio::transaction_location, (block_num)(trx_offset) )
+FC_REFLECT( eosio::authority_change, (account)(permission)(keys)(controlling_accounts) )
@@ -28,12 +28,13 @@ chain_api_plugin::~chain_api_plugin(){}
 void chain_api_plugin::set_program_options(options_description&, options_description&) {}
 void chain_api_plugin::plugin_initialize(const variables_map&) {}
 
-#define CALL(api_name, api_handle, api_namespace, call_name, http_response_code) \
+#define CALL(api_name, api_handle, api_namespace, call_name, http_response_code, invoke) \
 {std::string("/v1/" #api_name "/" #call_name), \
    [this, api_handle](string, string body, url_response_callback cb) mutable { \
           try { \
              if (body.empty()) body = "{}"; \
-             auto result = api_handle.call_name(fc::json::from_string(body).as<api_namespace::call_name ## _params>()); \
+             auto params = fc::json::from_string(body).as<api_namespace::call_name ## _params>(); \
+             auto result = invoke(api_handle.call_name(params)); \
              cb(http_response_code, fc::json::to_string(result)); \
           } catch (chain::tx_missing_sigs& e) { \
              error_results results{401, "UnAuthorized", e}; \
@@ -55,8 +56,13 @@ void chain_api_plugin::plugin_initialize(const variables_map&) {}
           } \
        }}
 
-#define CHAIN_RO_CALL(call_name, http_response_code) CALL(chain, ro_api, chain_apis::read_only, call_name, http_response_code)
-#define CHAIN_RW_CALL(call_name, http_response_code) CALL(chain, rw_api, chain_apis::read_write, call_name, http_response_code)
+// read-only calls run on the http threads, the read lock keeps block application from changing the database under them;
+// chain_controller only changes the database, the fork database and the block log while it holds the write lock
+#define READ_LOCKED(expr) my->db.get_database().with_read_lock([&]() { return expr; })
+#define UNLOCKED(expr) expr
+
+#define CHAIN_RO_CALL(call_name, http_response_code) CALL(chain, ro_api, chain_apis::read_only, call_name, http_response_code, READ_LOCKED)
+#define CHAIN_RW_CALL(call_name, http_response_code) CALL(chain, rw_api, chain_apis::read_write, call_name, http_response_code, UNLOCKED)
 
 void chain_api_plugin::plugin_startup() {
    ilog( "starting chain_api_plugin" );
@@ -64,8 +70,10 @@ void chain_api_plugin::plugin_startup() {
    auto ro_api = app().get_plugin<chain_plugin>().get_read_only_api();
    auto rw_api = app().get_plugin<chain_plugin>().get_read_write_api();
 
-   app().get_plugin<http_plugin>().add_api({
+   app().get_plugin<http_plugin>().add_read_only_api({
       CHAIN_RO_CALL(get_info, 200),
+      CHAIN_RO_CALL(get_wasm_cache_stats, 200),
+      CHAIN_RO_CALL(get_abi_cache_stats, 200),
       CHAIN_RO_CALL(get_block, 200),
       CHAIN_RO_CALL(get_account, 200),
       CHAIN_RO_CALL(get_code, 200),
@@ -74,7 +82,10 @@ void chain_api_plugin::plugin_startup() {
       CHAIN_RO_CALL(get_currency_stats, 200),
       CHAIN_RO_CALL(abi_json_to_bin, 200),
       CHAIN_RO_CALL(abi_bin_to_json, 200),
-      CHAIN_RO_CALL(get_required_keys, 200),
+      CHAIN_RO_CALL(get_required_keys, 200)
+   });
+
+   app().get_plugin<http_plugin>().add_api({
       CHAIN_RW_CALL(push_block, 202),
       CHAIN_RW_CALL(push_transaction, 202),
       CHAIN_RW_CALL(push_transactions, 202)
@@ -54,6 +54,14 @@ public:
    int32_t                          max_deferred_transaction_time_ms;
    //txn_msg_rate_limits              rate_limits;
    fc::optional<vm_type>            wasm_runtime;
+   uint32_t                         wasm_module_cache_size = config::default_wasm_module_cache_size;
+   uint32_t                         abi_serializer_cache_size = config::default_abi_serializer_cache_size;
+   bfs::path                        wasm_jit_cache_dir;
+   uint64_t                         wasm_jit_cache_size = config::default_wasm_jit_cache_size;
+   bool                             wasm_native_float = false;
+   vector<account_name>             wasm_warmup_accounts;
+   uint16_t                         thread_pool_size = config::default_controller_thread_pool_size;
+   uint16_t                         max_pending_shards = config::default_max_pending_shards;
 };
 
 chain_plugin::chain_plugin()
@@ -77,7 +85,23 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
          ("max-deferred-transaction-time", bpo::value<int32_t>()->default_value(20),
           "Limits the maximum time (in milliseconds) that is allowed a to push deferred transactions at the start of a block")
          ("wasm-runtime", bpo::value<eosio::chain::wasm_interface::vm_type>()->value_name("wavm/binaryen"), "Override default WASM runtime")
+         ("wasm-module-cache-size", bpo::value<uint32_t>()->default_value(config::default_wasm_module_cache_size),
+          "Number of instantiated contracts kept in memory, the least recently used ones are evicted")
+         ("abi-serializer-cache-size", bpo::value<uint32_t>()->default_value(config::default_abi_serializer_cache_size),
+          "Number of parsed account ABIs kept in memory for API calls, the least recently used ones are evicted")
+         ("wasm-warmup-account", bpo::value<vector<string>>()->composing()->multitoken(),
+          "Account whose contract is instantiated in the background at startup (may specify multiple times)")
+         ("wasm-jit-cache-dir", bpo::value<bfs::path>()->default_value("wasm-jit-cache"),
+          "the location where the wavm runtime keeps compiled contracts across restarts (absolute path or relative to application data dir, empty to disable)")
+         ("wasm-jit-cache-size-mb", bpo::value<uint64_t>()->default_value(config::default_wasm_jit_cache_size / (1024 * 1024)),
+          "Maximum size MB of the compiled contracts in wasm-jit-cache-dir, the oldest ones are removed beyond it")
+         ("wasm-native-float", bpo::bool_switch()->default_value(false),
+          "Compute float add, sub, mul, div and sqrt of contracts natively when this host is validated to give the results of softfloat at startup, instead of always with softfloat")
          ("shared-memory-size-mb", bpo::value<uint64_t>()->default_value(config::default_shared_memory_size / (1024  * 1024)), "Maximum size MB of database shared memory file")
+         ("chain-threads", bpo::value<uint16_t>()->default_value(config::default_controller_thread_pool_size),
+          "Number of worker threads used to unpack and recover signatures of the transactions in a block, 0 to do so on the main thread")
+         ("max-pending-shards", bpo::value<uint16_t>()->default_value(config::default_max_pending_shards),
+          "Maximum number of independent shards the producer packs into one cycle, 1 to place every transaction in a single shard")
 
 #warning TODO: rate limiting
          /*("per-authorized-account-transaction-msg-rate-limit-time-frame-sec", bpo::value<uint32_t>()->default_value(default_per_auth_account_time_frame_seconds),
@@ -177,6 +201,24 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
 
    if(options.count("wasm-runtime"))
       my->wasm_runtime = options.at("wasm-runtime").as<vm_type>();
+   my->wasm_module_cache_size = options.at("wasm-module-cache-size").as<uint32_t>();
+   my->abi_serializer_cache_size = options.at("abi-serializer-cache-size").as<uint32_t>();
+   if(options.count("wasm-jit-cache-dir")) {
+      auto jcd = options.at("wasm-jit-cache-dir").as<bfs::path>();
+      if(jcd.empty() || jcd.is_absolute())
+         my->wasm_jit_cache_dir = jcd;
+      else
+         my->wasm_jit_cache_dir = app().data_dir() / jcd;
+   }
+   my->wasm_jit_cache_size = options.at("wasm-jit-cache-size-mb").as<uint64_t>() * 1024 * 1024;
+   my->wasm_native_float = options.at("wasm-native-float").as<bool>();
+   if(options.count("wasm-warmup-account")) {
+      for(const auto& a : options.at("wasm-warmup-account").as<vector<string>>())
+         my->wasm_warmup_accounts.emplace_back(a);
+   }
+
+   my->thread_pool_size = options.at("chain-threads").as<uint16_t>();
+   my->max_pending_shards = options.at("max-pending-shards").as<uint16_t>();
 }
 
 void chain_plugin::plugin_startup()
@@ -210,6 +252,14 @@ void chain_plugin::plugin_startup()
    if(my->wasm_runtime)
       my->chain_config->wasm_runtime = *my->wasm_runtime;
 
+   my->chain_config->wasm_module_cache_size = my->wasm_module_cache_size;
+   my->chain_config->abi_serializer_cache_size = my->abi_serializer_cache_size;
+   my->chain_config->wasm_jit_cache_dir = my->wasm_jit_cache_dir;
+   my->chain_config->wasm_jit_cache_size = my->wasm_jit_cache_size;
+   my->chain_config->wasm_native_float = my->wasm_native_float;
+   my->chain_config->thread_pool_size = my->thread_pool_size;
+   my->chain_config->max_pending_shards = my->max_pending_shards;
+
    my->chain.emplace(*my->chain_config);
 
    if(!my->readonly) {
@@ -217,6 +267,15 @@ void chain_plugin::plugin_startup()
       my->chain->add_checkpoints(my->loaded_checkpoints);
    }
 
+   for(const auto& a : my->wasm_warmup_accounts) {
+      const auto* account = my->chain->get_database().find<account_object, by_name>(a);
+      if(account && account->code.size() > 0) {
+         my->chain->get_wasm_interface().warmup(account->code_version, account->code.data(), account->code.size());
+      } else {
+         wlog("wasm-warmup-account ${a} has no contract", ("a", a));
+      }
+   }
+
    ilog("Blockchain started; head block is #${num}, genesis timestamp is ${ts}",
         ("num", my->chain->head_block_num())("ts", (std::string)my->chain_config->genesis.initial_timestamp));
 
@@ -276,6 +335,15 @@ const chain_controller& chain_plugin::chain() const { return *my->chain; }
 namespace chain_apis {
 
 const string read_only::KEYi64 = "i64";
+const uint32_t read_only::max_table_rows = 1000;
+
+wasm_cache_stats read_only::get_wasm_cache_stats(const read_only::get_wasm_cache_stats_params&) const {
+   return db.get_wasm_interface().get_cache_stats();
+}
+
+abi_serializer_cache_stats read_only::get_abi_cache_stats(const read_only::get_abi_cache_stats_params&) const {
+   return db.get_abi_serializer_cache().get_stats();
+}
 
 read_only::get_info_results read_only::get_info(const read_only::get_info_params&) const {
    return {
@@ -290,12 +358,13 @@ read_only::get_info_results read_only::get_info(const read_only::get_info_params
    };
 }
 
-abi_def get_abi( const chain_controller& db, const name& account ) {
+abi_serializer_cache::cached_abi_ptr get_abi( const chain_controller& db, const name& account ) {
    const auto &d = db.get_database();
    const account_object *code_accnt = d.find<account_object, by_name>(account);
    EOS_ASSERT(code_accnt != nullptr, chain::account_query_exception, "Fail to retrieve account for ${account}", ("account", account) );
-   abi_def abi;
-   abi_serializer::to_abi(code_accnt->abi, abi);
+   auto abi = db.get_abi_serializer_cache().get_abi(*code_accnt);
+   if( !abi )
+      abi = std::make_shared<const cached_abi>(abi_def());
    return abi;
 }
 
@@ -309,20 +378,32 @@ string get_table_type( const abi_def& abi, const name& table_name ) {
 }
 
 read_only::get_table_rows_result read_only::get_table_rows( const read_only::get_table_rows_params& p )const {
-   const abi_def abi = get_abi( db, p.code );
-   auto table_type = get_table_type( abi, p.table );
+   const auto abi = get_abi( db, p.code );
+   auto table_type = get_table_type( abi->abi, p.table );
 
    if( table_type == KEYi64 ) {
-      return get_table_rows_ex<contracts::key_value_index, contracts::by_scope_primary>(p,abi);
+      if( p.index_position <= 1 )
+         return get_table_rows_ex<contracts::key_value_index, contracts::by_scope_primary>(p,abi->serializer);
+      if( p.key_type.empty() || p.key_type == "i64" )
+         return get_table_rows_by_secondary<contracts::index64_index>(p,abi->serializer);
+      if( p.key_type == "i128" )
+         return get_table_rows_by_secondary<contracts::index128_index>(p,abi->serializer);
+      if( p.key_type == "i256" )
+         return get_table_rows_by_secondary<contracts::index256_index>(p,abi->serializer);
+      if( p.key_type == "float64" )
+         return get_table_rows_by_secondary<contracts::index_double_index>(p,abi->serializer);
+      if( p.key_type == "float128" )
+         return get_table_rows_by_secondary<contracts::index_long_double_index>(p,abi->serializer);
+      EOS_ASSERT( false, chain::contract_table_query_exception, "Invalid key type ${type}", ("type",p.key_type) );
    }
 
-   EOS_ASSERT( false, chain::contract_table_query_exception,  "Invalid table type ${type}", ("type",table_type)("abi",abi));
+   EOS_ASSERT( false, chain::contract_table_query_exception,  "Invalid table type ${type}", ("type",table_type)("abi",abi->abi));
 }
 
 vector<asset> read_only::get_currency_balance( const read_only::get_currency_balance_params& p )const {
 
-   const abi_def abi = get_abi( db, p.code );
-   auto table_type = get_table_type( abi, "accounts" );
+   const auto abi = get_abi( db, p.code );
+   auto table_type = get_table_type( abi->abi, "accounts" );
 
    vector<asset> results;
    walk_table<contracts::key_value_index, contracts::by_scope_primary>(p.code, p.account, N(accounts), [&](const contracts::key_value_object& obj){
@@ -349,8 +430,8 @@ vector<asset> read_only::get_currency_balance( const read_only::get_currency_bal
 fc::variant read_only::get_currency_stats( const read_only::get_currency_stats_params& p )const {
    fc::mutable_variant_object results;
 
-   const abi_def abi = get_abi( db, p.code );
-   auto table_type = get_table_type( abi, "stat" );
+   const auto abi = get_abi( db, p.code );
+   auto table_type = get_table_type( abi->abi, "stat" );
 
    uint64_t scope = ( eosio::chain::string_to_symbol( 0, boost::algorithm::to_upper_copy(p.symbol).c_str() ) >> 8 );
 
@@ -375,16 +456,13 @@ fc::variant read_only::get_currency_stats( const read_only::get_currency_stats_p
 template<typename Api>
 struct resolver_factory {
    static auto make(const Api *api) {
-      return [api](const account_name &name) -> optional<abi_serializer> {
+      return [api](const account_name &name) -> abi_serializer_cache::abi_serializer_ptr {
          const auto *accnt = api->db.get_database().template find<account_object, by_name>(name);
          if (accnt != nullptr) {
-            abi_def abi;
-            if (abi_serializer::to_abi(accnt->abi, abi)) {
-               return abi_serializer(abi);
-            }
+            return api->db.get_abi_serializer_cache().get_serializer(*accnt);
          }
 
-         return optional<abi_serializer>();
+         return abi_serializer_cache::abi_serializer_ptr();
       };
    }
 };
@@ -510,9 +588,8 @@ read_only::abi_json_to_bin_result read_only::abi_json_to_bin( const read_only::a
    const auto code_account = db.get_database().find<account_object,by_name>( params.code );
    EOS_ASSERT(code_account != nullptr, contract_query_exception, "Contract can't be found ${contract}", ("contract", params.code));
 
-   abi_def abi;
-   if( abi_serializer::to_abi(code_account->abi, abi) ) {
-      abi_serializer abis( abi );
+   if( auto abi = db.get_abi_serializer_cache().get_serializer(*code_account) ) {
+      const auto& abis = *abi;
       try {
          result.binargs = abis.variant_to_binary(abis.get_action_type(params.action), params.args);
       } EOS_RETHROW_EXCEPTIONS(chain::invalid_action_args_exception,
@@ -525,10 +602,8 @@ read_only::abi_json_to_bin_result read_only::abi_json_to_bin( const read_only::a
 read_only::abi_bin_to_json_result read_only::abi_bin_to_json( const read_only::abi_bin_to_json_params& params )const {
    abi_bin_to_json_result result;
    const auto& code_account = db.get_database().get<account_object,by_name>( params.code );
-   abi_def abi;
-   if( abi_serializer::to_abi(code_account.abi, abi) ) {
-      abi_serializer abis( abi );
-      result.args = abis.binary_to_variant( abis.get_action_type( params.action ), params.binargs );
+   if( auto abi = db.get_abi_serializer_cache().get_serializer(code_account) ) {
+      result.args = abi->binary_to_variant( abi->get_action_type( params.action ), params.binargs );
    }
    return result;
 }
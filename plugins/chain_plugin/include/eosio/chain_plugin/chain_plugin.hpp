@@ -13,6 +13,8 @@
 #include <eosio/chain/transaction.hpp>
 #include <eosio/chain/contracts/abi_serializer.hpp>
 
+#include <fc/crypto/hex.hpp>
+
 #include <boost/container/flat_set.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
@@ -31,8 +33,12 @@ namespace eosio {
    using chain::asset;
    using chain::authority;
    using chain::account_name;
+   using chain::wasm_cache_stats;
    using chain::contracts::abi_def;
    using chain::contracts::abi_serializer;
+   using chain::contracts::abi_serializer_cache;
+   using chain::contracts::abi_serializer_cache_stats;
+   using chain::contracts::cached_abi;
 
 namespace chain_apis {
 struct empty{};
@@ -69,6 +75,12 @@ public:
    };
    get_info_results get_info(const get_info_params&) const;
 
+   using get_wasm_cache_stats_params = empty;
+   wasm_cache_stats get_wasm_cache_stats(const get_wasm_cache_stats_params&) const;
+
+   using get_abi_cache_stats_params = empty;
+   abi_serializer_cache_stats get_abi_cache_stats(const get_abi_cache_stats_params&) const;
+
    struct producer_info {
       name                       producer_name;
    };
@@ -144,6 +156,9 @@ public:
 
    fc::variant get_block(const get_block_params& params) const;
 
+   /// most rows returned by one get_table_rows call, larger tables are paged with next_key
+   static const uint32_t max_table_rows;
+
    struct get_table_rows_params {
       bool        json = false;
       name        code;
@@ -153,12 +168,16 @@ public:
       string      table_key;
       string      lower_bound;
       string      upper_bound;
-      uint32_t    limit = 10;
+      uint32_t    limit = 10;         ///< at most max_table_rows, 0 for max_table_rows
+      uint32_t    index_position = 1; ///< 1 for the primary key, 2 for the first secondary index of multi_index and so on
+      string      key_type;           ///< type of the secondary index: i64, i128, i256, float64 or float128
+      string      next_key;           ///< next_key of the previous call, continues the scan where it stopped
     };
 
    struct get_table_rows_result {
       vector<fc::variant> rows; ///< one row per item, either encoded as hex String or JSON object
       bool                more = false; ///< true if last element in data is not the end and sizeof data() < limit
+      string              next_key; ///< when more is set, pass it back as next_key to get the following rows
    };
 
    get_table_rows_result get_table_rows( const get_table_rows_params& params )const;
@@ -209,36 +228,78 @@ public:
       }
    }
 
-   template <typename IndexType, typename Scope>
-   read_only::get_table_rows_result get_table_rows_ex( const read_only::get_table_rows_params& p, const abi_def& abi )const {
-      read_only::get_table_rows_result result;
-      const auto& d = db.get_database();
-
+   static uint64_t get_table_scope( const string& scope_str ) {
       uint64_t scope = 0;
       try {
-         name s(p.scope);
+         name s(scope_str);
          scope = s.value;
       } catch( ... ) {
          try {
-            auto trimmed_scope_str = p.scope;
+            auto trimmed_scope_str = scope_str;
             boost::trim(trimmed_scope_str);
             scope = boost::lexical_cast<uint64_t>(trimmed_scope_str.c_str(), trimmed_scope_str.size());
          } catch( ... ) {
             try {
-               auto symb = eosio::chain::symbol::from_string(p.scope);
+               auto symb = eosio::chain::symbol::from_string(scope_str);
                scope = symb.value();
             } catch( ... ) {
                try {
-                  scope = ( eosio::chain::string_to_symbol( 0, p.scope.c_str() ) >> 8 );
+                  scope = ( eosio::chain::string_to_symbol( 0, scope_str.c_str() ) >> 8 );
                } catch( ... ) {
                   FC_ASSERT( false, "could not convert scope string to any of the following: uint64_t, valid name, or valid symbol (with or without the precision)" );
                }
             }
          }
       }
+      return scope;
+   }
+
+   /// index keys are passed around as the hex of their bytes, cursors are the keys of a row concatenated
+   template<typename Key>
+   static string table_key_to_hex( const Key& key ) {
+      static_assert( std::is_trivially_copyable<Key>::value, "table keys are copied as raw bytes" );
+      return fc::to_hex( reinterpret_cast<const char*>(&key), sizeof(key) );
+   }
+
+   template<typename Key>
+   static Key table_key_from_hex( const string& hex ) {
+      static_assert( std::is_trivially_copyable<Key>::value, "table keys are copied as raw bytes" );
+      Key key;
+      EOS_ASSERT( hex.size() == 2 * sizeof(key) &&
+                  fc::from_hex( hex, reinterpret_cast<char*>(&key), sizeof(key) ) == sizeof(key),
+                  chain::contract_table_query_exception, "Invalid table key ${key}", ("key",hex) );
+      return key;
+   }
+
+   /// 64 bit keys are given as numbers, wider ones as the hex of their bytes
+   static void table_key_from_string( const string& str, uint64_t& key ) {
+      key = fc::variant(str).as<uint64_t>();
+   }
+
+   template<typename Key>
+   static void table_key_from_string( const string& str, Key& key ) {
+      key = table_key_from_hex<Key>(str);
+   }
+
+   void add_table_row( read_only::get_table_rows_result& result, const read_only::get_table_rows_params& p,
+                       const abi_serializer& abis, const chain::contracts::type_name& row_type, const chain::contracts::key_value_object& obj )const {
+      if (p.json) {
+         fc::datastream<const char*> ds(obj.value.data(), obj.value.size());
+         result.rows.emplace_back(abis.binary_to_variant(row_type, ds));
+      } else {
+         vector<char> data;
+         copy_inline_row(obj, data);
+         result.rows.emplace_back(fc::variant(data));
+      }
+   }
+
+   template <typename IndexType, typename Scope>
+   read_only::get_table_rows_result get_table_rows_ex( const read_only::get_table_rows_params& p, const abi_serializer& abis )const {
+      read_only::get_table_rows_result result;
+      const auto& d = db.get_database();
+
+      uint64_t scope = get_table_scope(p.scope);
 
-      abi_serializer abis;
-      abis.set_abi(abi);
       const auto* t_id = d.find<chain::contracts::table_id_object, chain::contracts::by_code_scope_table>(boost::make_tuple(p.code, scope, p.table));
       if (t_id != nullptr) {
          const auto &idx = d.get_index<IndexType, Scope>();
@@ -254,28 +315,80 @@ public:
             upper = idx.lower_bound(boost::make_tuple(t_id->id, fc::variant(
                p.upper_bound).as<typename IndexType::value_type::key_type>()));
          }
+         if (p.next_key.size()) {
+            lower = idx.lower_bound(boost::make_tuple(t_id->id, table_key_from_hex<uint64_t>(p.next_key)));
+         }
 
-         vector<char> data;
+         const auto row_type = abis.get_table_type(p.table);
+         const auto limit = p.limit ? std::min(p.limit, max_table_rows) : max_table_rows;
+         uint32_t count = 0;
+         auto itr = lower;
+         for (; itr != upper && itr != idx.end() && itr->t_id == t_id->id && count < limit; ++itr, ++count) {
+            add_table_row(result, p, abis, row_type, *itr);
+         }
+         if (itr != upper && itr != idx.end() && itr->t_id == t_id->id) {
+            result.more = true;
+            result.next_key = table_key_to_hex(itr->primary_key);
+         }
+      }
+      return result;
+   }
 
-         auto end = fc::time_point::now() + fc::microseconds(1000 * 10); /// 10ms max time
+   /**
+    * Walks a secondary index of a table, which multi_index keeps in a table of its own named
+    * after the table with the number of the index in its low 4 bits, and returns the rows it
+    * points at in the order of the index.
+    */
+   template <typename IndexType>
+   read_only::get_table_rows_result get_table_rows_by_secondary( const read_only::get_table_rows_params& p, const abi_serializer& abis )const {
+      using key_type = typename IndexType::value_type::secondary_key_type;
+      read_only::get_table_rows_result result;
+      const auto& d = db.get_database();
 
-         unsigned int count = 0;
-         auto itr = lower;
-         for (itr = lower; itr != upper; ++itr) {
-            copy_inline_row(*itr, data);
+      EOS_ASSERT( p.index_position >= 2 && p.index_position <= 17, chain::contract_table_query_exception,
+                  "Invalid index position ${pos}", ("pos",p.index_position) );
+      uint64_t scope = get_table_scope(p.scope);
+      name index_table( (p.table.value & 0xFFFFFFFFFFFFFFF0ULL) | (p.index_position - 2) );
 
-            if (p.json) {
-               result.rows.emplace_back(abis.binary_to_variant(abis.get_table_type(p.table), data));
-            } else {
-               result.rows.emplace_back(fc::variant(data));
-            }
+      const auto* t_id = d.find<chain::contracts::table_id_object, chain::contracts::by_code_scope_table>(boost::make_tuple(p.code, scope, p.table));
+      const auto* index_t_id = d.find<chain::contracts::table_id_object, chain::contracts::by_code_scope_table>(boost::make_tuple(p.code, scope, index_table));
+      if (t_id != nullptr && index_t_id != nullptr) {
+         const auto &idx = d.get_index<IndexType, chain::contracts::by_secondary>();
+         decltype(index_t_id->id) next_tid(index_t_id->id._id + 1);
+         auto lower = idx.lower_bound(boost::make_tuple(index_t_id->id));
+         auto upper = idx.lower_bound(boost::make_tuple(next_tid));
 
-            if (++count == p.limit || fc::time_point::now() > end) {
-               break;
-            }
+         key_type key;
+         if (p.lower_bound.size()) {
+            table_key_from_string(p.lower_bound, key);
+            lower = idx.lower_bound(boost::make_tuple(index_t_id->id, key));
+         }
+         if (p.upper_bound.size()) {
+            table_key_from_string(p.upper_bound, key);
+            upper = idx.lower_bound(boost::make_tuple(index_t_id->id, key));
+         }
+         if (p.next_key.size()) {
+            const auto key_hex_size = 2 * sizeof(key_type);
+            EOS_ASSERT( p.next_key.size() == key_hex_size + 2 * sizeof(uint64_t), chain::contract_table_query_exception,
+                        "Invalid next_key ${key}", ("key",p.next_key) );
+            lower = idx.lower_bound(boost::make_tuple(index_t_id->id,
+                                                      table_key_from_hex<key_type>(p.next_key.substr(0, key_hex_size)),
+                                                      table_key_from_hex<uint64_t>(p.next_key.substr(key_hex_size))));
+         }
+
+         const auto row_type = abis.get_table_type(p.table);
+         const auto limit = p.limit ? std::min(p.limit, max_table_rows) : max_table_rows;
+         uint32_t count = 0;
+         auto itr = lower;
+         for (; itr != upper && itr != idx.end() && itr->t_id == index_t_id->id && count < limit; ++itr, ++count) {
+            const auto* row = d.find<chain::contracts::key_value_object, chain::contracts::by_scope_primary>(boost::make_tuple(t_id->id, itr->primary_key));
+            EOS_ASSERT( row != nullptr, chain::contract_table_query_exception,
+                        "Index entry for missing row ${pk}", ("pk",itr->primary_key) );
+            add_table_row(result, p, abis, row_type, *row);
          }
-         if (itr != upper) {
+         if (itr != upper && itr != idx.end() && itr->t_id == index_t_id->id) {
             result.more = true;
+            result.next_key = table_key_to_hex(itr->secondary_key) + table_key_to_hex(itr->primary_key);
          }
       }
       return result;
@@ -357,8 +470,8 @@ FC_REFLECT(eosio::chain_apis::read_only::get_block_params, (block_num_or_id))
 
 FC_REFLECT( eosio::chain_apis::read_write::push_transaction_results, (transaction_id)(processed) )
 
-FC_REFLECT( eosio::chain_apis::read_only::get_table_rows_params, (json)(code)(scope)(table)(table_key)(lower_bound)(upper_bound)(limit) )
-FC_REFLECT( eosio::chain_apis::read_only::get_table_rows_result, (rows)(more) );
+FC_REFLECT( eosio::chain_apis::read_only::get_table_rows_params, (json)(code)(scope)(table)(table_key)(lower_bound)(upper_bound)(limit)(index_position)(key_type)(next_key) )
+FC_REFLECT( eosio::chain_apis::read_only::get_table_rows_result, (rows)(more)(next_key) );
 
 FC_REFLECT( eosio::chain_apis::read_only::get_currency_balance_params, (code)(account)(symbol));
 FC_REFLECT( eosio::chain_apis::read_only::get_currency_stats_params, (code)(symbol));
@@ -36,6 +36,8 @@ namespace eosio {
    using std::shared_ptr;
    using websocketpp::connection_hdl;
 
+   constexpr auto def_http_threads = 2;
+
 
    namespace detail {
 
@@ -81,6 +83,7 @@ namespace eosio {
    class http_plugin_impl {
       public:
          map<string,url_handler>  url_handlers;
+         map<string,url_handler>  read_only_handlers; ///< called on the http threads
          optional<tcp::endpoint>  listen_endpoint;
          string                   access_control_allow_origin;
          string                   access_control_allow_headers;
@@ -94,6 +97,61 @@ namespace eosio {
 
          websocket_server_tls_type https_server;
 
+         boost::asio::io_context  http_ioc;
+         std::unique_ptr<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> http_work;
+         std::vector<std::thread> http_threads;
+         uint16_t                 http_thread_count = 0;
+
+         /**
+          * Responds to a request with the exception being handled, must be called from a catch block
+          */
+         static void report_exception(const url_response_callback& cb) {
+            try {
+               throw;
+            } catch( const fc::exception& e ) {
+               elog( "http: ${e}", ("e",e.to_detail_string()));
+               error_results results{websocketpp::http::status_code::internal_server_error,
+                                       "Internal Service Error", e};
+               cb(websocketpp::http::status_code::internal_server_error, fc::json::to_string(results));
+            } catch( const std::exception& e ) {
+               elog( "http: ${e}", ("e",e.what()));
+               error_results results{websocketpp::http::status_code::internal_server_error,
+                                       "Internal Service Error", fc::exception(FC_LOG_MESSAGE(error, e.what()))};
+               cb(websocketpp::http::status_code::internal_server_error, fc::json::to_string(results));
+            } catch( ... ) {
+               error_results results{websocketpp::http::status_code::internal_server_error,
+                                       "Internal Service Error", fc::exception(FC_LOG_MESSAGE(error, "Unknown Exception"))};
+               cb(websocketpp::http::status_code::internal_server_error, fc::json::to_string(results));
+            }
+         }
+
+         /**
+          * Calls a read-only handler on the http threads. The response of the deferred request is
+          * sent from the application thread, which owns the connection.
+          */
+         template<class T>
+         void call_read_only_handler(typename websocketpp::server<detail::asio_with_stub_log<T>>::connection_ptr con,
+                                     url_handler handler, string resource, string body) {
+            con->defer_http_response();
+            boost::asio::post(http_ioc, [con, handler = std::move(handler), resource = std::move(resource), body = std::move(body)]() {
+               url_response_callback cb = [con](int code, string body) {
+                  app().get_io_service().post([con, code, body = std::move(body)]() {
+                     con->set_body(body);
+                     con->set_status(websocketpp::http::status_code::value(code));
+                     websocketpp::lib::error_code ec;
+                     con->send_http_response(ec);
+                     if (ec)
+                        dlog("http: unable to send response: ${m}", ("m", ec.message()));
+                  });
+               };
+               try {
+                  handler(resource, body, cb);
+               } catch( ... ) {
+                  report_exception(cb);
+               }
+            });
+         }
+
          ssl_context_ptr on_tls_init(websocketpp::connection_hdl hdl) {
             ssl_context_ptr ctx = websocketpp::lib::make_shared<websocketpp::lib::asio::ssl::context>(asio::ssl::context::sslv23_server);
 
@@ -131,6 +189,10 @@ namespace eosio {
 
          template<class T>
          void handle_http_request(typename websocketpp::server<detail::asio_with_stub_log<T>>::connection_ptr con) {
+            url_response_callback cb = [con](int code, string body) {
+               con->set_body(body);
+               con->set_status(websocketpp::http::status_code::value(code));
+            };
             try {
                if (!access_control_allow_origin.empty()) {
                   con->append_header("Access-Control-Allow-Origin", access_control_allow_origin);
@@ -145,11 +207,11 @@ namespace eosio {
                auto body = con->get_request_body();
                auto resource = con->get_uri()->get_resource();
                auto handler_itr = url_handlers.find(resource);
+               auto read_only_itr = read_only_handlers.find(resource);
                if(handler_itr != url_handlers.end()) {
-                  handler_itr->second(resource, body, [con](int code, string body) {
-                     con->set_body(body);
-                     con->set_status(websocketpp::http::status_code::value(code));
-                  });
+                  handler_itr->second(resource, body, cb);
+               } else if(read_only_itr != read_only_handlers.end()) {
+                  call_read_only_handler<T>(con, read_only_itr->second, resource, body);
                } else {
                   wlog("404 - not found: ${ep}", ("ep",resource));
                   error_results results{websocketpp::http::status_code::not_found,
@@ -157,23 +219,8 @@ namespace eosio {
                   con->set_body(fc::json::to_string(results));
                   con->set_status(websocketpp::http::status_code::not_found);
                }
-            } catch( const fc::exception& e ) {
-               elog( "http: ${e}", ("e",e.to_detail_string()));
-               error_results results{websocketpp::http::status_code::internal_server_error,
-                                       "Internal Service Error", e};
-               con->set_body(fc::json::to_string(results));
-               con->set_status(websocketpp::http::status_code::internal_server_error);
-            } catch( const std::exception& e ) {
-               elog( "http: ${e}", ("e",e.what()));
-               error_results results{websocketpp::http::status_code::internal_server_error,
-                                       "Internal Service Error", fc::exception(FC_LOG_MESSAGE(error, e.what()))};
-               con->set_body(fc::json::to_string(results));
-               con->set_status(websocketpp::http::status_code::internal_server_error);
             } catch( ... ) {
-               error_results results{websocketpp::http::status_code::internal_server_error,
-                                       "Internal Service Error", fc::exception(FC_LOG_MESSAGE(error, "Unknown Exception"))};
-               con->set_body(fc::json::to_string(results));
-               con->set_status(websocketpp::http::status_code::internal_server_error);
+               report_exception(cb);
             }
          }
 
@@ -232,10 +279,15 @@ namespace eosio {
                 if (v) ilog("configured http with Access-Control-Allow-Credentials: true");
              })->default_value(false),
              "Specify if Access-Control-Allow-Credentials: true should be returned on each request.")
+
+            ("http-threads", bpo::value<uint16_t>()->default_value(def_http_threads),
+             "Number of threads that run read-only API calls; set to 0 to run them on the application thread.")
             ;
    }
 
    void http_plugin::plugin_initialize(const variables_map& options) {
+      my->http_thread_count = options.at("http-threads").as<uint16_t>();
+
       tcp::resolver resolver(app().get_io_service());
       if(options.count("http-server-address") && options.at("http-server-address").as<string>().length()) {
          string lipstr =  options.at("http-server-address").as<string>();
@@ -278,6 +330,15 @@ namespace eosio {
    }
 
    void http_plugin::plugin_startup() {
+      my->http_work.reset( new boost::asio::executor_work_guard<boost::asio::io_context::executor_type>( my->http_ioc.get_executor() ) );
+      for( uint16_t i = 0; i < my->http_thread_count; ++i ) {
+         my->http_threads.emplace_back( [ioc = &my->http_ioc]() {
+            try {
+               ioc->run();
+            } FC_LOG_AND_DROP()
+         });
+      }
+
       if(my->listen_endpoint) {
          try {
             my->create_server_for_endpoint(*my->listen_endpoint, my->server);
@@ -319,6 +380,13 @@ namespace eosio {
          my->server.stop_listening();
       if(my->https_server.is_listening())
          my->https_server.stop_listening();
+
+      my->http_work.reset();
+      my->http_ioc.stop();
+      for( auto& t : my->http_threads ) {
+         t.join();
+      }
+      my->http_threads.clear();
    }
 
    void http_plugin::add_handler(const string& url, const url_handler& handler) {
@@ -327,4 +395,15 @@ namespace eosio {
         my->url_handlers.insert(std::make_pair(url,handler));
       });
    }
+
+   void http_plugin::add_read_only_handler(const string& url, const url_handler& handler) {
+      if( !my->http_thread_count ) {
+         add_handler(url, handler);
+         return;
+      }
+      ilog( "add read-only api url: ${c}", ("c",url) );
+      app().get_io_service().post([=](){
+        my->read_only_handlers.insert(std::make_pair(url,handler));
+      });
+   }
 }
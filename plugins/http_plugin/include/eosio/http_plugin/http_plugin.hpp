@@ -50,6 +50,11 @@ namespace eosio {
     *  thread.  The callback can be called from any thread and will 
     *  automatically propagate the call to the http thread.
     *
+    *  Handlers registered as read-only are instead called from a pool of
+    *  http threads, concurrently with each other and with the application
+    *  thread.  They must only read state that is safe to read from several
+    *  threads, such as the chain database under its read lock.
+    *
     *  The HTTP service will run in its own thread with its own io_service to
     *  make sure that HTTP request processing does not interfer with other
     *  plugins.  
@@ -73,6 +78,13 @@ namespace eosio {
               add_handler(call.first, call.second);
         }
 
+        /// Handlers added this way run on the http thread pool, see http-threads
+        void add_read_only_handler(const string& url, const url_handler&);
+        void add_read_only_api(const api_description& api) {
+           for (const auto& call : api)
+              add_read_only_handler(call.first, call.second);
+        }
+
       private:
         std::unique_ptr<class http_plugin_impl> my;
    };
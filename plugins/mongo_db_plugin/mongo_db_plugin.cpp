@@ -4,6 +4,7 @@
  */
 #include <eosio/mongo_db_plugin/mongo_db_plugin.hpp>
 #include <eosio/chain/contracts/chain_initializer.hpp>
+#include <eosio/chain/contracts/abi_serializer_cache.hpp>
 #include <eosio/chain/config.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/transaction.hpp>
@@ -17,6 +18,7 @@
 #include <boost/thread/condition_variable.hpp>
 
 #include <queue>
+#include <set>
 
 #include <bsoncxx/builder/basic/kvp.hpp>
 #include <bsoncxx/builder/basic/document.hpp>
@@ -25,6 +27,7 @@
 
 #include <mongocxx/client.hpp>
 #include <mongocxx/instance.hpp>
+#include <mongocxx/pool.hpp>
 
 namespace fc { class variant; }
 
@@ -39,9 +42,63 @@ using chain::signed_transaction;
 using chain::signed_block;
 using chain::block_trace;
 using chain::transaction_id_type;
+using chain::contracts::abi_serializer_cache;
 
 static appbase::abstract_plugin& _mongo_db_plugin = app().register_plugin<mongo_db_plugin>();
 
+/**
+ * A block and its trace. The trace refers to the copy of the block held alongside it, so both stay valid
+ * for as long as the writers hold on to them.
+ */
+struct traced_block {
+   explicit traced_block(const block_trace& bt)
+   :block(bt.block), trace(block) {
+      trace.region_traces = bt.region_traces;
+      trace.implicit_transactions = bt.implicit_transactions;
+   }
+
+   const signed_block block;
+   block_trace        trace;
+};
+using traced_block_ptr = std::shared_ptr<const traced_block>;
+using signed_block_ptr = std::shared_ptr<const signed_block>;
+
+/// an applied or an irreversible block waiting for the writers
+struct queued_block {
+   uint64_t         seq = 0;
+   traced_block_ptr applied;
+   signed_block_ptr irreversible;
+};
+
+/// the current balance and pending changes of an account document
+struct account_state {
+   bsoncxx::oid               id;
+   asset                      eos_balance;
+   bool                       inserted = true; ///< false until the account's document is written
+   bool                       dirty = false;
+   fc::optional<std::string>  abi_json;
+};
+
+/**
+ * The documents of a batch of blocks, each collection is written with one bulk_write.
+ */
+struct block_batch {
+   static mongocxx::options::bulk_write unordered() {
+      mongocxx::options::bulk_write bulk_opts;
+      bulk_opts.ordered(false);
+      return bulk_opts;
+   }
+
+   mongocxx::bulk_write blocks{unordered()};
+   mongocxx::bulk_write trans{unordered()};
+   mongocxx::bulk_write msgs{unordered()};
+   mongocxx::bulk_write acts{unordered()};
+   size_t blocks_count = 0;
+   size_t trans_count = 0;
+   size_t msgs_count = 0;
+   size_t acts_count = 0;
+};
+
 class mongo_db_plugin_impl {
 public:
    mongo_db_plugin_impl();
@@ -49,41 +106,67 @@ public:
 
    void applied_block(const block_trace&);
    void applied_irreversible_block(const signed_block&);
-   void process_block(const block_trace&, const signed_block&);
-   void _process_block(const block_trace&, const signed_block&);
-   void process_irreversible_block(const signed_block&);
-   void _process_irreversible_block(const signed_block&);
+   void process_blocks(mongocxx::client&, const std::vector<traced_block_ptr>&);
+   void _process_block(mongocxx::client&, block_batch&, const block_trace&, const signed_block&);
+   void process_irreversible_blocks(mongocxx::client&, const std::vector<signed_block_ptr>&);
+   void _process_irreversible_blocks(mongocxx::client&, const std::vector<signed_block_ptr>&);
 
    void init();
    void wipe_database();
 
    static abi_def eos_abi; // cached for common use
 
+   /// ABIs read from the accounts collection, an entry is dropped when its account's setabi is processed
+   abi_serializer_cache abi_cache{chain::config::default_abi_serializer_cache_size};
+
    bool configured{false};
    bool wipe_database_on_startup{false};
 
    std::string db_name;
    mongocxx::instance mongo_inst;
-   mongocxx::client mongo_conn;
+   mongocxx::client mongo_conn; ///< used on the application thread until the writers are started
+   std::unique_ptr<mongocxx::pool> mongo_pool; ///< one client for each writer
    mongocxx::collection accounts;
 
    size_t queue_size = 0;
-   size_t processed = 0;
-   std::deque<signed_block> signed_block_queue;
-   std::deque<signed_block> signed_block_process_queue;
-   std::deque<std::pair<block_trace, signed_block>> block_trace_queue;
-   std::deque<std::pair<block_trace, signed_block>> block_trace_process_queue;
-   // transaction.id -> actions
-   std::map<std::string, std::vector<chain::action>> reversible_actions;
+   size_t writer_threads = 0;
+   size_t batch_size = 0;
+   bool verified{false};
+   uint64_t next_seq = 0;
+   std::deque<queued_block> block_queue;
+   std::set<uint64_t> in_flight; ///< seq of the first block of each batch being written
    boost::mutex mtx;
-   boost::condition_variable condition;
-   boost::thread consume_thread;
+   boost::condition_variable condition; ///< blocks queued or a batch written
+   boost::condition_variable space_condition; ///< room in the queue
+   std::vector<boost::thread> consume_threads;
    boost::atomic<bool> done{false};
    boost::atomic<bool> startup{true};
 
+   // transaction.id -> actions
+   std::map<std::string, std::vector<chain::action>> reversible_actions;
+   boost::mutex reversible_actions_mtx;
+
+   /// accounts changed by the batch of irreversible blocks being processed, by name, emptied once they are written
+   std::map<account_name, account_state> account_cache;
+
+   struct metrics {
+      uint64_t          blocks_queued = 0;
+      uint64_t          blocks_written = 0;
+      uint64_t          irreversible_written = 0;
+      uint64_t          batches = 0;
+      uint64_t          producer_waits = 0;
+      fc::microseconds  producer_wait_time;
+      size_t            max_queue_depth = 0;
+   } stats; ///< guarded by mtx
+
+   void verify_first_block(const signed_block& block);
+   void queue(queued_block&& b);
    void consume_blocks();
+   void log_metrics();
 
-   void update_account(const chain::action& msg);
+   account_state& find_account_state(mongocxx::collection& accounts, const account_name& name);
+   void update_account(mongocxx::collection& accounts, const chain::action& msg);
+   void write_accounts(mongocxx::collection& accounts);
 
    static const account_name newaccount;
    static const account_name transfer;
@@ -106,17 +189,15 @@ const std::string mongo_db_plugin_impl::actions_col = "Actions";
 const std::string mongo_db_plugin_impl::action_traces_col = "ActionTraces";
 const std::string mongo_db_plugin_impl::accounts_col = "Accounts";
 
-
 void mongo_db_plugin_impl::applied_irreversible_block(const signed_block& block) {
    try {
       if (startup) {
          // on startup we don't want to queue, instead push back on caller
-         process_irreversible_block(block);
+         process_irreversible_blocks(mongo_conn, {std::make_shared<const signed_block>(block)});
       } else {
-         boost::mutex::scoped_lock lock(mtx);
-         signed_block_queue.push_back(block);
-         lock.unlock();
-         condition.notify_one();
+         queued_block b;
+         b.irreversible = std::make_shared<const signed_block>(block);
+         queue(std::move(b));
       }
    } catch (fc::exception& e) {
       elog("FC Exception while applied_irreversible_block ${e}", ("e", e.to_string()));
@@ -129,14 +210,17 @@ void mongo_db_plugin_impl::applied_irreversible_block(const signed_block& block)
 
 void mongo_db_plugin_impl::applied_block(const block_trace& bt) {
    try {
+      if (!verified) {
+         verify_first_block(bt.block);
+         verified = true;
+      }
       if (startup) {
          // on startup we don't want to queue, instead push back on caller
-         process_block(bt, bt.block);
+         process_blocks(mongo_conn, {std::make_shared<const traced_block>(bt)});
       } else {
-         boost::mutex::scoped_lock lock(mtx);
-         block_trace_queue.emplace_back(std::make_pair(bt, bt.block));
-         lock.unlock();
-         condition.notify_one();
+         queued_block b;
+         b.applied = std::make_shared<const traced_block>(bt);
+         queue(std::move(b));
       }
    } catch (fc::exception& e) {
       elog("FC Exception while applied_block ${e}", ("e", e.to_string()));
@@ -147,49 +231,88 @@ void mongo_db_plugin_impl::applied_block(const block_trace& bt) {
    }
 }
 
+/**
+ * Queue a block for the writers. When the queue is full the caller, and with it the chain, waits for the
+ * writers to catch up instead of letting the queue grow.
+ */
+void mongo_db_plugin_impl::queue(queued_block&& b) {
+   boost::mutex::scoped_lock lock(mtx);
+   if (block_queue.size() >= queue_size && !done) {
+      const auto start = fc::time_point::now();
+      space_condition.wait(lock, [&] { return block_queue.size() < queue_size || done; });
+      const auto waited = fc::time_point::now() - start;
+      ++stats.producer_waits;
+      stats.producer_wait_time += waited;
+      if (waited > fc::milliseconds(500)) {
+         wlog("mongo_db_plugin queue full, waited ${t}ms for writers", ("t", waited.count() / 1000));
+      }
+   }
+   b.seq = next_seq++;
+   block_queue.emplace_back(std::move(b));
+   ++stats.blocks_queued;
+   stats.max_queue_depth = std::max(stats.max_queue_depth, block_queue.size());
+   lock.unlock();
+   condition.notify_all();
+}
+
+/**
+ * Each writer takes up to batch_size applied blocks from the front of the queue and writes them at once,
+ * so several writers insert the documents of different batches concurrently. A run of irreversible blocks
+ * is written once every block queued before it has been written, so the documents it updates exist and the
+ * account updates are applied one batch at a time, in order.
+ */
 void mongo_db_plugin_impl::consume_blocks() {
    try {
+      auto client = mongo_pool->acquire();
       while (true) {
          boost::mutex::scoped_lock lock(mtx);
-         while (signed_block_queue.empty() && block_trace_queue.empty() && !done) {
-            condition.wait(lock);
-         }
-         // capture blocks for processing
-         size_t block_trace_size = block_trace_queue.size();
-         if (block_trace_size > 0) {
-            block_trace_process_queue = move(block_trace_queue);
-            block_trace_queue.clear();
+         condition.wait(lock, [&] { return !block_queue.empty() || done; });
+         if (block_queue.empty()) break;
+
+         std::vector<traced_block_ptr> applied;
+         std::vector<signed_block_ptr> irreversible;
+         const uint64_t first_seq = block_queue.front().seq;
+         while (!block_queue.empty() && applied.size() + irreversible.size() < batch_size) {
+            auto& b = block_queue.front();
+            if (b.applied && irreversible.empty()) {
+               applied.emplace_back(std::move(b.applied));
+            } else if (b.irreversible && applied.empty()) {
+               irreversible.emplace_back(std::move(b.irreversible));
+            } else {
+               break;
+            }
+            block_queue.pop_front();
          }
-         size_t signed_block_size = signed_block_queue.size();
-         if (signed_block_size > 0) {
-            signed_block_process_queue = move(signed_block_queue);
-            signed_block_queue.clear();
+         if (done) {
+            ilog("draining queue, size: ${q}", ("q", block_queue.size()));
          }
+         space_condition.notify_all();
 
+         in_flight.insert(first_seq);
+         if (!irreversible.empty()) {
+            condition.wait(lock, [&] { return *in_flight.begin() == first_seq; });
+         }
          lock.unlock();
 
-         // warn if queue size greater than 75%
-         if (signed_block_size > (queue_size * 0.75) || block_trace_size > (queue_size * 0.75)) {
-            wlog("queue size: ${q}", ("q", signed_block_size + block_trace_size + 1));
-         } else if (done) {
-            ilog("draining queue, size: ${q}", ("q", signed_block_size + block_trace_size + 1));
+         if (!applied.empty()) {
+            process_blocks(*client, applied);
+         } else {
+            process_irreversible_blocks(*client, irreversible);
          }
 
-         // process block traces
-         while (!block_trace_process_queue.empty()) {
-            const auto& bt_pair = block_trace_process_queue.front();
-            process_block(bt_pair.first, bt_pair.second);
-            block_trace_process_queue.pop_front();
-         }
+         lock.lock();
+         in_flight.erase(first_seq);
+         const auto blocks_written_before = stats.blocks_written;
+         stats.blocks_written += applied.size();
+         stats.irreversible_written += irreversible.size();
+         ++stats.batches;
+         const bool report = stats.blocks_written / 1000 != blocks_written_before / 1000;
+         lock.unlock();
+         condition.notify_all();
 
-         // process blocks
-         while (!signed_block_process_queue.empty()) {
-            const signed_block& block = signed_block_process_queue.front();
-            process_irreversible_block(block);
-            signed_block_process_queue.pop_front();
+         if (report) {
+            log_metrics();
          }
-
-         if (signed_block_size == 0 && block_trace_size == 0 && done) break;
       }
       ilog("mongo_db_plugin consume thread shutdown gracefully");
    } catch (fc::exception& e) {
@@ -201,6 +324,15 @@ void mongo_db_plugin_impl::consume_blocks() {
    }
 }
 
+void mongo_db_plugin_impl::log_metrics() {
+   boost::mutex::scoped_lock lock(mtx);
+   ilog("mongo_db_plugin queued: ${q}, written: ${w}, irreversible: ${i}, batches: ${b}, queue depth: ${d}, max: ${m}, "
+        "producer waits: ${pw}, waited: ${pt}ms",
+        ("q", stats.blocks_queued)("w", stats.blocks_written)("i", stats.irreversible_written)("b", stats.batches)
+        ("d", block_queue.size())("m", stats.max_queue_depth)
+        ("pw", stats.producer_waits)("pt", stats.producer_wait_time.count() / 1000));
+}
+
 namespace {
 
    auto find_account(mongocxx::collection& accounts, const account_name& name) {
@@ -214,44 +346,32 @@ namespace {
       return *account;
    }
 
-   auto find_transaction(mongocxx::collection& transactions, const string& id) {
-      using bsoncxx::builder::stream::document;
-      document find_trans{};
-      find_trans << "transaction_id" << id;
-      auto transaction = transactions.find_one(find_trans.view());
-      if (!transaction) {
-         FC_THROW("Unable to find transaction ${id}", ("id", id));
-      }
-      return *transaction;
-   }
-
-   auto find_block(mongocxx::collection& blocks, const string& id) {
-      using bsoncxx::builder::stream::document;
-      document find_block{};
-      find_block << "block_id" << id;
-      auto block = blocks.find_one(find_block.view());
-      if (!block) {
-         FC_THROW("Unable to find block ${id}", ("id", id));
-      }
-      return *block;
-   }
+  abi_serializer_cache::cached_abi_ptr get_abi(abi_serializer_cache& abi_cache,
+                                                mongocxx::collection& accounts,
+                                                const account_name& account)
+  {
+     return abi_cache.get_abi(account, chain::digest_type(), [&]() {
+        auto from_account = find_account(accounts, account);
+        fc::optional<abi_def> abi = abi_def();
+        if (from_account.view().find("abi") != from_account.view().end()) {
+           *abi = fc::json::from_string(bsoncxx::to_json(from_account.view()["abi"].get_document())).as<abi_def>();
+        }
+        if (account == chain::config::system_account_name) {
+           *abi = chain::contracts::chain_initializer::eos_contract_abi(*abi);
+        }
+        return abi;
+     });
+  }
 
   void add_data(bsoncxx::builder::basic::document& msg_doc,
+                abi_serializer_cache& abi_cache,
                 mongocxx::collection& accounts,
                 const chain::action& msg)
   {
      using bsoncxx::builder::basic::kvp;
      try {
-        auto from_account = find_account(accounts, msg.account);
-        abi_def abi;
-        if (from_account.view().find("abi") != from_account.view().end()) {
-           abi = fc::json::from_string(bsoncxx::to_json(from_account.view()["abi"].get_document())).as<abi_def>();
-        }
-        abi_serializer abis;
-        if (msg.account == chain::config::system_account_name) {
-           abi = chain::contracts::chain_initializer::eos_contract_abi(abi);
-        }
-        abis.set_abi(abi);
+        auto abi = get_abi(abi_cache, accounts, msg.account);
+        const auto& abis = abi->serializer;
         auto v = abis.binary_to_variant(abis.get_action_type(msg.name), msg.data);
         auto json = fc::json::to_string(v);
         try {
@@ -293,9 +413,21 @@ namespace {
    }
 }
 
-void mongo_db_plugin_impl::process_irreversible_block(const signed_block& block) {
+void mongo_db_plugin_impl::verify_first_block(const signed_block& block) {
+   auto blocks = mongo_conn[db_name][blocks_col]; // Blocks
+   if (wipe_database_on_startup) {
+      // verify on start we have no previous blocks
+      verify_no_blocks(blocks);
+      FC_ASSERT(block.block_num() < 2, "Expected start of block, instead received block_num: ${bn}", ("bn", block.block_num()));
+   } else {
+      // verify on restart we have previous block
+      verify_last_block(blocks, block.previous.str());
+   }
+}
+
+void mongo_db_plugin_impl::process_irreversible_blocks(mongocxx::client& client, const std::vector<signed_block_ptr>& blocks) {
   try {
-     _process_irreversible_block(block);
+     _process_irreversible_blocks(client, blocks);
   } catch (fc::exception& e) {
      elog("FC Exception while processing block ${e}", ("e", e.to_string()));
   } catch (std::exception& e) {
@@ -305,32 +437,48 @@ void mongo_db_plugin_impl::process_irreversible_block(const signed_block& block)
   }
 }
 
-void mongo_db_plugin_impl::process_block(const block_trace& bt, const signed_block& block) {
+void mongo_db_plugin_impl::process_blocks(mongocxx::client& client, const std::vector<traced_block_ptr>& blocks) {
+   block_batch batch;
+   for (const auto& b : blocks) {
+      try {
+         _process_block(client, batch, b->trace, b->block);
+      } catch (fc::exception& e) {
+         elog("FC Exception while processing block trace ${e}", ("e", e.to_string()));
+      } catch (std::exception& e) {
+         elog("STD Exception while processing block trace ${e}", ("e", e.what()));
+      } catch (...) {
+         elog("Unknown exception while processing trace block");
+      }
+   }
+
    try {
-      _process_block(bt, block);
+      const auto first = blocks.front()->block.block_num();
+      const auto last = blocks.back()->block.block_num();
+      auto write = [&](const std::string& col, mongocxx::bulk_write& bulk, size_t count, const char* what) {
+         if (count > 0 && !client[db_name][col].bulk_write(bulk)) {
+            elog("Bulk ${w} insert failed for blocks ${f} to ${l}", ("w", what)("f", first)("l", last));
+         }
+      };
+      write(blocks_col, batch.blocks, batch.blocks_count, "blocks");
+      write(actions_col, batch.msgs, batch.msgs_count, "actions");
+      write(action_traces_col, batch.acts, batch.acts_count, "action traces");
+      write(trans_col, batch.trans, batch.trans_count, "transactions");
    } catch (fc::exception& e) {
-      elog("FC Exception while processing block trace ${e}", ("e", e.to_string()));
+      elog("FC Exception while writing blocks ${e}", ("e", e.to_string()));
    } catch (std::exception& e) {
-      elog("STD Exception while processing block trace ${e}", ("e", e.what()));
+      elog("STD Exception while writing blocks ${e}", ("e", e.what()));
    } catch (...) {
-      elog("Unknown exception while processing trace block");
+      elog("Unknown exception while writing blocks");
    }
 }
 
-void mongo_db_plugin_impl::_process_block(const block_trace& bt, const signed_block& block) {
+void mongo_db_plugin_impl::_process_block(mongocxx::client& client, block_batch& batch, const block_trace& bt, const signed_block& block) {
    // note bt.block is invalid at this point since it is a reference to internal chainbase block
    using namespace bsoncxx::types;
    using namespace bsoncxx::builder;
    using bsoncxx::builder::basic::kvp;
 
-   mongocxx::options::bulk_write bulk_opts;
-   bulk_opts.ordered(false);
-   mongocxx::bulk_write bulk_trans{bulk_opts};
-
-   auto blocks = mongo_conn[db_name][blocks_col]; // Blocks
-   auto trans = mongo_conn[db_name][trans_col]; // Transactions
-   auto msgs = mongo_conn[db_name][actions_col]; // Actions
-   auto action_traces = mongo_conn[db_name][action_traces_col]; // ActionTraces
+   auto accts = client[db_name][accounts_col]; // Accounts
 
    auto block_doc = bsoncxx::builder::basic::document{};
    const auto block_id = block.id();
@@ -338,17 +486,6 @@ void mongo_db_plugin_impl::_process_block(const block_trace& bt, const signed_bl
    const auto prev_block_id_str = block.previous.str();
    auto block_num = block.block_num();
 
-   if (processed == 0) {
-      if (wipe_database_on_startup) {
-         // verify on start we have no previous blocks
-         verify_no_blocks(blocks);
-         FC_ASSERT(block_num < 2, "Expected start of block, instead received block_num: ${bn}", ("bn", block_num));
-      } else {
-         // verify on restart we have previous block
-         verify_last_block(blocks, prev_block_id_str);
-      }
-   }
-
    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
          std::chrono::microseconds{fc::time_point::now().time_since_epoch().count()});
 
@@ -362,13 +499,12 @@ void mongo_db_plugin_impl::_process_block(const block_trace& bt, const signed_bl
                     kvp("pending", b_bool{true}));
    block_doc.append(kvp("createdAt", b_date{now}));
 
-   if (!blocks.insert_one(block_doc.view())) {
-      elog("Failed to insert block ${bid}", ("bid", block_id));
-   }
+   mongocxx::model::insert_one insert_block{block_doc.view()};
+   batch.blocks.append(insert_block);
+   ++batch.blocks_count;
 
    int32_t msg_num = -1;
-   bool actions_to_write = false;
-   auto process_action = [&](const std::string& trans_id_str, mongocxx::bulk_write& bulk_msgs, const chain::action& msg) -> auto {
+   auto process_action = [&](const std::string& trans_id_str, const chain::action& msg) -> auto {
       auto msg_oid = bsoncxx::oid{};
       auto msg_doc = bsoncxx::builder::basic::document{};
       msg_doc.append(kvp("_id", b_oid{msg_oid}),
@@ -384,18 +520,16 @@ void mongo_db_plugin_impl::_process_block(const block_trace& bt, const signed_bl
       }));
       msg_doc.append(kvp("handler_account_name", msg.account.to_string()));
       msg_doc.append(kvp("name", msg.name.to_string()));
-      add_data(msg_doc, accounts, msg);
+      add_data(msg_doc, abi_cache, accts, msg);
       msg_doc.append(kvp("createdAt", b_date{now}));
       mongocxx::model::insert_one insert_msg{msg_doc.view()};
-      bulk_msgs.append(insert_msg);
-      actions_to_write = true;
+      batch.msgs.append(insert_msg);
+      ++batch.msgs_count;
       ++msg_num;
       return msg_oid;
    };
 
-   bool action_traces_to_write = false;
    auto process_action_trace = [&](const std::string& trans_id_str,
-                                   mongocxx::bulk_write& bulk_acts,
                                    const chain::action_trace& act,
                                    const auto& msg_oid)
    {
@@ -418,13 +552,12 @@ void mongo_db_plugin_impl::_process_block(const block_trace& bt, const signed_bl
       }));
       act_doc.append(kvp("createdAt", b_date{now}));
       mongocxx::model::insert_one insert_act{act_doc.view()};
-      bulk_acts.append(insert_act);
-      action_traces_to_write = true;
+      batch.acts.append(insert_act);
+      ++batch.acts_count;
    };
 
    int32_t trx_num = 0;
    std::map<chain::transaction_id_type, std::string> trx_status_map;
-   bool transactions_in_block = false;
 
    auto process_trx = [&](const chain::transaction& trx) -> auto {
       auto txn_oid = bsoncxx::oid{};
@@ -444,24 +577,13 @@ void mongo_db_plugin_impl::_process_block(const block_trace& bt, const signed_bl
       );
       doc.append(kvp("createdAt", b_date{now}));
 
-      if (!trx.actions.empty()) {
-         mongocxx::bulk_write bulk_msgs{bulk_opts};
-         msg_num = 0;
-         for (const auto& msg : trx.actions) {
-            process_action(trans_id_str, bulk_msgs, msg);
-         }
-         auto result = msgs.bulk_write(bulk_msgs);
-         if (!result) {
-            elog("Bulk action insert failed for block: ${bid}, transaction: ${trx}",
-                 ("bid", block_id)("trx", trx_id));
-         }
+      msg_num = 0;
+      for (const auto& msg : trx.actions) {
+         process_action(trans_id_str, msg);
       }
-      transactions_in_block = true;
       return doc;
    };
 
-   mongocxx::bulk_write bulk_msgs{bulk_opts};
-   mongocxx::bulk_write bulk_acts{bulk_opts};
    trx_num = 1000000;
    for (const auto& rt: bt.region_traces) {
       for (const auto& ct: rt.cycle_traces) {
@@ -483,7 +605,8 @@ void mongo_db_plugin_impl::_process_block(const block_trace& bt, const signed_bl
                                 kvp("execute_after", b_date{std::chrono::milliseconds{
                                          std::chrono::seconds{trx.execute_after.sec_since_epoch()}}}));
                      mongocxx::model::insert_one insert_op{doc.view()};
-                     bulk_trans.append(insert_op);
+                     batch.trans.append(insert_op);
+                     ++batch.trans_count;
                      ++trx_num;
                   } else {
                      auto cancel = req.get<chain::deferred_reference>();
@@ -495,17 +618,17 @@ void mongo_db_plugin_impl::_process_block(const block_trace& bt, const signed_bl
                   }
                }
                if (!trx_trace.action_traces.empty()) {
-                  actions_to_write = true;
                   msg_num = 1000000;
                   for (const auto& act_trace : trx_trace.action_traces) {
                      const auto& msg = act_trace.act;
-                     auto msg_oid = process_action(trx_trace.id.str(), bulk_msgs, msg);
+                     auto msg_oid = process_action(trx_trace.id.str(), msg);
                      if (trx_trace.status == chain::transaction_receipt::executed) {
                         if (act_trace.receiver == chain::config::system_account_name) {
+                           boost::mutex::scoped_lock lock(reversible_actions_mtx);
                            reversible_actions[trx_trace.id.str()].emplace_back(msg);
                         }
                      }
-                     process_action_trace(trx_trace.id.str(), bulk_acts, act_trace, msg_oid);
+                     process_action_trace(trx_trace.id.str(), act_trace, msg_oid);
                   }
                }
 
@@ -526,7 +649,8 @@ void mongo_db_plugin_impl::_process_block(const block_trace& bt, const signed_bl
          }
       }));
       mongocxx::model::insert_one insert_op{doc.view()};
-      bulk_trans.append(insert_op);
+      batch.trans.append(insert_op);
+      ++batch.trans_count;
       ++trx_num;
    }
 
@@ -534,33 +658,14 @@ void mongo_db_plugin_impl::_process_block(const block_trace& bt, const signed_bl
       auto doc = process_trx(implicit_trx);
       doc.append(kvp("type", "implicit"));
       mongocxx::model::insert_one insert_op{doc.view()};
-      bulk_trans.append(insert_op);
+      batch.trans.append(insert_op);
+      ++batch.trans_count;
       ++trx_num;
    }
 
-   if (actions_to_write) {
-      auto result = msgs.bulk_write(bulk_msgs);
-      if (!result) {
-         elog("Bulk actions insert failed for block: ${bid}", ("bid", block_id));
-      }
-   }
-   if (action_traces_to_write) {
-      auto result = action_traces.bulk_write(bulk_acts);
-      if (!result) {
-         elog("Bulk action traces insert failed for block: ${bid}", ("bid", block_id));
-      }
-   }
-   if (transactions_in_block) {
-      auto result = trans.bulk_write(bulk_trans);
-      if (!result) {
-         elog("Bulk transaction insert failed for block: ${bid}", ("bid", block_id));
-      }
-   }
-
-   ++processed;
 }
 
-void mongo_db_plugin_impl::_process_irreversible_block(const signed_block& block)
+void mongo_db_plugin_impl::_process_irreversible_blocks(mongocxx::client& client, const std::vector<signed_block_ptr>& blocks)
 {
    using namespace bsoncxx::types;
    using namespace bsoncxx::builder;
@@ -568,131 +673,171 @@ void mongo_db_plugin_impl::_process_irreversible_block(const signed_block& block
    using bsoncxx::builder::stream::document;
    using bsoncxx::builder::stream::open_document;
    using bsoncxx::builder::stream::close_document;
-   using bsoncxx::builder::stream::finalize;
-
-
-   auto blocks = mongo_conn[db_name][blocks_col]; // Blocks
-   auto trans = mongo_conn[db_name][trans_col]; // Transactions
 
-   const auto block_id = block.id();
-   const auto block_id_str = block_id.str();
+   auto blocks_c = client[db_name][blocks_col]; // Blocks
+   auto trans = client[db_name][trans_col]; // Transactions
+   auto accts = client[db_name][accounts_col]; // Accounts
 
    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
          std::chrono::microseconds{fc::time_point::now().time_since_epoch().count()});
 
-   auto ir_block = find_block(blocks, block_id_str);
-
-   document update_block{};
-   update_block << "$set" << open_document << "pending" << b_bool{false}
-               << "updatedAt" << b_date{now}
-               << close_document;
-
-   blocks.update_one(document{} << "_id" << ir_block.view()["_id"].get_oid() << finalize, update_block.view());
-
-   for (const auto& r: block.regions) {
-      for (const auto& cs: r.cycles_summary) {
-         for (const auto& ss: cs) {
-            for (const auto& trx_receipt: ss.transactions) {
-               const auto trans_id_str = trx_receipt.id.str();
-               auto ir_trans = find_transaction(trans, trans_id_str);
-
-               document update_trans{};
-               update_trans << "$set" << open_document << "pending" << b_bool{false}
-                            << "updatedAt" << b_date{now}
-                            << close_document;
-
-               trans.update_one(document{} << "_id" << ir_trans.view()["_id"].get_oid() << finalize,
-                                update_trans.view());
-
-               // actions are irreversible, so update account document
-               if (ir_trans.view()["status"].get_utf8().value.to_string() == "executed") {
-                  for (const auto& msg : reversible_actions[trans_id_str]) {
-                     update_account(msg);
+   bsoncxx::builder::basic::array block_ids;
+   bsoncxx::builder::basic::array trans_ids;
+   std::vector<std::vector<chain::action>> irreversible_actions;
+   {
+      boost::mutex::scoped_lock lock(reversible_actions_mtx);
+      for (const auto& block : blocks) {
+         block_ids.append(block->id().str());
+         for (const auto& r: block->regions) {
+            for (const auto& cs: r.cycles_summary) {
+               for (const auto& ss: cs) {
+                  for (const auto& trx_receipt: ss.transactions) {
+                     const auto trans_id_str = trx_receipt.id.str();
+                     trans_ids.append(trans_id_str);
+
+                     // only actions of executed transactions were kept
+                     auto itr = reversible_actions.find(trans_id_str);
+                     if (itr != reversible_actions.end()) {
+                        irreversible_actions.emplace_back(std::move(itr->second));
+                        reversible_actions.erase(itr);
+                     }
                   }
                }
-               reversible_actions.erase(trans_id_str);
             }
          }
       }
    }
 
+   document update_pending{};
+   update_pending << "$set" << open_document << "pending" << b_bool{false}
+                  << "updatedAt" << b_date{now}
+                  << close_document;
+
+   auto in = [](const char* field, const bsoncxx::builder::basic::array& values) {
+      auto filter = bsoncxx::builder::basic::document{};
+      filter.append(kvp(field, [&values](bsoncxx::builder::basic::sub_document subdoc) {
+         subdoc.append(kvp("$in", b_array{values.view()}));
+      }));
+      return filter;
+   };
+   blocks_c.update_many(in("block_id", block_ids).view(), update_pending.view());
+   trans.update_many(in("transaction_id", trans_ids).view(), update_pending.view());
+
+   // actions are irreversible, so update account document
+   for (const auto& actions : irreversible_actions) {
+      for (const auto& msg : actions) {
+         update_account(accts, msg);
+      }
+   }
+   write_accounts(accts);
 }
 
-// For now providing some simple account processing to maintain eos_balance
-void mongo_db_plugin_impl::update_account(const chain::action& msg) {
-   using bsoncxx::builder::basic::kvp;
-   using bsoncxx::builder::stream::document;
-   using bsoncxx::builder::stream::open_document;
-   using bsoncxx::builder::stream::close_document;
-   using bsoncxx::builder::stream::finalize;
-   using namespace bsoncxx::types;
+account_state& mongo_db_plugin_impl::find_account_state(mongocxx::collection& accounts, const account_name& name) {
+   auto itr = account_cache.find(name);
+   if (itr == account_cache.end()) {
+      auto account = find_account(accounts, name);
+      account_state state;
+      state.id = account.view()["_id"].get_oid().value;
+      state.eos_balance = asset::from_string(account.view()["eos_balance"].get_utf8().value.to_string());
+      itr = account_cache.emplace(name, std::move(state)).first;
+   }
+   return itr->second;
+}
 
+// For now providing some simple account processing to maintain eos_balance
+void mongo_db_plugin_impl::update_account(mongocxx::collection& accounts, const chain::action& msg) {
    if (msg.account != chain::config::system_account_name)
       return;
 
    if (msg.name == transfer) {
-      auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::microseconds{fc::time_point::now().time_since_epoch().count()});
-
-      abi_serializer abis;
-      auto eosio_account = find_account(accounts, msg.account);
-      auto abi = fc::json::from_string(bsoncxx::to_json(eosio_account.view()["abi"].get_document())).as<abi_def>();
-      abis.set_abi(abi);
+      auto abi = get_abi(abi_cache, accounts, msg.account);
+      const auto& abis = abi->serializer;
       auto transfer = abis.binary_to_variant(abis.get_action_type(msg.name), msg.data);
-      auto from_name = transfer["from"].as<name>().to_string();
-      auto to_name = transfer["to"].as<name>().to_string();
-      auto from_account = find_account(accounts, from_name);
-      auto to_account = find_account(accounts, to_name);
+      auto& from_account = find_account_state(accounts, transfer["from"].as<name>());
+      auto& to_account = find_account_state(accounts, transfer["to"].as<name>());
 
-      asset from_balance = asset::from_string(from_account.view()["eos_balance"].get_utf8().value.to_string());
-      asset to_balance = asset::from_string(to_account.view()["eos_balance"].get_utf8().value.to_string());
       auto asset_quantity = transfer["quantity"].as<asset>();
-      edump((from_balance)(to_balance)(asset_quantity));
-      from_balance -= asset_quantity;
-      to_balance += asset_quantity;
-
-      document update_from{};
-      update_from << "$set" << open_document << "eos_balance" << from_balance.to_string()
-                  << "updatedAt" << b_date{now}
-                  << close_document;
-      document update_to{};
-      update_to << "$set" << open_document << "eos_balance" << to_balance.to_string()
-                << "updatedAt" << b_date{now}
-                << close_document;
-
-      accounts.update_one(document{} << "_id" << from_account.view()["_id"].get_oid() << finalize, update_from.view());
-      accounts.update_one(document{} << "_id" << to_account.view()["_id"].get_oid() << finalize, update_to.view());
+      edump((from_account.eos_balance)(to_account.eos_balance)(asset_quantity));
+      from_account.eos_balance -= asset_quantity;
+      to_account.eos_balance += asset_quantity;
+      from_account.dirty = true;
+      to_account.dirty = true;
 
    } else if (msg.name == newaccount) {
-      auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::microseconds{fc::time_point::now().time_since_epoch().count()});
       auto newaccount = msg.data_as<chain::contracts::newaccount>();
 
       // create new account
-      bsoncxx::builder::stream::document doc{};
-      doc << "name" << newaccount.name.to_string()
-          << "eos_balance" << asset().to_string()
-          << "staked_balance" << asset().to_string()
-          << "unstaking_balance" << asset().to_string()
-          << "createdAt" << b_date{now}
-          << "updatedAt" << b_date{now};
-      if (!accounts.insert_one(doc.view())) {
+      account_state state;
+      state.inserted = false;
+      state.dirty = true;
+      if (!account_cache.emplace(newaccount.name, std::move(state)).second) {
          elog("Failed to insert account ${n}", ("n", newaccount.name));
       }
 
    } else if (msg.name == setabi) {
-      auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::microseconds{fc::time_point::now().time_since_epoch().count()});
       auto setabi = msg.data_as<chain::contracts::setabi>();
-      auto from_account = find_account(accounts, setabi.account);
+      auto& from_account = find_account_state(accounts, setabi.account);
+      from_account.abi_json = fc::json::to_string(setabi.abi);
+      from_account.dirty = true;
+   }
+}
 
-      document update_from{};
-      update_from << "$set" << open_document
-                  << "abi" << bsoncxx::from_json(fc::json::to_string(setabi.abi))
-                  << "updatedAt" << b_date{now}
-                  << close_document;
+/**
+ * Write the accounts changed by a batch of irreversible blocks with one bulk_write
+ */
+void mongo_db_plugin_impl::write_accounts(mongocxx::collection& accounts) {
+   using namespace bsoncxx::types;
+   using bsoncxx::builder::basic::kvp;
+
+   auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+         std::chrono::microseconds{fc::time_point::now().time_since_epoch().count()});
 
-      accounts.update_one(document{} << "_id" << from_account.view()["_id"].get_oid() << finalize, update_from.view());
+   mongocxx::bulk_write bulk{block_batch::unordered()};
+   size_t count = 0;
+   std::vector<account_name> new_abis;
+   for (auto& entry : account_cache) {
+      auto& account = entry.second;
+      if (!account.dirty)
+         continue;
+
+      auto fields = bsoncxx::builder::basic::document{};
+      fields.append(kvp("eos_balance", account.eos_balance.to_string()),
+                    kvp("updatedAt", b_date{now}));
+      if (account.abi_json) {
+         fields.append(kvp("abi", b_document{bsoncxx::from_json(*account.abi_json)}));
+         new_abis.emplace_back(entry.first);
+      }
+
+      if (!account.inserted) {
+         fields.append(kvp("_id", b_oid{account.id}),
+                       kvp("name", entry.first.to_string()),
+                       kvp("staked_balance", asset().to_string()),
+                       kvp("unstaking_balance", asset().to_string()),
+                       kvp("createdAt", b_date{now}));
+         mongocxx::model::insert_one insert_op{fields.view()};
+         bulk.append(insert_op);
+      } else {
+         auto filter = bsoncxx::builder::basic::document{};
+         filter.append(kvp("_id", b_oid{account.id}));
+         auto update = bsoncxx::builder::basic::document{};
+         update.append(kvp("$set", b_document{fields.view()}));
+         mongocxx::model::update_one update_op{filter.view(), update.view()};
+         bulk.append(update_op);
+      }
+      ++count;
+      account.inserted = true;
+      account.dirty = false;
+      account.abi_json.reset();
+   }
+
+   if (count > 0 && !accounts.bulk_write(bulk)) {
+      elog("Bulk account update failed for ${c} accounts", ("c", count));
+   }
+   // every entry is clean now, the next batch reads the accounts it changes back from the collection
+   account_cache.clear();
+   // the ABIs are read back from the accounts collection, so only drop them once it holds the new ones
+   for (const auto& account : new_abis) {
+      abi_cache.erase(account);
    }
 }
 
@@ -704,10 +849,19 @@ mongo_db_plugin_impl::mongo_db_plugin_impl()
 
 mongo_db_plugin_impl::~mongo_db_plugin_impl() {
    try {
-      done = true;
-      condition.notify_one();
+      {
+         boost::mutex::scoped_lock lock(mtx);
+         done = true;
+      }
+      condition.notify_all();
+      space_condition.notify_all();
 
-      consume_thread.join();
+      for (auto& t : consume_threads) {
+         t.join();
+      }
+      if (!consume_threads.empty()) {
+         log_metrics();
+      }
    } catch (std::exception& e) {
       elog("Exception on mongo_db_plugin shutdown of consume thread: ${e}", ("e", e.what()));
    }
@@ -790,7 +944,11 @@ void mongo_db_plugin::set_program_options(options_description& cli, options_desc
 {
    cfg.add_options()
          ("mongodb-queue-size,q", bpo::value<uint>()->default_value(256),
-         "The queue size between nodeos and MongoDB plugin thread.")
+         "The number of blocks queued between nodeos and the MongoDB writers. When it is full nodeos waits for the writers.")
+         ("mongodb-writer-threads", bpo::value<uint>()->default_value(2),
+         "The number of threads writing blocks to MongoDB.")
+         ("mongodb-batch-size", bpo::value<uint>()->default_value(16),
+         "The maximum number of blocks written to MongoDB with one bulk write.")
          ("mongodb-uri,m", bpo::value<std::string>(),
          "MongoDB URI connection string, see: https://docs.mongodb.com/master/reference/connection-string/."
                " If not specified then plugin is disabled. Default database 'EOS' is used if not specified in URI.")
@@ -816,6 +974,10 @@ void mongo_db_plugin::plugin_initialize(const variables_map& options)
          auto size = options.at("mongodb-queue-size").as<uint>();
          my->queue_size = size;
       }
+      my->writer_threads = options.at("mongodb-writer-threads").as<uint>();
+      my->batch_size = options.at("mongodb-batch-size").as<uint>();
+      FC_ASSERT(my->queue_size > 0 && my->writer_threads > 0 && my->batch_size > 0,
+                "mongodb-queue-size, mongodb-writer-threads and mongodb-batch-size must be positive");
 
       std::string uri_str = options.at("mongodb-uri").as<std::string>();
       ilog("connecting to ${u}", ("u", uri_str));
@@ -824,6 +986,7 @@ void mongo_db_plugin::plugin_initialize(const variables_map& options)
       if (my->db_name.empty())
          my->db_name = "EOS";
       my->mongo_conn = mongocxx::client{uri};
+      my->mongo_pool.reset(new mongocxx::pool{uri});
 
       // add callback to chain_controller config
       chain_plugin* chain_plug = app().find_plugin<chain_plugin>();
@@ -848,7 +1011,9 @@ void mongo_db_plugin::plugin_startup()
    if (my->configured) {
       ilog("starting db plugin");
 
-      my->consume_thread = boost::thread([this] { my->consume_blocks(); });
+      for (size_t i = 0; i < my->writer_threads; ++i) {
+         my->consume_threads.emplace_back([this] { my->consume_blocks(); });
+      }
 
       // chain_controller is created and has resynced or replayed if needed
       my->startup = false;
@@ -129,6 +129,34 @@ namespace eosio {
       uint32_t end_block;
    };
 
+   /**
+    * The short id of a transaction in a compact_block_message, the first 64 bits of its id.
+    */
+   inline uint64_t short_txn_id( const transaction_id_type& id ) {
+      return id._hash[0];
+   }
+
+   /**
+    * A block relayed without its input transactions. The receiver matches each short id
+    * against the receipts of the summary, takes the transactions it already has from its
+    * own cache and asks the sender for the rest with a compact_block_request.
+    */
+   struct compact_block_message {
+      signed_block_summary   block;
+      vector<uint64_t>       input_ids; ///< short_txn_id of each input transaction, in block order
+   };
+
+   struct compact_block_request {
+      block_id_type          block_id;
+      vector<uint32_t>       indexes; ///< positions in compact_block_message::input_ids
+   };
+
+   struct compact_block_transactions {
+      block_id_type              block_id;
+      vector<uint32_t>           indexes;
+      vector<packed_transaction> transactions; ///< the transaction at each of indexes
+   };
+
    using net_message = static_variant<handshake_message,
                                       go_away_message,
                                       time_message,
@@ -138,7 +166,10 @@ namespace eosio {
                                       signed_block_summary,
                                       signed_block,
                                       signed_transaction,
-                                      packed_transaction>;
+                                      packed_transaction,
+                                      compact_block_message,
+                                      compact_block_request,
+                                      compact_block_transactions>;
 
 } // namespace eosio
 
@@ -154,6 +185,9 @@ FC_REFLECT( eosio::time_message, (org)(rec)(xmt)(dst) )
 FC_REFLECT( eosio::notice_message, (known_trx)(known_blocks) )
 FC_REFLECT( eosio::request_message, (req_trx)(req_blocks) )
 FC_REFLECT( eosio::sync_request_message, (start_block)(end_block) )
+FC_REFLECT( eosio::compact_block_message, (block)(input_ids) )
+FC_REFLECT( eosio::compact_block_request, (block_id)(indexes) )
+FC_REFLECT( eosio::compact_block_transactions, (block_id)(indexes)(transactions) )
 
 /**
  *
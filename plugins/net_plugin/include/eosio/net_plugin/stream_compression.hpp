@@ -0,0 +1,101 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+#pragma once
+#include <fc/exception/exception.hpp>
+#include <zlib.h>
+#include <algorithm>
+#include <vector>
+
+namespace eosio {
+
+  /**
+   *  @brief zlib deflate stream compressing the messages sent on one connection
+   *
+   *  The stream is kept from one message to the next, so each message is compressed
+   *  against the history of the previous ones, and it is flushed at the end of every
+   *  message so that the peer can decompress a message as soon as it is received.
+   */
+  class stream_compressor {
+  public:
+    explicit stream_compressor(int level = Z_BEST_SPEED) {
+      strm.zalloc = Z_NULL;
+      strm.zfree = Z_NULL;
+      strm.opaque = Z_NULL;
+      FC_ASSERT(deflateInit(&strm, level) == Z_OK, "unable to initialize zlib compression");
+    }
+    ~stream_compressor() { deflateEnd(&strm); }
+
+    stream_compressor(const stream_compressor&) = delete;
+    stream_compressor& operator=(const stream_compressor&) = delete;
+
+    /*
+     *  Compresses size bytes at data and appends them to out.
+     */
+    void compress(const char* data, size_t size, std::vector<char>& out) {
+      strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+      strm.avail_in = size;
+      do {
+        size_t old_size = out.size();
+        out.resize(old_size + std::max<size_t>(deflateBound(&strm, strm.avail_in), 64));
+        strm.next_out = reinterpret_cast<Bytef*>(out.data() + old_size);
+        strm.avail_out = out.size() - old_size;
+        int r = deflate(&strm, Z_SYNC_FLUSH);
+        out.resize(out.size() - strm.avail_out);
+        FC_ASSERT(r == Z_OK || r == Z_BUF_ERROR, "zlib compression failed: ${r}", ("r", r));
+      } while (strm.avail_out == 0);
+    }
+
+  private:
+    z_stream strm;
+  };
+
+  /**
+   *  @brief zlib inflate stream decompressing the messages received on one connection
+   *
+   *  The counterpart of stream_compressor, it must see every message of the stream in order.
+   */
+  class stream_decompressor {
+  public:
+    stream_decompressor() {
+      strm.zalloc = Z_NULL;
+      strm.zfree = Z_NULL;
+      strm.opaque = Z_NULL;
+      strm.next_in = Z_NULL;
+      strm.avail_in = 0;
+      FC_ASSERT(inflateInit(&strm) == Z_OK, "unable to initialize zlib decompression");
+    }
+    ~stream_decompressor() { inflateEnd(&strm); }
+
+    stream_decompressor(const stream_decompressor&) = delete;
+    stream_decompressor& operator=(const stream_decompressor&) = delete;
+
+    /*
+     *  Decompresses size bytes at data and appends them to out. Throws if out would
+     *  grow beyond max_size bytes.
+     */
+    void decompress(const char* data, size_t size, std::vector<char>& out, size_t max_size) {
+      strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+      strm.avail_in = size;
+      for (;;) {
+        size_t old_size = out.size();
+        FC_ASSERT(old_size < max_size, "decompressed message exceeds ${m} bytes", ("m", max_size));
+        out.resize(std::min(old_size + std::max<size_t>(size * 4, 4096), max_size));
+        strm.next_out = reinterpret_cast<Bytef*>(out.data() + old_size);
+        strm.avail_out = out.size() - old_size;
+        int r = inflate(&strm, Z_SYNC_FLUSH);
+        out.resize(out.size() - strm.avail_out);
+        FC_ASSERT(r == Z_OK || r == Z_BUF_ERROR, "zlib decompression failed: ${r}", ("r", r));
+        if (strm.avail_out != 0) {
+          break;
+        }
+      }
+      FC_ASSERT(strm.avail_in == 0, "zlib decompression stopped before the end of the message");
+    }
+
+  private:
+    z_stream strm;
+  };
+
+} // namespace eosio
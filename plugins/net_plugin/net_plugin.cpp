@@ -7,6 +7,7 @@
 #include <eosio/net_plugin/net_plugin.hpp>
 #include <eosio/net_plugin/protocol.hpp>
 #include <eosio/net_plugin/message_buffer.hpp>
+#include <eosio/net_plugin/stream_compression.hpp>
 #include <eosio/chain/chain_controller.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/block.hpp>
@@ -26,8 +27,15 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ip/host_name.hpp>
 #include <boost/asio/steady_timer.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/io_context_strand.hpp>
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/intrusive/set.hpp>
 
+#include <thread>
+
 namespace fc {
    extern std::unordered_map<std::string,logger>& get_logger_map();
 }
@@ -68,13 +76,33 @@ namespace eosio {
       return r;
    }
 
+   /**
+    * A packed net_message preceded by its size, as written to the socket. Immutable, so that one
+    * buffer can be queued on every connection a message is broadcast to.
+    */
+   using send_buffer_type = std::shared_ptr<const vector<char>>;
+
+   send_buffer_type create_send_buffer( const net_message& m ) {
+      uint32_t payload_size = fc::raw::pack_size( m );
+      char * header = reinterpret_cast<char*>(&payload_size);
+      size_t header_size = sizeof(payload_size);
+
+      size_t buffer_size = header_size + payload_size;
+
+      auto send_buffer = std::make_shared<vector<char>>(buffer_size);
+      fc::datastream<char*> ds( send_buffer->data(), buffer_size);
+      ds.write( header, header_size );
+      fc::raw::pack( ds, m );
+      return send_buffer;
+   }
+
    struct node_transaction_state {
       transaction_id_type id;
       time_point_sec  expires;  /// time after which this may be purged.
                                 /// Expires increased while the txn is
                                 /// "in flight" to anoher peer
       packed_transaction packed_txn;
-      vector<char>    serialized_txn; /// the received raw bundle
+      send_buffer_type serialized_txn; /// the received raw bundle, queued as is on the connections it is sent to
       uint32_t        block_num = 0; /// block transaction was included in
       uint32_t        true_block = 0; /// used to reset block_uum when request is 0
       uint16_t        requests = 0; /// the number of "in flight" requests for this txn
@@ -86,13 +114,7 @@ namespace eosio {
 
       void operator() (node_transaction_state& nts) {
          nts.packed_txn = txn;
-         net_message msg(txn);
-         uint32_t packsiz = fc::raw::pack_size(msg);
-         uint32_t bufsiz = packsiz + sizeof(packsiz);
-         nts.serialized_txn.resize(bufsiz);
-         fc::datastream<char*> ds( nts.serialized_txn.data(), bufsiz );
-         ds.write( reinterpret_cast<char*>(&packsiz), sizeof(packsiz) );
-         fc::raw::pack( ds, msg );
+         nts.serialized_txn = create_send_buffer( net_message(txn) );
       }
    };
 
@@ -141,6 +163,16 @@ namespace eosio {
 
    class net_plugin_impl {
    public:
+      /**
+       * The peer sockets run on the net threads, which read, frame and unpack their messages. The
+       * connections, and the handling of the unpacked messages, stay on the main thread. Declared
+       * first so that it outlives the sockets.
+       */
+      boost::asio::io_context          net_ioc;
+      unique_ptr<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> net_work;
+      vector<std::thread>              net_threads;
+      uint16_t                         net_thread_count = 0;
+
       unique_ptr<tcp::acceptor>        acceptor;
       tcp::endpoint                    listen_endpoint;
       string                           p2p_address;
@@ -178,6 +210,7 @@ namespace eosio {
       const std::chrono::system_clock::duration peer_authentication_interval{std::chrono::seconds{1}}; ///< Peer clock may be no more than 1 second skewed from our clock, including network latency.
 
       bool                          network_version_match = false;
+      bool                          p2p_compression = false; ///< compress the messages sent to peers that can decompress them
       chain_id_type                 chain_id;
       fc::sha256                    node_id;
 
@@ -194,14 +227,24 @@ namespace eosio {
       void start_session( connection_ptr c );
       void start_listen_loop( );
       void start_read_message( connection_ptr c);
+      /// reads the next messages of c, on its strand
+      void read_message( connection_ptr c);
+      /// handles a batch of messages read by read_message, on the main thread
+      void handle_messages( connection_ptr c, uint32_t session, const vector<net_message>& msgs);
+      /// closes c on the main thread, unless the session the net thread saw has ended already
+      void close_from_net_thread( connection_ptr c, uint32_t session, const string& reason);
 
       void   close( connection_ptr c );
       size_t count_open_sockets() const;
 
+      /// packs msg once, the first time verify accepts a connection, and queues the same buffer on every accepted connection
       template<typename VerifierFunc>
       void send_all( const net_message &msg, VerifierFunc verify );
+      template<typename VerifierFunc>
+      void send_all( const send_buffer_type& send_buffer, VerifierFunc verify );
 
       static void transaction_ready( const transaction_metadata&, const packed_transaction& txn);
+      void start_signature_recovery( const net_message& msg);
       void broadcast_block_impl( const signed_block &sb);
 
       bool is_valid( const handshake_message &msg);
@@ -230,6 +273,14 @@ namespace eosio {
       void handle_message( connection_ptr c, const signed_block &msg);
       void handle_message( connection_ptr c, const packed_transaction &msg);
       void handle_message( connection_ptr c, const signed_transaction &msg);
+      void handle_message( connection_ptr c, const compact_block_message &msg);
+      void handle_message( connection_ptr c, const compact_block_request &msg);
+      void handle_message( connection_ptr c, const compact_block_transactions &msg);
+
+      /// accepts a block rebuilt from a summary or a compact block, then relays it
+      void accept_relayed_block( connection_ptr c, const signed_block &sb);
+      /// accepts a whole block, in the order the sync manager applies them while catching up
+      void apply_block( connection_ptr c, const signed_block &msg);
 
       void start_conn_timer( );
       void start_txn_timer( );
@@ -294,9 +345,16 @@ namespace eosio {
    constexpr auto     def_txn_expire_wait = std::chrono::seconds(3);
    constexpr auto     def_resp_expected_wait = std::chrono::seconds(5);
    constexpr auto     def_sync_fetch_span = 100;
+   constexpr auto     def_sync_fetch_ranges = 4; ///< ranges fetched at once, each from a different peer
+   constexpr auto     def_sync_rate_interval = 10; ///< seconds between reports of the sync rates
    constexpr uint32_t  def_max_just_send = 1500; // roughly 1 "mtu"
 
    constexpr auto     message_header_size = 4;
+   constexpr uint32_t message_compressed_flag = 0x80000000; ///< set in the header of a message compressed with the connection's stream
+   constexpr uint32_t def_min_compress_size = 128; ///< smaller messages are sent as they are
+
+   constexpr auto     def_net_threads = 2;
+   constexpr auto     def_max_read_batches = 4; ///< batches a connection reads ahead of the main thread
 
    /**
     *  For a while, network version was a 16 bit value equal to the second set of 16 bits
@@ -318,8 +376,10 @@ namespace eosio {
     */
    constexpr uint16_t proto_base = 0;
    constexpr uint16_t proto_explicit_sync = 1;
+   constexpr uint16_t proto_compact_blocks = 2; ///< blocks are relayed as compact_block_message
+   constexpr uint16_t proto_stream_compression = 3; ///< messages may be compressed, see message_compressed_flag
 
-   constexpr uint16_t net_version = proto_explicit_sync;
+   constexpr uint16_t net_version = proto_stream_compression;
 
    /**
     *  Index by id
@@ -417,6 +477,15 @@ namespace eosio {
       time_point   start_time; ///< time request made or received
    };
 
+   /**
+    * A compact block waiting for the input transactions requested from the peer that sent it.
+    */
+   struct pending_compact_block {
+      signed_block       block;
+      vector<uint64_t>   input_ids;
+      vector<uint32_t>   missing; ///< indexes of the requested input transactions
+   };
+
    struct handshake_initializer {
       static void populate(handshake_message &hello);
    };
@@ -433,12 +502,23 @@ namespace eosio {
       transaction_state_index trx_state;
       optional<sync_state>    peer_requested;  // this peer is requesting info from us
       socket_ptr              socket;
+      boost::asio::io_context::strand strand; ///< serializes the operations on socket and the read loop
+      bool                    socket_open = false; ///< connected and not closed yet, tracked on the main thread
+      uint32_t                session = 0; ///< counts the sessions started on the connection
 
+      // the read loop state, only used on strand
       message_buffer<1024*1024>    pending_message_buffer;
       vector<char>            blk_buffer;
+      uint32_t                read_session = 0;
+      uint32_t                pending_read_batches = 0; ///< batches posted to the main thread and not handled yet
+      bool                    read_paused = false;
+      unique_ptr<stream_decompressor> decompressor; ///< created by the first compressed message of the session
+
+      bool                    compress_sends = false; ///< negotiated in the handshake, tracked on the main thread
+      unique_ptr<stream_compressor> compressor; ///< only used on strand
 
       struct queued_write {
-         std::shared_ptr<vector<char>> buff;
+         send_buffer_type buff;
          std::function<void(boost::system::error_code, std::size_t)> cb;
       };
       deque<queued_write>     write_queue;
@@ -458,6 +538,9 @@ namespace eosio {
       block_id_type          fork_head;
       uint32_t               fork_head_num;
       optional<request_message> last_req;
+      optional<pending_compact_block> pending_compact;
+
+      bool supports_compact_blocks() const { return protocol_version >= proto_compact_blocks; }
 
       connection_status get_status()const {
          connection_status stat;
@@ -528,6 +611,8 @@ namespace eosio {
 
       void enqueue( transaction_id_type id );
       void enqueue( const net_message &msg, bool trigger_send = true );
+      void enqueue_buffer( const send_buffer_type& send_buffer, bool trigger_send = true, go_away_reason close_after_send = no_reason );
+      void enqueue_packed_block( const packed_block_view &pb, bool trigger_send = true );
       void cancel_sync(go_away_reason);
       void flush_queues();
       bool enqueue_sync_block();
@@ -539,21 +624,37 @@ namespace eosio {
       void sync_timeout(boost::system::error_code ec);
       void fetch_timeout(boost::system::error_code ec);
 
-      void queue_write(std::shared_ptr<vector<char>> buff,
+      void queue_write(const send_buffer_type& buff,
                        bool trigger_send,
                        std::function<void(boost::system::error_code, std::size_t)> cb);
       void do_queue_write();
 
-      /** \brief Process the next message from the pending message buffer
+      /** \brief Unpack the next message from the pending message buffer
        *
-       * Process the next message from the pending_message_buffer.
+       * Unpack the next message from the pending_message_buffer into msg.
        * message_length is the already determined length of the data
-       * part of the message and impl in the net plugin implementation
-       * that will handle the message.
+       * part of the message. Runs on strand.
        * Returns true is successful. Returns false if an error was
-       * encountered unpacking or processing the message.
+       * encountered unpacking the message, the caller closes the connection.
        */
-      bool process_next_message(net_plugin_impl& impl, uint32_t message_length);
+      bool unpack_next_message(uint32_t message_length, net_message& msg);
+
+      /** \brief Unpacks a message compressed by the peer's stream_compressor
+       *
+       * Same as unpack_next_message for a message whose header had message_compressed_flag set.
+       * Runs on strand.
+       */
+      bool unpack_compressed_message(uint32_t message_length, net_message& msg);
+
+      /// compresses the message in buff with compressor, on strand
+      send_buffer_type compress_message(const send_buffer_type& buff);
+
+      /** \brief Process a message unpacked by unpack_next_message
+       *
+       * Returns true is successful. Returns false if an error was
+       * encountered processing the message.
+       */
+      bool process_message(net_plugin_impl& impl, const net_message& msg);
    };
 
    struct msgHandler : public fc::visitor<void> {
@@ -576,21 +677,52 @@ namespace eosio {
          in_sync
       };
 
+      /**
+       * A range of blocks requested from one peer while catching up with the last irreversible block.
+       */
+      struct sync_range {
+         uint32_t       start;
+         uint32_t       end;
+         uint32_t       next; ///< the next block expected from source
+         connection_ptr source;
+      };
+
+      /**
+       * A block received ahead of the next one to apply.
+       */
+      struct buffered_block {
+         connection_ptr source;
+         signed_block   block;
+      };
+
       uint32_t       sync_known_lib_num;
       uint32_t       sync_last_requested_num;
       uint32_t       sync_next_expected_num;
       uint32_t       sync_req_span;
+      uint32_t       sync_max_ranges;
       uint32_t       last_repeated;
-      connection_ptr source;
+      connection_ptr source; ///< the peer the last range was requested from
       stages         state;
 
+      vector<sync_range>                  ranges; ///< requested and not completely received
+      deque<pair<uint32_t,uint32_t>>      unassigned; ///< ranges given up by their peer, requested again first
+      std::map<uint32_t,buffered_block>   reorder_buffer; ///< blocks after sync_next_expected_num, by number
+
+      time_point     rate_start;
+      uint32_t       rate_downloaded = 0;
+      uint32_t       rate_applied = 0;
+
       deque<block_id_type> _blocks;
       chain_plugin * chain_plug;
 
       constexpr auto stage_str(stages s );
+      connection_ptr next_range_source(connection_ptr conn, uint32_t needed_num);
+      bool release_range(connection_ptr c);
+      void reset_ranges();
+      void report_rates(bool force);
 
    public:
-      sync_manager(uint32_t span);
+      sync_manager(uint32_t span, uint32_t max_ranges);
       void set_state(stages s);
       bool is_active(connection_ptr conn);
       void reset_lib_num(connection_ptr conn);
@@ -601,6 +733,11 @@ namespace eosio {
       void reassign_fetch(connection_ptr c, go_away_reason reason);
       void verify_catchup(connection_ptr c, uint32_t num, block_id_type id);
       void recv_block(connection_ptr c, const block_id_type &blk_id, uint32_t blk_num, bool accepted);
+      /**
+       * While catching up, buffers the blocks received ahead of the next one and applies the
+       * ones that are next in order. Returns false, leaving blk to the caller, when not catching up.
+       */
+      bool recv_sync_block(connection_ptr c, const signed_block& blk);
       void recv_handshake(connection_ptr c, const handshake_message& msg);
       void recv_notice(connection_ptr c, const notice_message& msg);
 
@@ -617,25 +754,52 @@ namespace eosio {
       vector<block_request> req_blks;
       vector<transaction_id_type> req_txn;
 
-      void bcast_block (const signed_block_summary& msg, connection_ptr skip = connection_ptr());
+      void bcast_block (const signed_block& msg, connection_ptr skip = connection_ptr());
       void bcast_transaction (const transaction_id_type& id,
                               time_point_sec expiration,
                               const packed_transaction& msg);
       void rejected_transaction (const packed_transaction& msg);
-      void recv_block (connection_ptr conn, const signed_block_summary& msg);
+      void recv_block (connection_ptr conn, const signed_block& msg);
       void recv_transaction(connection_ptr c, const transaction_id_type& id);
       void recv_notice (connection_ptr conn, const notice_message& msg, bool generated);
 
       void retry_fetch (connection_ptr conn);
    };
 
+   compact_block_message make_compact_block( const signed_block& sb ) {
+      compact_block_message cb;
+      cb.block = sb;
+      cb.input_ids.reserve( sb.input_transactions.size() );
+      for( const auto& t : sb.input_transactions ) {
+         cb.input_ids.push_back( short_txn_id( t.id() ) );
+      }
+      return cb;
+   }
+
+   /**
+    * The buffer relaying sb to c, the compact block if c understands them, otherwise the summary.
+    * Each message is packed once, for the first connection it is sent to.
+    */
+   const send_buffer_type& block_relay_buffer( const connection_ptr& c, const signed_block& sb,
+                                               send_buffer_type& summary_buffer, send_buffer_type& compact_buffer ) {
+      if( c->supports_compact_blocks() ) {
+         if( !compact_buffer )
+            compact_buffer = create_send_buffer( make_compact_block( sb ) );
+         return compact_buffer;
+      }
+      if( !summary_buffer )
+         summary_buffer = create_send_buffer( static_cast<const signed_block_summary&>( sb ) );
+      return summary_buffer;
+   }
+
    //---------------------------------------------------------------------------
 
    connection::connection( string endpoint )
       : blk_state(),
         trx_state(),
         peer_requested(),
-        socket( std::make_shared<tcp::socket>( std::ref( app().get_io_service() ))),
+        socket( std::make_shared<tcp::socket>( std::ref( my_impl->net_ioc ))),
+        strand( my_impl->net_ioc ),
         node_id(),
         last_handshake_recv(),
         last_handshake_sent(),
@@ -661,6 +825,7 @@ namespace eosio {
         trx_state(),
         peer_requested(),
         socket( s ),
+        strand( my_impl->net_ioc ),
         node_id(),
         last_handshake_recv(),
         last_handshake_sent(),
@@ -695,7 +860,7 @@ namespace eosio {
    }
 
    bool connection::connected() {
-      return (socket->is_open() && !connecting);
+      return (socket_open && !connecting);
    }
 
    bool connection::current() {
@@ -720,11 +885,21 @@ namespace eosio {
 
    void connection::close() {
       if(socket) {
-         socket->close();
+         // after the operations already started on the socket
+         connection_ptr self = shared_from_this();
+         boost::asio::post(strand, [self]() {
+            boost::system::error_code ec;
+            self->socket->close(ec);
+            self->pending_message_buffer.reset();
+            self->compressor.reset();
+            self->decompressor.reset();
+         });
       }
       else {
          wlog("no socket to close!");
       }
+      socket_open = false;
+      compress_sends = false;
       flush_queues();
       connecting = false;
       syncing = false;
@@ -732,18 +907,18 @@ namespace eosio {
          my_impl->big_msg_master->retry_fetch (shared_from_this());
       }
       reset();
+      pending_compact.reset();
       sent_handshake_count = 0;
       last_handshake_recv = handshake_message();
       last_handshake_sent = handshake_message();
       my_impl->sync_master->reset_lib_num(shared_from_this());
       fc_dlog(logger, "canceling wait on ${p}", ("p",peer_name()));
       cancel_wait();
-      pending_message_buffer.reset();
    }
 
    void connection::txn_send_pending(const vector<transaction_id_type> &ids) {
       for(auto tx = my_impl->local_txns.begin(); tx != my_impl->local_txns.end(); ++tx ){
-         if(tx->serialized_txn.size() && tx->block_num == 0) {
+         if(tx->serialized_txn && tx->block_num == 0) {
             bool found = false;
             for(auto known : ids) {
                if( known == tx->id) {
@@ -753,7 +928,7 @@ namespace eosio {
             }
             if(!found) {
                my_impl->local_txns.modify(tx,incr_in_flight);
-               queue_write(std::make_shared<vector<char>>(tx->serialized_txn),
+               queue_write(tx->serialized_txn,
                            true,
                            [this, tx](boost::system::error_code ec, std::size_t ) {
                               my_impl->local_txns.modify(tx, decr_in_flight);
@@ -766,9 +941,9 @@ namespace eosio {
    void connection::txn_send(const vector<transaction_id_type> &ids) {
       for(auto t : ids) {
          auto tx = my_impl->local_txns.get<by_id>().find(t);
-         if( tx != my_impl->local_txns.end() && tx->serialized_txn.size()) {
+         if( tx != my_impl->local_txns.end() && tx->serialized_txn) {
             my_impl->local_txns.modify( tx,incr_in_flight);
-            queue_write(std::make_shared<vector<char>>(tx->serialized_txn),
+            queue_write(tx->serialized_txn,
                         true,
                         [this, tx](boost::system::error_code ec, std::size_t ) {
                            my_impl->local_txns.modify(tx, decr_in_flight);
@@ -850,6 +1025,9 @@ namespace eosio {
                if (send_whole) {
                   enqueue(net_message(*b));
                }
+               else if (supports_compact_blocks()) {
+                  enqueue(net_message(make_compact_block(*b)));
+               }
                else {
                   signed_block_summary &sbs = *b;
                   enqueue(net_message(sbs));
@@ -913,7 +1091,7 @@ namespace eosio {
       enqueue(xpkt);
    }
 
-   void connection::queue_write(std::shared_ptr<vector<char>> buff,
+   void connection::queue_write(const send_buffer_type& buff,
                                 bool trigger_send,
                                 std::function<void(boost::system::error_code, std::size_t)> cb) {
       write_queue.push_back({buff, cb});
@@ -926,48 +1104,61 @@ namespace eosio {
          return;
       write_depth++;
       connection_wptr c(shared_from_this());
-      boost::asio::async_write(*socket, boost::asio::buffer(*write_queue.front().buff), [c](boost::system::error_code ec, std::size_t w) {
-            try {
-               auto conn = c.lock();
-               if(!conn)
-                  return;
-
-               if (conn->write_queue.size() ) {
-                  conn->write_queue.front().cb(ec, w);
-               }
-               conn->write_depth--;
+      // compressed and written on the net threads, the result is handled on the main thread which owns the write queue
+      bool compress = compress_sends && write_queue.front().buff->size() >= message_header_size + def_min_compress_size;
+      boost::asio::post(strand, [c, s = socket, buff = write_queue.front().buff, compress]() {
+         send_buffer_type out = buff;
+         if (compress) {
+            auto conn = c.lock();
+            if (conn) {
+               out = conn->compress_message(buff);
+            }
+         }
+         boost::asio::async_write(*s, boost::asio::buffer(*out), [c, out](boost::system::error_code ec, std::size_t w) {
+            app().get_io_service().post([c, ec, w]() {
+               try {
+                  auto conn = c.lock();
+                  if(!conn)
+                     return;
 
-               if(ec) {
-                  string pname = conn ? conn->peer_name() : "no connection name";
-                  if( ec.value() != boost::asio::error::eof) {
-                     elog("Error sending to peer ${p}: ${i}", ("p",pname)("i", ec.message()));
+                  if (conn->write_queue.size() ) {
+                     conn->write_queue.front().cb(ec, w);
                   }
-                  else {
-                     ilog("connection closure detected on write to ${p}",("p",pname));
+                  conn->write_depth--;
+
+                  if(ec) {
+                     string pname = conn ? conn->peer_name() : "no connection name";
+                     if( ec.value() != boost::asio::error::eof) {
+                        elog("Error sending to peer ${p}: ${i}", ("p",pname)("i", ec.message()));
+                     }
+                     else {
+                        ilog("connection closure detected on write to ${p}",("p",pname));
+                     }
+                     my_impl->close(conn);
+                     return;
                   }
-                  my_impl->close(conn);
-                  return;
+                  conn->write_queue.pop_front();
+                  conn->enqueue_sync_block();
+                  conn->do_queue_write();
                }
-               conn->write_queue.pop_front();
-               conn->enqueue_sync_block();
-               conn->do_queue_write();
-            }
-            catch(const std::exception &ex) {
-               auto conn = c.lock();
-               string pname = conn ? conn->peer_name() : "no connection name";
-               elog("Exception in do_queue_write to ${p} ${s}", ("p",pname)("s",ex.what()));
-            }
-            catch(const fc::exception &ex) {
-               auto conn = c.lock();
-               string pname = conn ? conn->peer_name() : "no connection name";
-               elog("Exception in do_queue_write to ${p} ${s}", ("p",pname)("s",ex.to_string()));
-            }
-            catch(...) {
-               auto conn = c.lock();
-               string pname = conn ? conn->peer_name() : "no connection name";
-               elog("Exception in do_queue_write to ${p}", ("p",pname) );
-            }
+               catch(const std::exception &ex) {
+                  auto conn = c.lock();
+                  string pname = conn ? conn->peer_name() : "no connection name";
+                  elog("Exception in do_queue_write to ${p} ${s}", ("p",pname)("s",ex.what()));
+               }
+               catch(const fc::exception &ex) {
+                  auto conn = c.lock();
+                  string pname = conn ? conn->peer_name() : "no connection name";
+                  elog("Exception in do_queue_write to ${p} ${s}", ("p",pname)("s",ex.to_string()));
+               }
+               catch(...) {
+                  auto conn = c.lock();
+                  string pname = conn ? conn->peer_name() : "no connection name";
+                  elog("Exception in do_queue_write to ${p}", ("p",pname) );
+               }
+            });
          });
+      });
    }
 
    void connection::cancel_sync(go_away_reason reason) {
@@ -998,6 +1189,12 @@ namespace eosio {
          peer_requested.reset();
       }
       try {
+         // irreversible blocks are sent as they are stored in the block log, without unpacking them
+         fc::optional<packed_block_view> pb = cc.fetch_packed_block_by_number(num);
+         if(pb) {
+            enqueue_packed_block( *pb, trigger_send);
+            return true;
+         }
          fc::optional<signed_block> sb = cc.fetch_block_by_number(num);
          if(sb) {
             enqueue( *sb, trigger_send);
@@ -1014,8 +1211,26 @@ namespace eosio {
       if (m.contains<go_away_message>()) {
          close_after_send = m.get<go_away_message>().reason;
       }
+      enqueue_buffer( create_send_buffer( m ), trigger_send, close_after_send );
+   }
 
-      uint32_t payload_size = fc::raw::pack_size( m );
+   void connection::enqueue_buffer( const send_buffer_type& send_buffer, bool trigger_send, go_away_reason close_after_send ) {
+      write_depth++;
+      queue_write(send_buffer,trigger_send,
+                  [this, close_after_send](boost::system::error_code ec, std::size_t ) {
+                     write_depth--;
+                     if(close_after_send != no_reason) {
+                        elog ("sent a go away message: ${r}, closing connection to ${p}",("r",reason_str(close_after_send))("p",peer_name()));
+                        my_impl->close(shared_from_this());
+                        return;
+                     }
+                  });
+   }
+
+   void connection::enqueue_packed_block( const packed_block_view &pb, bool trigger_send ) {
+      // same bytes as enqueue( net_message(signed_block) ): the variant tag followed by the packed block
+      fc::unsigned_int which( net_message::tag<signed_block>::value );
+      uint32_t payload_size = fc::raw::pack_size( which ) + pb.size();
       char * header = reinterpret_cast<char*>(&payload_size);
       size_t header_size = sizeof(payload_size);
 
@@ -1024,16 +1239,12 @@ namespace eosio {
       auto send_buffer = std::make_shared<vector<char>>(buffer_size);
       fc::datastream<char*> ds( send_buffer->data(), buffer_size);
       ds.write( header, header_size );
-      fc::raw::pack( ds, m );
+      fc::raw::pack( ds, which );
+      ds.write( pb.data(), pb.size() );
       write_depth++;
       queue_write(send_buffer,trigger_send,
-                  [this, close_after_send](boost::system::error_code ec, std::size_t ) {
+                  [this](boost::system::error_code ec, std::size_t ) {
                      write_depth--;
-                     if(close_after_send != no_reason) {
-                        elog ("sent a go away message: ${r}, closing connection to ${p}",("r",reason_str(close_after_send))("p",peer_name()));
-                        my_impl->close(shared_from_this());
-                        return;
-                     }
                   });
    }
 
@@ -1113,7 +1324,7 @@ namespace eosio {
       sync_wait();
    }
 
-   bool connection::process_next_message(net_plugin_impl& impl, uint32_t message_length) {
+   bool connection::unpack_next_message(uint32_t message_length, net_message& msg) {
       try {
          // If it is a signed_block, then save the raw message for the cache
          // This must be done before we unpack the message.
@@ -1132,8 +1343,46 @@ namespace eosio {
             pending_message_buffer.peek(blk_buffer.data(), message_length, index);
          }
          auto ds = pending_message_buffer.create_datastream();
-         net_message msg;
          fc::raw::unpack(ds, msg);
+      } catch(  const fc::exception& e ) {
+         edump((e.to_detail_string() ));
+         return false;
+      }
+      return true;
+   }
+
+   bool connection::unpack_compressed_message(uint32_t message_length, net_message& msg) {
+      try {
+         vector<char> compressed(message_length);
+         pending_message_buffer.read(compressed.data(), message_length);
+         if (!decompressor) {
+            decompressor.reset(new stream_decompressor());
+         }
+         vector<char> plain;
+         decompressor->decompress(compressed.data(), compressed.size(), plain, def_send_buffer_size*2);
+         fc::datastream<const char*> ds(plain.data(), plain.size());
+         fc::raw::unpack(ds, msg);
+      } catch(  const fc::exception& e ) {
+         edump((e.to_detail_string() ));
+         return false;
+      }
+      return true;
+   }
+
+   send_buffer_type connection::compress_message(const send_buffer_type& buff) {
+      if (!compressor) {
+         compressor.reset(new stream_compressor());
+      }
+      auto out = std::make_shared<vector<char>>(message_header_size);
+      out->reserve(buff->size());
+      compressor->compress(buff->data() + message_header_size, buff->size() - message_header_size, *out);
+      uint32_t header = uint32_t(out->size() - message_header_size) | message_compressed_flag;
+      memcpy(out->data(), &header, message_header_size);
+      return out;
+   }
+
+   bool connection::process_message(net_plugin_impl& impl, const net_message& msg) {
+      try {
          msgHandler m(impl, shared_from_this() );
          msg.visit(m);
       } catch(  const fc::exception& e ) {
@@ -1147,11 +1396,12 @@ namespace eosio {
 
    //-----------------------------------------------------------
 
-    sync_manager::sync_manager( uint32_t req_span )
+    sync_manager::sync_manager( uint32_t req_span, uint32_t max_ranges )
       :sync_known_lib_num( 0 )
       ,sync_last_requested_num( 0 )
       ,sync_next_expected_num( 1 )
       ,sync_req_span( req_span )
+      ,sync_max_ranges( max_ranges )
       ,last_repeated( 0 )
       ,source()
       ,state(in_sync)
@@ -1173,6 +1423,10 @@ namespace eosio {
          return;
       }
       fc_dlog(logger, "old state ${os} becoming ${ns}",("os",stage_str (state))("ns",stage_str (newstate)));
+      if (state == lib_catchup) {
+         report_rates(true);
+         reset_ranges();
+      }
       state = newstate;
    }
 
@@ -1194,8 +1448,7 @@ namespace eosio {
          if( c->last_handshake_recv.last_irreversible_block_num > sync_known_lib_num) {
             sync_known_lib_num =c->last_handshake_recv.last_irreversible_block_num;
          }
-      } else if( c == source ) {
-         sync_last_requested_num = 0;
+      } else if( release_range(c) ) {
          request_next_chunk();
       }
    }
@@ -1208,81 +1461,125 @@ namespace eosio {
               chain_plug->chain( ).head_block_num( ) < sync_last_requested_num );
    }
 
-   void sync_manager::request_next_chunk( connection_ptr conn ) {
-      uint32_t head_block = chain_plug->chain().head_block_num();
+   connection_ptr sync_manager::next_range_source( connection_ptr conn, uint32_t needed_num ) {
+      auto available = [this, needed_num]( const connection_ptr& c ) {
+         if (!c->current() || c->last_handshake_recv.last_irreversible_block_num < needed_num) {
+            return false;
+         }
+         for (const auto& r : ranges) {
+            if (r.source == c) {
+               return false;
+            }
+         }
+         return true;
+      };
+      if (conn && available(conn)) {
+         return conn;
+      }
+      auto& conns = my_impl->connections;
+      auto cptr = conns.find(source);
+      if (cptr != conns.end()) {
+         ++cptr;
+      }
+      for (size_t i = 0; i < conns.size(); ++i, ++cptr) {
+         if (cptr == conns.end()) {
+            cptr = conns.begin();
+         }
+         if (available(*cptr)) {
+            return *cptr;
+         }
+      }
+      return connection_ptr();
+   }
+
+   bool sync_manager::release_range( connection_ptr c ) {
+      for (auto r = ranges.begin(); r != ranges.end(); ++r) {
+         if (r->source == c) {
+            // the blocks before sync_next_expected_num may have come from another peer meanwhile
+            uint32_t start = std::max(r->next, sync_next_expected_num);
+            if (start <= r->end) {
+               unassigned.emplace_front(start, r->end);
+            }
+            ranges.erase(r);
+            return true;
+         }
+      }
+      return false;
+   }
+
+   void sync_manager::reset_ranges() {
+      for (auto& r : ranges) {
+         if (r.source->current()) {
+            r.source->cancel_sync(benign_other);
+         }
+      }
+      ranges.clear();
+      unassigned.clear();
+      reorder_buffer.clear();
+      sync_last_requested_num = sync_next_expected_num - 1;
+   }
 
-      if (head_block < sync_last_requested_num) {
-         fc_ilog (logger, "ignoring request, head is ${h} last req = ${r}",
-                  ("h",head_block)("r",sync_last_requested_num));
+   void sync_manager::report_rates( bool force ) {
+      auto now = time_point::now();
+      auto elapsed = now - rate_start;
+      if (!force && elapsed < fc::seconds(def_sync_rate_interval)) {
          return;
       }
+      if (elapsed.count() > 0 && (rate_downloaded || rate_applied)) {
+         double secs = elapsed.count() / 1000000.0;
+         fc_ilog(logger, "sync downloaded ${d} blocks/s, applied ${a} blocks/s, next ${n} of ${l}, ${r} ranges in flight, ${b} blocks buffered",
+                 ("d", uint32_t(rate_downloaded / secs))("a", uint32_t(rate_applied / secs))
+                 ("n", sync_next_expected_num)("l", sync_known_lib_num)
+                 ("r", ranges.size())("b", reorder_buffer.size()));
+      }
+      rate_start = now;
+      rate_downloaded = 0;
+      rate_applied = 0;
+   }
 
+   void sync_manager::request_next_chunk( connection_ptr conn ) {
       /* ----------
+       * Up to sync_max_ranges ranges are fetched at once, each from a different peer, while the
+       * blocks already received are applied. Nothing is requested more than sync_max_ranges spans
+       * ahead of the next block to apply, which bounds the reorder buffer.
+       *
        * next chunk provider selection criteria
-       * 1. a provider is supplied, use it.
-       * 2. we only have 1 peer so use that.
-       * 3. we have multiple peers, select the next available from the list
+       * 1. a provider is supplied and has no range in flight, use it.
+       * 2. otherwise the next current peer after the last one used that has no range in
+       *    flight and whose last irreversible block covers the range.
        */
-
-      if (conn) {
-         source = conn;
-      }
-      else if (my_impl->connections.size() == 1) {
-         if (!source) {
-            source = *my_impl->connections.begin();
+      uint32_t window_end = sync_next_expected_num + sync_max_ranges * sync_req_span - 1;
+      while (ranges.size() < sync_max_ranges) {
+         bool retry = !unassigned.empty();
+         uint32_t start = retry ? unassigned.front().first : std::max(sync_last_requested_num + 1, sync_next_expected_num);
+         uint32_t end = retry ? unassigned.front().second : std::min(start + sync_req_span - 1, sync_known_lib_num);
+         if (!retry && (start > end || start > window_end)) {
+            break;
          }
-         if (!source->current()) {
-            source.reset();
+         connection_ptr c = next_range_source(conn, retry ? end : start);
+         conn.reset();
+         if (!c) {
+            break;
          }
-      }
-      else {
-         auto cptr = my_impl->connections.find(source);
-         if (cptr == my_impl->connections.end()) {
-            elog ("unable to find previous source connection in connections list");
-            source.reset();
-            cptr = my_impl->connections.begin();
-         } else {
-            ++cptr;
+         if (retry) {
+            unassigned.pop_front();
          }
-         while (my_impl->connections.size() > 1) {
-            if (cptr == my_impl->connections.end()) {
-               cptr = my_impl->connections.begin();
-               if (!source) {
-                  break;
-               }
-            }
-            if (*cptr == source) {
-               break;
-            }
-            if ((*cptr)->current()) {
-               source = *cptr;
-               break;
-            }
-            else {
-               ++cptr;
-            }
+         else {
+            end = std::min(end, c->last_handshake_recv.last_irreversible_block_num);
+            sync_last_requested_num = end;
          }
+         fc_dlog(logger, "conn ${n} requesting range ${s} to ${e}, calling sync_wait",
+                 ("n",c->peer_name())("s",start)("e",end));
+         ranges.push_back({start, end, start, c});
+         source = c;
+         c->request_sync_blocks(start, end);
       }
 
-      if (!source) {
+      if (ranges.empty() && reorder_buffer.empty() && sync_next_expected_num <= sync_known_lib_num) {
          elog("Unable to continue syncing at this time");
          sync_known_lib_num = chain_plug->chain().last_irreversible_block_num();
-         sync_last_requested_num = 0;
          set_state(in_sync); // probably not, but we can't do anything else
-         return;
-      }
-
-      if( sync_last_requested_num != sync_known_lib_num ) {
-         uint32_t start = sync_next_expected_num;
-         uint32_t end = start + sync_req_span - 1;
-         if( end > sync_known_lib_num )
-            end = sync_known_lib_num;
-         if( end > 0 && end >= start ) {
-            fc_dlog(logger, "conn ${n} requesting range ${s} to ${e}, calling sync_wait",
-                    ("n",source->peer_name())("s",start)("e",end));
-            source->request_sync_blocks(start, end);
-            sync_last_requested_num = end;
-         }
+         sync_last_requested_num = 0;
       }
    }
 
@@ -1311,6 +1608,10 @@ namespace eosio {
       if (state == in_sync) {
          set_state(lib_catchup);
          sync_next_expected_num = chain_plug->chain().last_irreversible_block_num() + 1;
+         sync_last_requested_num = sync_next_expected_num - 1;
+         rate_start = time_point::now();
+         rate_downloaded = 0;
+         rate_applied = 0;
       }
 
       fc_ilog(logger, "Catching up with chain, our last req is ${cc}, theirs is ${t} peer ${p}",
@@ -1323,9 +1624,8 @@ namespace eosio {
       fc_ilog(logger, "reassign_fetch, our last req is ${cc}, next expected is ${ne} peer ${p}",
               ( "cc",sync_last_requested_num)("ne",sync_next_expected_num)("p",c->peer_name()));
 
-      if (c == source) {
+      if (release_range(c)) {
          c->cancel_sync (reason);
-         sync_last_requested_num = 0;
          request_next_chunk();
       }
    }
@@ -1449,6 +1749,10 @@ namespace eosio {
    void sync_manager::recv_block (connection_ptr c, const block_id_type &blk_id, uint32_t blk_num, bool accepted) {
       fc_dlog(logger," got block ${bn} from ${p}",("bn",blk_num)("p",c->peer_name()));
       if (!accepted) {
+         if (state == lib_catchup && blk_num == sync_next_expected_num) {
+            // the blocks fetched after it are useless, fetch again from the failed one
+            reset_ranges();
+         }
          uint32_t head_num = chain_plug->chain().head_block_num();
          if (head_num != last_repeated) {
             ilog ("block not accepted, try requesting one more time");
@@ -1459,7 +1763,9 @@ namespace eosio {
             ilog ("second attempt to retrive block ${n} failed",
                   ("n", head_num + 1));
             last_repeated = 0;
-            sync_last_requested_num = 0;
+            if (state != lib_catchup) {
+               sync_last_requested_num = 0;
+            }
             my_impl->close(c);
          }
          return;
@@ -1472,6 +1778,7 @@ namespace eosio {
             return;
          }
          sync_next_expected_num = blk_num + 1;
+         ++rate_applied;
       }
       if (state == head_catchup) {
          fc_dlog (logger, "sync_manager in head_catchup state");
@@ -1498,20 +1805,70 @@ namespace eosio {
             set_state(in_sync);
             send_handshakes();
          }
-         else if (blk_num == sync_last_requested_num) {
+         else {
+            request_next_chunk();
+         }
+      }
+   }
+
+   bool sync_manager::recv_sync_block (connection_ptr c, const signed_block& blk) {
+      if (state != lib_catchup) {
+         return false;
+      }
+      uint32_t blk_num = blk.block_num();
+      ++rate_downloaded;
+      bool requested = false;
+      for (auto r = ranges.begin(); r != ranges.end(); ++r) {
+         if (r->source == c) {
+            requested = blk_num >= r->start && blk_num <= r->end;
+            if (requested && blk_num >= r->next) {
+               r->next = blk_num + 1;
+            }
+            if (r->next > r->end) {
+               ranges.erase(r);
+            }
+            else {
+               fc_dlog(logger,"calling sync_wait on connection ${p}",("p",c->peer_name()));
+               c->sync_wait();
+            }
+            break;
+         }
+      }
+
+      if (blk_num > sync_next_expected_num) {
+         // only the blocks of the range requested from their sender are buffered. The ranges in flight lie within
+         // the window request_next_chunk requests from, so the buffer stays bounded, and a block a peer was asked
+         // for replaces whatever another peer sent for that number before
+         if (requested) {
+            reorder_buffer[blk_num] = buffered_block{c, blk};
             request_next_chunk();
          }
          else {
-            fc_dlog(logger,"calling sync_wait on connection ${p}",("p",c->peer_name()));
-            c->sync_wait();
+            fc_dlog(logger, "dropping block ${n} from ${p}, it was not requested from that peer",("n",blk_num)("p",c->peer_name()));
          }
       }
+      else if (blk_num == sync_next_expected_num) {
+         my_impl->apply_block(c, blk);
+         while (state == lib_catchup && !reorder_buffer.empty() &&
+                reorder_buffer.begin()->first == sync_next_expected_num) {
+            buffered_block next = std::move(reorder_buffer.begin()->second);
+            reorder_buffer.erase(reorder_buffer.begin());
+            my_impl->apply_block(next.source, next.block);
+         }
+      }
+      else {
+         fc_dlog(logger, "block ${n} from ${p} was already applied",("n",blk_num)("p",c->peer_name()));
+      }
+      if (state == lib_catchup) {
+         report_rates(false);
+      }
+      return true;
    }
 
    //------------------------------------------------------------------------
 
-   void big_msg_manager::bcast_block (const signed_block_summary &bsum, connection_ptr skip) {
-      net_message msg(bsum);
+   void big_msg_manager::bcast_block (const signed_block &bsum, connection_ptr skip) {
+      net_message msg(static_cast<const signed_block_summary&>(bsum));
       uint32_t packsiz = fc::raw::pack_size(msg);
       uint32_t msgsiz = packsiz + sizeof(packsiz);
       notice_message pending_notify;
@@ -1538,6 +1895,10 @@ namespace eosio {
             });
       }
       else {
+         // each message is packed once, for the first connection it is sent to
+         send_buffer_type notify_buffer;
+         send_buffer_type summary_buffer;
+         send_buffer_type compact_buffer;
          for (auto cp : my_impl->connections) {
             if (cp == skip || !cp->current()) {
                continue;
@@ -1545,11 +1906,13 @@ namespace eosio {
             const auto& prev = cp->blk_state.find (bsum.previous);
             if (prev != cp->blk_state.end() && !prev->is_known) {
                cp->blk_state.insert((block_state){bid,bnum,false,true,time_point()});
-               cp->enqueue( pending_notify );
+               if (!notify_buffer)
+                  notify_buffer = create_send_buffer( pending_notify );
+               cp->enqueue_buffer( notify_buffer );
             }
             else {
                cp->blk_state.insert((block_state){bid,bnum,true,true,time_point()});
-               cp->enqueue( bsum );
+               cp->enqueue_buffer( block_relay_buffer( cp, bsum, summary_buffer, compact_buffer ) );
             }
          }
       }
@@ -1579,25 +1942,17 @@ namespace eosio {
          fc_dlog(logger, "found txnid in local_txns" );
          return;
       }
-      uint32_t packsiz = 0;
-      uint32_t bufsiz = 0;
-
-      net_message msg(txn);
-      packsiz = fc::raw::pack_size(msg);
-      bufsiz = packsiz + sizeof(packsiz);
-      vector<char> buff(bufsiz);
-      fc::datastream<char*> ds( buff.data(), bufsiz);
-      ds.write( reinterpret_cast<char*>(&packsiz), sizeof(packsiz) );
-      fc::raw::pack( ds, msg );
+      // the same buffer is kept for peers that request the transaction later
+      send_buffer_type send_buffer = create_send_buffer( net_message(txn) );
       node_transaction_state nts = {txnid,
                                     expiration,
                                     txn,
-                                    std::move(buff),
+                                    send_buffer,
                                     0, 0, 0};
       my_impl->local_txns.insert(std::move(nts));
 
-      if(bufsiz <= just_send_it_max) {
-         my_impl->send_all( txn, [skip, txnid](connection_ptr c) -> bool {
+      if(send_buffer->size() <= just_send_it_max) {
+         my_impl->send_all( send_buffer, [skip, txnid](connection_ptr c) -> bool {
                if(c == skip || c->syncing ) {
                   return false;
                }
@@ -1631,7 +1986,7 @@ namespace eosio {
 
    }
 
-   void big_msg_manager::recv_block (connection_ptr c, const signed_block_summary& msg) {
+   void big_msg_manager::recv_block (connection_ptr c, const signed_block& msg) {
       block_id_type blk_id = msg.id();
       uint32_t num = msg.block_num();
       const auto& blkstate = c->blk_state.get<by_id>().find(blk_id);
@@ -1672,27 +2027,34 @@ namespace eosio {
 
       if( !my_impl->sync_master->is_active(c) ) {
          fc_dlog(logger,"got a block to forward");
-         net_message nmsg(msg);
+         net_message nmsg(static_cast<const signed_block_summary&>(msg));
          if(fc::raw::pack_size(nmsg) < just_send_it_max ) {
             fc_dlog(logger, "forwarding the signed block");
-            my_impl->send_all( msg, [c, blk_id, num](connection_ptr conn) -> bool {
-                  bool sendit = false;
-                  if( c != conn && !conn->syncing ) {
-                     auto b = conn->blk_state.get<by_id>().find(blk_id);
-                     if(b == conn->blk_state.end()) {
-                        conn->blk_state.insert({blk_id,num,true,true,fc::time_point()});
-                        sendit = true;
-                     } else if (!b->is_known) {
-                        conn->blk_state.modify(b,set_is_known);
-                        sendit = true;
-                     }
+            send_buffer_type summary_buffer;
+            send_buffer_type compact_buffer;
+            for (auto conn : my_impl->connections) {
+               if (!conn->current()) {
+                  continue;
+               }
+               bool sendit = false;
+               if( c != conn && !conn->syncing ) {
+                  auto b = conn->blk_state.get<by_id>().find(blk_id);
+                  if(b == conn->blk_state.end()) {
+                     conn->blk_state.insert({blk_id,num,true,true,fc::time_point()});
+                     sendit = true;
+                  } else if (!b->is_known) {
+                     conn->blk_state.modify(b,set_is_known);
+                     sendit = true;
                   }
-                  fc_dlog(logger, "${action} block ${num} to ${c}",
-                          ("action", sendit ? "sending" : "skipping")
-                          ("num",num)
-                          ("c", conn->peer_name() ));
-                  return sendit;
-               });
+               }
+               fc_dlog(logger, "${action} block ${num} to ${c}",
+                       ("action", sendit ? "sending" : "skipping")
+                       ("num",num)
+                       ("c", conn->peer_name() ));
+               if (sendit) {
+                  conn->enqueue_buffer( block_relay_buffer( conn, msg, summary_buffer, compact_buffer ) );
+               }
+            }
          }
          else {
             notice_message note;
@@ -1879,44 +2241,49 @@ namespace eosio {
       auto current_endpoint = *endpoint_itr;
       ++endpoint_itr;
       c->connecting = true;
-      c->socket->async_connect( current_endpoint, [c, endpoint_itr, this] ( const boost::system::error_code& err ) {
-            if( !err ) {
-               start_session( c );
-               c->send_handshake ();
-            } else {
-               if( endpoint_itr != tcp::resolver::iterator() ) {
-                  close(c);
-                  connect( c, endpoint_itr );
-               }
-               else {
-                  elog( "connection failed to ${peer}: ${error}",
-                        ( "peer", c->peer_name())("error",err.message()));
-                  c->connecting = false;
-                  my_impl->close(c);
+      // connected on the net threads, the result is handled on the main thread
+      boost::asio::post( c->strand, [c, current_endpoint, endpoint_itr, this]() {
+         c->socket->async_connect( current_endpoint, [c, endpoint_itr, this] ( const boost::system::error_code& err ) {
+            app().get_io_service().post( [c, endpoint_itr, this, err]() {
+               if( !err ) {
+                  start_session( c );
+                  c->send_handshake ();
+               } else {
+                  if( endpoint_itr != tcp::resolver::iterator() ) {
+                     close(c);
+                     connect( c, endpoint_itr );
+                  }
+                  else {
+                     elog( "connection failed to ${peer}: ${error}",
+                           ( "peer", c->peer_name())("error",err.message()));
+                     c->connecting = false;
+                     my_impl->close(c);
+                  }
                }
-            }
+            } );
          } );
+      } );
    }
 
    void net_plugin_impl::start_session( connection_ptr con ) {
-      boost::asio::ip::tcp::no_delay nodelay( true );
-      con->socket->set_option( nodelay );
+      con->socket_open = true;
+      ++con->session;
+      boost::asio::post( con->strand, [con]() {
+         boost::system::error_code ec;
+         con->socket->set_option( boost::asio::ip::tcp::no_delay( true ), ec );
+      });
       start_read_message( con );
       ++started_sessions;
-
-      // for now, we can just use the application main loop.
-      //     con->readloop_complete  = bf::async( [=](){ read_loop( con ); } );
-      //     con->writeloop_complete = bf::async( [=](){ write_loop con ); } );
    }
 
 
    void net_plugin_impl::start_listen_loop( ) {
-      auto socket = std::make_shared<tcp::socket>( std::ref( app().get_io_service() ) );
+      auto socket = std::make_shared<tcp::socket>( std::ref( net_ioc ) );
       acceptor->async_accept( *socket, [socket,this]( boost::system::error_code ec ) {
             if( !ec ) {
                uint32_t visitors = 0;
                for (auto &conn : connections) {
-                  if(conn->socket->is_open() && conn->peer_addr.empty()) {
+                  if(conn->socket_open && conn->peer_addr.empty()) {
                      visitors++;
                   }
                }
@@ -1942,14 +2309,24 @@ namespace eosio {
    }
 
    void net_plugin_impl::start_read_message( connection_ptr conn ) {
+      if(!conn->socket) {
+         return;
+      }
+      uint32_t session = conn->session;
+      boost::asio::post( conn->strand, [this, conn, session]() {
+         conn->read_session = session;
+         conn->pending_read_batches = 0;
+         conn->read_paused = false;
+         read_message( conn );
+      });
+   }
 
+   void net_plugin_impl::read_message( connection_ptr conn ) {
+      uint32_t session = conn->read_session;
       try {
-         if(!conn->socket) {
-            return;
-         }
          conn->socket->async_read_some
             (conn->pending_message_buffer.get_buffer_sequence_for_boost_async_read(),
-             [this,conn]( boost::system::error_code ec, std::size_t bytes_transferred ) {
+             boost::asio::bind_executor( conn->strand, [this,conn,session]( boost::system::error_code ec, std::size_t bytes_transferred ) {
                try {
                   if( !ec ) {
                      if (bytes_transferred > conn->pending_message_buffer.bytes_to_write()) {
@@ -1958,6 +2335,7 @@ namespace eosio {
                      }
                      FC_ASSERT(bytes_transferred <= conn->pending_message_buffer.bytes_to_write());
                      conn->pending_message_buffer.advance_write_ptr(bytes_transferred);
+                     auto msgs = std::make_shared<vector<net_message>>();
                      while (conn->pending_message_buffer.bytes_to_read() > 0) {
                         uint32_t bytes_in_buffer = conn->pending_message_buffer.bytes_to_read();
 
@@ -1967,14 +2345,19 @@ namespace eosio {
                            uint32_t message_length;
                            auto index = conn->pending_message_buffer.read_index();
                            conn->pending_message_buffer.peek(&message_length, sizeof(message_length), index);
+                           bool compressed = message_length & message_compressed_flag;
+                           message_length &= ~message_compressed_flag;
                            if(message_length > def_send_buffer_size*2) {
-                              elog("incoming message length unexpected (${i})", ("i", message_length));
-                              close(conn);
+                              close_from_net_thread(conn, session, "incoming message length unexpected (" + std::to_string(message_length) + ")");
                               return;
                            }
                            if (bytes_in_buffer >= message_length + message_header_size) {
                               conn->pending_message_buffer.advance_read_ptr(message_header_size);
-                              if (!conn->process_next_message(*this, message_length)) {
+                              msgs->emplace_back();
+                              bool unpacked = compressed ? conn->unpack_compressed_message(message_length, msgs->back())
+                                                         : conn->unpack_next_message(message_length, msgs->back());
+                              if (!unpacked) {
+                                 close_from_net_thread(conn, session, "failed to unpack a message");
                                  return;
                               }
                            } else {
@@ -1983,45 +2366,87 @@ namespace eosio {
                            }
                         }
                      }
-                     start_read_message(conn);
-                  } else {
-                     auto pname = conn->peer_name();
+                     if (!msgs->empty()) {
+                        ++conn->pending_read_batches;
+                        app().get_io_service().post([this, conn, session, msgs]() {
+                           handle_messages(conn, session, *msgs);
+                        });
+                     }
+                     // keep reading while the main thread handles the messages, unless it falls behind
+                     if (conn->pending_read_batches < def_max_read_batches) {
+                        read_message(conn);
+                     } else {
+                        conn->read_paused = true;
+                     }
+                  } else if (ec != boost::asio::error::operation_aborted) {
                      if (ec.value() != boost::asio::error::eof) {
-                        elog( "Error reading message from ${p}: ${m}",("p",pname)( "m", ec.message() ) );
+                        close_from_net_thread(conn, session, "Error reading message: " + ec.message());
                      } else {
-                        ilog( "Peer ${p} closed connection",("p",pname) );
+                        close_from_net_thread(conn, session, string());
                      }
-                     close( conn );
                   }
                }
                catch(const std::exception &ex) {
-                  string pname = conn ? conn->peer_name() : "no connection name";
-                  elog("Exception in handling read data from ${p} ${s}",("p",pname)("s",ex.what()));
-                  close( conn );
+                  close_from_net_thread(conn, session, string("Exception in handling read data: ") + ex.what());
                }
                catch(const fc::exception &ex) {
-                  string pname = conn ? conn->peer_name() : "no connection name";
-                  elog("Exception in handling read data ${s}", ("p",pname)("s",ex.to_string()));
-                  close( conn );
+                  close_from_net_thread(conn, session, "Exception in handling read data: " + ex.to_string());
                }
                catch (...) {
-                  string pname = conn ? conn->peer_name() : "no connection name";
-                  elog( "Undefined exception hanlding the read data from connection ${p}",( "p",pname));
-                  close( conn );
+                  close_from_net_thread(conn, session, "Undefined exception handling the read data");
                }
-            } );
+            } ));
       } catch (...) {
-         string pname = conn ? conn->peer_name() : "no connection name";
-         elog( "Undefined exception handling reading ${p}",("p",pname) );
-         close( conn );
+         close_from_net_thread(conn, session, "Undefined exception handling reading");
       }
    }
 
+   void net_plugin_impl::handle_messages( connection_ptr conn, uint32_t session, const vector<net_message>& msgs ) {
+      // messages read before the connection was closed are dropped
+      if (conn->session != session || !conn->socket_open) {
+         return;
+      }
+      // keys of all the transactions read are recovered on the chain thread pool while the
+      // messages are handled one by one, instead of each in turn when it is pushed
+      for (const auto& msg : msgs) {
+         start_signature_recovery(msg);
+      }
+      for (const auto& msg : msgs) {
+         if (!conn->process_message(*this, msg)) {
+            return;
+         }
+      }
+      boost::asio::post(conn->strand, [this, conn, session]() {
+         if (conn->read_session != session) {
+            return;
+         }
+         --conn->pending_read_batches;
+         if (conn->read_paused) {
+            conn->read_paused = false;
+            read_message(conn);
+         }
+      });
+   }
+
+   void net_plugin_impl::close_from_net_thread( connection_ptr conn, uint32_t session, const string& reason ) {
+      app().get_io_service().post([this, conn, session, reason]() {
+         if (conn->session != session || !conn->socket_open) {
+            return;
+         }
+         if (reason.empty()) {
+            ilog( "Peer ${p} closed connection",("p",conn->peer_name()) );
+         } else {
+            elog( "${r}, closing connection to ${p}",("r",reason)("p",conn->peer_name()) );
+         }
+         close( conn );
+      });
+   }
+
    size_t net_plugin_impl::count_open_sockets() const
    {
       size_t count = 0;
       for( auto &c : connections) {
-         if(c->socket->is_open())
+         if(c->socket_open)
             ++count;
       }
       return count;
@@ -2030,9 +2455,22 @@ namespace eosio {
 
    template<typename VerifierFunc>
    void net_plugin_impl::send_all( const net_message &msg, VerifierFunc verify) {
+      send_buffer_type send_buffer;
+      for( auto &c : connections) {
+         if( c->current() && verify( c)) {
+            if( !send_buffer ) {
+               send_buffer = create_send_buffer( msg );
+            }
+            c->enqueue_buffer( send_buffer );
+         }
+      }
+   }
+
+   template<typename VerifierFunc>
+   void net_plugin_impl::send_all( const send_buffer_type& send_buffer, VerifierFunc verify) {
       for( auto &c : connections) {
          if( c->current() && verify( c)) {
-            c->enqueue( msg );
+            c->enqueue_buffer( send_buffer );
          }
       }
    }
@@ -2114,6 +2552,7 @@ namespace eosio {
             return;
          }
          c->protocol_version = to_protocol_version(msg.network_version);
+         c->compress_sends = p2p_compression && c->protocol_version >= proto_stream_compression;
          if(c->protocol_version != net_version) {
             if (network_version_match) {
                elog("Peer network version does not match expected ${nv} but got ${mnv}",
@@ -2319,6 +2758,22 @@ namespace eosio {
       }
    }
 
+   void net_plugin_impl::start_signature_recovery( const net_message& msg) {
+      if( chain_plug->is_skipping_transaction_signatures()) {
+         return;
+      }
+      chain_controller &cc = chain_plug->chain();
+      if( msg.contains<packed_transaction>()) {
+         cc.recover_signing_keys( msg.get<packed_transaction>());
+      } else if( msg.contains<signed_block>()) {
+         cc.recover_signing_keys( msg.get<signed_block>());
+      } else if( msg.contains<compact_block_transactions>()) {
+         for( const auto& t : msg.get<compact_block_transactions>().transactions ) {
+            cc.recover_signing_keys( t );
+         }
+      }
+   }
+
    void net_plugin_impl::handle_message( connection_ptr c, const packed_transaction &msg) {
       fc_dlog(logger, "got a packed transaction from ${p}, cancel wait", ("p",c->peer_name()));
       if( sync_master->is_active(c) ) {
@@ -2419,6 +2874,12 @@ namespace eosio {
          }
       }
 
+      accept_relayed_block(c, sb);
+   }
+
+   void net_plugin_impl::accept_relayed_block( connection_ptr c, const signed_block &sb) {
+      block_id_type blk_id = sb.id();
+      uint32_t blk_num = sb.block_num();
       bool accepted = false;
       try {
          chain_plug->accept_block(sb, sync_master->is_active(c));
@@ -2443,18 +2904,136 @@ namespace eosio {
       pending_notify.known_trx.mode = none;
       big_msg_master->recv_notice (c, pending_notify, true);
 #endif
-      big_msg_master->recv_block(c, msg);
+      big_msg_master->recv_block(c, sb);
       sync_master->recv_block(c, blk_id, blk_num, accepted);
+   }
+
+   void net_plugin_impl::handle_message( connection_ptr c, const compact_block_message &msg) {
+      chain_controller &cc = chain_plug->chain();
+      block_id_type blk_id = msg.block.id();
+      uint32_t blk_num = msg.block.block_num();
+      c->cancel_wait();
+      c->pending_compact.reset();
+
+      try {
+         if( cc.is_known_block(blk_id)) {
+            sync_master->recv_block(c, blk_id, blk_num, true);
+            return;
+         }
+      } catch( ...) {
+         elog("Caught an unknown exception trying to recall blockID");
+      }
+
+      fc::microseconds age( fc::time_point::now() - msg.block.timestamp);
+      fc_dlog(logger, "got compact block #${n} with ${t} input transactions from ${p} block age in secs = ${age}",
+              ("n",blk_num)("t",msg.input_ids.size())("p",c->peer_name())("age",age.to_seconds()));
+
+      // the short ids are resolved through the receipts, an id shared by two receipts is requested
+      map<uint64_t, optional<transaction_id_type>> receipt_ids;
+      for (const auto &region : msg.block.regions) {
+         for (const auto &cycle_sum : region.cycles_summary) {
+            for (const auto &shard : cycle_sum) {
+               for (const auto &recpt : shard.transactions) {
+                  auto r = receipt_ids.emplace(short_txn_id(recpt.id), recpt.id);
+                  if (!r.second && r.first->second && *r.first->second != recpt.id) {
+                     r.first->second.reset();
+                  }
+               }
+            }
+         }
+      }
+
+      pending_compact_block pcb{signed_block(msg.block), msg.input_ids, {}};
+      pcb.block.input_transactions.resize(msg.input_ids.size());
+      update_block_num ubn(blk_num);
+      for (uint32_t i = 0; i < msg.input_ids.size(); ++i) {
+         auto rid = receipt_ids.find(msg.input_ids[i]);
+         if (rid != receipt_ids.end() && rid->second) {
+            auto ltx = local_txns.get<by_id>().find(*rid->second);
+            if (ltx != local_txns.end()) {
+               pcb.block.input_transactions[i] = ltx->packed_txn;
+               local_txns.modify( ltx, ubn );
+               continue;
+            }
+         }
+         pcb.missing.push_back(i);
+      }
+
+      if (pcb.missing.empty()) {
+         accept_relayed_block(c, pcb.block);
+         return;
+      }
+      fc_dlog(logger, "requesting ${m} of ${t} input transactions of block #${n} from ${p}",
+              ("m",pcb.missing.size())("t",msg.input_ids.size())("n",blk_num)("p",c->peer_name()));
+      c->enqueue(compact_block_request{blk_id, pcb.missing});
+      c->pending_compact = std::move(pcb);
+      c->fetch_wait();
+   }
+
+   void net_plugin_impl::handle_message( connection_ptr c, const compact_block_request &msg) {
+      compact_block_transactions reply;
+      reply.block_id = msg.block_id;
+      try {
+         optional<signed_block> b = chain_plug->chain().fetch_block_by_id(msg.block_id);
+         if (b) {
+            for (auto i : msg.indexes) {
+               if (i < b->input_transactions.size()) {
+                  reply.indexes.push_back(i);
+                  reply.transactions.push_back(b->input_transactions[i]);
+               }
+            }
+         }
+         else {
+            fc_dlog(logger, "no block ${id} for the compact block request of ${p}", ("id",msg.block_id)("p",c->peer_name()));
+         }
+      } catch (const fc::exception &ex) {
+         elog( "unable to fetch block ${id} for ${p}: ${e}", ("id",msg.block_id)("p",c->peer_name())("e",ex.to_string()));
+      }
+      // an empty reply tells the peer to give up on the block
+      c->enqueue(reply);
+   }
+
+   void net_plugin_impl::handle_message( connection_ptr c, const compact_block_transactions &msg) {
+      c->cancel_wait();
+      if (!c->pending_compact || c->pending_compact->block.id() != msg.block_id) {
+         fc_dlog(logger, "dropping unexpected compact block transactions from ${p}", ("p",c->peer_name()));
+         return;
+      }
+      pending_compact_block pcb = std::move(*c->pending_compact);
+      c->pending_compact.reset();
 
+      uint32_t blk_num = pcb.block.block_num();
+      set<uint32_t> missing(pcb.missing.begin(), pcb.missing.end());
+      for (size_t i = 0; i < msg.indexes.size() && i < msg.transactions.size(); ++i) {
+         uint32_t idx = msg.indexes[i];
+         const auto &trx = msg.transactions[i];
+         if (missing.count(idx) && short_txn_id(trx.id()) == pcb.input_ids[idx]) {
+            pcb.block.input_transactions[idx] = trx;
+            missing.erase(idx);
+         }
+      }
+      if (!missing.empty()) {
+         elog("${p} did not send ${m} input transactions of block #${n}, waiting for it to sync",
+              ("p",c->peer_name())("m",missing.size())("n",blk_num));
+         return;
+      }
+      accept_relayed_block(c, pcb.block);
    }
 
    void net_plugin_impl::handle_message( connection_ptr c, const signed_block &msg) {
       // should only be during synch or rolling upgrade
+      fc_dlog(logger, "canceling wait on ${p}", ("p",c->peer_name()));
+      c->cancel_wait();
+      if( sync_master->recv_sync_block(c, msg)) {
+         return;
+      }
+      apply_block(c, msg);
+   }
+
+   void net_plugin_impl::apply_block( connection_ptr c, const signed_block &msg) {
       chain_controller &cc = chain_plug->chain();
       block_id_type blk_id = msg.id();
       uint32_t blk_num = msg.block_num();
-      fc_dlog(logger, "canceling wait on ${p}", ("p",c->peer_name()));
-      c->cancel_wait();
 
       try {
          if( cc.is_known_block(blk_id)) {
@@ -2545,7 +3124,7 @@ namespace eosio {
                wlog ("Peer keepalive ticked sooner than expected: ${m}", ("m", ec.message()));
             }
             for (auto &c : connections ) {
-               if (c->socket->is_open()) {
+               if (c->socket_open) {
                   c->send_time();
                }
             }
@@ -2583,7 +3162,7 @@ namespace eosio {
       vector <connection_ptr> discards;
       num_clients = 0;
       for( auto &c : connections ) {
-         if( !c->socket->is_open() && !c->connecting) {
+         if( !c->socket_open && !c->connecting) {
             if( c->peer_addr.length() > 0) {
                connect(c);
             }
@@ -2591,7 +3170,7 @@ namespace eosio {
                discards.push_back( c);
             }
          } else {
-            if( c->socket->is_open() && c->peer_addr.empty()) {
+            if( c->socket_open && c->peer_addr.empty()) {
                num_clients++;
             }
          }
@@ -2605,7 +3184,7 @@ namespace eosio {
    }
 
    void net_plugin_impl::close( connection_ptr c ) {
-      if( c->peer_addr.empty( ) && c->socket->is_open() ) {
+      if( c->peer_addr.empty( ) && c->socket_open ) {
          if (num_clients == 0) {
             fc_wlog( logger, "num_clients already at 0");
          }
@@ -2784,7 +3363,11 @@ namespace eosio {
          ( "network-version-match", bpo::value<bool>()->default_value(false),
            "True to require exact match of peer network version.")
          ( "sync-fetch-span", bpo::value<uint32_t>()->default_value(def_sync_fetch_span), "number of blocks to retrieve in a chunk from any individual peer during synchronization")
+         ( "sync-fetch-ranges", bpo::value<uint32_t>()->default_value(def_sync_fetch_ranges), "number of chunks retrieved at once from different peers during synchronization")
          ( "max-implicit-request", bpo::value<uint32_t>()->default_value(def_max_just_send), "maximum sizes of transaction or block messages that are sent without first sending a notice")
+         ( "net-threads", bpo::value<uint16_t>()->default_value(def_net_threads), "number of threads that read and unpack the messages of peers, which are handled on the main thread")
+         ( "p2p-compression", bpo::value<string>()->default_value("none"),
+           "Compression of the messages sent to peers that support it, with a zlib stream kept per connection. Can be 'none' or 'zlib'.")
          ;
    }
 
@@ -2797,8 +3380,13 @@ namespace eosio {
       ilog("Initialize net plugin");
 
       my->network_version_match = options.at("network-version-match").as<bool>();
+      const string compression = options.at("p2p-compression").as<string>();
+      FC_ASSERT( compression == "none" || compression == "zlib", "unknown p2p-compression ${c}", ("c", compression) );
+      my->p2p_compression = compression == "zlib";
 
-      my->sync_master.reset( new sync_manager(options.at("sync-fetch-span").as<uint32_t>() ) );
+      uint32_t sync_fetch_ranges = options.at("sync-fetch-ranges").as<uint32_t>();
+      FC_ASSERT( sync_fetch_ranges > 0, "sync-fetch-ranges must be at least 1" );
+      my->sync_master.reset( new sync_manager(options.at("sync-fetch-span").as<uint32_t>(), sync_fetch_ranges ) );
       my->big_msg_master.reset( new big_msg_manager );
 
       my->connector_period = std::chrono::seconds(options.at("connection-cleanup-period").as<int>());
@@ -2806,6 +3394,8 @@ namespace eosio {
       my->resp_expected_period = def_resp_expected_wait;
       my->big_msg_master->just_send_it_max = options.at("max-implicit-request").as<uint32_t>();
       my->max_client_count = options.at("max-clients").as<int>();
+      my->net_thread_count = options.at("net-threads").as<uint16_t>();
+      FC_ASSERT( my->net_thread_count > 0, "net-threads must be at least 1" );
 
       my->num_clients = 0;
       my->started_sessions = 0;
@@ -2894,6 +3484,15 @@ namespace eosio {
    }
 
    void net_plugin::plugin_startup() {
+      my->net_work.reset( new boost::asio::executor_work_guard<boost::asio::io_context::executor_type>( my->net_ioc.get_executor() ) );
+      for( uint16_t i = 0; i < my->net_thread_count; ++i ) {
+         my->net_threads.emplace_back( [ioc = &my->net_ioc]() {
+            try {
+               ioc->run();
+            } FC_LOG_AND_DROP()
+         });
+      }
+
       if( my->acceptor ) {
          my->acceptor->open(my->listen_endpoint.protocol());
          my->acceptor->set_option(tcp::acceptor::reuse_address(true));
@@ -2930,6 +3529,14 @@ namespace eosio {
 
             my->acceptor.reset(nullptr);
          }
+
+         ilog( "stop ${n} net threads",( "n",my->net_threads.size()) );
+         my->net_work.reset();
+         my->net_ioc.stop();
+         for( auto& t : my->net_threads ) {
+            t.join();
+         }
+         my->net_threads.clear();
          ilog( "exit shutdown" );
       }
       FC_CAPTURE_AND_RETHROW()
@@ -5,6 +5,7 @@
 #pragma once
 #include <appbase/application.hpp>
 #include <eosio/http_plugin/http_plugin.hpp>
+#include <eosio/chain_plugin/chain_plugin.hpp>
 
 namespace eosio {
 
@@ -15,7 +16,7 @@ public:
    txn_test_gen_plugin();
    ~txn_test_gen_plugin();
 
-   APPBASE_PLUGIN_REQUIRES((http_plugin))
+   APPBASE_PLUGIN_REQUIRES((http_plugin)(chain_plugin))
    virtual void set_program_options(options_description&, options_description& cfg) override;
  
    void plugin_initialize(const variables_map& options);
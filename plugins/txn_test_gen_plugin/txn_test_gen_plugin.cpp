@@ -28,9 +28,22 @@
 
 namespace eosio { namespace detail {
   struct txn_test_gen_empty {};
+
+  struct txn_test_gen_stats {
+     uint64_t elapsed_ms              = 0;
+     uint64_t pushed_transactions     = 0;
+     uint32_t blocks                  = 0;
+     uint64_t block_transactions      = 0;
+     uint64_t cycles                  = 0;
+     uint64_t shards                  = 0;
+     double   transactions_per_second = 0;
+     double   shards_per_cycle        = 0;
+  };
 }}
 
 FC_REFLECT(eosio::detail::txn_test_gen_empty, );
+FC_REFLECT(eosio::detail::txn_test_gen_stats, (elapsed_ms)(pushed_transactions)(blocks)(block_transactions)(cycles)(shards)
+                                              (transactions_per_second)(shards_per_cycle));
 
 namespace eosio {
 
@@ -70,7 +83,18 @@ using namespace eosio::chain;
      api_handle->call_name(); \
      eosio::detail::txn_test_gen_empty result;
 
+#define INVOKE_R_V(api_handle, call_name) \
+     auto result = api_handle->call_name();
+
 struct txn_test_gen_plugin_impl {
+   /// the accounts of the i-th pair, each pair only transfers between its own two accounts
+   static name pair_account(char side, uint16_t i) {
+      std::string n = std::string("txn.test.") + side;
+      if(i > 0)
+         n += char('0' + i);
+      return name(n);
+   }
+
    void create_test_accounts(const std::string& init_name, const std::string& init_priv_key) {
       name newaccountA("txn.test.a");
       name newaccountB("txn.test.b");
@@ -120,6 +144,14 @@ struct txn_test_gen_plugin_impl {
 
          trx.actions.emplace_back(vector<chain::permission_level>{{creator,"active"}}, contracts::newaccount{creator, newaccountC, owner_auth, active_auth, recovery_auth});
          }
+         //create the accounts of the additional pairs with the "A" and "B" keys
+         for(uint16_t i = 1; i < pairs; ++i) {
+            auto recovery_auth = eosio::chain::authority{1, {}, {{{creator, "active"}, 1}}};
+            auto a_auth = eosio::chain::authority{1, {{txn_text_receiver_A_pub_key, 1}}, {}};
+            auto b_auth = eosio::chain::authority{1, {{txn_text_receiver_B_pub_key, 1}}, {}};
+            trx.actions.emplace_back(vector<chain::permission_level>{{creator,"active"}}, contracts::newaccount{creator, pair_account('a', i), a_auth, a_auth, recovery_auth});
+            trx.actions.emplace_back(vector<chain::permission_level>{{creator,"active"}}, contracts::newaccount{creator, pair_account('b', i), b_auth, b_auth, recovery_auth});
+         }
 
          trx.expiration = cc.head_block_time() + fc::seconds(30);
          trx.set_reference_block(cc.head_block_id());
@@ -161,24 +193,18 @@ struct txn_test_gen_plugin_impl {
             act.account = N(eosio.token);
             act.name = N(issue);
             act.authorization = vector<permission_level>{{newaccountC,config::active_name}};
-            act.data = eosio_token_serializer.variant_to_binary("issue", fc::json::from_string("{\"to\":\"eosio.token\",\"quantity\":\"600.0000 CUR\",\"memo\":\"\"}"));
-            trx.actions.push_back(act);
-         }
-         {
-            action act;
-            act.account = N(eosio.token);
-            act.name = N(transfer);
-            act.authorization = vector<permission_level>{{newaccountC,config::active_name}};
-            act.data = eosio_token_serializer.variant_to_binary("transfer", fc::json::from_string("{\"from\":\"eosio.token\",\"to\":\"txn.test.a\",\"quantity\":\"200.0000 CUR\",\"memo\":\"\"}"));
+            act.data = eosio_token_serializer.variant_to_binary("issue", fc::json::from_string(fc::format_string("{\"to\":\"eosio.token\",\"quantity\":\"${q}.0000 CUR\",\"memo\":\"\"}", fc::mutable_variant_object()("q", 200 + 400 * pairs))));
             trx.actions.push_back(act);
          }
-         {
-            action act;
-            act.account = N(eosio.token);
-            act.name = N(transfer);
-            act.authorization = vector<permission_level>{{newaccountC,config::active_name}};
-            act.data = eosio_token_serializer.variant_to_binary("transfer", fc::json::from_string("{\"from\":\"eosio.token\",\"to\":\"txn.test.b\",\"quantity\":\"200.0000 CUR\",\"memo\":\"\"}"));
-            trx.actions.push_back(act);
+         for(uint16_t i = 0; i < pairs; ++i) {
+            for(char side : {'a', 'b'}) {
+               action act;
+               act.account = N(eosio.token);
+               act.name = N(transfer);
+               act.authorization = vector<permission_level>{{newaccountC,config::active_name}};
+               act.data = eosio_token_serializer.variant_to_binary("transfer", fc::json::from_string(fc::format_string("{\"from\":\"eosio.token\",\"to\":\"${to}\",\"quantity\":\"200.0000 CUR\",\"memo\":\"\"}", fc::mutable_variant_object()("to", pair_account(side, i)))));
+               trx.actions.push_back(act);
+            }
          }
 
          trx.expiration = cc.head_block_time() + fc::seconds(30);
@@ -201,16 +227,30 @@ struct txn_test_gen_plugin_impl {
 
       running = true;
 
-      //create the actions here
-      act_a_to_b.account = N(eosio.token);
-      act_a_to_b.name = N(transfer);
-      act_a_to_b.authorization = vector<permission_level>{{name("txn.test.a"),config::active_name}};
-      act_a_to_b.data = eosio_token_serializer.variant_to_binary("transfer", fc::json::from_string(fc::format_string("{\"from\":\"txn.test.a\",\"to\":\"txn.test.b\",\"quantity\":\"1.0000 CUR\",\"memo\":\"${l}\"}", fc::mutable_variant_object()("l", salt))));
+      //create the actions here, one pair of transfers for every pair of accounts
+      acts_a_to_b.clear();
+      acts_b_to_a.clear();
+      for(uint16_t i = 0; i < pairs; ++i) {
+         name a = pair_account('a', i);
+         name b = pair_account('b', i);
+
+         action act_a_to_b;
+         act_a_to_b.account = N(eosio.token);
+         act_a_to_b.name = N(transfer);
+         act_a_to_b.authorization = vector<permission_level>{{a,config::active_name}};
+         act_a_to_b.data = eosio_token_serializer.variant_to_binary("transfer", fc::json::from_string(fc::format_string("{\"from\":\"${a}\",\"to\":\"${b}\",\"quantity\":\"1.0000 CUR\",\"memo\":\"${l}\"}", fc::mutable_variant_object()("a", a)("b", b)("l", salt))));
+         acts_a_to_b.push_back(act_a_to_b);
+
+         action act_b_to_a;
+         act_b_to_a.account = N(eosio.token);
+         act_b_to_a.name = N(transfer);
+         act_b_to_a.authorization = vector<permission_level>{{b,config::active_name}};
+         act_b_to_a.data = eosio_token_serializer.variant_to_binary("transfer", fc::json::from_string(fc::format_string("{\"from\":\"${b}\",\"to\":\"${a}\",\"quantity\":\"1.0000 CUR\",\"memo\":\"${l}\"}", fc::mutable_variant_object()("a", a)("b", b)("l", salt))));
+         acts_b_to_a.push_back(act_b_to_a);
+      }
 
-      act_b_to_a.account = N(eosio.token);
-      act_b_to_a.name = N(transfer);
-      act_b_to_a.authorization = vector<permission_level>{{name("txn.test.b"),config::active_name}};
-      act_b_to_a.data = eosio_token_serializer.variant_to_binary("transfer", fc::json::from_string(fc::format_string("{\"from\":\"txn.test.b\",\"to\":\"txn.test.a\",\"quantity\":\"1.0000 CUR\",\"memo\":\"${l}\"}", fc::mutable_variant_object()("l", salt))));
+      stats = eosio::detail::txn_test_gen_stats();
+      started = fc::time_point::now();
 
       timer_timeout = period;
       batch = batch_size/2;
@@ -267,28 +307,56 @@ struct txn_test_gen_plugin_impl {
       variant nonce_vo = fc::mutable_variant_object()
          ("value", fc::to_string(nonce++));
       signed_transaction trx;
-      trx.actions.push_back(act_a_to_b);
+      trx.actions.push_back(acts_a_to_b[i % pairs]);
       trx.context_free_actions.emplace_back(action({}, config::system_account_name, "nonce", eosio_serializer.variant_to_binary("nonce", nonce_vo)));
       trx.set_reference_block(reference_block_id);
       trx.expiration = cc.head_block_time() + fc::seconds(30);
       trx.max_net_usage_words = 100;
       trx.sign(a_priv_key, chainid);
       cc.push_transaction(packed_transaction(trx));
+      ++stats.pushed_transactions;
       }
 
       {
       variant nonce_vo = fc::mutable_variant_object()
          ("value", fc::to_string(nonce++));
       signed_transaction trx;
-      trx.actions.push_back(act_b_to_a);
+      trx.actions.push_back(acts_b_to_a[i % pairs]);
       trx.context_free_actions.emplace_back(action({}, config::system_account_name, "nonce", eosio_serializer.variant_to_binary("nonce", nonce_vo)));
       trx.set_reference_block(reference_block_id);
       trx.expiration = cc.head_block_time() + fc::seconds(30);
       trx.max_net_usage_words = 100;
       trx.sign(b_priv_key, chainid);
       cc.push_transaction(packed_transaction(trx));
+      ++stats.pushed_transactions;
+      }
+      }
+   }
+
+   void on_applied_block(const block_trace& trace) {
+      if(!running)
+         return;
+      ++stats.blocks;
+      for(const auto& region : trace.block.regions) {
+         stats.cycles += region.cycles_summary.size();
+         for(const auto& cycle : region.cycles_summary) {
+            stats.shards += cycle.size();
+            for(const auto& shard : cycle)
+               stats.block_transactions += shard.transactions.size();
+         }
       }
+   }
+
+   eosio::detail::txn_test_gen_stats get_stats() {
+      auto result = stats;
+      if(running) {
+         result.elapsed_ms = (fc::time_point::now() - started).count() / 1000;
+         if(result.elapsed_ms > 0)
+            result.transactions_per_second = result.block_transactions * 1000.0 / result.elapsed_ms;
       }
+      if(result.cycles > 0)
+         result.shards_per_cycle = double(result.shards) / result.cycles;
+      return result;
    }
 
    void stop_generation() {
@@ -305,10 +373,14 @@ struct txn_test_gen_plugin_impl {
    unsigned timer_timeout;
    unsigned batch;
 
-   action act_a_to_b;
-   action act_b_to_a;
+   vector<action> acts_a_to_b;
+   vector<action> acts_b_to_a;
 
    int32_t txn_reference_block_lag;
+   uint16_t pairs = 1;
+
+   fc::time_point started;
+   eosio::detail::txn_test_gen_stats stats;
 
    abi_serializer eosio_token_serializer = fc::json::from_string(eosio_token_abi).as<contracts::abi_def>();
 };
@@ -319,19 +391,26 @@ txn_test_gen_plugin::~txn_test_gen_plugin() {}
 void txn_test_gen_plugin::set_program_options(options_description&, options_description& cfg) {
    cfg.add_options()
       ("txn-reference-block-lag", bpo::value<int32_t>()->default_value(0), "Lag in number of blocks from the head block when selecting the reference block for transactions (-1 means Last Irreversible Block)")
+      ("txn-test-gen-pairs", bpo::value<uint16_t>()->default_value(1), "Number of independent pairs of accounts (1-6) that transfer between each other, each pair can be scheduled into its own shard")
    ;
 }
 
 void txn_test_gen_plugin::plugin_initialize(const variables_map& options) {
    my.reset(new txn_test_gen_plugin_impl);
    my->txn_reference_block_lag = options.at("txn-reference-block-lag").as<int32_t>();
+   my->pairs = boost::algorithm::clamp<uint16_t>(options.at("txn-test-gen-pairs").as<uint16_t>(), 1, 6);
 }
 
 void txn_test_gen_plugin::plugin_startup() {
+   app().get_plugin<chain_plugin>().chain().applied_block.connect([this](const block_trace& trace) {
+      my->on_applied_block(trace);
+   });
+
    app().get_plugin<http_plugin>().add_api({
       CALL(txn_test_gen, my, create_test_accounts, INVOKE_V_R_R(my, create_test_accounts, std::string, std::string), 200),
       CALL(txn_test_gen, my, stop_generation, INVOKE_V_V(my, stop_generation), 200),
-      CALL(txn_test_gen, my, start_generation, INVOKE_V_R_R_R(my, start_generation, std::string, uint64_t, uint64_t), 200)
+      CALL(txn_test_gen, my, start_generation, INVOKE_V_R_R_R(my, start_generation, std::string, uint64_t, uint64_t), 200),
+      CALL(txn_test_gen, my, get_stats, INVOKE_R_V(my, get_stats), 200)
    });
 }
 
@@ -974,6 +974,9 @@ int main( int argc, char** argv ) {
    string lower;
    string upper;
    string table_key;
+   string key_type;
+   string next_key;
+   uint32_t index_position = 1;
    bool binary = false;
    uint32_t limit = 10;
    auto getTable = get->add_subcommand( "table", localized("Retrieve the contents of a database table"), false);
@@ -985,6 +988,9 @@ int main( int argc, char** argv ) {
    getTable->add_option( "-k,--key", table_key, localized("The name of the key to index by as defined by the abi, defaults to primary key") );
    getTable->add_option( "-L,--lower", lower, localized("JSON representation of lower bound value of key, defaults to first") );
    getTable->add_option( "-U,--upper", upper, localized("JSON representation of upper bound value value of key, defaults to last") );
+   getTable->add_option( "--index", index_position, localized("Index to scan, 1 for the primary key, 2 for the first secondary index and so on") );
+   getTable->add_option( "--key-type", key_type, localized("Type of the secondary index key: i64, i128, i256, float64 or float128") );
+   getTable->add_option( "--next", next_key, localized("The next_key returned by a previous call, to continue the scan") );
 
    getTable->set_callback([&] {
       auto result = call(get_table_func, fc::mutable_variant_object("json", !binary)
@@ -995,6 +1001,9 @@ int main( int argc, char** argv ) {
                          ("lower_bound",lower)
                          ("upper_bound",upper)
                          ("limit",limit)
+                         ("index_position",index_position)
+                         ("key_type",key_type)
+                         ("next_key",next_key)
                          );
 
       std::cout << fc::json::to_pretty_string(result)
@@ -892,6 +892,7 @@ BOOST_FIXTURE_TEST_CASE(db_tests, TESTER) { try {
    CALL_TEST_FUNCTION( *this, "test_db", "primary_i64_general", {});
    CALL_TEST_FUNCTION( *this, "test_db", "primary_i64_lowerbound", {});
    CALL_TEST_FUNCTION( *this, "test_db", "primary_i64_upperbound", {});
+   CALL_TEST_FUNCTION( *this, "test_db", "primary_i64_range", {});
    CALL_TEST_FUNCTION( *this, "test_db", "idx64_general", {});
    CALL_TEST_FUNCTION( *this, "test_db", "idx64_lowerbound", {});
    CALL_TEST_FUNCTION( *this, "test_db", "idx64_upperbound", {});
@@ -1,6 +1,7 @@
 #include <boost/test/unit_test.hpp>
 #include <eosio/testing/tester_network.hpp>
 #include <eosio/chain/producer_object.hpp>
+#include <fstream>
 
 using namespace eosio;
 using namespace eosio::chain;
@@ -273,6 +274,26 @@ uint32_t calc_exp_last_irr_block_num(const base_tester& chain, const uint32_t& h
    }
 };
 
+// Configuration of a controller, kept in tempdir, that validates the blocks produced by chain
+chain_controller::controller_config validator_config(const base_tester& chain, const fc::temp_directory& tempdir, uint16_t thread_pool_size) {
+   chain_controller::controller_config vcfg;
+   vcfg.block_log_dir      = tempdir.path() / "blocklog";
+   vcfg.shared_memory_dir  = tempdir.path() / "shared";
+   vcfg.shared_memory_size = 1024*1024*8;
+   vcfg.genesis.initial_timestamp = fc::time_point::from_iso_string("2020-01-01T00:00:00.000");
+   vcfg.genesis.initial_key = chain.get_public_key( config::system_account_name, "active" );
+   vcfg.thread_pool_size = thread_pool_size;
+   return vcfg;
+}
+
+// Produces a block of count transactions alternately authorized by alice and bob
+signed_block produce_dummy_block(base_tester& chain, int count) {
+   for( int i = 0; i < count; ++i ) {
+      chain.push_dummy( i % 2 ? N(alice) : N(bob), "dummy" + std::to_string(i) );
+   }
+   return chain.produce_block();
+}
+
 BOOST_AUTO_TEST_CASE(trx_variant ) {
    try {
       TESTER chain;
@@ -552,6 +573,70 @@ BOOST_AUTO_TEST_CASE(order_dependent_transactions)
       BOOST_REQUIRE_EQUAL( chain.validate(), true );
    } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE(independent_transactions_shards)
+{ try {
+      TESTER chain;
+      chain.create_accounts( {N(alice), N(bob), N(carol)} );
+      chain.produce_blocks(2);
+
+      // reqauth touches no tables, so transactions of different accounts are independent of each other
+      auto alice_id = chain.push_dummy(N(alice), "1").id;
+      auto bob_id   = chain.push_dummy(N(bob), "2").id;
+      auto carol_id = chain.push_dummy(N(carol), "3").id;
+      auto block = chain.produce_block();
+      {
+         const auto& cycle = block.regions.front().cycles_summary.back();
+         BOOST_REQUIRE_EQUAL( cycle.size(), 3 );
+         BOOST_REQUIRE_EQUAL( cycle.at(0).transactions.size(), 1 );
+         BOOST_REQUIRE_EQUAL( cycle.at(1).transactions.size(), 1 );
+         BOOST_REQUIRE_EQUAL( cycle.at(2).transactions.size(), 1 );
+         BOOST_REQUIRE_EQUAL( cycle.at(0).transactions.front().id.str(), alice_id.str() );
+         BOOST_REQUIRE_EQUAL( cycle.at(1).transactions.front().id.str(), bob_id.str() );
+         BOOST_REQUIRE_EQUAL( cycle.at(2).transactions.front().id.str(), carol_id.str() );
+      }
+
+      // updateauth writes the permissions every transaction is authorized against, so it joins all the shards
+      // together, keeping the order in which the transactions were applied
+      alice_id = chain.push_dummy(N(alice), "4").id;
+      bob_id   = chain.push_dummy(N(bob), "5").id;
+      auto update_id = chain.push_action(name("eosio"), name("updateauth"), N(carol), fc::mutable_variant_object()
+              ("account", "carol")
+              ("permission", "first")
+              ("parent", "active")
+              ("data",  authority(chain.get_public_key(N(carol), "first")))
+              ("delay", 0)).id;
+      carol_id = chain.push_dummy(N(carol), "6").id;
+      block = chain.produce_block();
+      {
+         const auto& cycle = block.regions.front().cycles_summary.back();
+         BOOST_REQUIRE_EQUAL( cycle.size(), 1 );
+         const auto& trxs = cycle.front().transactions;
+         BOOST_REQUIRE_EQUAL( trxs.size(), 4 );
+         BOOST_REQUIRE_EQUAL( trxs.at(0).id.str(), alice_id.str() );
+         BOOST_REQUIRE_EQUAL( trxs.at(1).id.str(), bob_id.str() );
+         BOOST_REQUIRE_EQUAL( trxs.at(2).id.str(), update_id.str() );
+         BOOST_REQUIRE_EQUAL( trxs.at(3).id.str(), carol_id.str() );
+      }
+
+      // transactions billed to the same account keep their order in one shard, as resource usage is checked as they
+      // are applied
+      alice_id = chain.push_dummy(N(alice), "7").id;
+      bob_id   = chain.push_dummy(N(bob), "8").id;
+      auto alice_id2 = chain.push_dummy(N(alice), "9").id;
+      block = chain.produce_block();
+      {
+         const auto& cycle = block.regions.front().cycles_summary.back();
+         BOOST_REQUIRE_EQUAL( cycle.size(), 2 );
+         BOOST_REQUIRE_EQUAL( cycle.at(0).transactions.size(), 2 );
+         BOOST_REQUIRE_EQUAL( cycle.at(0).transactions.at(0).id.str(), alice_id.str() );
+         BOOST_REQUIRE_EQUAL( cycle.at(0).transactions.at(1).id.str(), alice_id2.str() );
+         BOOST_REQUIRE_EQUAL( cycle.at(1).transactions.size(), 1 );
+         BOOST_REQUIRE_EQUAL( cycle.at(1).transactions.front().id.str(), bob_id.str() );
+      }
+
+      BOOST_REQUIRE_EQUAL( chain.validate(), true );
+   } FC_LOG_AND_RETHROW() }
+
 // Simple test of block production when a block is missed
 BOOST_AUTO_TEST_CASE(missed_blocks)
 { try {
@@ -1255,4 +1340,260 @@ BOOST_AUTO_TEST_CASE(producer_r1_key) { try {
          
 } FC_LOG_AND_RETHROW() }
 
+
+BOOST_AUTO_TEST_CASE(parallel_input_preparation) { try {
+   tester chain;
+   chain.create_accounts( {N(alice), N(bob)} );
+   chain.produce_block();
+
+   auto block = produce_dummy_block( chain, 16 );
+   BOOST_REQUIRE_EQUAL( block.input_transactions.size(), 16 );
+
+   // the same blocks must validate to the same head whether the inputs are prepared on the calling thread or on a pool
+   for( uint16_t threads : {0, 1, 4} ) {
+      fc::temp_directory tempdir;
+      chain_controller validator( validator_config( chain, tempdir, threads ) );
+      for( uint32_t i = 1; i < chain.control->head_block_num(); ++i ) {
+         validator.push_block( *chain.control->fetch_block_by_number(i) );
+      }
+
+      auto bad_block = block;
+      bad_block.input_transactions.back().signatures.front() = chain.get_private_key( N(carol), "active" ).sign( digest_type() );
+      BOOST_REQUIRE_THROW( validator.push_block( bad_block ), fc::exception );
+
+      validator.push_block( block );
+      BOOST_REQUIRE_EQUAL( validator.head_block_id().str(), chain.control->head_block_id().str() );
+      BOOST_REQUIRE_EQUAL( validator.head_block_header().transaction_mroot.str(), block.transaction_mroot.str() );
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(early_signature_recovery) { try {
+   tester chain;
+   chain.create_accounts( {N(alice), N(bob)} );
+   chain.produce_block();
+
+   auto block = produce_dummy_block( chain, 8 );
+
+   // keys recovered ahead of time are used by push_block, in order, exactly as if recovered while applying
+   fc::temp_directory tempdir;
+   chain_controller validator( validator_config( chain, tempdir, 2 ) );
+   for( uint32_t i = 1; i < chain.control->head_block_num(); ++i ) {
+      auto b = chain.control->fetch_block_by_number(i);
+      validator.recover_signing_keys( *b );
+      validator.push_block( *b );
+   }
+
+   // a signature that does not satisfy the authority is still rejected
+   auto bad_block = block;
+   bad_block.input_transactions.back().signatures.front() = chain.get_private_key( N(carol), "active" ).sign( digest_type() );
+   validator.recover_signing_keys( bad_block );
+   BOOST_REQUIRE_THROW( validator.push_block( bad_block ), fc::exception );
+
+   validator.recover_signing_keys( block );
+   validator.push_block( block );
+   BOOST_REQUIRE_EQUAL( validator.head_block_id().str(), chain.control->head_block_id().str() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(early_signature_recovery_exact_bytes) { try {
+   tester chain;
+   chain.create_accounts( {N(alice)} );
+   chain.produce_block();
+
+   variant pretty_trx = fc::mutable_variant_object()
+      ("actions", fc::variants({
+         fc::mutable_variant_object()
+            ("account", name(config::system_account_name))
+            ("name", "reqauth")
+            ("authorization", fc::variants({
+               fc::mutable_variant_object()
+                  ("actor", "alice")
+                  ("permission", name(config::active_name))
+            }))
+            ("data", fc::mutable_variant_object()
+               ("from", "alice")
+            )
+      }))
+      ("context_free_actions", fc::variants({
+         fc::mutable_variant_object()
+            ("account", name(config::system_account_name))
+            ("name", "nonce")
+            ("data", fc::mutable_variant_object()
+               ("value", "cfd")
+            )
+      }));
+
+   signed_transaction trx;
+   contracts::abi_serializer::from_variant( pretty_trx, trx, chain.get_resolver() );
+   chain.set_transaction_headers( trx );
+   trx.context_free_data.emplace_back( bytes{'a'} );
+   trx.sign( chain.get_private_key( N(alice), "active" ), chain_id_type() );
+   packed_transaction signed_trx( trx );
+
+   // same id and signatures, but context free data that the signature does not cover
+   trx.context_free_data.front() = bytes{'b'};
+   packed_transaction relayed_trx( trx );
+   BOOST_REQUIRE_EQUAL( relayed_trx.id().str(), signed_trx.id().str() );
+
+   // keys recovered for one copy are never handed to the other
+   chain.control->recover_signing_keys( signed_trx );
+   BOOST_REQUIRE_THROW( chain.control->push_transaction( relayed_trx ), fc::exception );
+   chain.control->push_transaction( signed_trx );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(early_signature_recovery_cleanup) { try {
+   tester chain;
+   chain.create_accounts( {N(alice)} );
+   chain.produce_block();
+
+   auto make_trx = [&]( const string& nonce, uint32_t expiration, const string& signer ) {
+      variant pretty_trx = fc::mutable_variant_object()
+         ("actions", fc::variants({
+            fc::mutable_variant_object()
+               ("account", name(config::system_account_name))
+               ("name", "reqauth")
+               ("authorization", fc::variants({
+                  fc::mutable_variant_object()
+                     ("actor", "alice")
+                     ("permission", name(config::active_name))
+               }))
+               ("data", fc::mutable_variant_object()
+                  ("from", "alice")
+               )
+         }))
+         ("context_free_actions", fc::variants({
+            fc::mutable_variant_object()
+               ("account", name(config::system_account_name))
+               ("name", "nonce")
+               ("data", fc::mutable_variant_object()
+                  ("value", nonce)
+               )
+         }));
+      signed_transaction trx;
+      contracts::abi_serializer::from_variant( pretty_trx, trx, chain.get_resolver() );
+      chain.set_transaction_headers( trx, expiration );
+      trx.sign( chain.get_private_key( name(signer), "active" ), chain_id_type() );
+      return packed_transaction( trx );
+   };
+
+   // a transaction that is rejected takes its recovery with it
+   auto rejected = make_trx( "rejected", 60, "carol" );
+   chain.control->recover_signing_keys( rejected );
+   BOOST_REQUIRE_EQUAL( chain.control->pending_signature_recoveries(), 1 );
+   BOOST_REQUIRE_THROW( chain.control->push_transaction( rejected ), fc::exception );
+   BOOST_REQUIRE_EQUAL( chain.control->pending_signature_recoveries(), 0 );
+
+   // so does a duplicate of a transaction that was accepted
+   auto accepted = make_trx( "accepted", 60, "alice" );
+   chain.control->push_transaction( accepted );
+   chain.control->recover_signing_keys( accepted );
+   BOOST_REQUIRE_THROW( chain.control->push_transaction( accepted ), fc::exception );
+   BOOST_REQUIRE_EQUAL( chain.control->pending_signature_recoveries(), 0 );
+
+   // a transaction that is never pushed is dropped once it expires
+   chain.control->recover_signing_keys( make_trx( "unpushed", 3, "alice" ) );
+   chain.produce_block();
+   BOOST_REQUIRE_EQUAL( chain.control->pending_signature_recoveries(), 1 );
+   chain.produce_block( fc::seconds(3) );
+   BOOST_REQUIRE_EQUAL( chain.control->pending_signature_recoveries(), 0 );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(block_log_range) { try {
+   tester chain;
+   chain.create_accounts( {N(alice)} );
+   for( int i = 0; i < 12; ++i ) {
+      chain.push_dummy( N(alice), "dummy" + std::to_string(i) );
+      chain.produce_block();
+   }
+
+   const uint32_t lib = chain.control->last_irreversible_block_num();
+   BOOST_REQUIRE( lib > 2 );
+
+   // the views of the range are the packed blocks that fetch_block_by_number unpacks
+   uint32_t expected = 2;
+   for( const auto& view : chain.control->fetch_block_range( 2, lib ) ) {
+      BOOST_REQUIRE_EQUAL( view.block_num(), expected );
+      auto block = chain.control->fetch_block_by_number( expected );
+      BOOST_REQUIRE( block );
+      BOOST_REQUIRE_EQUAL( view.size(), fc::raw::pack_size( *block ) );
+      BOOST_REQUIRE_EQUAL( view.unpack().id().str(), block->id().str() );
+      ++expected;
+   }
+   BOOST_REQUIRE_EQUAL( expected, lib + 1 );
+
+   // the range stops at the head of the log and views stay valid while the log grows
+   auto range = chain.control->fetch_block_range( lib, lib + 100 );
+   BOOST_REQUIRE( range.begin() != range.end() );
+   auto head_view = *range.begin();
+   chain.produce_blocks( 5 );
+   BOOST_REQUIRE_EQUAL( head_view.unpack().id().str(), chain.control->get_block_id_for_num( lib ).str() );
+   BOOST_REQUIRE( !chain.control->fetch_packed_block_by_number( chain.control->head_block_num() ) );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(block_log_index_reconstruction) { try {
+   tester chain;
+   chain.produce_blocks( 20 );
+
+   fc::temp_directory tempdir;
+   vector<uint64_t> positions;
+   {
+      block_log log( tempdir.path() );
+      for( uint32_t i = 1; i <= chain.control->head_block_num(); ++i ) {
+         positions.push_back( log.append( *chain.control->fetch_block_by_number(i) ) );
+      }
+   }
+   const auto index_file = tempdir.path() / "blocks.index";
+   const auto index_size = fc::file_size( index_file );
+
+   auto check_index = [&]() {
+      block_log log( tempdir.path() );
+      BOOST_REQUIRE_EQUAL( fc::file_size( index_file ), index_size );
+      for( uint32_t i = 1; i <= positions.size(); ++i ) {
+         BOOST_REQUIRE_EQUAL( log.get_block_pos(i), positions[i-1] );
+      }
+   };
+
+   // an index cut short, as by an interrupted rebuild, is completed from where it stops
+   fc::resize_file( index_file, index_size / 2 );
+   check_index();
+
+   // entries that do not agree with the log are replaced
+   {
+      std::fstream index( index_file.generic_string().c_str(), std::ios::in | std::ios::out | std::ios::binary );
+      uint64_t bogus = 12345;
+      index.seekp( sizeof(uint64_t) * 5 );
+      index.write( (char*)&bogus, sizeof(bogus) );
+      index.seekp( 0, std::ios::end );
+      index.write( (char*)&bogus, sizeof(bogus) );
+   }
+   check_index();
+
+   fc::remove_all( index_file );
+   check_index();
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(pipelined_replay) { try {
+   tester chain;
+   chain.create_accounts( {N(alice), N(bob)} );
+   for( int i = 0; i < 20; ++i ) {
+      chain.push_dummy( i % 2 ? N(alice) : N(bob), "dummy" + std::to_string(i) );
+      chain.produce_block();
+   }
+   const uint32_t lib = chain.control->last_irreversible_block_num();
+
+   // replaying with the blocks prepared on the calling thread or ahead of time on a pool reaches the same state
+   for( uint16_t threads : {0, 2} ) {
+      fc::temp_directory tempdir;
+      {
+         block_log log( tempdir.path() / "blocklog" );
+         for( uint32_t i = 1; i <= lib; ++i ) {
+            log.append( *chain.control->fetch_block_by_number(i) );
+         }
+      }
+
+      chain_controller replayed( validator_config( chain, tempdir, threads ) );
+      BOOST_REQUIRE_EQUAL( replayed.head_block_num(), lib );
+      BOOST_REQUIRE_EQUAL( replayed.head_block_id().str(), chain.control->get_block_id_for_num( lib ).str() );
+   }
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -16,6 +16,7 @@
 
 #include <eosio/chain/contracts/chain_initializer.hpp>
 #include <eosio/chain/contracts/abi_serializer.hpp>
+#include <eosio/chain/contracts/abi_serializer_cache.hpp>
 #include <eosio/abi_generator/abi_generator.hpp>
 
 #include "config.hpp"
@@ -3069,4 +3070,53 @@ BOOST_AUTO_TEST_CASE(abi_table_repeat)
    BOOST_CHECK_EXCEPTION( abi_serializer abis(abi), fc::assert_exception, is_table_exception );
 } FC_LOG_AND_RETHROW() }
 
+
+BOOST_AUTO_TEST_CASE(abi_serializer_cache_versions)
+{ try {
+   abi_serializer_cache cache(2);
+   int loads = 0;
+   auto loader = [&]() -> optional<abi_def> {
+      ++loads;
+      return chain_initializer::eos_contract_abi(abi_def());
+   };
+   const auto v1 = digest_type::hash(std::string("v1"));
+   const auto v2 = digest_type::hash(std::string("v2"));
+
+   auto first = cache.get_abi(N(alice), v1, loader);
+   BOOST_REQUIRE(first);
+   BOOST_CHECK(cache.get_abi(N(alice), v1, loader) == first);
+   BOOST_CHECK_EQUAL(loads, 1);
+
+   // a new version of the ABI replaces the entry
+   auto second = cache.get_abi(N(alice), v2, loader);
+   BOOST_CHECK(second != first);
+   BOOST_CHECK_EQUAL(loads, 2);
+   BOOST_CHECK_EQUAL(cache.get_stats().size, 1);
+
+   // accounts without an ABI are not cached
+   BOOST_CHECK(!cache.get_abi(N(bob), v1, []() { return optional<abi_def>(); }));
+
+   cache.get_abi(N(bob), v1, loader);
+   cache.get_abi(N(alice), v2, loader);
+   cache.get_abi(N(carol), v1, loader); // evicts bob, the least recently used
+   cache.get_abi(N(alice), v2, loader);
+   BOOST_CHECK_EQUAL(loads, 4);
+   cache.get_abi(N(bob), v1, loader);
+   BOOST_CHECK_EQUAL(loads, 5);
+
+   cache.erase(N(bob));
+   cache.get_abi(N(bob), v1, loader);
+   BOOST_CHECK_EQUAL(loads, 6);
+
+   auto stats = cache.get_stats();
+   BOOST_CHECK_EQUAL(stats.hits, 3);
+   BOOST_CHECK_EQUAL(stats.misses, 7);
+   BOOST_CHECK_EQUAL(stats.evictions, 2);
+   BOOST_CHECK_EQUAL(stats.size, 2);
+   BOOST_CHECK_EQUAL(stats.capacity, 2);
+
+   // callers keep evicted entries alive
+   BOOST_CHECK(first->serializer.get_action_type(N(setabi)) == "setabi");
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,145 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+
+#include <eosio/account_history_plugin/history_store.hpp>
+#include <fc/crypto/private_key.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace eosio {
+using namespace std;
+
+namespace {
+   transaction_id_type trx_id(uint32_t n) {
+      return transaction_id_type::hash(n);
+   }
+
+   history_block make_block(uint32_t block_num, uint32_t count) {
+      history_block b;
+      b.block_num = block_num;
+      for (uint32_t i = 0; i < count; ++i)
+         b.transactions.push_back({trx_id(block_num * 100 + i), transaction_location{block_num, 100 + i * 10}, {N(alice), account_name(N(bob) + i)}});
+      return b;
+   }
+}
+
+BOOST_AUTO_TEST_SUITE(history_store_tests)
+
+/// Test that an account's transactions come back newest first and survive reopening the store
+BOOST_AUTO_TEST_CASE(account_postings)
+{
+  try {
+    fc::temp_directory tempdir;
+    {
+      history_store store(tempdir.path());
+      BOOST_CHECK_EQUAL(store.head_block_num(), 0);
+      store.append(make_block(2, 3));
+      store.append(make_block(5, 2));
+      BOOST_CHECK_THROW(store.append(make_block(5, 1)), fc::assert_exception);
+    }
+
+    history_store store(tempdir.path());
+    BOOST_CHECK_EQUAL(store.head_block_num(), 5);
+    BOOST_CHECK_EQUAL(store.count_account_transactions(N(alice)), 5);
+    BOOST_CHECK_EQUAL(store.count_account_transactions(N(bob)), 2);
+    BOOST_CHECK_EQUAL(store.count_account_transactions(N(carol)), 0);
+
+    auto all = store.get_account_transactions(N(alice), 0, 10);
+    BOOST_REQUIRE_EQUAL(all.size(), 5);
+    BOOST_CHECK_EQUAL(all[0].block_num, 5);
+    BOOST_CHECK_EQUAL(all[0].trx_offset, 110);
+    BOOST_CHECK_EQUAL(all[1].trx_offset, 100);
+    BOOST_CHECK_EQUAL(all[2].block_num, 2);
+    BOOST_CHECK_EQUAL(all[2].trx_offset, 120);
+
+    auto page = store.get_account_transactions(N(alice), 3, 10);
+    BOOST_REQUIRE_EQUAL(page.size(), 2);
+    BOOST_CHECK_EQUAL(page[0].trx_offset, 110);
+    BOOST_CHECK(store.get_account_transactions(N(alice), 5, 10).empty());
+
+    auto location = store.find_transaction(trx_id(201));
+    BOOST_REQUIRE(location);
+    BOOST_CHECK_EQUAL(location->block_num, 2);
+    BOOST_CHECK_EQUAL(location->trx_offset, 110);
+    BOOST_CHECK(!store.find_transaction(trx_id(7)));
+
+    store.wipe();
+    BOOST_CHECK_EQUAL(store.head_block_num(), 0);
+    BOOST_CHECK(!store.find_transaction(trx_id(201)));
+  } FC_LOG_AND_RETHROW()
+}
+
+/// Test that authority changes replace the keys and controlling accounts of a permission
+BOOST_AUTO_TEST_CASE(authorities)
+{
+  try {
+    fc::temp_directory tempdir;
+    auto key1 = fc::crypto::private_key::regenerate(fc::sha256::hash(string("key1"))).get_public_key();
+    auto key2 = fc::crypto::private_key::regenerate(fc::sha256::hash(string("key2"))).get_public_key();
+    {
+      history_store store(tempdir.path());
+      auto b = make_block(1, 1);
+      b.authorities.push_back({N(alice), N(owner), {key1}, {N(bob)}});
+      b.authorities.push_back({N(alice), N(active), {key1}, {}});
+      store.append(b);
+
+      b = make_block(2, 1);
+      b.authorities.push_back({N(alice), N(owner), {key2}, {}});
+      store.append(b);
+    }
+
+    history_store store(tempdir.path());
+    BOOST_CHECK(store.get_key_accounts(key1) == vector<account_name>{N(alice)});
+    BOOST_CHECK(store.get_key_accounts(key2) == vector<account_name>{N(alice)});
+    BOOST_CHECK(store.get_controlled_accounts(N(bob)).empty());
+
+    auto b = make_block(3, 1);
+    b.authorities.push_back({N(alice), N(active)});
+    store.append(b);
+    BOOST_CHECK(store.get_key_accounts(key1).empty());
+
+    // authorities changed by deferred transactions arrive in blocks without any transaction to record
+    b = make_block(4, 0);
+    b.authorities.push_back({N(carol), N(active), {key2}, {N(alice)}});
+    store.append(b);
+    BOOST_CHECK_EQUAL(store.head_block_num(), 4);
+    BOOST_CHECK((store.get_key_accounts(key2) == vector<account_name>{N(alice), N(carol)}));
+    BOOST_CHECK(store.get_controlled_accounts(N(alice)) == vector<account_name>{N(carol)});
+
+    // changes of reversible blocks replace the stored authorities of their permissions only
+    vector<authority_change> newer{{N(carol), N(active), {key1}, {}}, {N(dave), N(owner), {key2}, {N(alice)}}};
+    BOOST_CHECK((store.get_key_accounts(key2, newer) == vector<account_name>{N(alice), N(dave)}));
+    BOOST_CHECK(store.get_key_accounts(key1, newer) == vector<account_name>{N(carol)});
+    BOOST_CHECK(store.get_controlled_accounts(N(alice), newer) == vector<account_name>{N(dave)});
+    newer.push_back({N(alice), N(owner)});
+    BOOST_CHECK(store.get_key_accounts(key2, newer) == vector<account_name>{N(dave)});
+  } FC_LOG_AND_RETHROW()
+}
+
+/// Test that records written after the last completed block are dropped on open
+BOOST_AUTO_TEST_CASE(interrupted_append)
+{
+  try {
+    fc::temp_directory tempdir;
+    {
+      history_store store(tempdir.path());
+      store.append(make_block(1, 2));
+    }
+    {
+      // a block whose logs were written but whose head was not
+      std::ofstream postings((tempdir.path() / "postings.log").generic_string().c_str(), std::ios::binary | std::ios::app);
+      postings << string(30, 'x');
+    }
+
+    history_store store(tempdir.path());
+    BOOST_CHECK_EQUAL(store.head_block_num(), 1);
+    BOOST_CHECK_EQUAL(store.count_account_transactions(N(alice)), 2);
+    store.append(make_block(2, 1));
+    BOOST_CHECK_EQUAL(store.get_account_transactions(N(alice), 0, 1).front().block_num, 2);
+  } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace eosio
@@ -7,6 +7,7 @@
 #include <eosio/chain/authority.hpp>
 #include <eosio/chain/types.hpp>
 #include <eosio/chain/asset.hpp>
+#include <eosio/chain/checktime_timer.hpp>
 #include <eosio/testing/tester.hpp>
 
 #include <eosio/utilities/key_conversion.hpp>
@@ -16,6 +17,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <thread>
+
 #ifdef NON_VALIDATING_TEST
 #define TESTER tester
 #else
@@ -447,6 +450,69 @@ BOOST_AUTO_TEST_CASE(alphabetic_sort)
 
 } FC_LOG_AND_RETHROW() }
 
+/// Test that a checktime timer expires once its deadline passes, on every thread
+BOOST_AUTO_TEST_CASE(checktime_timer_expiry)
+{ try {
+   auto wait_for_expiry = [](checktime_timer& timer) {
+      auto limit = fc::time_point::now() + fc::seconds(10);
+      while (!timer.expired() && fc::time_point::now() < limit)
+         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      return timer.expired();
+   };
+
+   auto& timer = checktime_timer::for_this_thread();
+   auto deadline = fc::time_point::now() + fc::milliseconds(50);
+   timer.arm(deadline);
+   BOOST_TEST(!timer.expired());
+   BOOST_TEST(wait_for_expiry(timer));
+   BOOST_TEST(fc::time_point::now() > deadline);
+
+   // a deadline in the past expires right away, a later one is armed again
+   timer.arm(fc::time_point::now() - fc::milliseconds(1));
+   BOOST_TEST(timer.expired());
+   timer.arm(fc::time_point::now() + fc::seconds(60));
+   BOOST_TEST(!timer.expired());
+
+   bool other_expired = false;
+   std::thread other([&]() {
+      auto& other_timer = checktime_timer::for_this_thread();
+      other_timer.arm(fc::time_point::now() + fc::milliseconds(10));
+      other_expired = wait_for_expiry(other_timer);
+   });
+   other.join();
+   BOOST_TEST(other_expired);
+   BOOST_TEST(!timer.expired());
+} FC_LOG_AND_RETHROW() }
+
+/// Test that timers armed concurrently expire on time, and that a timer armed again is never expired early
+BOOST_AUTO_TEST_CASE(checktime_timer_rearm)
+{ try {
+   std::atomic<uint32_t> late(0), early(0);
+   vector<std::thread> threads;
+   for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&]() {
+         auto& timer = checktime_timer::for_this_thread();
+         for (int i = 0; i < 100; ++i) {
+            timer.arm(fc::time_point::now() + fc::microseconds(100 * (i % 5 + 1)));
+            auto limit = fc::time_point::now() + fc::seconds(10);
+            while (!timer.expired() && fc::time_point::now() < limit)
+               std::this_thread::yield();
+            if (!timer.expired())
+               ++late;
+
+            timer.arm(fc::time_point::now() + fc::seconds(60));
+            if (timer.expired())
+               ++early;
+            timer.arm(fc::time_point::maximum());
+         }
+      });
+   }
+   for (auto& thread : threads)
+      thread.join();
+   BOOST_TEST(late.load() == 0u);
+   BOOST_TEST(early.load() == 0u);
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace eosio
@@ -0,0 +1,74 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+
+#include <eosio/net_plugin/stream_compression.hpp>
+#include <boost/test/unit_test.hpp>
+#include <string>
+
+
+namespace eosio {
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(stream_compression_tests)
+
+/// Test that consecutive messages decompress to their original bytes and that later ones benefit from the history
+BOOST_AUTO_TEST_CASE(stream_round_trip)
+{
+  try {
+    stream_compressor comp;
+    stream_decompressor decomp;
+
+    string block_like;
+    for (int i = 0; i < 200; ++i) {
+      block_like += "eosio.token transfer from alice to bob " + to_string(i % 7) + ";";
+    }
+    vector<string> messages{ block_like, "x", string(), block_like + "tail", block_like };
+
+    vector<size_t> compressed_sizes;
+    for (const auto& m : messages) {
+      vector<char> compressed;
+      comp.compress(m.data(), m.size(), compressed);
+      compressed_sizes.push_back(compressed.size());
+
+      vector<char> plain;
+      decomp.decompress(compressed.data(), compressed.size(), plain, 1024*1024);
+      BOOST_CHECK_EQUAL(string(plain.begin(), plain.end()), m);
+    }
+    BOOST_CHECK_LT(compressed_sizes[0], block_like.size() / 4);
+    // the same message again is mostly back references into the stream history
+    BOOST_CHECK_LT(compressed_sizes[4], compressed_sizes[0]);
+  } FC_LOG_AND_RETHROW()
+}
+
+/// Test that decompression stops at the size limit
+BOOST_AUTO_TEST_CASE(stream_size_limit)
+{
+  try {
+    stream_compressor comp;
+    stream_decompressor decomp;
+
+    string big(64*1024, 'a');
+    vector<char> compressed;
+    comp.compress(big.data(), big.size(), compressed);
+
+    vector<char> plain;
+    BOOST_CHECK_THROW(decomp.decompress(compressed.data(), compressed.size(), plain, 1024), fc::assert_exception);
+  } FC_LOG_AND_RETHROW()
+}
+
+/// Test that bytes which are not a zlib stream are rejected
+BOOST_AUTO_TEST_CASE(stream_corrupt_input)
+{
+  try {
+    stream_decompressor decomp;
+    string junk(100, '\x7f');
+    vector<char> plain;
+    BOOST_CHECK_THROW(decomp.decompress(junk.data(), junk.size(), plain, 1024*1024), fc::assert_exception);
+  } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace eosio
@@ -74,4 +74,171 @@ BOOST_FIXTURE_TEST_CASE( multi_index_load, TESTER ) try {
 
 } FC_LOG_AND_RETHROW()
 
+
+/// Touches hundreds of rows in one action, and checks that finding them in the row cache costs less than scanning it
+BOOST_FIXTURE_TEST_CASE( multi_index_many_rows, TESTER ) try {
+
+   produce_blocks(2);
+   create_accounts( {N(multitest)} );
+   produce_blocks(2);
+
+   set_code( N(multitest), multi_index_test_wast );
+   set_abi( N(multitest), multi_index_test_abi );
+
+   produce_blocks(1);
+
+   abi_serializer abi_ser(json::from_string(multi_index_test_abi).as<abi_def>());
+
+   auto trigger = [&]( uint32_t what ) {
+      signed_transaction trx;
+      action trigger_act;
+      trigger_act.account = N(multitest);
+      trigger_act.name = N(trigger);
+      trigger_act.authorization = vector<permission_level>{{N(multitest), config::active_name}};
+      trigger_act.data = abi_ser.variant_to_binary("trigger", mutable_variant_object()
+                                                   ("what", what)
+      );
+      trx.actions.emplace_back(std::move(trigger_act));
+      set_transaction_headers(trx);
+      trx.sign(get_private_key(N(multitest), "active"), chain_id_type());
+
+      auto start = fc::time_point::now();
+      auto trace = push_transaction(trx);
+      auto elapsed = fc::time_point::now() - start;
+      produce_block();
+      BOOST_REQUIRE_EQUAL(true, chain_has_transaction(trx.id()));
+      return std::make_pair(trace.cpu_usage, elapsed);
+   };
+
+   // the contract asserts every row it finds, modifies and erases
+   trigger(2);
+
+   // the same lookups of the same rows, through the row cache and by a linear scan; cpu usage counts the
+   // instructions executed, so it is compared, and the wall clock times are only reported
+   auto cached = trigger(4);
+   auto scanned = trigger(5);
+   BOOST_TEST_MESSAGE( "multi_index_many_rows: row cache " << cached.first << " cpu, " << cached.second.count() << " us; "
+                       << "linear scan " << scanned.first << " cpu, " << scanned.second.count() << " us" );
+   BOOST_REQUIRE_LT( cached.first, scanned.first );
+
+} FC_LOG_AND_RETHROW()
+
+/// Iterates one multi_index while another modifies the rows ahead of it, which must not be served stale
+BOOST_FIXTURE_TEST_CASE( multi_index_read_ahead, TESTER ) try {
+
+   produce_blocks(2);
+   create_accounts( {N(multitest)} );
+   produce_blocks(2);
+
+   set_code( N(multitest), multi_index_test_wast );
+   set_abi( N(multitest), multi_index_test_abi );
+
+   produce_blocks(1);
+
+   abi_serializer abi_ser(json::from_string(multi_index_test_abi).as<abi_def>());
+
+   signed_transaction trx;
+   action trigger_act;
+   trigger_act.account = N(multitest);
+   trigger_act.name = N(trigger);
+   trigger_act.authorization = vector<permission_level>{{N(multitest), config::active_name}};
+   trigger_act.data = abi_ser.variant_to_binary("trigger", mutable_variant_object()
+                                                ("what", 3)
+   );
+   trx.actions.emplace_back(std::move(trigger_act));
+   set_transaction_headers(trx);
+   trx.sign(get_private_key(N(multitest), "active"), chain_id_type());
+   push_transaction(trx);
+
+   produce_block();
+   BOOST_REQUIRE_EQUAL(true, chain_has_transaction(trx.id()));
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( multi_index_table_rows, TESTER ) try {
+
+   produce_blocks(2);
+   create_accounts( {N(multitest)} );
+   produce_blocks(2);
+
+   set_code( N(multitest), multi_index_test_wast );
+   set_abi( N(multitest), multi_index_test_abi );
+
+   produce_blocks(1);
+
+   abi_serializer abi_ser(json::from_string(multi_index_test_abi).as<abi_def>());
+
+   signed_transaction trx;
+   action trigger_act;
+   trigger_act.account = N(multitest);
+   trigger_act.name = N(trigger);
+   trigger_act.authorization = vector<permission_level>{{N(multitest), config::active_name}};
+   trigger_act.data = abi_ser.variant_to_binary("trigger", mutable_variant_object()
+                                                ("what", 0)
+   );
+   trx.actions.emplace_back(std::move(trigger_act));
+   set_transaction_headers(trx);
+   trx.sign(get_private_key(N(multitest), "active"), chain_id_type());
+   push_transaction(trx);
+   produce_block();
+
+   // the orders table holds id 1 expiring at 300 and id 2 expiring at 400
+   eosio::chain_apis::read_only api(*control);
+   eosio::chain_apis::read_only::get_table_rows_params p;
+   p.json = true;
+   p.code = N(multitest);
+   p.scope = "multitest";
+   p.table = N(orders);
+   p.limit = 1;
+
+   auto page1 = api.get_table_rows(p);
+   BOOST_REQUIRE_EQUAL(page1.rows.size(), 1);
+   BOOST_REQUIRE(page1.more);
+   BOOST_CHECK_EQUAL(page1.rows[0]["id"].as_uint64(), 1);
+
+   p.next_key = page1.next_key;
+   auto page2 = api.get_table_rows(p);
+   BOOST_REQUIRE_EQUAL(page2.rows.size(), 1);
+   BOOST_CHECK(!page2.more);
+   BOOST_CHECK_EQUAL(page2.rows[0]["id"].as_uint64(), 2);
+
+   // by expiration, the first secondary index
+   p.index_position = 2;
+   p.key_type = "i64";
+   p.next_key.clear();
+   p.lower_bound = "350";
+   p.limit = 10;
+   auto late = api.get_table_rows(p);
+   BOOST_REQUIRE_EQUAL(late.rows.size(), 1);
+   BOOST_CHECK(!late.more);
+   BOOST_CHECK_EQUAL(late.rows[0]["expiration"].as_uint64(), 400);
+
+   // no limit returns as many rows as the server allows
+   p.lower_bound.clear();
+   p.limit = 0;
+   auto all = api.get_table_rows(p);
+   BOOST_REQUIRE_EQUAL(all.rows.size(), 2);
+   BOOST_CHECK(!all.more);
+
+   p.limit = 1;
+   page1 = api.get_table_rows(p);
+   BOOST_REQUIRE_EQUAL(page1.rows.size(), 1);
+   BOOST_REQUIRE(page1.more);
+   BOOST_CHECK_EQUAL(page1.rows[0]["id"].as_uint64(), 1);
+
+   p.next_key = page1.next_key;
+   page2 = api.get_table_rows(p);
+   BOOST_REQUIRE_EQUAL(page2.rows.size(), 1);
+   BOOST_CHECK(!page2.more);
+   BOOST_CHECK_EQUAL(page2.rows[0]["id"].as_uint64(), 2);
+
+   // rows are returned as hex without the ABI
+   p.json = false;
+   p.next_key.clear();
+   auto raw = api.get_table_rows(p);
+   BOOST_REQUIRE_EQUAL(raw.rows.size(), 1);
+   BOOST_CHECK(raw.rows[0].is_string());
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()
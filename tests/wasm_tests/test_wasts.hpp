@@ -281,6 +281,28 @@ static const char mutable_global_wast[] = R"=====(
 )
 )=====";
 
+static const char instance_reset_wast[] = R"=====(
+(module
+ (import "env" "eosio_assert" (func $eosio_assert (param i32 i32)))
+ (table 0 anyfunc)
+ (memory $0 1)
+ (data (i32.const 16) "init")
+ (export "memory" (memory $0))
+ (export "apply" (func $apply))
+ (func $apply (param $0 i64) (param $1 i64) (param $2 i64)
+  (call $eosio_assert (i64.eq (get_global $g0) (i64.const 2)) (i32.const 0))
+  (call $eosio_assert (i32.eq (i32.load (i32.const 16)) (i32.const 1953066601)) (i32.const 0))
+  (call $eosio_assert (i32.eq (i32.load (i32.const 1024)) (i32.const 0)) (i32.const 0))
+  (call $eosio_assert (i32.eq (current_memory) (i32.const 1)) (i32.const 0))
+  (set_global $g0 (i64.const 444))
+  (i32.store (i32.const 16) (i32.const 0))
+  (i32.store (i32.const 1024) (i32.const 7))
+  (drop (grow_memory (i32.const 1)))
+ )
+ (global $g0 (mut i64) (i64.const 2))
+)
+)=====";
+
 static const char biggest_memory_wast[] = R"=====(
 (module
  (import "env" "eosio_assert" (func $$eosio_assert (param i32 i32)))
@@ -6,6 +6,7 @@
 #include <eosio/chain/wasm_eosio_constraints.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/wast_to_wasm.hpp>
+#include <eosio/chain/native_float.hpp>
 #include <asserter/asserter.wast.hpp>
 #include <asserter/asserter.abi.hpp>
 
@@ -18,15 +19,27 @@
 #include <eosio.system/eosio.system.wast.hpp>
 #include <eosio.system/eosio.system.abi.hpp>
 
+#include <IR/IR.h>
+#include <IR/Module.h>
 #include <Runtime/Runtime.h>
+#include <WAST/WAST.h>
 
+#include <fc/filesystem.hpp>
 #include <fc/variant_object.hpp>
 #include <fc/io/json.hpp>
 
 #include "test_wasts.hpp"
 #include "test_softfloat_wasts.hpp"
 
+#include <softfloat.hpp>
+
+#include <algorithm>
 #include <array>
+#include <cfenv>
+#include <fstream>
+#include <regex>
+#include <set>
+#include <thread>
 #include <utility>
 
 #ifdef NON_VALIDATING_TEST
@@ -69,6 +82,17 @@ struct provereset {
 
 FC_REFLECT_EMPTY(provereset);
 
+/// a chain executing its contracts on the given runtime, whatever the default runtime is
+struct runtime_tester : tester {
+   runtime_tester(wasm_interface::vm_type runtime, bool native_float = false) : tester(false) {
+      close();
+      cfg.wasm_runtime = runtime;
+      cfg.wasm_native_float = native_float;
+      open();
+      push_genesis_block();
+   }
+};
+
 BOOST_AUTO_TEST_SUITE(wasm_tests)
 
 /**
@@ -205,6 +229,301 @@ BOOST_FIXTURE_TEST_CASE( prove_mem_reset, TESTER ) try {
 
 } FC_LOG_AND_RETHROW() /// prove_mem_reset
 
+/**
+ * Prove resetting a memory restores the given snapshot and zeros the rest, whatever was restored or written before
+ */
+BOOST_AUTO_TEST_CASE( memory_snapshot_reset ) try {
+   const size_t page_size = 1 << IR::numBytesPerPageLog2;
+   IR::MemoryType two_pages(false, {2, 16});
+   IR::MemoryType three_pages(false, {3, 16});
+   Runtime::MemoryInstance* memory = Runtime::createMemory(two_pages);
+   BOOST_REQUIRE(memory != nullptr);
+
+   vector<uint8_t> image_a(page_size + 100, 'a');
+   vector<uint8_t> image_b(10, 'b');
+   Runtime::MemorySnapshot* snapshot_a = Runtime::createMemorySnapshot(image_a.data(), image_a.size());
+   Runtime::MemorySnapshot* snapshot_b = Runtime::createMemorySnapshot(image_b.data(), image_b.size());
+
+   auto require_contents = [&](const vector<uint8_t>& image) {
+      const uint8_t* base = Runtime::getMemoryBaseAddress(memory);
+      const size_t size = Runtime::getMemoryNumPages(memory) * page_size;
+      BOOST_REQUIRE(std::equal(image.begin(), image.end(), base));
+      BOOST_REQUIRE(std::all_of(base + image.size(), base + size, [](uint8_t c) { return c == 0; }));
+   };
+   auto scribble = [&]() {
+      Runtime::growMemory(memory, 1);
+      uint8_t* base = Runtime::getMemoryBaseAddress(memory);
+      for (size_t offset = 0; offset < Runtime::getMemoryNumPages(memory) * page_size; offset += 4096)
+         base[offset] = base[offset + 5] = 'x';
+   };
+
+   Runtime::resetMemory(memory, two_pages, snapshot_a);
+   require_contents(image_a);
+   scribble();
+   Runtime::resetMemory(memory, two_pages, snapshot_a);
+   require_contents(image_a);
+
+   scribble();
+   Runtime::resetMemory(memory, three_pages, snapshot_b);
+   BOOST_REQUIRE_EQUAL(Runtime::getMemoryNumPages(memory), 3);
+   require_contents(image_b);
+
+   // deleting the snapshot that was restored last doesn't leave its image behind
+   Runtime::resetMemory(memory, two_pages, snapshot_a);
+   scribble();
+   Runtime::deleteMemorySnapshot(snapshot_a);
+   Runtime::resetMemory(memory, two_pages);
+   require_contents({});
+
+   Runtime::resetMemory(memory, two_pages, snapshot_b);
+   require_contents(image_b);
+   Runtime::deleteMemorySnapshot(snapshot_b);
+} FC_LOG_AND_RETHROW() /// memory_snapshot_reset
+
+/**
+ * Prove the module cache keeps the most recently used modules and counts its hits and misses
+ */
+BOOST_FIXTURE_TEST_CASE( module_cache, TESTER ) try {
+   produce_blocks(2);
+
+   create_accounts( {N(asserter)} );
+   produce_block();
+
+   // setcode warms the new code up in the background
+   auto before = control->get_wasm_interface().get_cache_stats();
+   set_code(N(asserter), asserter_wast);
+   produce_blocks(1);
+   BOOST_REQUIRE_EQUAL(before.warmups + 1, control->get_wasm_interface().get_cache_stats().warmups);
+
+   for (int i = 0; i < 2; i++) {
+      signed_transaction trx;
+      trx.actions.emplace_back( vector<permission_level>{{N(asserter),config::active_name}},
+                                provereset {} );
+      set_transaction_headers(trx);
+      trx.sign( get_private_key( N(asserter), "active" ), chain_id_type() );
+      push_transaction( trx );
+      produce_blocks(1);
+   }
+   auto after = control->get_wasm_interface().get_cache_stats();
+   BOOST_REQUIRE(after.hits > before.hits);
+   BOOST_REQUIRE(after.size <= after.capacity);
+
+   // a cache of two modules evicts the least recently used one
+   wasm_interface wasm( wasm_interface::vm_type::binaryen, 2, fc::path(), config::default_wasm_jit_cache_size );
+   vector<vector<uint8_t>> codes = { wast_to_wasm(noop_wast), wast_to_wasm(asserter_wast), wast_to_wasm(stltest_wast) };
+   for (const auto& code : codes)
+      wasm.warmup( fc::sha256::hash((const char*)code.data(), code.size()), (const char*)code.data(), code.size() );
+
+   auto deadline = fc::time_point::now() + fc::seconds(60);
+   while (wasm.get_cache_stats().compilations < codes.size() && fc::time_point::now() < deadline)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+   auto stats = wasm.get_cache_stats();
+   BOOST_REQUIRE_EQUAL(stats.compilations, codes.size());
+   BOOST_REQUIRE_EQUAL(stats.evictions, 1);
+   BOOST_REQUIRE_EQUAL(stats.size, 2);
+   BOOST_REQUIRE_EQUAL(stats.capacity, 2);
+} FC_LOG_AND_RETHROW() /// module_cache
+
+/**
+ * Prove wavm keeps compiled code across restarts, and recompiles entries that are corrupt
+ */
+BOOST_AUTO_TEST_CASE( jit_object_cache ) try {
+   fc::temp_directory tempdir;
+   auto code = wast_to_wasm(asserter_wast);
+
+   // each wasm_interface starts with an empty module cache, like a restarted node
+   auto instantiate = [&](const vector<uint8_t>& wasm_code, uint64_t cache_size) {
+      auto code_id = fc::sha256::hash((const char*)wasm_code.data(), wasm_code.size());
+      wasm_interface wasm( wasm_interface::vm_type::wavm, 1, tempdir.path(), cache_size );
+      wasm.warmup( code_id, (const char*)wasm_code.data(), wasm_code.size() );
+      auto deadline = fc::time_point::now() + fc::seconds(60);
+      while (wasm.get_cache_stats().compilations < 1 && fc::time_point::now() < deadline)
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      BOOST_REQUIRE_EQUAL(wasm.get_cache_stats().compilations, 1);
+   };
+   auto read_entries = [&]() {
+      vector<string> entries;
+      for (fc::directory_iterator it(tempdir.path()); it != fc::directory_iterator(); ++it) {
+         BOOST_REQUIRE_EQUAL((*it).extension().generic_string(), ".wavmobj");
+         std::ifstream in((*it).generic_string(), std::ios::binary);
+         entries.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+      }
+      return entries;
+   };
+
+   instantiate(code, config::default_wasm_jit_cache_size);
+   auto entries = read_entries();
+   BOOST_REQUIRE_EQUAL(entries.size(), 1);
+
+   // a valid entry is loaded and left alone
+   instantiate(code, config::default_wasm_jit_cache_size);
+   BOOST_REQUIRE(read_entries() == entries);
+
+   // a corrupt entry is replaced by recompiling the code
+   fc::path entry_path = *fc::directory_iterator(tempdir.path());
+   {
+      std::fstream out(entry_path.generic_string(), std::ios::binary | std::ios::in | std::ios::out);
+      out.seekp(entries[0].size() - 1);
+      out.put(~entries[0].back());
+   }
+   instantiate(code, config::default_wasm_jit_cache_size);
+   auto recompiled = read_entries();
+   BOOST_REQUIRE_EQUAL(recompiled.size(), 1);
+   BOOST_REQUIRE_EQUAL(recompiled[0].size(), entries[0].size());
+   BOOST_REQUIRE(recompiled[0].back() == entries[0].back());
+
+   // beyond the size of the cache the entries written longest ago are removed, never the one just written
+   instantiate(wast_to_wasm(noop_wast), entries[0].size());
+   auto pruned = read_entries();
+   BOOST_REQUIRE_EQUAL(pruned.size(), 1);
+   BOOST_REQUIRE(pruned != recompiled);
+} FC_LOG_AND_RETHROW() /// jit_object_cache
+
+/**
+ * Prove a restarted chain executes the machine code it loads from a warm jit cache
+ */
+BOOST_AUTO_TEST_CASE( jit_object_cache_restart ) try {
+   fc::temp_directory jit_cache;
+   runtime_tester chain(wasm_interface::vm_type::wavm);
+   chain.close();
+   chain.cfg.wasm_jit_cache_dir = jit_cache.path();
+   chain.open();
+
+   chain.create_accounts( {N(asserter)} );
+   chain.set_code(N(asserter), asserter_wast);
+   chain.produce_block();
+
+   auto push_assert = [&](int8_t condition, const string& message) {
+      signed_transaction trx;
+      trx.actions.emplace_back( vector<permission_level>{{N(asserter),config::active_name}},
+                                assertdef {condition, message} );
+      chain.set_transaction_headers(trx);
+      trx.sign( chain.get_private_key( N(asserter), "active" ), chain_id_type() );
+      chain.push_transaction( trx );
+      chain.produce_block();
+   };
+   push_assert(1, "Should Not Assert!");
+
+   // a second link to each entry tells whether the restarted chain loads it or writes a new entry over it
+   vector<fc::path> entries;
+   for (fc::directory_iterator it(jit_cache.path()); it != fc::directory_iterator(); ++it)
+      entries.push_back(*it);
+   BOOST_REQUIRE(!entries.empty());
+   for (const auto& entry : entries)
+      boost::filesystem::create_hard_link(entry, entry.generic_string() + ".link");
+
+   chain.close();
+   chain.open();
+   push_assert(1, "Should Not Assert Either!");
+   BOOST_CHECK_THROW(push_assert(0, "Should Assert!"), transaction_exception);
+   for (const auto& entry : entries)
+      BOOST_CHECK_EQUAL(boost::filesystem::hard_link_count(entry), 2);
+} FC_LOG_AND_RETHROW() /// jit_object_cache_restart
+
+/**
+ * Prove instances of a module execute concurrently, each in its own memory
+ */
+BOOST_AUTO_TEST_CASE( concurrent_instances ) try {
+   // keeps the wavm runtime initialized
+   wasm_interface wasm( wasm_interface::vm_type::wavm, 1, fc::path(), config::default_wasm_jit_cache_size );
+
+   const char* counter_wast = R"=====(
+(module
+ (memory 1)
+ (func (export "bump") (param i32) (result i32)
+  (i32.store (i32.const 0) (i32.add (i32.load (i32.const 0)) (get_local 0)))
+  (i32.load (i32.const 0))
+ )
+)
+)=====";
+   IR::Module module;
+   std::vector<WAST::Error> errors;
+   BOOST_REQUIRE(WAST::parseModule(counter_wast, strlen(counter_wast), module, errors));
+
+   Runtime::ModuleInstance* compiled = Runtime::instantiateModule(module, {}, std::string(), Runtime::createMemory(module.memories.defs[0].type));
+   BOOST_REQUIRE(compiled != nullptr);
+
+   const int num_threads = 4;
+   const int num_calls = 2000;
+   vector<Runtime::ModuleInstance*> instances = {compiled};
+   for (int i = 1; i < num_threads; ++i)
+      instances.push_back(Runtime::cloneModuleInstance(module, compiled, Runtime::createMemory(module.memories.defs[0].type)));
+
+   std::array<bool, num_threads> counted;
+   vector<std::thread> threads;
+   for (int i = 0; i < num_threads; ++i) {
+      threads.emplace_back([&, i]() {
+         Runtime::MemoryInstance* memory = Runtime::getDefaultMemory(instances[i]);
+         Runtime::resetMemory(memory, module.memories.defs[0].type);
+         Runtime::FunctionInstance* bump = Runtime::asFunctionNullable(Runtime::getInstanceExport(instances[i], "bump"));
+         counted[i] = bump != nullptr;
+         for (int call = 1; counted[i] && call <= num_calls; ++call)
+            counted[i] = Runtime::invokeFunction(bump, {Runtime::Value(I32(1))}).i32 == call;
+      });
+   }
+   for (auto& thread : threads)
+      thread.join();
+
+   for (int i = 0; i < num_threads; ++i)
+      BOOST_REQUIRE(counted[i]);
+   BOOST_REQUIRE(Runtime::getDefaultMemory(instances[0]) != Runtime::getDefaultMemory(instances[1]));
+} FC_LOG_AND_RETHROW() /// concurrent_instances
+
+/**
+ * Compare the fixed cost of an action under each runtime, only the results are checked and the timings are reported
+ */
+BOOST_AUTO_TEST_CASE( runtime_action_overhead ) try {
+   const int num_transactions = 20;
+   const int actions_per_transaction = 50;
+   for (auto runtime : {wasm_interface::vm_type::binaryen, wasm_interface::vm_type::wavm}) {
+      runtime_tester chain(runtime);
+      chain.produce_blocks(2);
+      chain.create_accounts( {N(noop)} );
+      chain.produce_block();
+      chain.set_code(N(noop), noop_wast);
+      chain.set_abi(N(noop), noop_abi);
+      chain.produce_block();
+
+      abi_def abi;
+      BOOST_REQUIRE_EQUAL(abi_serializer::to_abi(chain.control->get_database().get<account_object,by_name>(N(noop)).abi, abi), true);
+      abi_serializer abi_ser(abi);
+
+      fc::microseconds elapsed;
+      vector<transaction_id_type> ids;
+      // the first transaction instantiates the module and is left out of the timing
+      for (int t = 0; t <= num_transactions; ++t) {
+         signed_transaction trx;
+         for (int a = 0; a < actions_per_transaction; ++a) {
+            action act;
+            act.account = N(noop);
+            act.name = N(anyaction);
+            act.authorization = vector<permission_level>{{N(noop), config::active_name}};
+            act.data = abi_ser.variant_to_binary("anyaction", mutable_variant_object()
+                                                 ("from", "noop")
+                                                 ("type", "benchmark")
+                                                 ("data", std::to_string(t * actions_per_transaction + a))
+                                                 );
+            trx.actions.emplace_back(std::move(act));
+         }
+         chain.set_transaction_headers(trx);
+         trx.sign(chain.get_private_key(N(noop), "active"), chain_id_type());
+
+         auto start = fc::time_point::now();
+         chain.push_transaction(trx);
+         if (t > 0)
+            elapsed += fc::time_point::now() - start;
+         ids.push_back(trx.id());
+         chain.produce_block();
+      }
+
+      for (const auto& id : ids)
+         BOOST_REQUIRE_EQUAL(true, chain.chain_has_transaction(id));
+      BOOST_TEST_MESSAGE( (runtime == wasm_interface::vm_type::binaryen ? "binaryen" : "wavm") << ": "
+                          << elapsed.count() / (num_transactions * actions_per_transaction) << " us per action" );
+   }
+} FC_LOG_AND_RETHROW() /// runtime_action_overhead
+
 /**
  * Prove the modifications to global variables are wiped between runs
  */
@@ -382,6 +701,278 @@ BOOST_FIXTURE_TEST_CASE( f64_tests, TESTER ) try {
    }
 } FC_LOG_AND_RETHROW()
 
+namespace {
+   template<typename T> struct softfloat_ops;
+
+   template<> struct softfloat_ops<float> {
+      using bits_type = uint32_t;
+      static bits_type add(bits_type a, bits_type b) { return f32_add(float32_t{a}, float32_t{b}).v; }
+      static bits_type sub(bits_type a, bits_type b) { return f32_sub(float32_t{a}, float32_t{b}).v; }
+      static bits_type mul(bits_type a, bits_type b) { return f32_mul(float32_t{a}, float32_t{b}).v; }
+      static bits_type div(bits_type a, bits_type b) { return f32_div(float32_t{a}, float32_t{b}).v; }
+      static bits_type sqrt(bits_type a) { return f32_sqrt(float32_t{a}).v; }
+      static float parse(const string& literal) { return std::strtof(literal.c_str(), nullptr); }
+   };
+
+   template<> struct softfloat_ops<double> {
+      using bits_type = uint64_t;
+      static bits_type add(bits_type a, bits_type b) { return f64_add(float64_t{a}, float64_t{b}).v; }
+      static bits_type sub(bits_type a, bits_type b) { return f64_sub(float64_t{a}, float64_t{b}).v; }
+      static bits_type mul(bits_type a, bits_type b) { return f64_mul(float64_t{a}, float64_t{b}).v; }
+      static bits_type div(bits_type a, bits_type b) { return f64_div(float64_t{a}, float64_t{b}).v; }
+      static bits_type sqrt(bits_type a) { return f64_sqrt(float64_t{a}).v; }
+      static double parse(const string& literal) { return std::strtod(literal.c_str(), nullptr); }
+   };
+
+   template<typename T>
+   typename softfloat_ops<T>::bits_type float_bits(T value) {
+      typename softfloat_ops<T>::bits_type bits;
+      memcpy(&bits, &value, sizeof(bits));
+      return bits;
+   }
+
+   template<typename T>
+   T float_from_bits(typename softfloat_ops<T>::bits_type bits) {
+      T value;
+      memcpy(&value, &bits, sizeof(value));
+      return value;
+   }
+
+   /// the value of a f32.const or f64.const literal of the softfloat test wasts
+   template<typename T>
+   T parse_float_literal(string literal) {
+      using bits_type = typename softfloat_ops<T>::bits_type;
+      const int mantissa_bits = std::numeric_limits<T>::digits - 1;
+      const bits_type sign = bits_type(1) << (sizeof(bits_type) * 8 - 1);
+      const bits_type exponent = ~sign & ~((bits_type(1) << mantissa_bits) - 1);
+
+      bits_type negative = 0;
+      if (literal[0] == '-' || literal[0] == '+') {
+         negative = literal[0] == '-' ? sign : 0;
+         literal.erase(0, 1);
+      }
+      if (literal == "inf")
+         return float_from_bits<T>(negative | exponent);
+      if (literal.compare(0, 3, "nan") == 0) {
+         bits_type payload = literal.size() > 4 ? std::stoull(literal.substr(4), nullptr, 16) : bits_type(1) << (mantissa_bits - 1);
+         return float_from_bits<T>(negative | exponent | payload);
+      }
+      return float_from_bits<T>(negative | float_bits(softfloat_ops<T>::parse(literal)));
+   }
+
+   /**
+    * Run one operation the way softfloat_api does, native when native_float takes it, and compare the bits with
+    * softfloat alone. Counts the operations that were native.
+    */
+   template<typename T>
+   bool matches_softfloat(const string& op, T a, T b, size_t& native_count) {
+      using ops = softfloat_ops<T>;
+      T native;
+      bool taken;
+      typename ops::bits_type expected;
+      if (op == "add") {
+         taken = native_float::add(a, b, native);
+         expected = ops::add(float_bits(a), float_bits(b));
+      } else if (op == "sub") {
+         taken = native_float::sub(a, b, native);
+         expected = ops::sub(float_bits(a), float_bits(b));
+      } else if (op == "mul") {
+         taken = native_float::mul(a, b, native);
+         expected = ops::mul(float_bits(a), float_bits(b));
+      } else if (op == "div") {
+         taken = native_float::div(a, b, native);
+         expected = ops::div(float_bits(a), float_bits(b));
+      } else {
+         taken = native_float::sqrt(a, native);
+         expected = ops::sqrt(float_bits(a));
+      }
+      if (!taken)
+         return true;
+      ++native_count;
+      return float_bits(native) == expected;
+   }
+
+   /**
+    * Check the operations of the test wast with its operands, and every operand combined with every other one
+    */
+   template<typename T>
+   void check_native_float(const char* wast, size_t& native_count) {
+      static const std::regex call_regex(R"=====(\(call \$(add|sub|mul|div|sqrt) \(f(?:32|64)\.const ([^ )]+)\)(?: \(f(?:32|64)\.const ([^ )]+)\))?\))=====");
+      const string text(wast);
+      std::set<typename softfloat_ops<T>::bits_type> operands;
+      for (std::sregex_iterator itr(text.begin(), text.end(), call_regex), end; itr != end; ++itr) {
+         const auto& match = *itr;
+         T a = parse_float_literal<T>(match[2]);
+         T b = match[3].matched ? parse_float_literal<T>(match[3]) : T(0);
+         BOOST_CHECK_MESSAGE(matches_softfloat(match[1], a, b, native_count), match.str());
+         operands.insert(float_bits(a));
+         operands.insert(float_bits(b));
+      }
+      BOOST_REQUIRE(!operands.empty());
+
+      for (auto a : operands) {
+         for (auto b : operands) {
+            for (const string op : {"add", "sub", "mul", "div", "sqrt"}) {
+               BOOST_CHECK_MESSAGE(matches_softfloat(op, float_from_bits<T>(a), float_from_bits<T>(b), native_count),
+                                   op << " " << std::hex << a << " " << b);
+            }
+         }
+      }
+   }
+}
+
+/**
+ * Prove the native float operations give the same bits as softfloat, for the operands of the softfloat tests
+ */
+BOOST_AUTO_TEST_CASE( native_float_differential ) try {
+   if (!native_float::enabled()) {
+      BOOST_TEST_MESSAGE("native float operations are not enabled on this host, softfloat is used for all of them");
+      return;
+   }
+   size_t native_count = 0;
+   check_native_float<float>(f32_test_wast, native_count);
+   check_native_float<double>(f64_test_wast, native_count);
+   BOOST_REQUIRE(native_count > 0);
+} FC_LOG_AND_RETHROW() /// native_float_differential
+
+/**
+ * Prove native float operations are only used when the node opts in, and that the float tests pass either way
+ */
+BOOST_AUTO_TEST_CASE( native_float_opt_in ) try {
+   for (bool opt_in : {false, true}) {
+      runtime_tester chain(config::default_wasm_runtime, opt_in);
+      BOOST_REQUIRE_EQUAL(chain.control->get_wasm_interface().native_float_enabled(), opt_in && native_float::enabled());
+
+      chain.produce_blocks(2);
+      chain.create_accounts( {N(f_tests)} );
+      chain.produce_block();
+      for (const char* wast : {f32_test_wast, f64_test_wast}) {
+         chain.set_code(N(f_tests), wast);
+         chain.produce_block();
+
+         signed_transaction trx;
+         action act;
+         act.account = N(f_tests);
+         act.name = N();
+         act.authorization = vector<permission_level>{{N(f_tests),config::active_name}};
+         trx.actions.push_back(act);
+
+         chain.set_transaction_headers(trx);
+         trx.sign(chain.get_private_key( N(f_tests), "active" ), chain_id_type());
+         chain.push_transaction(trx);
+         chain.produce_block();
+         BOOST_REQUIRE_EQUAL(true, chain.chain_has_transaction(trx.id()));
+      }
+   }
+} FC_LOG_AND_RETHROW() /// native_float_opt_in
+
+namespace {
+   /// one float operation of a contract and the bits softfloat gives for it
+   struct float_case {
+      string   op;
+      uint64_t a;
+      uint64_t b;
+   };
+
+   /**
+    * A contract asserting that each operation gives the bits softfloat gives for it, the operands and results are
+    * passed as integers so only the operations themselves are computed as floats
+    */
+   template<typename T>
+   string softfloat_results_wast(const vector<float_case>& cases) {
+      using ops = softfloat_ops<T>;
+      const string f = sizeof(T) == 4 ? "f32" : "f64";
+      const string i = sizeof(T) == 4 ? "i32" : "i64";
+      auto literal = [&](uint64_t bits) {
+         return sizeof(T) == 4 ? std::to_string(int32_t(bits)) : std::to_string(int64_t(bits));
+      };
+      auto operand = [&](uint64_t bits) {
+         return "(" + f + ".reinterpret/" + i + " (" + i + ".const " + literal(bits) + "))";
+      };
+
+      string wast = R"=====(
+(module
+ (import "env" "eosio_assert" (func $eosio_assert (param i32 i32)))
+ (table 0 anyfunc)
+ (memory $0 1)
+ (export "memory" (memory $0))
+ (export "apply" (func $apply))
+ (func $apply (param $0 i64) (param $1 i64) (param $2 i64)
+)=====";
+      for (const auto& c : cases) {
+         typename ops::bits_type a = c.a, b = c.b, expected;
+         string operation;
+         if (c.op == "sqrt") {
+            expected = ops::sqrt(a);
+            operation = "(" + f + ".sqrt " + operand(a) + ")";
+         } else {
+            expected = c.op == "add" ? ops::add(a, b) : c.op == "sub" ? ops::sub(a, b) : c.op == "mul" ? ops::mul(a, b) : ops::div(a, b);
+            operation = "(" + f + "." + c.op + " " + operand(a) + " " + operand(b) + ")";
+         }
+         wast += "  (call $eosio_assert (" + i + ".eq (" + i + ".reinterpret/" + f + " " + operation + ") (" + i + ".const "
+               + literal(expected) + ")) (i32.const 0))\n";
+      }
+      return wast + " )\n)\n";
+   }
+}
+
+/**
+ * Prove add, sub, mul, div and sqrt give the softfloat results when the node does not opt in to native float
+ * operations. The executing thread rounds toward positive infinity, which only changes the native results, so a
+ * native operation taken without the opt in would fail the contract.
+ */
+BOOST_AUTO_TEST_CASE( native_float_opt_out ) try {
+   // rounded differently by the thread, a NaN payload, an invalid operation and a NaN result
+   const vector<float_case> f32_cases = {
+      {"add", 0x3f800000, 0x30800000}, {"sub", 0x3f800000, 0xb0800000}, {"mul", 0x3f800001, 0x3f800001},
+      {"div", 0x40400000, 0x41980000}, {"sqrt", 0x40400000, 0},
+      {"add", 0x7fa00001, 0x3f800000}, {"mul", 0x00000000, 0x7f800000}, {"sqrt", 0xbf800000, 0}
+   };
+   const vector<float_case> f64_cases = {
+      {"add", 0x3ff0000000000000, 0x3c30000000000000}, {"sub", 0x3ff0000000000000, 0xbc30000000000000},
+      {"mul", 0x3ff0000000000001, 0x3ff0000000000001}, {"div", 0x3ff0000000000000, 0x4008000000000000},
+      {"sqrt", 0x4008000000000000, 0},
+      {"add", 0x7ff4000000000001, 0x3ff0000000000000}, {"mul", 0x0000000000000000, 0x7ff0000000000000},
+      {"sqrt", 0xbff0000000000000, 0}
+   };
+
+   for (bool opt_in : {false, true}) {
+      runtime_tester chain(config::default_wasm_runtime, opt_in);
+      chain.produce_blocks(2);
+      chain.create_accounts( {N(f_tests)} );
+      chain.produce_block();
+      for (const auto& wast : {softfloat_results_wast<float>(f32_cases), softfloat_results_wast<double>(f64_cases)}) {
+         chain.set_code(N(f_tests), wast.c_str());
+         chain.produce_block();
+
+         signed_transaction trx;
+         action act;
+         act.account = N(f_tests);
+         act.name = N();
+         act.authorization = vector<permission_level>{{N(f_tests),config::active_name}};
+         trx.actions.push_back(act);
+         chain.set_transaction_headers(trx);
+         trx.sign(chain.get_private_key( N(f_tests), "active" ), chain_id_type());
+
+         // the self check of native_float is done by now, rounding mode changes after it go unnoticed
+         BOOST_REQUIRE_EQUAL(chain.control->get_wasm_interface().native_float_enabled(), opt_in && native_float::enabled());
+         const int rounding = std::fegetround();
+         std::fesetround(FE_UPWARD);
+         bool failed = false;
+         try {
+            chain.push_transaction(trx);
+         } catch (const fc::assert_exception&) {
+            failed = true;
+         }
+         std::fesetround(rounding);
+
+         // the native operations are taken, and differ, only when opted in
+         BOOST_REQUIRE_EQUAL(failed, chain.control->get_wasm_interface().native_float_enabled());
+         chain.produce_block();
+      }
+   }
+} FC_LOG_AND_RETHROW() /// native_float_opt_out
+
 // test softfloat conversion operations
 BOOST_FIXTURE_TEST_CASE( f32_f64_conversion_tests, tester ) try {
    produce_blocks(2);
@@ -752,6 +1343,38 @@ BOOST_FIXTURE_TEST_CASE( check_global_reset, TESTER ) try {
    BOOST_CHECK_EQUAL(transaction_receipt::executed, receipt.status);
 } FC_LOG_AND_RETHROW()
 
+/**
+ * Prove binaryen's reused instances start every action with the initial globals, memory contents and memory size,
+ * whatever the previous action on the same thread left behind
+ */
+BOOST_AUTO_TEST_CASE( binaryen_instance_reset ) try {
+   runtime_tester chain(wasm_interface::vm_type::binaryen);
+   chain.produce_blocks(2);
+   chain.create_accounts( {N(resetter)} );
+   chain.produce_block();
+   chain.set_code(N(resetter), instance_reset_wast);
+   chain.produce_block();
+
+   // each action checks the initial state and then overwrites the global, the data segment and a zeroed word
+   // and grows the memory
+   for (int t = 0; t < 3; ++t) {
+      signed_transaction trx;
+      for (uint64_t a = 0; a < 3; ++a) {
+         action act;
+         act.account = N(resetter);
+         act.name = name(a);
+         act.authorization = vector<permission_level>{{N(resetter),config::active_name}};
+         trx.actions.push_back(act);
+      }
+      chain.set_transaction_headers(trx);
+      trx.sign(chain.get_private_key( N(resetter), "active" ), chain_id_type());
+      chain.push_transaction(trx);
+      chain.produce_block();
+      BOOST_REQUIRE_EQUAL(true, chain.chain_has_transaction(trx.id()));
+      BOOST_CHECK_EQUAL(transaction_receipt::executed, chain.get_transaction_receipt(trx.id()).status);
+   }
+} FC_LOG_AND_RETHROW() /// binaryen_instance_reset
+
 BOOST_FIXTURE_TEST_CASE( stl_test, TESTER ) try {
     produce_blocks(2);
 